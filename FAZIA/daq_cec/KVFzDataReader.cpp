@@ -22,7 +22,7 @@ DAQ::FzEventSet fFzEvSet;
 
 bool KVFzDataReader::parse_event_from_message()
 {
-   google::protobuf::io::CodedInputStream codedIStream((const uint8_t*)(fBuffer + fEvOffset), fEvSize);
+   google::protobuf::io::CodedInputStream codedIStream((const uint8_t*)(fData + fEvOffset), fEvSize);
    if (!fFzEvSet.ParseFromCodedStream(&codedIStream)) {
       Error("parse_event_from_message", "problem parsing event set");
       return false;
@@ -34,18 +34,25 @@ bool KVFzDataReader::parse_event_from_message()
    return true;
 }
 
-bool KVFzDataReader::read_buffer()
+bool KVFzDataReader::open_next_file()
 {
-   // if previous read reached the end of a file, we try to open the next file in the list
-
-   if (fReachedEndOfFile) {
-      TObject* o = fFileListIterator->operator()();
-      if (!o) return false; // no more files to read
-      // open next file
-      KVString url = fFullFilePath + o->GetName();
-      open_file(url);
-   }
-   return KVProtobufDataReader::read_buffer();
+   // all events in the current file have been read: open the next file in the list
+
+   TObject* o = fFileListIterator->operator()();
+   if (!o) return false; // no more files to read
+   open_file_in_list(o);
+   return true;
+}
+
+void KVFzDataReader::open_file_in_list(TObject* o)
+{
+   // open file in list of files for run, and start reading ahead the following file (if any)
+   // in the background, so that it is ready when needed
+
+   KVString url = fFullFilePath + o->GetName();
+   open_file(url);
+   TObject* next = fListOfFiles->After(o);
+   if (next) prefetch_file(fFullFilePath + next->GetName());
 }
 
 KVFzDataReader::KVFzDataReader(const Char_t* filepath, Int_t bufSiz)
@@ -94,8 +101,7 @@ KVFzDataReader::KVFzDataReader(const Char_t* filepath, Int_t bufSiz)
    fListOfFiles->ls();
    fFileListIterator->Reset();
    // open first file
-   KVString url = fFullFilePath + fFileListIterator->operator()()->GetName();
-   open_file(url);
+   open_file_in_list(fFileListIterator->operator()());
 }
 
 const DAQ::FzEvent& KVFzDataReader::get_fazia_event() const
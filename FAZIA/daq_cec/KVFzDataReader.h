@@ -31,7 +31,8 @@ class KVFzDataReader : public KVProtobufDataReader {
    int run_number;//! run number deduced from filename
 
    bool parse_event_from_message();
-   bool read_buffer();
+   bool open_next_file();
+   void open_file_in_list(TObject*);
 
 public:
    KVFzDataReader() : fListOfFiles(nullptr), fFileListIterator(nullptr) {}
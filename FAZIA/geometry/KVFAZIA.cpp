@@ -12,6 +12,14 @@
 #include "TSystem.h"
 #include "KVDataSet.h"
 #include "KVConfig.h"
+#ifdef WITH_CPP11
+#include "KVThreadPool.h"
+#include <chrono>
+#include <unordered_set>
+#endif
+#ifdef USING_ROOT6
+#include "TROOT.h"
+#endif
 
 //#include "TGeoBox.h"
 #include "TGeoCompositeShape.h"
@@ -48,6 +56,13 @@ KVFAZIA::KVFAZIA(const Char_t* title)
 {
    // Default constructor
    fStartingBlockNumber = 0;
+   fRawDataLinkBlocks = -1;
+   fPSAThreadPool = nullptr;
+   fPSANumberOfThreads = -1;
+   for (int i = 0; i < KVSignal::kUNKDT; ++i) {
+      fPSATime[i] = 0;
+      fPSACount[i] = 0;
+   }
    gFazia = this;
    fDetectorLabels = "";
    fSignalTypes = "QL1,I1,QH1,Q2,I2,Q3";
@@ -78,9 +93,18 @@ KVFAZIA::~KVFAZIA()
 {
    // Destructor
 
+#ifdef WITH_CPP11
+   SafeDelete(fPSAThreadPool);
+#endif
    if (gFazia == this) gFazia = nullptr;
 }
 
+void KVFAZIA::set_global_pointers()
+{
+   // Make gFazia point to this array (after making a working copy)
+   gFazia = this;
+}
+
 void KVFAZIA::AddDetectorLabel(const Char_t* label)
 {
    if (fDetectorLabels == "") fDetectorLabels += label;
@@ -200,6 +224,7 @@ void KVFAZIA::BuildTarget()
 void KVFAZIA::Build(Int_t)
 {
    // Build the FAZIA array
+   fRawDataLinkBlocks = -1;// links to detectors & signals of raw data will be rebuilt
    GetGeometryParameters();
    GenerateCorrespondanceFile();
 
@@ -372,33 +397,46 @@ Bool_t KVFAZIA::treat_event(const DAQ::FzEvent& e)
 
    Bool_t good = kTRUE;
 
+   if (fRawDataLinkBlocks < 0) BuildRawDataLinks();
+   if (fPSANumberOfThreads < 0) InitialisePSA();
+   fPSASignals.clear();
+   fPSASignalTypes.clear();
+
    //get info from trigger
+   // parameter names are resolved once and for all (see KVNameValueList::GetSlot)
+   static const KVNameValueList::Slot trigpat = KVNameValueList::GetSlot("FAZIA.TRIGPAT");
+   static const KVNameValueList::Slot trigrate_ext = KVNameValueList::GetSlot("FAZIA.TRIGRATE.EXT");
+   static const KVNameValueList::Slot trigrate_man = KVNameValueList::GetSlot("FAZIA.TRIGRATE.MAN");
+   static const KVNameValueList::Slot trigrate_tot = KVNameValueList::GetSlot("FAZIA.TRIGRATE.TOT");
+   static const KVNameValueList::Slot trigrate_val = KVNameValueList::GetSlot("FAZIA.TRIGRATE.VAL");
+   static const KVNameValueList::Slot deadtime = KVNameValueList::GetSlot("FAZIA.DEADTIME");
+   static const std::vector<KVNameValueList::Slot> trigrate_pat = []() {
+      std::vector<KVNameValueList::Slot> v;
+      for (int i = 0; i < 32; ++i) v.push_back(KVNameValueList::GetSlot(Form("FAZIA.TRIGRATE.PAT%d", i)));
+      return v;
+   }();
    int ts = e.trinfo_size();
    uint64_t dt = 0;
    uint64_t tot = 0;
    for (Int_t tr = ts - 1; tr >= 0; tr--) {
       const DAQ::FzTrigInfo& rdtrinfo = e.trinfo(tr);
       uint64_t triggervalue = rdtrinfo.value();
-      if (tr == ts - 5)       fReconParameters.SetValue("FAZIA.TRIGPAT", (int)triggervalue);
+      if (tr == ts - 5)       fReconParameters.SetValue(trigpat, (int)triggervalue);
       else if (tr == ts - 6)  fReconParameters.SetValue64bit("FAZIA.EC", ((triggervalue << 12) + e.ec()));
       else if (tr == ts - 8)  dt = triggervalue;
-      else if (tr == ts - 9)  fReconParameters.SetValue("FAZIA.TRIGRATE.EXT", 1.*triggervalue / dt);
-      else if (tr == ts - 10) fReconParameters.SetValue("FAZIA.TRIGRATE.MAN", 1.*triggervalue / dt);
-      else if (tr == ts - 11) fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
-      else if (tr == ts - 12) fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
-      else if (tr == ts - 13) fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
-      else if (tr == ts - 14) fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
-      else if (tr == ts - 15) fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
-      else if (tr == ts - 16) fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
-      else if (tr == ts - 17) fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
-      else if (tr == ts - 18) fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
+      else if (tr == ts - 9)  fReconParameters.SetValue(trigrate_ext, 1.*triggervalue / dt);
+      else if (tr == ts - 10) fReconParameters.SetValue(trigrate_man, 1.*triggervalue / dt);
+      else if (tr <= ts - 11 && tr >= ts - 18) {
+         if (tr - 2 >= 0 && tr - 2 < (int)trigrate_pat.size()) fReconParameters.SetValue(trigrate_pat[tr - 2], 1.*triggervalue / dt);
+         else fReconParameters.SetValue(Form("FAZIA.TRIGRATE.PAT%d", tr - 2), 1.*triggervalue / dt);
+      }
       else if (tr == ts - 19) {
-         fReconParameters.SetValue("FAZIA.TRIGRATE.TOT", 1.*triggervalue / dt);
+         fReconParameters.SetValue(trigrate_tot, 1.*triggervalue / dt);
          tot = triggervalue;
       }
       else if (tr == ts - 20) {
-         fReconParameters.SetValue("FAZIA.TRIGRATE.VAL", 1.*triggervalue / dt);
-         fReconParameters.SetValue("FAZIA.DEADTIME", 100.*(1. - 1.*triggervalue / tot));
+         fReconParameters.SetValue(trigrate_val, 1.*triggervalue / dt);
+         fReconParameters.SetValue(deadtime, 100.*(1. - 1.*triggervalue / tot));
       }
       else {}
    }
@@ -432,6 +470,10 @@ Bool_t KVFAZIA::treat_event(const DAQ::FzEvent& e)
             for (Int_t mm = 0; mm < rdhit.data_size(); mm++) {
                const DAQ::FzData& rdata = rdhit.data(mm);
                int fIdSignal = rdata.type();
+               if (fIdSignal > 5) {
+                  Warning("treat_event", "datatype %d>5", fIdSignal);
+                  continue;
+               }
 
                int DetTag = rdhit.dettag();
                int GTTag = rdhit.gttag();
@@ -441,7 +483,8 @@ Bool_t KVFAZIA::treat_event(const DAQ::FzEvent& e)
                int fIdQuartet = fQuartet[fIdFee][fIdTel];
                int fIdTelescope = fTelescope[fIdFee][fIdTel];
 
-               KVFAZIADetector* det = (KVFAZIADetector*)GetDetector(Form("%s-%d", FzDetector_str[fIdSignal], 100 * fIdBlk + 10 * fIdQuartet + fIdTelescope));
+               const RawDataLink* link = GetRawDataLink(fIdBlk, fIdFee, fIdTel, fIdSignal);
+               KVFAZIADetector* det = (link ? link->fDetector : nullptr);
                if (!det) {
 //                  Error("treat_event", "No detector %s-%d found in FAZIA geometry...", FzDetector_str[fIdSignal], 100 * fIdBlk + 10 * fIdQuartet + fIdTelescope);
                   continue;
@@ -464,35 +507,17 @@ Bool_t KVFAZIA::treat_event(const DAQ::FzEvent& e)
                }
                if (rdata.has_waveform()) {
                   const DAQ::Waveform& rwf = rdata.waveform();
-                  Int_t supp;
-
-                  if (fIdSignal <= 5) {
-                     TString sname = GetSignalName(fIdBlk, fIdQuartet, fIdTelescope, fIdSignal);//QH1-123 etc.
-                     if (sname == "")
-                        Warning("treat_event", "signal name is empty !!! blk=%d qua=%d tel=%d\n", fIdBlk, fIdQuartet, fIdTelescope);
-
-                     TGraph sig(rwf.sample_size());
-
-                     for (Int_t nn = 0; nn < rwf.sample_size(); nn++) {
-                        if (fIdSignal != DAQ::FzData::ADC) {
-                           if (rwf.sample(nn) > 8191) {
-                              supp = rwf.sample(nn) | 0xFFFFC000;
-                           }
-                           else {
-                              supp = rwf.sample(nn);
-                           }
-                        }
-                        else {
-                           supp = rwf.sample(nn);
-                        }
-                        sig.SetPoint(nn, nn, supp);
+
+                  if (link->fSignal) {
+                     link->fSignal->SetADCSamples(rwf.sample_size(), rwf.sample().data(), kTRUE);
+                     if (fPSAThreadPool) {
+                        fPSASignals.push_back(link->fSignal);
+                        fPSASignalTypes.push_back(fIdSignal);
                      }
-                     det->SetSignal(&sig, sname);
-                  }
-                  else {
-                     if (fIdSignal > 5)
-                        Warning("treat_event", "datatype %d>5 - taille = %d\n", fIdSignal, rwf.sample_size());
                   }
+                  else
+                     Warning("treat_event", "%s : No signal of name #%s# is available", det->GetName(),
+                             GetSignalName(fIdBlk, fIdQuartet, fIdTelescope, fIdSignal).Data());
                }
             }
          }
@@ -503,6 +528,8 @@ Bool_t KVFAZIA::treat_event(const DAQ::FzEvent& e)
 //   fFPGAParameters.ls();
 //   fSignals.ls();
 
+   if (good && fPSAThreadPool) PerformPSA();
+
    return good;
 }
 #endif
@@ -551,6 +578,8 @@ void KVFAZIA::CreateCorrespondence()
    }
    KVEnv DetLink;
    DetLink.ReadFile(DataFilePath, kEnvUser);
+   memset(fQuartet, 0, sizeof(fQuartet));
+   memset(fTelescope, 0, sizeof(fTelescope));
    for (int t = 1; t <= 4; t++) {
       for (int q = 1; q <= 4; q++) {
          TString elec = DetLink.GetValue(Form("T%1d-Q%1d", t, q), " ");
@@ -567,3 +596,111 @@ void KVFAZIA::CreateCorrespondence()
    }
 }
 
+void KVFAZIA::BuildRawDataLinks()
+{
+   // Fill table of detectors and signals corresponding to each combination of
+   // block, FEE, FPGA and signal type in raw data, so that the detector and signal
+   // corresponding to each data word can be found without looking up their names.
+   //
+   // Called the first time raw data is read, once the array has been built. The table is only
+   // rebuilt if the array is built again (Build()): it is not updated if detectors or their
+   // signals are added or removed by any other means afterwards.
+
+   fRawDataLinkBlocks = 0;
+   TIter next(GetDetectors());
+   TObject* obj;
+   while ((obj = next())) {
+      KVFAZIADetector* det = dynamic_cast<KVFAZIADetector*>(obj);
+      if (det && det->GetBlockNumber() >= fRawDataLinkBlocks) fRawDataLinkBlocks = det->GetBlockNumber() + 1;
+   }
+   fRawDataLinks.assign(fRawDataLinkBlocks * 8 * 2 * 6, RawDataLink{nullptr, nullptr});
+   for (int blk = 0; blk < fRawDataLinkBlocks; ++blk) {
+      for (int fee = 0; fee < 8; ++fee) {
+         for (int fpga = 0; fpga < 2; ++fpga) {
+            int qua = fQuartet[fee][fpga];
+            int tel = fTelescope[fee][fpga];
+            for (int sig = 0; sig < 6; ++sig) {
+               RawDataLink& link = fRawDataLinks[((blk * 8 + fee) * 2 + fpga) * 6 + sig];
+               link.fDetector = (KVFAZIADetector*)GetDetector(Form("%s-%d", FzDetector_str[sig], 100 * blk + 10 * qua + tel));
+               if (link.fDetector) link.fSignal = link.fDetector->GetSignal(GetSignalName(blk, qua, tel, sig));
+            }
+         }
+      }
+   }
+}
+
+void KVFAZIA::InitialisePSA()
+{
+   // Start worker threads for parallel PSA if required by (possibly dataset-dependent) variable
+   //
+   //    FAZIA.PSA.NumberOfThreads
+   //
+   // (see class description). Called the first time raw data is read.
+
+   fPSANumberOfThreads = (Int_t)GetDataSetEnv(fDataSet, "FAZIA.PSA.NumberOfThreads", 0.);
+   if (fPSANumberOfThreads > 0) {
+#ifdef WITH_CPP11
+#ifdef USING_ROOT6
+      ROOT::EnableThreadSafety();
+#endif
+      fPSAThreadPool = new KVThreadPool(fPSANumberOfThreads);
+      Info("InitialisePSA", "PSA of signals will be performed in parallel using %u threads", fPSAThreadPool->GetNumberOfThreads());
+#else
+      Warning("InitialisePSA", "Parallel PSA requires C++11: signals will be treated sequentially");
+#endif
+   }
+}
+
+void KVFAZIA::PerformPSA()
+{
+   // Perform pulse shape analysis of all signals read in the current event,
+   // distributing the signals between the worker threads.
+   // As in KVFAZIADetector::Fired(), the end line of each signal is computed before its PSA.
+   // Each signal is treated only once, even if its samples were read more than once in the event.
+   // The time spent treating each signal is added to the total for its type.
+
+#ifdef WITH_CPP11
+   fPSASignalTime.assign(fPSASignals.size(), 0.);
+   std::unordered_set<KVSignal*> submitted;
+   for (size_t i = 0; i < fPSASignals.size(); ++i) {
+      KVSignal* sig = fPSASignals[i];
+      if (!submitted.insert(sig).second) {
+         fPSASignalTypes[i] = -1;
+         continue;
+      }
+      Double_t* time = &fPSASignalTime[i];
+      fPSAThreadPool->Submit([sig, time]() {
+         auto start = std::chrono::steady_clock::now();
+         sig->ComputeEndLine();
+         sig->TreateSignal();
+         *time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      });
+   }
+   fPSAThreadPool->Wait();
+   for (size_t i = 0; i < fPSASignals.size(); ++i) {
+      Int_t type = fPSASignalTypes[i];
+      if (type >= 0 && type < KVSignal::kUNKDT) {
+         fPSATime[type] += fPSASignalTime[i];
+         ++fPSACount[type];
+      }
+   }
+#endif
+}
+
+void KVFAZIA::PrintPSATiming() const
+{
+   // Print total and mean time spent in parallel PSA for each type of signal
+
+   if (!IsParallelPSA()) {
+      Info("PrintPSATiming", "Parallel PSA is not enabled (see FAZIA.PSA.NumberOfThreads)");
+      return;
+   }
+   Double_t total = 0;
+   for (int i = 0; i < KVSignal::kUNKDT; ++i) total += fPSATime[i];
+   printf("PSA timing (%d threads):\n", fPSANumberOfThreads);
+   for (int i = 0; i < KVSignal::kUNKDT; ++i) {
+      if (!fPSACount[i]) continue;
+      printf("   %-4s : %12llu signals  %10.3f s  (%6.2f us/signal, %5.1f %%)\n", FzDataType_str[i], fPSACount[i], fPSATime[i],
+             1.e6 * fPSATime[i] / fPSACount[i], (total > 0 ? 100.*fPSATime[i] / total : 0.));
+   }
+}
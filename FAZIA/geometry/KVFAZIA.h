@@ -9,12 +9,15 @@
 #include <KVGeoImport.h>
 #include <KVEnv.h>
 #include <KVSignal.h>
+#include <vector>
 
 #if ROOT_VERSION_CODE <= ROOT_VERSION(5,32,0)
 #include "TGeoMatrix.h"
 #endif
 
 class KVDetectorEvent;
+class KVFAZIADetector;
+class KVThreadPool;
 #ifdef WITH_PROTOBUF
 #ifndef __CINT__
 namespace DAQ {
@@ -27,6 +30,20 @@ namespace DAQ {
   \class KVFAZIA
   \ingroup FAZIAGeo
   \brief Description of a FAZIA detector geometry
+
+  ### Parallel pulse shape analysis
+  When raw data is read, pulse shape analysis (KVSignal::TreateSignal()) is normally performed
+  for each signal when it is needed during event reconstruction, one signal after the other.
+  As signals are independent, they can instead all be treated as soon as each event has been read,
+  concurrently by a pool of worker threads. This is enabled by giving a number of threads > 0
+  for the (possibly dataset-dependent) variable
+
+~~~~
+FAZIA.PSA.NumberOfThreads: 4
+~~~~
+
+  The time spent treating each type of signal (QH1, I1, QL1, Q2, I2, Q3) is accumulated and can be
+  printed with PrintPSATiming().
  */
 class KVFAZIA : public KVMultiDetArray {
 protected:
@@ -51,6 +68,33 @@ protected:
    int fQuartet[8][2];//! quartet number from #FEE and #FPGA
    int fTelescope[8][2];//! telescope number from #FEE and #FPGA
 
+   void set_global_pointers();
+
+   // detector and signal corresponding to each combination of block, FEE, FPGA and signal type in raw data
+   struct RawDataLink {
+      KVFAZIADetector* fDetector;
+      KVSignal* fSignal;
+   };
+   std::vector<RawDataLink> fRawDataLinks;//! [block][fee][fpga][signal type] (see BuildRawDataLinks)
+   Int_t fRawDataLinkBlocks;//! number of blocks in fRawDataLinks (-1 if not built yet)
+   void BuildRawDataLinks();
+   std::vector<KVSignal*> fPSASignals;//! signals read in current event (for parallel PSA)
+   std::vector<Int_t> fPSASignalTypes;//! type of each signal in fPSASignals (see KVSignal::SignalType)
+   std::vector<Double_t> fPSASignalTime;//! time spent treating each signal in fPSASignals
+   KVThreadPool* fPSAThreadPool;//! worker threads for parallel PSA
+   Int_t fPSANumberOfThreads;//! number of threads for parallel PSA (-1 if not yet initialised)
+   Double_t fPSATime[KVSignal::kUNKDT];//! total time spent treating each type of signal [s]
+   ULong64_t fPSACount[KVSignal::kUNKDT];//! total number of signals treated for each type
+   void InitialisePSA();
+   void PerformPSA();
+
+   const RawDataLink* GetRawDataLink(Int_t blk, Int_t fee, Int_t fpga, Int_t sig) const
+   {
+      // Return detector & signal corresponding to given raw data indices, or nullptr if out of range
+      if (blk < 0 || blk >= fRawDataLinkBlocks || fee < 0 || fee > 7 || fpga < 0 || fpga > 1 || sig < 0 || sig > 5) return nullptr;
+      return &fRawDataLinks[((blk * 8 + fee) * 2 + fpga) * 6 + sig];
+   }
+
    // values of trapezoidal filter rise time set in the fpgas defined in .kvrootrc
    Double_t fQH1risetime;
    Double_t fQ2risetime;
@@ -128,6 +172,23 @@ public:
    void FillDetectorList(KVReconstructedNucleus* rnuc, KVHashList* DetList, const KVString& DetNames);
 
    KVGroupReconstructor* GetReconstructorForGroup(const KVGroup*) const;
+
+   Bool_t IsParallelPSA() const
+   {
+      // kTRUE if PSA of all signals is performed concurrently after reading each event
+      return fPSAThreadPool != nullptr;
+   }
+   Double_t GetPSATime(Int_t type) const
+   {
+      // Total time [s] spent in parallel PSA of signals of given type (see KVSignal::SignalType)
+      return (type >= 0 && type < KVSignal::kUNKDT) ? fPSATime[type] : 0.;
+   }
+   ULong64_t GetPSACount(Int_t type) const
+   {
+      // Total number of signals of given type (see KVSignal::SignalType) treated by parallel PSA
+      return (type >= 0 && type < KVSignal::kUNKDT) ? fPSACount[type] : 0;
+   }
+   void PrintPSATiming() const;
    Double_t GetSetupParameter(const Char_t* parname);
 
    ClassDef(KVFAZIA, 1) //Base class for description of the FAZIA set up
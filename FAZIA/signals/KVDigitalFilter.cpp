@@ -53,6 +53,21 @@
 //     void ApplyTo(float  *data, const int N, int reverse=0) const;    //
 //     void ApplyTo(int    *data, const int N, int reverse=0) const;    //
 //                                                                      //
+//   // Apply it to many signals with the same length at once          //
+//   // (vectorised over signals):                                      //
+//     void ApplyToBatch(float *data, const int NSignals,               //
+//                       const int NSamples, int reverse=0) const;      //
+//     void ApplyToBatch(const std::vector<KVSignal*>&, int reverse=0); //
+//                                                                      //
+//   // Chebyshev filter as a cascade of second-order sections          //
+//auto stages=KVDigitalFilter::BuildChebyshevBiquads(10,0,0.5,6,10);   //
+//   for (auto& f : stages) f.ApplyTo( &s );                            //
+//                                                                      //
+//   // Filters use vectorisable kernels with double precision          //
+//   // intermediate results. The original scalar implementation (long  //
+//   // double precision) can be used instead with                      //
+//   KVDigitalFilter::SetUseScalarKernels();                            //
+//                                                                      //
 //   // Combine two  filters                                            //
 //KVDigitalFilter rc=KVDigitalFilter::BuildRCLowPass( 2, 10 );                   //
 //KVDigitalFilter cr=KVDigitalFilter::BuildRCHighPass( 2, 10 );                  //
@@ -76,6 +91,8 @@
 //                                                                      //
 //////////////////////////////////////////////////////////////////////////
 #include "KVDigitalFilter.h"
+#include <vector>
+#include <algorithm>
 #define DUEPI 6.28318530717958623
 #define    PI (DUEPI/2.)
 
@@ -83,6 +100,87 @@
 
 ClassImp(KVDigitalFilter);
 
+Bool_t KVDigitalFilter::fgScalarKernels = kFALSE;
+
+namespace {
+   template<typename T>
+   std::vector<T>& work_buffer(int nsamples, int which = 0)
+   {
+      // Buffers for intermediate results of ApplyTo/FIRApplyTo, reused from one call to the next.
+      // One set per thread, as the same filter may be applied to different signals in parallel.
+      thread_local std::vector<T> buffer[2];
+      if ((int)buffer[which].size() < nsamples) buffer[which].resize(nsamples);
+      return buffer[which];
+   }
+
+   template<typename T>
+   void filter_direct(const double* a, const double* b, int ncoeff, bool recursive, T* data, int nsamples)
+   {
+      // Vectorisable version of the filters applied by ApplyTo (recursive=true) and
+      // FIRApplyTo (recursive=false), with intermediate results in double precision.
+      //
+      // The x-part (a coefficients) is computed for all samples at once, one coefficient
+      // at a time: the loops over samples have no dependencies and are vectorised by the
+      // compiler. Only the y-part (b coefficients) remains in a sequential loop, which is
+      // written out explicitly for first and second order filters (RC filters, biquads).
+
+      double* y = work_buffer<double>(nsamples).data();
+      for (int i = 0; i < nsamples; i++) y[i] = a[0] * data[i];
+      for (int k = 1; k < ncoeff; k++) {
+         const double ak = a[k];
+         if (ak == 0) continue;
+         for (int i = k; i < nsamples; i++) y[i] += ak * data[i - k];
+      }
+      if (recursive) {
+         switch (ncoeff) {
+            case 0:
+            case 1:
+               break;
+            case 2: {
+               const double b1 = b[1];
+               for (int i = 1; i < nsamples; i++) y[i] += b1 * y[i - 1];
+               break;
+            }
+            case 3: {
+               const double b1 = b[1], b2 = b[2];
+               if (nsamples > 1) y[1] += b1 * y[0];
+               for (int i = 2; i < nsamples; i++) y[i] += b1 * y[i - 1] + b2 * y[i - 2];
+               break;
+            }
+            default:
+               for (int i = 1; i < nsamples; i++) {
+                  double yb = 0;
+                  for (int k = 1; k < ncoeff && k <= i; k++) yb += b[k] * y[i - k];
+                  y[i] += yb;
+               }
+         }
+      }
+      for (int i = 0; i < nsamples; i++) data[i] = (T)y[i];
+   }
+
+   template<typename T>
+   void filter_fast(const double* a, const double* b, int ncoeff, bool recursive, T* data, int nsamples, int reverse)
+   {
+      // reverse filtering is the same as direct filtering of the time-reversed signal
+      switch (reverse) {
+         case 0:
+            filter_direct(a, b, ncoeff, recursive, data, nsamples);
+            break;
+         case 1:
+            std::reverse(data, data + nsamples);
+            filter_direct(a, b, ncoeff, recursive, data, nsamples);
+            std::reverse(data, data + nsamples);
+            break;
+         case -1:
+            filter_fast(a, b, ncoeff, recursive, data, nsamples, 0);
+            filter_fast(a, b, ncoeff, recursive, data, nsamples, 1);
+            break;
+         default:
+            printf("ERROR in %s: reverse=%d not supported\n", __PRETTY_FUNCTION__, reverse);
+      }
+   }
+}
+
 //============================================
 KVDigitalFilter KVDigitalFilter::BuildRCLowPass(const double& tau_usec, const double& tau_clk)
 {
@@ -145,6 +243,42 @@ KVDigitalFilter KVDigitalFilter::BuildChebyshev(const double& freq_cutoff_mhz, i
    return filter;
 }
 //============================================
+std::vector<KVDigitalFilter> KVDigitalFilter::BuildChebyshevBiquads(const double& freq_cutoff_mhz, int is_highpass,
+      const double&  percent_ripple, int npoles,
+      const double& tau_clk)
+{
+   // Same filter as BuildChebyshev(), given as a cascade of npoles/2 second order
+   // sections (biquads) which have to be applied one after the other, e.g.
+   //
+   //    for (auto& f : stages) f.ApplyTo(&signal);
+   //
+   // Each section is normalised to unit gain (at 0 frequency for a low-pass, at Nyquist frequency
+   // for a high-pass), so that the gain of the cascade is the same as with BuildChebyshev().
+   // Contrary to the single high-order filter, the cascade remains numerically stable
+   // for any number of poles, and each section can use the fast path for second order filters.
+
+   std::vector<KVDigitalFilter> stages;
+   const double fc = freq_cutoff_mhz * (tau_clk / 1e3);
+   const double np = npoles;
+   for (int p = 1; p <= np / 2; p++) {
+      double a0, a1, a2, b1, b2;
+      ComputeChebyshevCoeffs_serv(fc, is_highpass, percent_ripple, np, p, &a0, &a1, &a2, &b1, &b2);
+      KVDigitalFilter stage(tau_clk);
+      stage.Alloc(3);
+      stage.a[0] = a0;
+      stage.a[1] = a1;
+      stage.a[2] = a2;
+      stage.b[1] = b1;
+      stage.b[2] = b2;
+      double sign = (is_highpass ? -1. : 1.);
+      double sa = a0 + sign * a1 + a2;
+      double sb = sign * b1 + b2;
+      stage.Multiply((1. - sb) / sa);
+      stages.push_back(stage);
+   }
+   return stages;
+}
+//============================================
 
 void KVDigitalFilter::ComputeChebyshevCoeffs_serv(const double& fc, const double&   lh,
       const double& pr, const double&   np,
@@ -380,8 +514,15 @@ void KVDigitalFilter::ApplyTo(double* datax, const int NSamples, int reverse) co
 {
    // Copiato +- da KVSignal.cxx
    // Diversa la convenzione per a0 b0!
+   //
+   // Unless SetUseScalarKernels() has been called, the vectorised implementation is used.
+
+   if (!fgScalarKernels) {
+      filter_fast(a, b, Ncoeff, true, datax, NSamples, reverse);
+      return;
+   }
 
-   std::vector<long double> datay(NSamples);
+   std::vector<long double>& datay = work_buffer<long double>(NSamples);
    int i = 0, k = 0;
    switch (reverse) {
       case 0:// direct
@@ -429,8 +570,15 @@ void KVDigitalFilter::ApplyTo(float* datax, const int NSamples, int reverse) con
 {
    // Copiato +- da KVSignal.cxx
    // Diversa la convenzione per a0 b0!
+   //
+   // Unless SetUseScalarKernels() has been called, the vectorised implementation is used.
 
-   std::vector<long double> datay(NSamples);
+   if (!fgScalarKernels) {
+      filter_fast(a, b, Ncoeff, true, datax, NSamples, reverse);
+      return;
+   }
+
+   std::vector<long double>& datay = work_buffer<long double>(NSamples);
    int i = 0, k = 0;
    switch (reverse) {
       case 0:// direct
@@ -476,8 +624,15 @@ void KVDigitalFilter::ApplyTo(int* datax, const int NSamples, int reverse) const
 {
    // Copiato +- da KVSignal.cxx
    // Diversa la convenzione per a0 b0!
+   //
+   // Unless SetUseScalarKernels() has been called, the vectorised implementation is used.
+
+   if (!fgScalarKernels) {
+      filter_fast(a, b, Ncoeff, true, datax, NSamples, reverse);
+      return;
+   }
 
-   std::vector<long double> datay(NSamples);
+   std::vector<long double>& datay = work_buffer<long double>(NSamples);
    int i = 0, k = 0;
    switch (reverse) {
       case 0:// direct
@@ -963,8 +1118,15 @@ void KVDigitalFilter::FIRApplyTo(float* datax, const int NSamples, int reverse)
 {
    // Copiato +- da KVSignal.cxx
    // Diversa la convenzione per a0 b0!
+   //
+   // Unless SetUseScalarKernels() has been called, the vectorised implementation is used.
+
+   if (!fgScalarKernels) {
+      filter_fast(a, b, Ncoeff, false, datax, NSamples, reverse);
+      return;
+   }
 
-   std::vector<long double> datay(NSamples);
+   std::vector<long double>& datay = work_buffer<long double>(NSamples);
    int i = 0, k = 0;
    switch (reverse) {
       case 0:// direct
@@ -1008,8 +1170,15 @@ void KVDigitalFilter::FIRApplyTo(double* datax, const int NSamples, int reverse)
 {
    // Copiato +- da KVSignal.cxx
    // Diversa la convenzione per a0 b0!
+   //
+   // Unless SetUseScalarKernels() has been called, the vectorised implementation is used.
 
-   std::vector<long double> datay(NSamples);
+   if (!fgScalarKernels) {
+      filter_fast(a, b, Ncoeff, false, datax, NSamples, reverse);
+      return;
+   }
+
+   std::vector<long double>& datay = work_buffer<long double>(NSamples);
    int i = 0, k = 0;
    switch (reverse) {
       case 0:// direct
@@ -1051,3 +1220,81 @@ void KVDigitalFilter::FIRApplyTo(double* datax, const int NSamples, int reverse)
    for (int i = 0; i < NSamples; i++)
       datax[i] = (double)datay[i];
 }
+//=============================================
+void KVDigitalFilter::ApplyToBatch(float* data, const int NSignals, const int NSamples, int reverse) const
+{
+   // Apply filter to NSignals signals with the same number of samples NSamples, stored one after
+   // the other in data (i.e. sample i of signal n is data[n*NSamples+i]).
+   //
+   // The signals are filtered all at once: for each sample, the same operations are performed for
+   // all signals, which is vectorised by the compiler even for the recursive part of the filter.
+   // Results are the same (within double precision rounding) as calling ApplyTo() for each signal.
+
+   if (fgScalarKernels || NSignals < 2) {
+      for (int n = 0; n < NSignals; n++) ApplyTo(data + n * NSamples, NSamples, reverse);
+      return;
+   }
+   if (reverse == -1) {
+      ApplyToBatch(data, NSignals, NSamples, 0);
+      ApplyToBatch(data, NSignals, NSamples, 1);
+      return;
+   }
+   if (reverse != 0 && reverse != 1) {
+      printf("ERROR in %s: reverse=%d not supported\n", __PRETTY_FUNCTION__, reverse);
+      return;
+   }
+
+   // samples are reordered so that x[i*NSignals+n] is sample i (counted from the end if reverse=1) of signal n
+   const int total = NSignals * NSamples;
+   double* x = work_buffer<double>(total, 0).data();
+   double* y = work_buffer<double>(total, 1).data();
+   for (int n = 0; n < NSignals; n++) {
+      const float* sig = data + n * NSamples;
+      for (int i = 0; i < NSamples; i++) x[i * NSignals + n] = sig[reverse ? NSamples - 1 - i : i];
+   }
+
+   for (int i = 0; i < NSamples; i++) {
+      double* yi = y + i * NSignals;
+      const double* xi = x + i * NSignals;
+      for (int n = 0; n < NSignals; n++) yi[n] = a[0] * xi[n];
+      for (int k = 1; k < Ncoeff && k <= i; k++) {
+         const double ak = a[k], bk = b[k];
+         const double* xk = x + (i - k) * NSignals;
+         const double* yk = y + (i - k) * NSignals;
+         for (int n = 0; n < NSignals; n++) yi[n] += ak * xk[n] + bk * yk[n];
+      }
+   }
+
+   for (int n = 0; n < NSignals; n++) {
+      float* sig = data + n * NSamples;
+      for (int i = 0; i < NSamples; i++) sig[reverse ? NSamples - 1 - i : i] = (float)y[i * NSignals + n];
+   }
+}
+//=============================================
+void KVDigitalFilter::ApplyToBatch(const std::vector<KVSignal*>& signals, int reverse) const
+{
+   // Apply filter to all signals at once (see ApplyToBatch(float*,int,int,int)).
+   // All signals must have the same number of samples and channel width (tau_clk of filter).
+
+   if (signals.empty()) return;
+   const int NSamples = signals[0]->GetNSamples();
+   for (auto s : signals) {
+      if (fabs(s->GetChannelWidth() - tau_clk) > 1e-6) {
+         printf("ERROR in %s: different tau_clk! %e != %e\n",
+                __PRETTY_FUNCTION__, s->GetChannelWidth(),  tau_clk);
+         return;
+      }
+      if (s->GetNSamples() != NSamples) {
+         printf("ERROR in %s: signals have different numbers of samples (%d != %d)\n",
+                __PRETTY_FUNCTION__, s->GetNSamples(), NSamples);
+         return;
+      }
+   }
+   const int NSignals = signals.size();
+   float* data = work_buffer<float>(NSignals * NSamples).data();
+   for (int n = 0; n < NSignals; n++)
+      std::copy(signals[n]->GetArray()->GetArray(), signals[n]->GetArray()->GetArray() + NSamples, data + n * NSamples);
+   ApplyToBatch(data, NSignals, NSamples, reverse);
+   for (int n = 0; n < NSignals; n++)
+      std::copy(data + n * NSamples, data + (n + 1) * NSamples, signals[n]->GetArray()->GetArray());
+}
@@ -8,6 +8,7 @@ classes copied from FClasses of INFN-Firenze
 #include <stdlib.h>
 #include <KVBase.h>
 #include <KVSignal.h>
+#include <vector>
 
 #ifndef __KVDigitalFilter_H
 #define __KVDigitalFilter_H
@@ -42,6 +43,9 @@ public:
    static    KVDigitalFilter BuildChebyshev(const double& freq_cutoff_mhz, int is_highpass,
          const double& percent_ripple, int npoles,
          const double& tau_clk);
+   static    std::vector<KVDigitalFilter> BuildChebyshevBiquads(const double& freq_cutoff_mhz, int is_highpass,
+         const double& percent_ripple, int npoles,
+         const double& tau_clk);
    static    KVDigitalFilter BuildUnity(const double&  tau_clk);
    static    KVDigitalFilter BuildIntegrator(const double& tau_clk);
 
@@ -152,6 +156,18 @@ public:
       }
       FIRApplyTo(s->GetArray()->GetArray(), s->GetNSamples(), reverse);
    }
+   void ApplyToBatch(float* data, const int NSignals, const int NSamples, int reverse = 0) const;
+   void ApplyToBatch(const std::vector<KVSignal*>& signals, int reverse = 0) const;
+   static void SetUseScalarKernels(Bool_t yes = kTRUE)
+   {
+      // Use original (non-vectorised, long double precision) implementation of filters.
+      // This is a global setting, not to be changed while filters are being applied.
+      fgScalarKernels = yes;
+   }
+   static Bool_t UseScalarKernels()
+   {
+      return fgScalarKernels;
+   }
    void Alloc(const int Ncoeff);
    void Azzera();
    int ReadMatlabFIR(char* filecoeff);
@@ -177,6 +193,8 @@ protected:
 
    double tau_clk;
 
+   static Bool_t fgScalarKernels; // use original scalar implementation of filters
+
    ClassDef(KVDigitalFilter, 1)   // FIASCO: Class for digital filtering
 };
 
@@ -13,6 +13,8 @@
 #include "TMatrixF.h"
 #include "TClass.h"
 
+#include <algorithm>
+
 #define LOG2 (double)6.93147180559945286e-01
 # define M_PI     3.14159265358979323846  /* pi */
 
@@ -34,6 +36,16 @@ ClassImp(KVSignal)
 // SIGNAL TYPE
 // ===========
 // KVSignal::GetType() returns one of: "QH1", "QL1", "Q2", "Q3", "I1", "I2"
+//
+// SAMPLES
+// =======
+// The TGraph part of the signal holds the raw samples as read from data (and is what is
+// written to file or drawn). All processing methods (shapers, filters, interpolation, FFT,
+// etc.) work in place on the array of float samples returned by GetArray(), with an implicit
+// uniform time axis (sample i is at time i*fChannelWidthInt): the TGraph is only updated by
+// an explicit call to ApplyModifications(). Temporary arrays needed by these methods are
+// taken from a scratch buffer belonging to each signal, which is reused from one waveform to
+// the next instead of being allocated for each call.
 ////////////////////////////////////////////////////////////////////////////////
 
 void KVSignal::init()
@@ -157,24 +169,64 @@ void KVSignal::SetData(Int_t nn, Double_t* xx, Double_t* yy)
       Info("SetData", "called with points number=%d", nn);
       return;
    }
-   Int_t np = 0;
-   fYmin = fYmax = yy[np];
-   SetPoint(np, xx[np], yy[np]);
-   for (np = 1; np < nn; np += 1) {
-      SetPoint(np, xx[np], yy[np]);
+   std::copy(xx, xx + nn, fX);
+   std::copy(yy, yy + nn, fY);
+   fYmin = fYmax = yy[0];
+   for (Int_t np = 1; np < nn; np += 1) {
       if (yy[np] < fYmin) fYmin = yy[np];
       if (yy[np] > fYmax) fYmax = yy[np];
    }
+   if (fHistogram) {
+      // as in TGraph::SetPoint
+      delete fHistogram;
+      fHistogram = nullptr;
+   }
    SetADCData();
 }
 
+//________________________________________________________________
+void KVSignal::SetADCSamples(Int_t nn, const Int_t* samples, Bool_t sign_extend_14bit)
+{
+   // Set signal directly from an array of raw samples, sample number i being placed at x=i.
+   // This is equivalent to filling a TGraph with the samples and calling SetData(), but
+   // without any intermediate copy.
+   //
+   // If sign_extend_14bit=kTRUE, samples are 14-bit signed values from FAZIA raw data:
+   // any sample greater than 8191 is negative.
+
+   Set(nn);
+   if (nn == 0) {
+      Info("SetADCSamples", "called with points number=%d", nn);
+      return;
+   }
+   fChannelWidthInt = fChannelWidth;
+   Float_t* adc = fAdc.GetArray();
+   for (Int_t np = 0; np < nn; ++np) {
+      Int_t supp = samples[np];
+      if (sign_extend_14bit && supp > 8191) supp |= 0xFFFFC000;
+      fX[np] = np;
+      fY[np] = supp;
+      adc[np] = supp;
+   }
+   fYmin = fYmax = fY[0];
+   for (Int_t np = 1; np < nn; ++np) {
+      if (fY[np] < fYmin) fYmin = fY[np];
+      if (fY[np] > fYmax) fYmax = fY[np];
+   }
+   if (fHistogram) {
+      // as in TGraph::SetPoint
+      delete fHistogram;
+      fHistogram = nullptr;
+   }
+}
+
 //________________________________________________________________
 void KVSignal::SetADCData()
 {
 
    fChannelWidthInt = fChannelWidth;
    fAdc.Set(GetN());
-   for (int ii = 0; ii < GetN(); ii++) fAdc.AddAt(fY[ii], ii);
+   std::copy(fY, fY + GetN(), fAdc.GetArray());
 
 }
 
@@ -349,27 +401,21 @@ void KVSignal::Print(Option_t*) const
 
 void KVSignal::ComputeRawAmplitude(void)
 {
-   Double_t xx, yy;
-   Int_t np = 0;
-   GetPoint(np++, xx, yy);
-   fYmin = fYmax = yy;
+   if (!GetN()) return;
+   fYmin = fYmax = fY[0];
 
-   for (np = 1; np < GetN(); np += 1) {
-      GetPoint(np, xx, yy);
-      if (yy < fYmin) fYmin = yy;
-      if (yy > fYmax) fYmax = yy;
+   for (Int_t np = 1; np < GetN(); np += 1) {
+      if (fY[np] < fYmin) fYmin = fY[np];
+      if (fY[np] > fYmax) fYmax = fY[np];
    }
 }
 //________________________________________________________________
 
 Bool_t KVSignal::TestWidth() const
 {
-   Double_t x0, x1, y0, y1;
+   if (GetN() < 2) return kFALSE;
 
-   GetPoint(0, x0, y0);
-   GetPoint(1, x1, y1);
-
-   Double_t actual_width = x1 - x0;
+   Double_t actual_width = fX[1] - fX[0];
    return ((actual_width == GetChannelWidth()));
 }
 
@@ -377,10 +423,11 @@ Bool_t KVSignal::TestWidth() const
 
 void KVSignal::ChangeChannelWidth(Double_t newwidth)
 {
-   Double_t xx, yy;
-   for (Int_t ii = 0; ii < GetN(); ii += 1) {
-      GetPoint(ii, xx, yy);
-      SetPoint(ii, ii * newwidth, yy);
+   for (Int_t ii = 0; ii < GetN(); ii += 1) fX[ii] = ii * newwidth;
+   if (fHistogram) {
+      // as in TGraph::SetPoint
+      delete fHistogram;
+      fHistogram = nullptr;
    }
 }
 
@@ -477,10 +524,7 @@ void KVSignal::RemoveBaseLine()
 
 void KVSignal::BuildReverseTimeSignal()
 {
-   TArrayF copy(fAdc);
-   Int_t np = fAdc.GetSize();
-
-   for (int i = 0; i < np; i++) fAdc.AddAt(copy.GetAt(np - i - 1), i);
+   std::reverse(fAdc.GetArray(), fAdc.GetArray() + fAdc.GetSize());
 }
 
 Double_t KVSignal::ComputeAmplitude()
@@ -674,20 +718,26 @@ void KVSignal::FIR_ApplyTrapezoidal(double trise, double tflat) // trise=sqrt(12
 
 //    Info("FIR_ApplyTrapezoidal","irise %d iflat %d chw %lf",irise,iflat, fChannelWidth);
 
-   TArrayF sorig(fAdc);
    float* data  = fAdc.GetArray();
-   float* datao = sorig.GetArray();
-   int N        = sorig.GetSize();
+   int N        = fAdc.GetSize();
+   if (!N) return;
+   double* diff = GetWorkBuffer(N);
 
    // 1
-   for (int i = irise; i < N; i++)         data[i] -= datao[i - irise];
-   for (int i = irise + iflat; i < N; i++)   data[i] -= datao[i - irise - iflat];
-   for (int i = 2 * irise + iflat; i < N; i++) data[i] += datao[i - 2 * irise - iflat];
+   // differences of the original samples are computed in the scratch buffer (with float precision,
+   // as if done in place), in separate loops without branches which can be vectorised
+   const int i1 = TMath::Min(irise, N);
+   const int i2 = TMath::Min(irise + iflat, N);
+   const int i3 = TMath::Min(2 * irise + iflat, N);
+   for (int i = 0; i < i1; i++)  diff[i] = data[i];
+   for (int i = i1; i < i2; i++) diff[i] = data[i] - data[i - irise];
+   for (int i = i2; i < i3; i++) diff[i] = data[i] - data[i - irise] - data[i - irise - iflat];
+   for (int i = i3; i < N; i++)  diff[i] = data[i] - data[i - irise] - data[i - irise - iflat] + data[i - 2 * irise - iflat];
 
    // normalizzazione
    double amp = 1e3 * trise / fChannelWidth;
-   data[0] /=  amp;
-   for (int i = 1; i < N; i++) data[i] = data[i] / amp + data[i - 1];
+   data[0] = diff[0] / amp;
+   for (int i = 1; i < N; i++) data[i] = diff[i] / amp + data[i - 1];
 }
 
 
@@ -875,22 +925,11 @@ int KVSignal::FFT(unsigned int p_nSamples, bool p_bInverseTransform,
 int KVSignal::FFT(bool p_bInverseTransform, double* p_lpRealOut, double* p_lpImagOut)
 {
    // returns the lenght of FFT( power of 2)
-   static double* buffer = NULL;
-   static int bufflen = 0;
    int NSA = fAdc.GetSize();
    int ibits = (int)ceil(log((double)NSA) / LOG2);
    NSA = 1 << ibits;
 
-   if (buffer != NULL && bufflen < NSA) {
-      delete [] buffer;
-      buffer = NULL;
-   }
-
-
-   if (buffer == NULL) {
-      bufflen = NSA;
-      buffer = new double [NSA];
-   }
+   double* buffer = GetWorkBuffer(NSA);
    unsigned int N = fAdc.GetSize();
    float* data = fAdc.GetArray();
    for (unsigned int i = 0; i < N; i++)
@@ -1029,21 +1068,26 @@ double KVSignal::GetDataCubicSpline(double t)
 
    float* data = fAdc.GetArray();
    int N = fAdc.GetSize();
-   int dimensione = 18; //dimensione della matrice dei campioni.!!!!deve essere pari!!!!
+   const int dimensione = 18; //dimensione della matrice dei campioni.!!!!deve essere pari!!!!
    float cm1, cNm1;
 
-
-   TMatrixD e(dimensione, dimensione);
-   TArrayD data_e(dimensione * dimensione);
-   for (int k = 0, i = 0; i < dimensione; i++) {
-      data_e[k] = 4.;
-      if ((k + 1) < pow(dimensione, 2)) data_e[k + 1] = 1.;
-      if ((k - 1) > 0)                 data_e[k - 1] = 1.;
-      k += dimensione + 1;
+   // the inverted matrix only depends on the channel width: it is computed once (per thread)
+   // and reused for all interpolated points of all signals with the same channel width
+   thread_local TMatrixD e(dimensione, dimensione);
+   thread_local Double_t e_width = -1;
+   if (h != e_width) {
+      TArrayD data_e(dimensione * dimensione);
+      for (int k = 0, i = 0; i < dimensione; i++) {
+         data_e[k] = 4.;
+         if ((k + 1) < pow(dimensione, 2)) data_e[k + 1] = 1.;
+         if ((k - 1) > 0)                 data_e[k - 1] = 1.;
+         k += dimensione + 1;
+      }
+      e.SetMatrixArray(data_e.GetArray());
+      e *= 1. / 6 / h;
+      e.Invert();
+      e_width = h;
    }
-   e.SetMatrixArray(data_e.GetArray());
-   e *= 1. / 6 / h;
-   e.Invert();
 
    double dati_b[] = { -1, 3, -3, 1, 3, -6, 3, 0, -3, 0, 3, 0, 1, 4, 1, 0};
    TMatrixD delta(4, 4, dati_b);
@@ -1108,16 +1152,13 @@ void KVSignal::BuildCubicSplineSignal(double taufinal)
    const double tau = fChannelWidth;
 
    fChannelWidthInt = taufinal;
-   TArrayF interpo;
-   interpo.Set((int)(Nsa * tau / taufinal));
-   int nlast = interpo.GetSize() - (int)(3 * tau / taufinal);
+   int ninterpo = (int)(Nsa * tau / taufinal);
+   int nlast = ninterpo - (int)(3 * tau / taufinal);
    if (nlast <= 0) return;
 
-   for (int i = 0; i < interpo.GetSize(); i++) interpo.AddAt(GetDataCubicSpline(i * taufinal), i);
-   fAdc.Set(0);
-   fAdc.Set(interpo.GetSize());
-   for (int i = 0; i < interpo.GetSize(); i++) fAdc.AddAt(interpo.At(i), i);
-   for (int i = nlast; i < interpo.GetSize(); i++) fAdc.AddAt(interpo.At(nlast), i);
+   double* interpo = GetWorkBuffer(ninterpo);
+   for (int i = 0; i < ninterpo; i++) interpo[i] = (float)GetDataCubicSpline(i * taufinal);
+   CopyWorkBufferToADC(ninterpo, nlast);
 
 }
 /***********************************************/
@@ -1135,16 +1176,13 @@ void KVSignal::BuildCubicSignal(double taufinal)
    const double tau = fChannelWidth;
 
    fChannelWidthInt = taufinal;
-   TArrayF interpo;
-   interpo.Set((int)(Nsa * tau / taufinal));
-   int nlast = interpo.GetSize() - (int)(3 * tau / taufinal);
+   int ninterpo = (int)(Nsa * tau / taufinal);
+   int nlast = ninterpo - (int)(3 * tau / taufinal);
    if (nlast <= 0) return;
 
-   for (int i = 0; i < interpo.GetSize(); i++) interpo.AddAt(GetDataInterCubic(i * taufinal), i);
-   fAdc.Set(0);
-   fAdc.Set(interpo.GetSize());
-   for (int i = 0; i < nlast; i++) fAdc.AddAt(interpo.At(i), i);
-   for (int i = nlast; i < interpo.GetSize(); i++) fAdc.AddAt(interpo.At(nlast), i);
+   double* interpo = GetWorkBuffer(ninterpo);
+   for (int i = 0; i < ninterpo && i <= nlast; i++) interpo[i] = (float)GetDataInterCubic(i * taufinal);
+   CopyWorkBufferToADC(ninterpo, nlast);
 
 }
 /***********************************************/
@@ -1159,22 +1197,21 @@ void KVSignal::BuildSmoothingSplineSignal(double taufinal, double l, int nbits)
    const int Nsa = fAdc.GetSize();
    const double tau = fChannelWidth;
 
+   // the coefficients only need the samples, not the TGraph points
    KVSignal coeff;
-   ApplyModifications(&coeff);
-   coeff.SetADCData();
+   coeff.SetChannelWidth(fChannelWidthInt);
+   coeff.fAdc = fAdc;
    if (coeff.FIR_ApplySmoothingSpline(l, nbits) != 0) return;
 
    fChannelWidthInt = taufinal;
-   TArrayF interpo;
-   interpo.Set((int)(Nsa * tau / taufinal));
-   int nlast = interpo.GetSize() - (int)(3 * tau);
+   int ninterpo = (int)(Nsa * tau / taufinal);
+   int nlast = ninterpo - (int)(3 * tau);
    if (nlast <= 0) return;
 
-   for (int i = 0; i < interpo.GetSize() - (int)(53 * tau / taufinal); i++) interpo.AddAt(coeff.GetDataSmoothingSplineLTI(i * taufinal), i);
-   fAdc.Set(0);
-   fAdc.Set(interpo.GetSize());
-   for (int i = 0; i < nlast; i++) fAdc.AddAt(interpo.At(i), i);
-   for (int i = nlast; i < interpo.GetSize(); i++) fAdc.AddAt(interpo.At(nlast), i);
+   double* interpo = GetWorkBuffer(ninterpo);
+   int ncalc = ninterpo - (int)(53 * tau / taufinal);
+   for (int i = 0; i < ninterpo; i++) interpo[i] = (i < ncalc ? (float)coeff.GetDataSmoothingSplineLTI(i * taufinal) : 0.);
+   CopyWorkBufferToADC(ninterpo, nlast);
 
 }
 /***********************************************/
@@ -1183,6 +1220,17 @@ void KVSignal::BuildSmoothingSplineSignal()
    BuildSmoothingSplineSignal(GetInterpolatedChannelWidth());
 }
 /***********************************************/
+void KVSignal::CopyWorkBufferToADC(Int_t n, Int_t nlast)
+{
+   // Replace samples with the n values of the scratch buffer filled by an interpolation method.
+   // Samples from nlast onwards are all set to the value of the buffer at nlast.
+
+   fAdc.Set(n);
+   float* data = fAdc.GetArray();
+   for (int i = 0; i < nlast; i++) data[i] = fWork[i];
+   for (int i = nlast; i < n; i++) data[i] = fWork[nlast];
+}
+/***********************************************/
 
 int KVSignal::FIR_ApplySmoothingSpline(double l, int nbits)
 {
@@ -1236,8 +1284,18 @@ int KVSignal::FIR_ApplySmoothingSpline(double l, int nbits)
       }
       while (fmax * pow(2, nfloat + 1) < 1);
    }
-   double* xvec = new double[2 * nmax + 1];
-   double* yvec = new double[2 * nmax + 1];
+   // coefficients go on the stack in the usual case nmax=50
+   // (the scratch buffer is used by FIR_ApplyRecursiveFilter)
+   double xfix[101], yfix[101];
+   std::vector<double> xdyn, ydyn;
+   double* xvec = xfix;
+   double* yvec = yfix;
+   if (2 * nmax + 1 > 101) {
+      xdyn.resize(2 * nmax + 1);
+      ydyn.resize(2 * nmax + 1);
+      xvec = xdyn.data();
+      yvec = ydyn.data();
+   }
    if (nbits > 2) {
       for (i = 0; i <= nmax; i++) {
          yvec[nmax + i] = yvec[nmax - i] = 0;
@@ -1252,8 +1310,6 @@ int KVSignal::FIR_ApplySmoothingSpline(double l, int nbits)
    }
    FIR_ApplyRecursiveFilter(0, 2 * nmax + 1, xvec, yvec, 0);
    ShiftLeft(nmax * fChannelWidth);
-   delete [] xvec;
-   delete [] yvec;
    return 0;
 }
 
@@ -1386,7 +1442,24 @@ void KVSignal::FIR_ApplyRecursiveFilter(double a0, int N, double* a, double* b,
 {
    // signal will be: y[n]=a0*x[n]+sum a[k] x[k] + sum b[k] y[k]
    int NSamples = fAdc.GetSize();
-   double* datay = new double[NSamples];
+   if (N == 1 && (reverse == 0 || reverse == 1)) {
+      // first order filters (RC filters of the semi-gaussian shaper): same operations as
+      // below, without the inner loops on coefficients or the intermediate array
+      float* data = fAdc.GetArray();
+      const double a1 = a[0], b1 = b[0];
+      double xprev = 0, yprev = 0;
+      for (int n = 0; n < NSamples; n++) {
+         const int i = (reverse ? NSamples - 1 - n : n);
+         const double x = data[i];
+         double y = a0 * x;
+         if (n) y += a1 * xprev + b1 * yprev;
+         xprev = x;
+         yprev = y;
+         data[i] = (float)y;
+      }
+      return;
+   }
+   double* datay = GetWorkBuffer(NSamples);
    float* datax = fAdc.GetArray();
    //    memset(datay, 0, NSamples*sizeof(float)); //azzero l'array.
    /*----------------------------------------------*/
@@ -1421,7 +1494,6 @@ void KVSignal::FIR_ApplyRecursiveFilter(double a0, int N, double* a, double* b,
       case -1: // bidirectional
          FIR_ApplyRecursiveFilter(a0, N, a, b, 0);
          FIR_ApplyRecursiveFilter(a0, N, a, b, 1);
-         delete [] datay;
          return;
       default:
          printf("ERROR in %s: reverse=%d not supported\n", __PRETTY_FUNCTION__, reverse);
@@ -1431,14 +1503,13 @@ void KVSignal::FIR_ApplyRecursiveFilter(double a0, int N, double* a, double* b,
    /// non con double! memcpy(datax, datay, NSamples*sizeof(float));
    for (int i = 0; i < NSamples; i++)
       datax[i] = (float)datay[i];
-   delete [] datay;
 }
 
 void KVSignal::FIR_ApplyMovingAverage(int npoints)  // causal moving average
 {
-   TArrayF sorig = fAdc;
    float* data = fAdc.GetArray();
-   float* datao = sorig.GetArray();
+   double* datao = GetWorkBuffer(GetNSamples());
+   std::copy(data, data + GetNSamples(), datao);
 
    for (int n = npoints; n < GetNSamples(); n++)
       data[n] = data[n - 1] + (datao[n] - datao[n - npoints]) / npoints;
@@ -1466,19 +1537,35 @@ void KVSignal::ApplyModifications(TGraph* newSignal, Int_t nsa)
 
    Int_t nn = fAdc.GetSize();
    if (nsa > 0 && nsa < nn) nn = nsa;
-   if (newSignal->InheritsFrom("KVSignal"))((KVSignal*)newSignal)->SetChannelWidth(fChannelWidthInt);
+   if (newSignal->InheritsFrom("KVSignal")) {
+      // fill arrays of TGraph directly: same result as SetPoint for each sample
+      KVSignal* sig = (KVSignal*)newSignal;
+      sig->SetChannelWidth(fChannelWidthInt);
+      if (sig->GetN() < nn) sig->TGraph::Set(nn);
+      for (int ii = 0; ii < nn; ii++) {
+         sig->fX[ii] = ii * fChannelWidthInt;
+         sig->fY[ii] = fAdc.At(ii);
+      }
+      if (sig->fHistogram) {
+         delete sig->fHistogram;
+         sig->fHistogram = nullptr;
+      }
+      return;
+   }
    for (int ii = 0; ii < nn; ii++) newSignal->SetPoint(ii, ii * fChannelWidthInt, fAdc.At(ii));
 }
 
 
 void KVSignal::Multiply(Double_t fact)
 {
-   for (int i = 0; i < fAdc.GetSize(); i++) fAdc.AddAt(fAdc.At(i)*fact, i);
+   float* data = fAdc.GetArray();
+   for (int i = 0; i < fAdc.GetSize(); i++) data[i] *= fact;
 }
 
 void KVSignal::Add(Double_t fact)
 {
-   for (int i = 0; i < fAdc.GetSize(); i++) fAdc.AddAt(fAdc.At(i) + fact, i);
+   float* data = fAdc.GetArray();
+   for (int i = 0; i < fAdc.GetSize(); i++) data[i] += fact;
 }
 
 /***************************************************************************/
@@ -7,6 +7,7 @@
 #include "TGraph.h"
 #include "TArrayF.h"
 #include "TH1F.h"
+#include <vector>
 
 class KVDetector;
 class KVDBParameterList;
@@ -34,6 +35,7 @@ protected:
    Int_t fFPGAOutputNumbers;  //!ASsociated FPGA energy outputs
 
    TArrayF fAdc;                    //! needed to use the psa methods copied from FClasses of Firenze
+   std::vector<Double_t> fWork;     //! scratch buffer reused by the processing methods
    //results of signal treatement
    Double_t fAmplitude;             // amplitude of the signal
    Double_t fRiseTime;              // rise time of the signal
@@ -69,6 +71,13 @@ protected:
    virtual void BuildSmoothingSplineSignal(); //Interpolazione mediante cubic spline
    void init();
    void TreateOldSignalName();
+   Double_t* GetWorkBuffer(Int_t n)
+   {
+      // return scratch buffer with at least n elements, reused from one call to the next
+      if ((Int_t)fWork.size() < n) fWork.resize(n);
+      return fWork.data();
+   }
+   void CopyWorkBufferToADC(Int_t n, Int_t nlast);
 
 public:
    KVSignal();
@@ -119,6 +128,7 @@ public:
 
    //operation on data arrays
    void SetData(Int_t nn, Double_t* xx, Double_t* yy);
+   void SetADCSamples(Int_t nn, const Int_t* samples, Bool_t sign_extend_14bit = kFALSE);
    virtual void Set(Int_t n);
    void SetADCData();
    TArrayF* GetArray()
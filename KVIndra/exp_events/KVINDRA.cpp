@@ -121,7 +121,13 @@ KVINDRA::~KVINDRA()
    }
    fPhoswich = 0;
    if (fSelecteur) delete fSelecteur;
-   gIndra = 0;
+   if (gIndra == this) gIndra = 0;
+}
+
+void KVINDRA::set_global_pointers()
+{
+   // Make gIndra point to this array (after making a working copy)
+   gIndra = this;
 }
 
 //_________________________________________________________________________________
@@ -110,6 +110,7 @@ protected:
    void SetNamesOfIDTelescopes() const;
 
    void PerformClosedROOTGeometryOperations();
+   void set_global_pointers();
 #ifdef WITH_MFM
    Bool_t handle_raw_data_event_mfmframe_ebyedat(const MFMEbyedatFrame&);
 #endif
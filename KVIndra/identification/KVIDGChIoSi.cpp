@@ -65,7 +65,7 @@ Bool_t KVIDGChIoSi::IsIdentifiable(Double_t x, Double_t y, TString* rejected_by)
    if (fSeuil) {
       can_id = fSeuil->WhereAmI(x, y, "right");
       if (!can_id) {
-         const_cast < KVIDGChIoSi* >(this)->fICode = k_BelowSeuilSi;
+         GetThreadContext().fICode = k_BelowSeuilSi;
          if (rejected_by) *rejected_by = fSeuil->GetName();
          return kFALSE;
       };
@@ -74,7 +74,7 @@ Bool_t KVIDGChIoSi::IsIdentifiable(Double_t x, Double_t y, TString* rejected_by)
    if (fEmaxSi) {
       can_id =  fEmaxSi->WhereAmI(x, y, "left");
       if (!can_id) {
-         const_cast < KVIDGChIoSi* >(this)->fICode = k_RightOfEmaxSi;
+         GetThreadContext().fICode = k_RightOfEmaxSi;
          if (rejected_by) *rejected_by = fEmaxSi->GetName();
          return kFALSE;
       };
@@ -163,28 +163,29 @@ void KVIDGChIoSi::Identify(Double_t x, Double_t y, KVIdentificationResult* idr)
    //            fire.
 
    KVIDZAGrid::Identify(x, y, idr);
+   IdentificationContext& ctx = GetThreadContext(); // context used by KVIDZAGrid::Identify
    // check Bragg & punch through for well identified particles
-   if (fICode < KVIDZAGrid::kICODE4) {
+   if (ctx.fICode < KVIDZAGrid::kICODE4) {
       //identified particles below (left of) Bragg line : Z is a Zmin
       if (fBragg && fBragg->WhereAmI(x, y, "left")) {
-         const_cast<KVIDGChIoSi*>(this)->fICode = k_LeftOfBragg;
+         ctx.fICode = k_LeftOfBragg;
          idr->SetComment("Point to identify below Bragg curve. Z given is a Zmin");
       }
       //if a particle is well-identified (i.e. not too far from the identification lines)
       //but it lies below the 'Punch_through' line, we give it a warning code
       if (fPunch && fPunch->WhereAmI(x, y, "below")) {
-         const_cast<KVIDGChIoSi*>(this)->fICode = k_BelowPunchThrough;
+         ctx.fICode = k_BelowPunchThrough;
          idr->SetComment("warning: point below punch-through line");
       }
-      idr->IDquality = fICode;
+      idr->IDquality = ctx.fICode;
    }
-   else if (fICode == KVIDZAGrid::kICODE7) {
+   else if (ctx.fICode == KVIDZAGrid::kICODE7) {
       // for particles above last line in grid, check if we are in fact in the Bragg zone
       if (fBragg && fBragg->WhereAmI(x, y, "left")) {
-         const_cast<KVIDGChIoSi*>(this)->fICode = k_LeftOfBragg;
+         ctx.fICode = k_LeftOfBragg;
          idr->SetComment("Point to identify below Bragg curve. Z given is a Zmin");
          idr->IDOK = kTRUE;
-         idr->IDquality = fICode;
+         idr->IDquality = ctx.fICode;
       }
 
    }
@@ -76,19 +76,20 @@ void KVIDGChIoSi_e494s::Identify(Double_t x, Double_t y, KVIdentificationResult*
    //    the particle is below the 'ChIo threshold line' => quality code KVIDGChIoSi_e494s::k_BelowSeuilChIo
 
    KVIDGChIoSi::Identify(x, y, idr);
+   IdentificationContext& ctx = GetThreadContext(); // context used by KVIDZAGrid::Identify
 
-   if (fICode < kICODE4) {
+   if (ctx.fICode < kICODE4) {
 
       if (fChIoSeuil && fChIoSeuil->WhereAmI(x, y, "below")) {
-         const_cast<KVIDGChIoSi_e494s*>(this)->fICode = k_BelowSeuilChIo;
+         ctx.fICode = k_BelowSeuilChIo;
          idr->SetComment("warning: point below ChIo threshold line");
       }
       Int_t ZValidityvalue = -1;
       ZValidityvalue = const_cast<KVIDGChIoSi_e494s*>(this)->GetParameters()->GetIntValue("ZValidity");
       if (ZValidityvalue > -1 && idr->Z > ZValidityvalue) {
-         const_cast<KVIDGChIoSi_e494s*>(this)->fICode = kICODE9;
+         ctx.fICode = kICODE9;
       }
-      idr->IDquality = fICode;
+      idr->IDquality = ctx.fICode;
    }
 }
 //________________________________________________________________
@@ -119,7 +120,7 @@ Bool_t KVIDGChIoSi_e494s::IsIdentifiable(Double_t x, Double_t y) const
    if (fChIoSeuil) {
       can_id = fChIoSeuil->WhereAmI(x, y, "above");
       if (!can_id) {
-         const_cast < KVIDGChIoSi_e494s* >(this)->fICode = k_BelowSeuilChIo;
+         GetThreadContext().fICode = k_BelowSeuilChIo;
          return kFALSE;
       };
    }
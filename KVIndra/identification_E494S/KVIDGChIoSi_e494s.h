@@ -21,7 +21,7 @@ protected:
       // Used by test Identification.
       // we only include particles with GetQualityCode()<4 (i.e. well identified) or equal to kICODE9
       // (i.e. well identified from extrapolated ID lines).
-      return (idr.IDOK || (fICode == kICODE9));
+      return (idr.IDOK || (idr.IDquality == kICODE9));
    }
 
 public:
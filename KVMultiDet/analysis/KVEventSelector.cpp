@@ -761,6 +761,9 @@ void KVEventSelector::Init(TTree* tree)
       Info("Init", "Analysing data in branch : %s", GetBranchName());
       fChain->SetBranchAddress(GetBranchName(), &Event, &b_Event);
    }
+   else if (ConnectEventColumns(fChain)) {
+      Info("Init", "Analysing data in columnar format (%s)", GetEvent()->ClassName());
+   }
    else {
       Error("Init", "Failed to link KVEvent object with a branch. Expected branch name=%s",
             GetBranchName());
@@ -254,6 +254,14 @@ public:
    {
       return fChain ? fChain->GetTree()->GetEntry(entry, getall) : 0;
    }
+   virtual Bool_t  ConnectEventColumns(TTree*)
+   {
+      // Called by Init() if the tree does not have a branch with the expected name:
+      // override in derived classes which can read events stored in a columnar format
+      // (one branch per quantity), set the event with SetEvent() and return kTRUE.
+      // GetEntry() must then be overridden to fill the event from the columns.
+      return kFALSE;
+   }
    Int_t GetFriendTreeEntry(Long64_t entry, Int_t getall = 0)
    {
       return fAuxChain ? fAuxChain->GetTree()->GetEntry(entry, getall) : 0;
@@ -11,11 +11,21 @@ $Date: 2008/03/12 11:21:58 $
 #include "TSystem.h"
 #include "Riostream.h"
 #include "KVError.h"
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
 ClassImp(KVLockfile)
 
+namespace {
+   // timeout used by KVLockfile::createlock() if none is set, so that a lockfile left by
+   // a program which died while holding it cannot block all other programs forever
+   const int fallback_locktimeout = 300;
+}
+
 
 
 KVLockfile::KVLockfile(const Char_t* filename): fFile(filename), fLockfile("lockfile")
@@ -42,7 +52,7 @@ void KVLockfile::init()
    //Set value of have_exec accordingly
    have_exec = FindExecutable(fLockfile);
    if (!have_exec) {
-      Warning(KV__ERROR(init), "Unix 'lockfile' command not found on system. You should install it.");
+      Warning(KV__ERROR(init), "Unix 'lockfile' command not found on system, files will be locked using open(O_EXCL). You should install it.");
    }
    sleeptime = 8; //time to wait before retrying lock
    retries = -1; //number of times to retry
@@ -125,19 +135,56 @@ int KVLockfile::testlock()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Bool_t KVLockfile::Lock(const Char_t* filename)
+int KVLockfile::createlock()
 {
-   if (!have_exec) {
-      locked = kTRUE;
-      return kTRUE;
+   //Used instead of lockfile command if it is not installed: the lockfile is created
+   //with open(O_CREAT|O_EXCL), which fails if the file already exists, with the same
+   //behaviour as the command for the current values of the parameters
+   //(sleeptime, retries, locktimeout, suspend), except that if no locktimeout is set,
+   //a lockfile older than 300 seconds is removed by force.
+   //
+   //Returns 0 if the lockfile was created, non-zero otherwise.
+
+   TString lock = Form("%s.lock", fFile.Data());
+   int timeout = (locktimeout ? locktimeout : fallback_locktimeout);
+   int attempts = 0;
+   while (1) {
+      int fd = ::open(lock.Data(), O_WRONLY | O_CREAT | O_EXCL, 0444);
+      if (fd >= 0) {
+         ::close(fd);
+         return 0;
+      }
+      if (errno != EEXIST) return -1;
+      // remove lockfile by force if it is older than timeout
+      FileStat_t fs;
+      if (!gSystem->GetPathInfo(lock.Data(), fs) && time(nullptr) - fs.fMtime >= timeout) {
+         gSystem->Unlink(lock.Data());
+         gSystem->Sleep(1000 * suspend);
+         continue;
+      }
+      if (retries >= 0 && attempts >= retries) return 1;
+      ++attempts;
+      gSystem->Sleep(1000 * sleeptime);
    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Bool_t KVLockfile::Lock(const Char_t* filename)
+{
    if (locked) {
       cout << "<Error in KVLockfile::Lock: file " << fFile.Data() << " is already locked. Release it first>" << endl;
       return kFALSE;
    }
    if (strcmp(filename, "")) fFile = filename;
-   writecmd();
-   if (!testlock()) {
+   int status;
+   if (have_exec) {
+      writecmd();
+      status = testlock();
+   }
+   else
+      status = createlock();
+   if (!status) {
       //cout << "<Info in KVLockfile::Lock : Locked " << fFile.Data() << ">" << endl;
       locked = kTRUE;
       return kTRUE;
@@ -153,10 +200,6 @@ Bool_t KVLockfile::Lock(const Char_t* filename)
 
 Bool_t KVLockfile::Release()
 {
-   if (!have_exec) {
-      locked = kFALSE;
-      return kTRUE;
-   }
    if (!locked) {
       cout << "<Error in KVLockfile::Release: file is not locked. Lock it first>" << endl;
       return kFALSE;
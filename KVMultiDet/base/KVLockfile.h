@@ -65,6 +65,11 @@ lox.Release();
 lox2.Release();
 ~~~~
 Note that Release() is called automatically in the destructor in case e.g. the KVLockfile goes out of scope.
+
+If `lockfile` is not installed, the same lockfiles are created using `open(O_CREAT|O_EXCL)`, with the same
+behaviour for the number of retries, sleeptime, timeout and suspend, except that if no timeout is set
+a default timeout of 300 seconds is used: otherwise a lockfile left by a program which died while holding
+it would block all other programs forever (there is no timeout and retries are unlimited by default).
 */
 class KVLockfile {
    KVString fFile;//name of file
@@ -79,6 +84,7 @@ class KVLockfile {
 
    void init();
    int testlock();
+   int createlock();
    void writecmd();
    Bool_t FindExecutable(TString& exec, const Char_t* path = "$(PATH)");
 
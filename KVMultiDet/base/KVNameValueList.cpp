@@ -6,14 +6,33 @@
 #include "Riostream.h"
 #include <KVEnv.h>
 #include <TROOT.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 using namespace std;
 
 ClassImp(KVNameValueList)
 
+namespace {
+   // Names of all parameters for which a slot was requested with KVNameValueList::GetSlot().
+   // The index of each name is its position in fNames.
+   struct KVNameValueListSlots {
+      std::mutex fMutex;
+      std::unordered_map<std::string, Int_t> fIndex;
+      std::deque<std::string> fNames;// references to names stay valid when new ones are added
+   };
+   KVNameValueListSlots& slot_names()
+   {
+      static KVNameValueListSlots slots;
+      return slots;
+   }
+}
+
 //______________________________________________
 KVNameValueList::KVNameValueList()
-   : fList(), fIgnoreBool(kFALSE)
+   : fList(), fIgnoreBool(kFALSE), fSlotCacheRemovals(0)
 {
    // Default constructor
    fList.SetOwner(kTRUE);
@@ -21,7 +40,7 @@ KVNameValueList::KVNameValueList()
 
 //______________________________________________
 KVNameValueList::KVNameValueList(const Char_t* name, const Char_t* title)
-   : TNamed(name, title), fList(), fIgnoreBool(kFALSE)
+   : TNamed(name, title), fList(), fIgnoreBool(kFALSE), fSlotCacheRemovals(0)
 {
    // Ctor with name & title
    //
@@ -33,7 +52,7 @@ KVNameValueList::KVNameValueList(const Char_t* name, const Char_t* title)
 }
 
 //______________________________________________
-KVNameValueList::KVNameValueList(const KVNameValueList& NVL) : TNamed()
+KVNameValueList::KVNameValueList(const KVNameValueList& NVL) : TNamed(), fSlotCacheRemovals(0)
 {
    // Copy constructor
    NVL.Copy(*this);
@@ -287,6 +306,49 @@ KVNamedParameter* KVNameValueList::FindParameter(const Char_t* name) const
    return (KVNamedParameter*)fList.FindObject(name);
 }
 
+//______________________________________________
+KVNameValueList::Slot KVNameValueList::GetSlot(const Char_t* name)
+{
+   // Return the slot corresponding to the given parameter name, which can be used instead of the name
+   // in order to access the parameter in any list without looking up its name every time.
+   // The same name always gives the same slot, for all lists.
+
+   KVNameValueListSlots& slots = slot_names();
+   std::lock_guard<std::mutex> lock(slots.fMutex);
+   auto it = slots.fIndex.find(name);
+   if (it != slots.fIndex.end()) return Slot(it->second, slots.fNames[it->second].c_str());
+   Int_t index = slots.fNames.size();
+   slots.fNames.push_back(name);
+   slots.fIndex[name] = index;
+   return Slot(index, slots.fNames.back().c_str());
+}
+
+//______________________________________________
+const Char_t* KVNameValueList::GetSlotName(Int_t index)
+{
+   // Return name of parameter corresponding to slot with given index, or "" if index is not valid
+
+   KVNameValueListSlots& slots = slot_names();
+   std::lock_guard<std::mutex> lock(slots.fMutex);
+   if (index < 0 || index >= (Int_t)slots.fNames.size()) return "";
+   return slots.fNames[index].c_str();
+}
+
+//______________________________________________
+void KVNameValueList::set_slot(const Slot& slot, KVNamedParameter* par)
+{
+   // Associate parameter with slot. All previous associations are forgotten if any parameters
+   // were removed from the list since they were made.
+
+   if (slot.fIndex < 0) return;
+   if (fSlotCacheRemovals != fList.GetNumberOfRemovals()) {
+      fSlotCache.assign(fSlotCache.size(), nullptr);
+      fSlotCacheRemovals = fList.GetNumberOfRemovals();
+   }
+   if (slot.fIndex >= (Int_t)fSlotCache.size()) fSlotCache.resize(slot.fIndex + 1, nullptr);
+   fSlotCache[slot.fIndex] = par;
+}
+
 KVNamedParameter* KVNameValueList::GetParameter(Int_t idx) const
 {
    //return the parameter object with index idx
@@ -8,6 +8,7 @@
 #include "TNamed.h"
 #include "TRegexp.h"
 #include "KVNamedParameter.h"
+#include <vector>
 class KVEnv;
 
 /**
@@ -110,6 +111,27 @@ class KVEnv;
  l.GetValue64bit("A64"); => (unsigned long long) 1234567890987654321
  ~~~~~~~~~~~
 
+ ###Fast access to parameters using slots###
+ Every access to a parameter by name requires the name to be hashed and compared with the names in the list.
+ When the same parameters are accessed over and over (e.g. for every event or every particle), the names
+ can be resolved once and for all into slots with GetSlot(), which can then be used instead of the names
+ with any list:
+
+ ~~~~~~~~~~~{.cpp}
+ static const KVNameValueList::Slot ekin = KVNameValueList::GetSlot("EKIN");
+
+ l.SetValue(ekin, 35.6);
+ l.GetDoubleValue(ekin); => 35.6
+ l.GetDoubleValue("EKIN"); => 35.6
+ ~~~~~~~~~~~
+
+ The first time a slot is used to set a value (or to find a parameter in a non-const list), the parameter is looked up by name;
+ after this, the list keeps a direct reference to the parameter for this slot, which is used until a parameter is removed from the
+ list (RemoveParameter(), Clear(), reading from a file, etc.) or the parameter is renamed.
+ Accesses through const methods (GetValue(), HasParameter(), etc.) use these references but never change them, so that they can be
+ made by several threads at once.
+ Slots do not change anything to the contents of the list or the way it is stored.
+
  */
 
 class KVNameValueList : public TNamed {
@@ -117,6 +139,49 @@ protected:
    KVHashList fList;//list of KVNamedParameter objects
    Bool_t fIgnoreBool;//do not convert "yes", "false", "on", etc. in TEnv file to boolean
 
+   std::vector<KVNamedParameter*> fSlotCache;//! parameter corresponding to each slot (see GetSlot)
+   UInt_t fSlotCacheRemovals;//! value of fList.GetNumberOfRemovals() when fSlotCache was filled
+
+public:
+   /**
+     \class Slot
+     \brief Pre-resolved name of a parameter in a KVNameValueList
+
+     Obtained with KVNameValueList::GetSlot(): can be used instead of the name of the parameter
+     with any list in order to avoid looking up the name in the list every time.
+    */
+   class Slot {
+      friend class KVNameValueList;
+      Int_t fIndex;
+      const Char_t* fName;//! name of parameter (if known)
+      Slot(Int_t index, const Char_t* name) : fIndex(index), fName(name) {}
+   public:
+      Slot() : fIndex(-1), fName(nullptr) {}
+      explicit Slot(Int_t index) : fIndex(index), fName(nullptr) {}
+      Bool_t IsValid() const
+      {
+         return fIndex > -1;
+      }
+      Int_t GetIndex() const
+      {
+         return fIndex;
+      }
+      const Char_t* GetName() const
+      {
+         return (fName ? fName : KVNameValueList::GetSlotName(fIndex));
+      }
+   };
+
+private:
+   KVNamedParameter* cached_slot(const Slot& slot) const
+   {
+      // Parameter associated with the slot by set_slot(), if it is still in the list with the same name
+      if (fSlotCacheRemovals != fList.GetNumberOfRemovals() || (UInt_t)slot.fIndex >= fSlotCache.size()) return nullptr;
+      KVNamedParameter* par = fSlotCache[slot.fIndex];
+      return (par && !strcmp(par->GetName(), slot.GetName()) ? par : nullptr);
+   }
+   void set_slot(const Slot&, KVNamedParameter*);
+
 public:
    KVNameValueList();
    KVNameValueList(const Char_t* name, const Char_t* title = "");
@@ -320,6 +385,76 @@ public:
       return kFALSE;
    }
 
+   static Slot GetSlot(const Char_t* name);
+   static const Char_t* GetSlotName(Int_t index);
+
+   KVNamedParameter* FindParameter(const Slot& slot) const
+   {
+      // Return the parameter corresponding to the slot (see GetSlot()), or nullptr if it is not in the list.
+      // If the parameter was already found or set using the slot, it is returned without looking up its name.
+      // The list is not modified, therefore this can be called by several threads at once.
+      KVNamedParameter* par = cached_slot(slot);
+      return (par ? par : FindParameter(slot.GetName()));
+   }
+   KVNamedParameter* FindParameter(const Slot& slot)
+   {
+      // Return the parameter corresponding to the slot (see GetSlot()), or nullptr if it is not in the list.
+      // The parameter is associated with the slot, so that the next accesses with the slot do not need
+      // to look up its name (until a parameter is removed from the list, or this one is renamed).
+      KVNamedParameter* par = cached_slot(slot);
+      if (!par && (par = FindParameter(slot.GetName()))) set_slot(slot, par);
+      return par;
+   }
+   template<typename value_type>
+   void SetValue(const Slot& slot, value_type value)
+   {
+      // Set the value of the parameter corresponding to the slot (see GetSlot()).
+      // If the parameter is not in the list, it is added.
+      KVNamedParameter* par = FindParameter(slot);
+      if (par) par->Set(value);
+      else {
+         par = new KVNamedParameter(slot.GetName(), value);
+         fList.Add(par);
+         set_slot(slot, par);
+      }
+   }
+   template <typename value_type>
+   value_type GetValue(const Slot& slot) const
+   {
+      // return the value of the parameter corresponding to the slot (see GetSlot())
+      // returns a default value (-1, false or "-1")
+      // if the parameter is not present
+      KVNamedParameter* par = FindParameter(slot);
+      return (par ? par->Get<value_type>() : KVNamedParameter::DefaultValue<value_type>());
+   }
+   Bool_t HasParameter(const Slot& slot) const
+   {
+      return FindParameter(slot) != nullptr;
+   }
+   template <typename value_type>
+   Bool_t HasParameter(const Slot& slot) const
+   {
+      // Return kTRUE if list has parameter corresponding to slot and it is of given type
+      KVNamedParameter* p = FindParameter(slot);
+      return (p && p->Is<value_type>());
+   }
+   Int_t GetIntValue(const Slot& slot) const
+   {
+      return GetValue<int>(slot);
+   }
+   Bool_t GetBoolValue(const Slot& slot) const
+   {
+      return GetValue<bool>(slot);
+   }
+   Double_t GetDoubleValue(const Slot& slot) const
+   {
+      return GetValue<double>(slot);
+   }
+   const Char_t* GetStringValue(const Slot& slot) const
+   {
+      return GetValue<cstring>(slot);
+   }
+
    KVNamedParameter* FindParameter(const Char_t* name) const;
    KVNamedParameter* GetParameter(Int_t idx) const;
    void RemoveParameter(const Char_t* name);
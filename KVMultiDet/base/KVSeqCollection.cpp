@@ -29,6 +29,7 @@ void KVSeqCollection::init()
    // in fgCleanups which is a THashList
 
    SetName(Form("KVSeqCollection_%lld", fSCCounter));
+   fNRemovals = 0;
    fSCCounter++;//always increases, so names are different
    ++fgCounter;//decreased by dtor, counts instances
    if (!fgCleanups) {
@@ -211,6 +212,7 @@ void KVSeqCollection::Clear(Option_t* option)
    }
    else
       fCollection->Clear(option);
+   ++fNRemovals;
    if (cleaner) SetCleanup();
    Changed();
 }
@@ -229,6 +231,7 @@ void KVSeqCollection::Delete(Option_t* option)
       }
    }
    fCollection->Delete(option);
+   ++fNRemovals;
    if (cleaner) SetCleanup();
    Changed();
 }
@@ -250,7 +253,10 @@ TObject* KVSeqCollection::Remove(TObject* obj)
    // Remove object from list.
 
    TObject* result = fCollection->Remove(obj);
-   if (result) Changed();
+   if (result) {
+      ++fNRemovals;
+      Changed();
+   }
    return result;
 }
 
@@ -265,6 +271,7 @@ void KVSeqCollection::RecursiveRemove(TObject* obj)
    // by calling this method.
 
    fCollection->RecursiveRemove(obj);
+   ++fNRemovals;
 }
 
 void  KVSeqCollection::PrintCollectionHeader(Option_t*) const
@@ -823,6 +830,7 @@ void KVSeqCollection::Streamer(TBuffer& R__b)
          fCollection->SetOwner(owns);
       }
       else R__b >> fCollection;
+      ++fNRemovals;
       R__b.CheckByteCount(R__s, R__c, KVSeqCollection::IsA());
    }
    else {
@@ -101,6 +101,7 @@ class KVSeqCollection : public TSeqCollection {
    void init();
    static Int_t fgCounter;// counts instances
    static TSeqCollection* fgCleanups;// regroup all lists which are to be cleaned up
+   UInt_t fNRemovals;//! number of times objects were removed from the list
 
 protected:
    TSeqCollection* fCollection;//Pointer to embedded ROOT collection
@@ -148,6 +149,14 @@ public:
       // (see SendModifiedSignals).
       return TestBit(kSignals);
    }
+   UInt_t GetNumberOfRemovals() const
+   {
+      // Counts the number of times that objects have been removed from the list
+      // (Remove, RecursiveRemove, Clear, Delete, or reading the list from a file).
+      // As long as this number does not change, pointers to objects in the list kept
+      // elsewhere remain valid.
+      return fNRemovals;
+   }
 
    virtual TObject* At(Int_t idx) const
    {
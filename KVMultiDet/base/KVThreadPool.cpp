@@ -0,0 +1,90 @@
+//Created by KVClassFactory on Sat Oct 17 10:12:31 2026
+
+#include "KVThreadPool.h"
+
+#ifdef WITH_CPP11
+
+KVThreadPool::KVThreadPool(unsigned int nthreads)
+   : fRunning(0), fStop(false)
+{
+   // Start nthreads worker threads.
+   // If nthreads=0, use the number of concurrent threads supported by the hardware.
+
+   if (!nthreads) nthreads = std::thread::hardware_concurrency();
+   if (!nthreads) nthreads = 1;
+   fWorkers.reserve(nthreads);
+   for (unsigned int i = 0; i < nthreads; ++i) fWorkers.emplace_back(&KVThreadPool::work, this);
+}
+
+KVThreadPool::~KVThreadPool()
+{
+   // Any tasks remaining in the queue are executed before the worker threads are stopped
+
+   {
+      std::unique_lock<std::mutex> lock(fMutex);
+      fStop = true;
+   }
+   fTaskAvailable.notify_all();
+   for (auto& w : fWorkers) w.join();
+}
+
+void KVThreadPool::Submit(std::function<void()> task)
+{
+   // Add a task to the queue. It will be executed by the first free worker thread.
+
+   {
+      std::unique_lock<std::mutex> lock(fMutex);
+      fTasks.push(std::move(task));
+   }
+   fTaskAvailable.notify_one();
+}
+
+void KVThreadPool::Wait()
+{
+   // Block until the task queue is empty and no task is being executed.
+   // If any task threw an exception, the first one is rethrown.
+
+   std::unique_lock<std::mutex> lock(fMutex);
+   fAllTasksDone.wait(lock, [this]() {
+      return fTasks.empty() && !fRunning;
+   });
+   if (fException) {
+      std::exception_ptr e = fException;
+      fException = nullptr;
+      std::rethrow_exception(e);
+   }
+}
+
+void KVThreadPool::work()
+{
+   // Main loop of each worker thread
+
+   for (;;) {
+      std::function<void()> task;
+      {
+         std::unique_lock<std::mutex> lock(fMutex);
+         fTaskAvailable.wait(lock, [this]() {
+            return fStop || !fTasks.empty();
+         });
+         if (fTasks.empty()) return; // fStop==true and nothing left to do
+         task = std::move(fTasks.front());
+         fTasks.pop();
+         ++fRunning;
+      }
+      std::exception_ptr e;
+      try {
+         task();
+      }
+      catch (...) {
+         e = std::current_exception();
+      }
+      {
+         std::unique_lock<std::mutex> lock(fMutex);
+         if (e && !fException) fException = e;
+         --fRunning;
+         if (fTasks.empty() && !fRunning) fAllTasksDone.notify_all();
+      }
+   }
+}
+
+#endif
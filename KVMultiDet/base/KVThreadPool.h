@@ -0,0 +1,69 @@
+//Created by KVClassFactory on Sat Oct 17 10:12:31 2026
+
+#ifndef __KVTHREADPOOL_H
+#define __KVTHREADPOOL_H
+
+#include "KVConfig.h"
+
+#ifdef WITH_CPP11
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+\class KVThreadPool
+\brief Fixed-size pool of worker threads executing queued tasks
+\ingroup Core
+
+Tasks (any callable with signature `void()`) are added to the queue with Submit().
+They are executed in the order they were submitted by the first available worker thread.
+Calling Wait() blocks the calling thread until all submitted tasks have finished executing.
+If any task throws an exception, the exception is caught by the worker thread, and the first
+one is rethrown by Wait() once all tasks have finished.
+
+~~~~{.cpp}
+KVThreadPool pool(4);
+for(auto& g : groups) pool.Submit([&g]() { g.Process(); });
+pool.Wait();
+~~~~
+
+The worker threads are started by the constructor and stopped by the destructor.
+If the number of threads is given as 0, std::thread::hardware_concurrency() threads are used.
+
+This class is not available in the interpreter (no dictionary is generated for it), and requires
+C++11 or later.
+*/
+class KVThreadPool {
+   std::vector<std::thread> fWorkers;
+   std::queue<std::function<void()> > fTasks;
+   std::mutex fMutex;
+   std::condition_variable fTaskAvailable;
+   std::condition_variable fAllTasksDone;
+   unsigned int fRunning;// number of tasks currently being executed
+   std::exception_ptr fException;// first exception thrown by a task since last Wait()
+   bool fStop;
+
+   void work();
+
+public:
+   KVThreadPool(unsigned int nthreads = 0);
+   virtual ~KVThreadPool();
+
+   KVThreadPool(const KVThreadPool&) = delete;
+   KVThreadPool& operator=(const KVThreadPool&) = delete;
+
+   void Submit(std::function<void()> task);
+   void Wait();
+
+   unsigned int GetNumberOfThreads() const
+   {
+      return fWorkers.size();
+   }
+};
+
+#endif
+#endif
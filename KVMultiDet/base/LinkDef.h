@@ -19,6 +19,7 @@
 #pragma link C++ class KVNamedParameter+;
 #pragma link C++ class KVNameValueList+;
 #pragma link C++ class KVNameValueList::Iterator+;
+#pragma link C++ class KVNameValueList::Slot+;
 #pragma link C++ class KVBase-;//customised streamer
 #pragma link C++ class KVColouredBase+;
 #pragma link C++ class KVClassFactory+;
@@ -20,7 +20,13 @@ Double_t KVLightEnergyCsI::CalculLumiere(Double_t* x, Double_t* par)
    //~~~~~~~~~~~~~~~~~~
    //
 
-   Double_t energie = x[0];
+   return light_output(x[0], par);
+}
+
+Double_t KVLightEnergyCsI::light_output(Double_t energie, const Double_t* par) const
+{
+   // Total light output for energy (in MeV) of particle with current Z & A (see CalculLumiere())
+
    Double_t c1 = par[0];
    Double_t c2 = Z * Z * A * par[1];
    Double_t c3 = A * par[2];
@@ -38,6 +44,25 @@ Double_t KVLightEnergyCsI::CalculLumiere(Double_t* x, Double_t* par)
    return lumcalc;
 }
 
+Double_t KVLightEnergyCsI::compiled_derivative(Double_t energie) const
+{
+   // Derivative of the total light output with respect to energy for particle with current Z & A
+
+   const Double_t* par = GetCalibFunction()->GetParameters();
+   Double_t c1 = par[0];
+   Double_t c2 = Z * Z * A * par[1];
+   if (c2 <= 0.0) return c1;
+   Double_t c3 = A * par[2];
+   Double_t c4 = par[3];
+   Double_t T = 8 * A;
+   Double_t ex = TMath::Exp((c3 - energie) / T);
+   Double_t c4_new = c4 / (1. + ex);
+   Double_t dc4_new = c4 * ex / T / ((1. + ex) * (1. + ex));
+
+   return c1 - c1 * c2 / (c2 + energie)
+          + c1 * c2 * (dc4_new * TMath::Log((energie + c2) / (c3 + c2)) + c4_new / (energie + c2));
+}
+
 KVLightEnergyCsI::KVLightEnergyCsI(): KVCalibrator()
 {
    //default initialisations
@@ -20,16 +20,37 @@ light output for high energy protons.
 
 The parameter a3 normally has a fixed value (a3=6), but this is not "hard-coded" : it should be fixed
 when fitting data.
+
+The light output and its derivative are calculated directly (without the TF1) when fast paths are enabled
+(see KVCalibrator), so that the energy can be found by Newton's method, using brackets which are calculated once
+for each (Z,A).
 */
 
 class KVLightEnergyCsI: public KVCalibrator {
 
    Double_t CalculLumiere(Double_t*, Double_t*);
+   Double_t light_output(Double_t energy, const Double_t* par) const;
 
 protected:
    mutable Double_t Z;
    mutable Double_t A;
 
+   virtual Bool_t init_compiled_function() const
+   {
+      // The light formula can always be calculated without the TF1
+      return kTRUE;
+   }
+   virtual Double_t compiled_eval(Double_t energy) const
+   {
+      return light_output(energy, GetCalibFunction()->GetParameters());
+   }
+   virtual Double_t compiled_derivative(Double_t) const;
+   virtual Long64_t inversion_context() const
+   {
+      // The light output depends on the Z & A of the particle
+      return 1000 * (Long64_t)Z + (Long64_t)A;
+   }
+
 public:
    KVLightEnergyCsI();
    virtual ~ KVLightEnergyCsI() {}
@@ -35,6 +35,13 @@ protected:
    Double_t fAmed;                //!A of detector material (CsI)
    TF1* fDlight;                  //!function to integrate to get fLight
 
+   virtual Bool_t init_compiled_function() const
+   {
+      // No compiled version of these light formulas: the TF1 is used (but brackets for inversion
+      // are still calculated once for each Z & A, see KVCalibrator)
+      return kFALSE;
+   }
+
 public:
    enum LightFormula {
       kExact,
@@ -2,132 +2,284 @@
 //Author: John Frankland,,,
 
 #include "KVProtobufDataReader.h"
+#include "TEnv.h"
+#include "TUrl.h"
 
 #include <google/protobuf/io/coded_stream.h>
+#include <cstring>
+#include <thread>
+#ifdef R__UNIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 ClassImp(KVProtobufDataReader)
 
 #define KV_PROTOBUF_MSG_SIZE 4
 
-Bool_t KVProtobufDataReader::GetNextEvent()
-{
-   // Prepare to read next event in buffer.
-   //  - if a new buffer is needed, we read one from the file
-   //  - at current position in buffer we read the size of the next protobuf message
-   //  - we check if the entire message is contained within the buffer
-   //    if not, the part of the message already read is moved to the start of the buffer
-   //    then the rest of the buffer is filled from the file
-   //  - if this method returns true, then fEvOffset and fEvSize are correctly positioned
-   //    in order for the message to be read (handled by daughter class with specific
-   //    protobuf message format)
-   //  - if this method returns false, then either a major problem occurred when reading
-   //    the file, or we have reached the end and there are no more events/messages to read
+struct KVProtobufDataReader::mapped_file {
+   // Read-only memory mapping of a whole local file.
+   // The mapping can be done by a separate thread (map_async()), in which case
+   // all pages of the file are read from disk before the thread finishes.
+   TString path;
+   char* addr;
+   Long64_t size;
+   std::thread worker;
 
-   if (fReachedEndOfFile) {
-      // derived classes may override read_buffer() so that it opens a new file
-      if (!read_buffer()) return false;
+   mapped_file(const TString& p) : path(p), addr(nullptr), size(0) {}
+   ~mapped_file()
+   {
+      wait();
+      unmap();
    }
-
-   // do we have enough bytes left (4) in buffer to read size of next event?
-   if (get_remaining_readable_buffer() < KV_PROTOBUF_MSG_SIZE) fNeedToReadBuffer = true;
-
-   if (fNeedToReadBuffer)
-      if (!read_buffer()) return false;
-
-   // get size of next event in buffer
-   fEvSize = 0;
+   void map(bool read_ahead)
    {
-      // Read the message size (4-bytes/32-bit integer)
-      google::protobuf::io::CodedInputStream codedIStream((const uint8_t*)(fBuffer + fEvOffset), KV_PROTOBUF_MSG_SIZE);
-      codedIStream.ReadLittleEndian32(&fEvSize);
-      if (fEvSize == 0) {
-         Error("GetNextEvent", "read zero size event");
-         return false;
+#ifdef R__UNIX
+      int fd = ::open(path.Data(), O_RDONLY);
+      if (fd < 0) return;
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size > 0) {
+         void* a = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (a != MAP_FAILED) {
+            addr = (char*)a;
+            size = st.st_size;
+            madvise(a, size, MADV_SEQUENTIAL);
+            if (read_ahead) {
+               madvise(a, size, MADV_WILLNEED);
+               // touch every page, so that the whole file is read now (in this thread)
+               // rather than when it is parsed
+               long page = sysconf(_SC_PAGESIZE);
+               volatile char sum = 0;
+               for (Long64_t i = 0; i < size; i += page) sum += addr[i];
+               (void)sum;
+            }
+         }
       }
+      ::close(fd);
+#else
+      (void)read_ahead;
+#endif
    }
-   //Info("GetNextEvent", "event size=%d bytes", fEvSize);
-
-   fEvOffset += KV_PROTOBUF_MSG_SIZE;
-   // do we have enough bytes left to read the event?
-   if (get_remaining_readable_buffer() < fEvSize) {
-      fNeedToReadBuffer = true;
-      if (!read_buffer()) return false;
+   void map_async()
+   {
+      worker = std::thread([this]() {
+         map(true);
+      });
    }
-
-   if (!parse_event_from_message()) {
-      // problem parsing event - try to read next event
-      fEvOffset += fEvSize;
-      return GetNextEvent();
+   void wait()
+   {
+      if (worker.joinable()) worker.join();
    }
+   void unmap()
+   {
+#ifdef R__UNIX
+      if (addr) munmap(addr, size);
+#endif
+      addr = nullptr;
+      size = 0;
+   }
+};
 
-   fEvOffset += fEvSize;
+Bool_t KVProtobufDataReader::GetNextEvent()
+{
+   // Prepare to read next event.
+   //  - at current position in buffer we read the size of the next protobuf message
+   //  - we check if the entire message is contained within the buffer;
+   //    if not (only for files read with TFile), the part of the message already read is
+   //    moved to the start of the buffer then the rest of the buffer is filled from the file
+   //  - when all messages in the current file have been read, open_next_file() is called
+   //    (derived classes may override it to open the next file of a run)
+   //  - messages which cannot be parsed (see parse_event_from_message()) are skipped
+   //  - if this method returns true, then the message has been parsed by the daughter class
+   //    with its specific protobuf message format
+   //  - if this method returns false, then either a major problem occurred when reading
+   //    the file, or we have reached the end and there are no more events/messages to read
 
-   return true;
+   while (true) {
+      if (get_remaining_readable_buffer() >= KV_PROTOBUF_MSG_SIZE) {
+         // get size of next event in buffer
+         fEvSize = 0;
+         {
+            // Read the message size (4-bytes/32-bit integer)
+            google::protobuf::io::CodedInputStream codedIStream((const uint8_t*)(fData + fEvOffset), KV_PROTOBUF_MSG_SIZE);
+            codedIStream.ReadLittleEndian32(&fEvSize);
+            if (fEvSize == 0) {
+               Error("GetNextEvent", "read zero size event");
+               return false;
+            }
+         }
+         if (get_remaining_readable_buffer() >= (Long64_t)fEvSize + KV_PROTOBUF_MSG_SIZE) {
+            // the whole message is in the buffer
+            fEvOffset += KV_PROTOBUF_MSG_SIZE;
+            bool ok = parse_event_from_message();
+            fEvOffset += fEvSize;
+            if (ok) return true;
+            // problem parsing event - try to read next event
+            continue;
+         }
+         if (!fReachedEndOfFile && (Long64_t)fEvSize + KV_PROTOBUF_MSG_SIZE > fBufSize) {
+            Error("GetNextEvent", "event size (%u bytes) is larger than buffer (%d bytes)", fEvSize, fBufSize);
+            return false;
+         }
+      }
+      // the next message is not (entirely) in the buffer
+      if (!fReachedEndOfFile) {
+         read_buffer();
+         continue;
+      }
+      if (get_remaining_readable_buffer() > 0)
+         Warning("GetNextEvent", "incomplete message at end of file (%lld bytes) ignored", get_remaining_readable_buffer());
+      if (!open_next_file()) return false;
+   }
 }
 
 bool KVProtobufDataReader::read_buffer()
 {
-   // read a buffer from the file
+   // read a buffer from a file opened with TFile
+   //
+   // any bytes remaining to be read at the end of the current buffer are first moved
+   // to the beginning of the buffer
 
    if (fReachedEndOfFile) {
       // last read reached end of file
       return false;
    }
-   ptrdiff_t fFillOffset = 0;
-   // if fEvOffset>0 we need to copy the remaining bytes of the last buffer to the
-   // beginning of the buffer and adjust fFillOffset accordingly
-   if (fEvOffset > 0 && get_remaining_readable_buffer()) {
-      //Info("read_buffer", "Copying last %d bytes of old buffer to beginning of new buffer", get_remaining_readable_buffer());
-      memcpy(fBuffer, (fBuffer + fEvOffset), get_remaining_readable_buffer());
+   if (!fBuffer) fBuffer = new char[fBufSize];
+   Long64_t fFillOffset = 0;
+   if (fEvOffset > 0 && get_remaining_readable_buffer() > 0) {
+      memmove(fBuffer, (fBuffer + fEvOffset), get_remaining_readable_buffer());
       fFillOffset = get_remaining_readable_buffer();
    }
-   Int_t bytes_to_read = fBufSize - fFillOffset;
+   else if (fEvOffset == 0)
+      fFillOffset = fDataSize;
+   Long64_t bytes_to_read = fBufSize - fFillOffset;
    if (bytes_to_read > fFileSize) bytes_to_read = fFileSize;
-   //Info("read_buffer", "fFillOffset:%ld      bytes to read:%d bytes", fFillOffset, bytes_to_read);
    Long64_t old_bytes = fFile->GetBytesRead();
-   fFile->ReadBuffer((char*)(fBuffer + fFillOffset), bytes_to_read);
+   if (fFile->ReadBuffer((char*)(fBuffer + fFillOffset), (Int_t)bytes_to_read))
+      Error("read_buffer", "error reading file %s", fFile->GetName());
    Long64_t bytes_read = fFile->GetBytesRead() - old_bytes;
-   //Info("read_buffer", "Read %d bytes from file", (Int_t)bytes_read);
    fFileSize -= bytes_read;
-   if (bytes_read == 0 || fFileSize == 0 || bytes_read < (Int_t)(fBufSize - fFillOffset)) fReachedEndOfFile = true;
-   fNeedToReadBuffer = false;
+   if (bytes_read == 0 || fFileSize <= 0) fReachedEndOfFile = true;
+   fData = fBuffer;
+   fDataSize = fFillOffset + bytes_read;
    fEvOffset = 0;
    return (bytes_read > 0);
 }
 
+Bool_t KVProtobufDataReader::is_local_file(const Char_t* url, TString& path)
+{
+   // \returns kTRUE if url refers to a local file (i.e. no protocol or "file:"),
+   // in which case path is the path to the file
+
+   TUrl u(url, kTRUE);
+   if (strcmp(u.GetProtocol(), "file")) return kFALSE;
+   path = u.GetFile();
+   return kTRUE;
+}
+
+void KVProtobufDataReader::close_file()
+{
+   // Release currently open/mapped file
+   delete fMapped;
+   fMapped = nullptr;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+   fFile.reset();
+#else
+   SafeDelete(fFile);
+#endif
+}
+
 void KVProtobufDataReader::open_file(const Char_t* filepath)
 {
+   // Open file for reading.
+   //
+   // Local files are memory-mapped (unless KVProtobufDataReader.MemoryMap is 'no'). If the
+   // file was given to prefetch_file(), the mapping already made by the background thread is used.
+   //
+   // Other files (or if mapping fails) are opened with TFile and read in buffers.
+
+   close_file();
+   fEvOffset = 0;
+   fDataSize = 0;
+   fData = fBuffer;
+   fFileSize = 0;
+   fReachedEndOfFile = false;
+
+   TString path;
+   if (fUseMemoryMap && is_local_file(filepath, path)) {
+      mapped_file* mf = nullptr;
+      if (fPrefetched && fPrefetched->path == path) {
+         mf = fPrefetched;
+         fPrefetched = nullptr;
+         mf->wait();
+      }
+      else {
+         mf = new mapped_file(path);
+         mf->map(false);
+      }
+      if (mf->addr) {
+         fMapped = mf;
+         fData = mf->addr;
+         fDataSize = mf->size;
+         fReachedEndOfFile = true;
+         Info("open_file", "%s : size of file = %lld bytes (memory-mapped)", filepath, fDataSize);
+         return;
+      }
+      delete mf;
+   }
+
    TString fp(filepath);
    fp.Append("?filetype=raw");
 #if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
    fFile.reset(TFile::Open(fp));
 #else
-   SafeDelete(fFile);
    fFile = TFile::Open(fp);
 #endif
+   if (!fFile) {
+      Error("open_file", "cannot open %s", filepath);
+      fReachedEndOfFile = true;
+      return;
+   }
    fFileSize = fFile->GetSize();
    Info("open_file", "%s : size of file = %lld bytes", filepath, fFileSize);
-   fEvOffset = 0;
-   fNeedToReadBuffer = true;
-   fReachedEndOfFile = false;
+}
+
+void KVProtobufDataReader::prefetch_file(const Char_t* filepath)
+{
+   // Start memory-mapping and reading the given (local) file in a separate thread,
+   // so that it is ready when open_file() is called for it.
+   //
+   // Does nothing for non-local files or if KVProtobufDataReader.Prefetch is 'no'.
+
+   TString path;
+   if (!fUseMemoryMap || !fUsePrefetch || !is_local_file(filepath, path)) return;
+   delete fPrefetched;
+   fPrefetched = new mapped_file(path);
+   fPrefetched->map_async();
 }
 
 KVProtobufDataReader::KVProtobufDataReader(const Char_t* filepath, Int_t bufSiz)
-   : KVRawDataReader(),
-     fBufSize(bufSiz), fBuffer(new char[bufSiz]), fFile(nullptr), fEvSize(0), fEvOffset(0), fNeedToReadBuffer(true),
+   : KVRawDataReader(), fMapped(nullptr), fPrefetched(nullptr),
+     fUseMemoryMap(gEnv->GetValue("KVProtobufDataReader.MemoryMap", kTRUE)),
+     fUsePrefetch(gEnv->GetValue("KVProtobufDataReader.Prefetch", kTRUE)),
+     fBufSize(bufSiz), fBuffer(nullptr), fData(nullptr), fDataSize(0), fFile(nullptr), fFileSize(0), fEvSize(0), fEvOffset(0),
      fReachedEndOfFile(false)
 {
    // Open Google protobuf file for reading. Filepath URL will be passed to TFile::Open
    // therefore can use same plugins eg. "root://" etc.
-   // Default buffer size: 16MB
+   // Default buffer size: 16MB (only used for files which are not memory-mapped)
    // Note: buffer size given as Int_t, as this is argument type required by TFile::ReadBuffer
 
    open_file(filepath);
 }
 
 KVProtobufDataReader::KVProtobufDataReader(Int_t bufSiz)
-   : KVRawDataReader(),
-     fBufSize(bufSiz), fBuffer(new char[bufSiz]), fFile(nullptr), fFileSize(0), fEvSize(0), fEvOffset(0), fNeedToReadBuffer(true),
+   : KVRawDataReader(), fMapped(nullptr), fPrefetched(nullptr),
+     fUseMemoryMap(gEnv->GetValue("KVProtobufDataReader.MemoryMap", kTRUE)),
+     fUsePrefetch(gEnv->GetValue("KVProtobufDataReader.Prefetch", kTRUE)),
+     fBufSize(bufSiz), fBuffer(nullptr), fData(nullptr), fDataSize(0), fFile(nullptr), fFileSize(0), fEvSize(0), fEvOffset(0),
      fReachedEndOfFile(false)
 {
    // Create file reader of given buffer size, do not open any files yet
@@ -137,10 +289,9 @@ KVProtobufDataReader::KVProtobufDataReader(Int_t bufSiz)
 KVProtobufDataReader::~KVProtobufDataReader()
 {
    // Destructor
+   delete fPrefetched;
+   close_file();
    delete [] fBuffer;
-#if ROOT_VERSION_CODE < ROOT_VERSION(6,0,0)
-   SafeDelete(fFile);
-#endif
 }
 
 KVSeqCollection* KVProtobufDataReader::GetFiredDataParameters() const
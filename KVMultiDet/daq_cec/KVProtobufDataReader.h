@@ -9,35 +9,67 @@
   \class KVProtobufDataReader
 \brief Read Google Protobuf DAQ files
   \ingroup DAQ
+
+Local files are memory-mapped and messages are parsed directly from the mapping,
+without any copy. Files accessed through other protocols (e.g. `root://`) are read
+using TFile in buffers of fixed size (16MB by default).
+
+Derived classes handling runs split over several files (see open_next_file()) can
+call prefetch_file() with the name of the next file in order to have it memory-mapped
+and read from disk by a separate thread while the current file is being read.
+
+Both features can be disabled with the following variables in your `.kvrootrc`:
+~~~~
+KVProtobufDataReader.MemoryMap:  no
+KVProtobufDataReader.Prefetch:   no
+~~~~
 */
 
 class KVProtobufDataReader : public KVRawDataReader {
+   struct mapped_file;
+   mapped_file* fMapped;//! current memory-mapped file, if any
+   mapped_file* fPrefetched;//! next file, mapped in the background by prefetch_file()
+   Bool_t fUseMemoryMap;//! memory-map local files
+   Bool_t fUsePrefetch;//! enable prefetch_file()
+
+   void close_file();
+   static Bool_t is_local_file(const Char_t* url, TString& path);
+
 protected:
    Int_t fBufSize;//! buffer size
-   char* fBuffer;//! current buffer
+   char* fBuffer;//! buffer for files read with TFile
+   const char* fData;//! current data: either fBuffer or memory-mapped file
+   Long64_t fDataSize;//! number of bytes of data at fData
 #ifdef USING_ROOT6
    unique_ptr<TFile> fFile;//! TFile plugin handle
 #else
    TFile* fFile;//! TFile plugin handle
 #endif
-   Long64_t fFileSize;//! size of file in bytes
+   Long64_t fFileSize;//! number of bytes of file not yet read
    UInt_t fEvSize;//! size of next event in buffer
    ptrdiff_t fEvOffset;//! next position to read in buffer
-   bool fNeedToReadBuffer;//! true when the buffer is empty/incomplete
    bool fReachedEndOfFile;//! true when we have read all bytes from file
 
    virtual bool read_buffer();
+   virtual bool open_next_file()
+   {
+      // Called when all events in the current file have been read.
+      // Derived classes handling several files should open the next one (if any)
+      // with open_file() and return true.
+      return false;
+   }
 
-   UInt_t get_remaining_readable_buffer() const
+   Long64_t get_remaining_readable_buffer() const
    {
       // number of bytes remaining to read in buffer starting from current
       // position fEvOffset
-      return (UInt_t)(fBufSize - fEvOffset);
+      return fDataSize - fEvOffset;
    }
 
    virtual bool parse_event_from_message() = 0;
 
    void open_file(const Char_t* filepath);
+   void prefetch_file(const Char_t* filepath);
 
 public:
    KVProtobufDataReader(Int_t bufSiz = 16 * 1024 * 1024);
@@ -205,6 +205,13 @@ public:
       Type    fType;//iterator type
       mutable Bool_t  fIterating;//=kTRUE when iteration in progress
       TString fGroup;//groupname for group iterations
+      Int_t   fGroupIndex;//index of group for group iterations (see KVParticle::GetGroupIndex), -1 for all particles
+      void SetGroup(const TString& grp)
+      {
+         // Set group for group iterations, and look up its index once and for all
+         fGroup = grp;
+         fGroupIndex = (grp.IsNull() ? -1 : KVParticle::GetGroupIndex(grp));
+      }
       Bool_t AcceptableIteration()
       {
          // Returns kTRUE if the current particle in the iteration
@@ -215,7 +222,7 @@ public:
                return current()->IsOK();
                break;
             case Group:
-               return current()->BelongsToGroup(fGroup);
+               return fGroupIndex < 0 || current()->BelongsToGroupIndex(fGroupIndex);
                break;
             case All:
             default:
@@ -238,13 +245,15 @@ public:
            fType(Null),
 #endif
            fIterating(kFALSE),
-           fGroup()
+           fGroup(),
+           fGroupIndex(-1)
       {}
       Iterator(const Iterator& i)
          : fIter(i.fIter),
            fType(i.fType),
            fIterating(i.fIterating),
-           fGroup(i.fGroup)
+           fGroup(i.fGroup),
+           fGroupIndex(i.fGroupIndex)
       {}
 
 #ifdef WITH_CPP11
@@ -252,7 +261,7 @@ public:
 #else
       Iterator(const KVEvent* e, Type t = All, const TString& grp = "")
 #endif
-         : fIter(e->fParticles), fType(t), fIterating(kTRUE), fGroup(grp)
+         : fIter(e->fParticles), fType(t), fIterating(kTRUE)
       {
          // Construct an iterator object to read in sequence the particles in event *e.
          // By default, opt="" and all particles are included in the iteration.
@@ -264,6 +273,7 @@ public:
          //                                    kTRUE
 
          // set iterator to first particle of event corresponding to selection
+         SetGroup(grp);
          fIter.Begin();
          while ((current() != nullptr) && !AcceptableIteration()) ++fIter;
       }
@@ -273,7 +283,7 @@ public:
 #else
       Iterator(const KVEvent& e, Type t = All, const TString& grp = "")
 #endif
-         : fIter(e.fParticles), fType(t), fIterating(kTRUE), fGroup(grp)
+         : fIter(e.fParticles), fType(t), fIterating(kTRUE)
       {
          // Construct an iterator object to read in sequence the particles in event *e.
          // By default, opt="" and all particles are included in the iteration.
@@ -285,6 +295,7 @@ public:
          //                                    kTRUE
 
          // set iterator to first particle of event corresponding to selection
+         SetGroup(grp);
          fIter.Begin();
          while ((current() != nullptr) && !AcceptableIteration()) ++fIter;
       }
@@ -339,6 +350,7 @@ public:
             fIter = rhs.fIter;
             fType = rhs.fType;
             fGroup = rhs.fGroup;
+            fGroupIndex = rhs.fGroupIndex;
             fIterating = rhs.fIterating;
          }
          return *this;
@@ -364,7 +376,7 @@ public:
          if (t != Null) {
 #endif
             fType = t;
-            fGroup = grp;
+            SetGroup(grp);
          }
          fIter.Begin();
          fIterating = kTRUE;
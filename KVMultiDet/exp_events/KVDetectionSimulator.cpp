@@ -56,25 +56,39 @@ void KVDetectionSimulator::DetectEvent(KVEvent* event, const Char_t* detection_f
    // Reset detectors in array hit by any previous events
    ClearHitGroups();
 
+   // status of each particle during detection
+   struct particle_status {
+      KVNucleus* part;
+      KVNucleus* _part;// particle in detection frame
+      KVNameValueList det_stat;
+      Double_t eLostInTarget;
+      TVector3 initial_momentum;
+      particle_status(KVNucleus* p, KVNucleus* _p)
+         : part(p), _part(_p), eLostInTarget(0), initial_momentum(_p->GetMomentum()) {}
+   };
+   std::vector<particle_status> status;
+   status.reserve(event->GetMult());
+   // particles to be propagated through the array
+   std::vector<KVNucleus*> propagate;
+   std::vector<particle_status*> propagate_status;
+
    event->ResetGetNextParticle();
    KVNucleus* part;
    while ((part = event->GetNextParticle())) {  // loop over particles
-
-      KVNucleus* _part = (KVNucleus*)part->GetFrame(detection_frame, kFALSE);
-
-      KVNameValueList det_stat, nvl;
-      Double_t eLostInTarget = 0;
-
-      TVector3 initial_momentum = _part->GetMomentum();
+      status.push_back(particle_status(part, (KVNucleus*)part->GetFrame(detection_frame, kFALSE)));
+   }
+   for (auto& st : status) {
+      KVNucleus* _part = st._part;
+      part = st.part;
 
       if (part->GetZ() == 0) {
-         det_stat.SetValue("UNDETECTED", "NEUTRON");
+         st.det_stat.SetValue("UNDETECTED", "NEUTRON");
 
          part->AddGroup("UNDETECTED");
          part->AddGroup("NEUTRON");
       }
       else if (_part->GetKE() < GetMinKECutOff()) {
-         det_stat.SetValue("UNDETECTED", "NO ENERGY");
+         st.det_stat.SetValue("UNDETECTED", "NO ENERGY");
 
          part->AddGroup("UNDETECTED");
          part->AddGroup("NO ENERGY");
@@ -86,9 +100,9 @@ void KVDetectionSimulator::DetectEvent(KVEvent* event, const Char_t* detection_f
             //simulate passage through target material
             Double_t ebef = _part->GetKE();
             GetTarget()->DetectParticle(_part);
-            eLostInTarget = ebef - _part->GetKE();
+            st.eLostInTarget = ebef - _part->GetKE();
             if (_part->GetKE() < GetMinKECutOff()) {
-               det_stat.SetValue("UNDETECTED", "STOPPED IN TARGET");
+               st.det_stat.SetValue("UNDETECTED", "STOPPED IN TARGET");
 
                part->AddGroup("UNDETECTED");
                part->AddGroup("STOPPED IN TARGET");
@@ -97,44 +111,54 @@ void KVDetectionSimulator::DetectEvent(KVEvent* event, const Char_t* detection_f
          }
 
          if (_part->GetKE() > GetMinKECutOff()) {
+            propagate.push_back(_part);
+            propagate_status.push_back(&st);
+         }
+      }
+   }
 
-            nvl = DetectParticle(_part);
+   // propagate all particles through the array together: energy losses in each
+   // material are calculated for all particles at once
+   fArray->GetNavigator()->PropagateParticles(propagate);
 
-            if (nvl.IsEmpty()) {
+   for (auto st : propagate_status) {
+      part = st->part;
+      KVNameValueList nvl = GetDetectorEnergyLosses(st->_part);
 
-               det_stat.SetValue("UNDETECTED", "DEAD ZONE");
+      if (nvl.IsEmpty()) {
 
-               part->AddGroup("UNDETECTED");
-               part->AddGroup("DEAD ZONE");
+         st->det_stat.SetValue("UNDETECTED", "DEAD ZONE");
+
+         part->AddGroup("UNDETECTED");
+         part->AddGroup("DEAD ZONE");
 
-            }
-            else {
-               part->AddGroup("DETECTED");
-            }
-         }
       }
+      else {
+         part->AddGroup("DETECTED");
 
-      if (IncludeTargetEnergyLoss() && GetTarget()) part->SetParameter("TARGET Out", eLostInTarget);
-      if (!nvl.IsEmpty()) {
          Int_t nbre_nvl = nvl.GetNpar();
          KVString LastDet(nvl.GetNameAt(nbre_nvl - 1));
          if (part->GetE() < GetMinKECutOff() || part->GetParameters()->HasParameter("DEADZONE")) {
             part->SetParameter("STOPPING DETECTOR", LastDet.Data());
-            det_stat.SetValue("DETECTED", "OK");
+            st->det_stat.SetValue("DETECTED", "OK");
          }
          else {
-            det_stat.SetValue("DETECTED", "PUNCHED THROUGH");
+            st->det_stat.SetValue("DETECTED", "PUNCHED THROUGH");
          }
          for (Int_t ii = 0; ii < nvl.GetNpar(); ++ii) {
             part->SetParameter(nvl.GetNameAt(ii), nvl.GetDoubleValue(ii));
          }
       }
-      for (Int_t ii = 0; ii < det_stat.GetNpar(); ii += 1) {
-         part->SetParameter(det_stat.GetNameAt(ii), det_stat.GetStringValue(ii));
-      }
+   }
 
-      _part->SetMomentum(initial_momentum);
+   for (auto& st : status) {
+      part = st.part;
+      if (IncludeTargetEnergyLoss() && GetTarget()) part->SetParameter("TARGET Out", st.eLostInTarget);
+      for (Int_t ii = 0; ii < st.det_stat.GetNpar(); ii += 1) {
+         part->SetParameter(st.det_stat.GetNameAt(ii), st.det_stat.GetStringValue(ii));
+      }
 
+      st._part->SetMomentum(st.initial_momentum);
    }
 
 }
@@ -155,6 +179,15 @@ KVNameValueList KVDetectionSimulator::DetectParticle(KVNucleus* part)
 
    fArray->GetNavigator()->PropagateParticle(part);
 
+   return GetDetectorEnergyLosses(part);
+}
+
+KVNameValueList KVDetectionSimulator::GetDetectorEnergyLosses(KVNucleus* part)
+{
+   // After propagation of particle through the array, returns a list containing the name
+   // and energy loss of each detector hit (list is empty if none i.e. particle
+   // in beam pipe or dead zone of the multidetector)
+
    // particle missed all detectors
    if (part->GetParameters()->IsEmpty()) return KVNameValueList();
 
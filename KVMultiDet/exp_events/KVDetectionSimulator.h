@@ -23,6 +23,8 @@ private:
    KVDetectorEvent fHitGroups;//        used to reset hit detectors in between events
    Bool_t fCalcTargELoss;//             whether to include energy loss in target, if defined
 
+   KVNameValueList GetDetectorEnergyLosses(KVNucleus*);
+
 public:
    KVDetectionSimulator() : KVBase(), fArray(nullptr), fCalcTargELoss(kTRUE) {}
    KVDetectionSimulator(KVMultiDetArray* a, Double_t cut_off = 1.e-3);
@@ -5,15 +5,33 @@
 #include "KVDetectorEvent.h"
 #include "KVGroupReconstructor.h"
 #include "KVTarget.h"
+#include "KVThreadPool.h"
+#ifdef USING_ROOT6
+#include "TROOT.h"
+#endif
+#ifdef WITH_CPP11
+#include <mutex>
+#endif
 
 #include <iostream>
 using namespace std;
 
 ClassImp(KVEventReconstructor)
 
+#ifdef WITH_CPP11
+namespace {
+   // energy loss calculations are not reentrant: only one reconstructor at a time may calibrate
+   std::mutex calibration_mutex;
+   // identification grids are shared by all working copies of the array: unless parallel identification
+   // is enabled, only one reconstructor at a time may identify
+   std::mutex identification_mutex;
+}
+#endif
+
 KVEventReconstructor::KVEventReconstructor(KVMultiDetArray* a, KVReconstructedEvent* e, Bool_t)
    : KVBase("KVEventReconstructor", Form("Reconstruction of events in array %s", a->GetName())),
-     fArray(a), fEvent(e), fGroupReconstructor(a->GetNumberOfGroups(), 1)
+     fArray(a), fEvent(e), fGroupReconstructor(a->GetNumberOfGroups(), 1), fThreadPool(nullptr),
+     fSerializeCalibration(kFALSE), fParallelIdentification(kFALSE)
 {
    // Default constructor
    // Set up group reconstructor for every group of the array.
@@ -24,6 +42,16 @@ KVEventReconstructor::KVEventReconstructor(KVMultiDetArray* a, KVReconstructedEv
    //
    //    EventReconstruction.DoIdentification
    //    EventReconstruction.DoCalibration
+   //
+   // Parallel reconstruction of hit groups is enabled if the following variable is > 0
+   // (it gives the number of worker threads to use):
+   //
+   //    EventReconstruction.NumberOfThreads
+   //
+   // Identification is performed in parallel, either by the worker threads or by several reconstructors
+   // using working copies of the array (see SetSerializeCalibration()), only if the following variable is 'yes':
+   //
+   //    EventReconstruction.ParallelIdentification
 
    fGroupReconstructor.SetOwner();
    unique_ptr<KVSeqCollection> gr_list(a->GetStructureTypeList("GROUP"));
@@ -65,6 +93,30 @@ KVEventReconstructor::KVEventReconstructor(KVMultiDetArray* a, KVReconstructedEv
    }
    else
       Info("KVEventReconstructor", " -- no identification or calibration will be performed");
+
+   fParallelIdentification = GetDataSetEnv(fArray->GetDataSet(), "EventReconstruction.ParallelIdentification", kFALSE);
+   Int_t nthreads = (Int_t)GetDataSetEnv(fArray->GetDataSet(), "EventReconstruction.NumberOfThreads", 0.);
+   if (nthreads > 0) {
+#ifdef WITH_CPP11
+#ifdef USING_ROOT6
+      ROOT::EnableThreadSafety();
+#endif
+      fThreadPool = new KVThreadPool(nthreads);
+      Info("KVEventReconstructor", " -- groups will be reconstructed%s in parallel using %u threads",
+           (fParallelIdentification ? " & identified" : ""), fThreadPool->GetNumberOfThreads());
+#else
+      Warning("KVEventReconstructor", "Parallel reconstruction requires C++11: groups will be reconstructed sequentially");
+#endif
+   }
+}
+
+KVEventReconstructor::~KVEventReconstructor()
+{
+   // Destructor
+   // Stops worker threads used for parallel reconstruction (if any)
+#ifdef WITH_CPP11
+   SafeDelete(fThreadPool);
+#endif
 }
 
 //________________________________________________________________
@@ -106,14 +158,30 @@ void KVEventReconstructor::ReconstructEvent(const TSeqCollection* fired)
    TIter it(detev.GetGroups());
    KVGroup* group;
    while ((group = (KVGroup*)it())) {
-      KVGroupReconstructor* grec = (KVGroupReconstructor*)fGroupReconstructor[group->GetNumber()];
-      if (grec) {
-         fHitGroups[fNGrpRecon] = group->GetNumber();
-         grec->Process();
+      if (fGroupReconstructor[group->GetNumber()]) {
+         fHitGroups.push_back(group->GetNumber());
          ++fNGrpRecon;
       }
    }
 
+   if (IsParallelReconstruction() && fNGrpRecon > 1) {
+      ProcessHitGroupsInParallel();
+   }
+   else if (fSerializeCalibration) {
+      for (int k = 0; k < fNGrpRecon; ++k) {
+         KVGroupReconstructor* grec = (KVGroupReconstructor*)fGroupReconstructor[fHitGroups[k]];
+         if (fParallelIdentification) grec->ReconstructAndIdentify();
+         else grec->ReconstructParticles();
+      }
+      if (!fParallelIdentification) IdentifyHitGroups();
+      CalibrateHitGroups();
+   }
+   else {
+      for (int k = 0; k < fNGrpRecon; ++k) {
+         ((KVGroupReconstructor*)fGroupReconstructor[fHitGroups[k]])->Process();
+      }
+   }
+
    // merge resulting event fragments
    MergeGroupEventFragments();
 
@@ -134,3 +202,54 @@ void KVEventReconstructor::MergeGroupEventFragments()
    }
    GetEvent()->MergeEventFragments(&to_merge, "N");// "N" = no group reset
 }
+
+void KVEventReconstructor::ProcessHitGroupsInParallel()
+{
+   // Reconstruction of particles in each hit group is performed concurrently by the worker threads,
+   // as is identification if EventReconstruction.ParallelIdentification is 'yes'; otherwise
+   // identification is performed sequentially for each group (see IdentifyHitGroups()).
+   // Calibration is then performed sequentially for each group (energy loss calculations are not reentrant).
+
+#ifdef WITH_CPP11
+   Bool_t parallel_id = fParallelIdentification;
+   for (int k = 0; k < fNGrpRecon; ++k) {
+      KVGroupReconstructor* grec = (KVGroupReconstructor*)fGroupReconstructor[fHitGroups[k]];
+      fThreadPool->Submit([grec, parallel_id]() {
+         if (parallel_id) grec->ReconstructAndIdentify();
+         else grec->ReconstructParticles();
+      });
+   }
+   fThreadPool->Wait();
+   if (!parallel_id) IdentifyHitGroups();
+   CalibrateHitGroups();
+#endif
+}
+
+void KVEventReconstructor::IdentifyHitGroups()
+{
+   // Identification of particles in each hit group, once all have been reconstructed.
+   // If SetSerializeCalibration() was called, waits until no other reconstructor is identifying
+   // (identification grids are shared by all working copies of the array).
+
+#ifdef WITH_CPP11
+   std::unique_lock<std::mutex> lock(identification_mutex, std::defer_lock);
+   if (fSerializeCalibration) lock.lock();
+#endif
+   for (int k = 0; k < fNGrpRecon; ++k) {
+      ((KVGroupReconstructor*)fGroupReconstructor[fHitGroups[k]])->IdentifyIfRequired();
+   }
+}
+
+void KVEventReconstructor::CalibrateHitGroups()
+{
+   // Calibration of particles in each hit group, once all have been reconstructed & identified.
+   // If SetSerializeCalibration() was called, waits until no other reconstructor is calibrating.
+
+#ifdef WITH_CPP11
+   std::unique_lock<std::mutex> lock(calibration_mutex, std::defer_lock);
+   if (fSerializeCalibration) lock.lock();
+#endif
+   for (int k = 0; k < fNGrpRecon; ++k) {
+      ((KVGroupReconstructor*)fGroupReconstructor[fHitGroups[k]])->CalibrateIfRequired();
+   }
+}
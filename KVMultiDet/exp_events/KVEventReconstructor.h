@@ -10,6 +10,8 @@
 #include "KVMultiDetArray.h"
 #include "KVReconstructedEvent.h"
 
+class KVThreadPool;
+
 /**
   \class KVEventReconstructor
   \ingroup Reconstruction
@@ -27,6 +29,38 @@
     using a KVGroupReconstructor-derived object (uses plugins)
  -# Merge together the different event fragments into the output reconstructed
     event object
+
+ ### Parallel reconstruction of groups
+ As groups are independent by construction (see KVMultiDetArray::DeduceGroupsFromTrajectories),
+ the reconstruction of particles in the different hit groups of an event
+ can be performed concurrently by a pool of worker threads. This is enabled by giving a number
+ of threads > 0 for the (possibly dataset-dependent) variable
+
+~~~~
+EventReconstruction.NumberOfThreads: 4
+~~~~
+
+ By default the particles of each group are then identified sequentially once all groups have been
+ reconstructed, as identification grids may be shared by telescopes in different groups, and not all
+ of them are reentrant (e.g. KVIDQAGrid). If all identifications used by a dataset are reentrant
+ (such as KVIDZAGrid::Identify()), identification can also be performed by the worker threads by setting
+ the following (possibly dataset-dependent) variable:
+
+~~~~
+EventReconstruction.ParallelIdentification: yes
+~~~~
+
+ Calibration of the particles in each group is then performed sequentially once all groups
+ have been treated, as energy loss calculations are not (yet) reentrant.
+ The merged event is identical to that obtained with sequential reconstruction.
+
+ ### Parallel reconstruction of events
+ Several events can be reconstructed at the same time by different KVEventReconstructor objects,
+ each using its own working copy of the array (see KVMultiDetArray::MakeWorkingCopy() and
+ KVReconstructionPipeline). In this case SetSerializeCalibration() must be called for each of them:
+ calibration is then performed by only one reconstructor at a time, as is identification
+ (working copies share the identification grids) unless EventReconstruction.ParallelIdentification
+ is 'yes'.
 */
 class KVEventReconstructor : public KVBase {
 
@@ -37,6 +71,13 @@ private:
    Int_t           fNGrpRecon;//!          number of group reconstructors for current event
    std::vector<int> fHitGroups;//!         group indices in current event
    KVDetectorEvent detev;//!               list of hit groups in event
+   KVThreadPool*   fThreadPool;//!         worker threads for parallel group reconstruction
+   Bool_t          fSerializeCalibration;//! kTRUE if other reconstructors calibrate events concurrently
+   Bool_t          fParallelIdentification;//! kTRUE if groups may be identified concurrently
+
+   void ProcessHitGroupsInParallel();
+   void IdentifyHitGroups();
+   void CalibrateHitGroups();
 
 protected:
    KVMultiDetArray* GetArray()
@@ -46,17 +87,37 @@ protected:
 
 public:
    KVEventReconstructor(KVMultiDetArray*, KVReconstructedEvent*, Bool_t = kFALSE);
-   virtual ~KVEventReconstructor() {}
+   virtual ~KVEventReconstructor();
 
    void Copy(TObject& obj) const;
 
    void ReconstructEvent(const TSeqCollection* = nullptr);
    void MergeGroupEventFragments();
 
+   void SetSerializeCalibration(Bool_t yes = kTRUE)
+   {
+      // Call with yes=kTRUE if other reconstructors (using working copies of the array)
+      // reconstruct events at the same time as this one: calibration of events by all
+      // such reconstructors is then performed by only one of them at a time, as is
+      // identification unless EventReconstruction.ParallelIdentification is 'yes'.
+      fSerializeCalibration = yes;
+   }
+   Bool_t IsParallelReconstruction() const
+   {
+      // kTRUE if hit groups are reconstructed concurrently
+      return fThreadPool != nullptr;
+   }
+
    KVReconstructedEvent* GetEvent()
    {
       return fEvent;
    }
+   void SetEvent(KVReconstructedEvent* e)
+   {
+      // Change the event into which the next events will be reconstructed.
+      // It must be of the same class as the event given to the constructor.
+      fEvent = e;
+   }
    void* GetEventReference()
    {
       // for KVEvent::MakeEventBranch
@@ -278,6 +278,16 @@ void KVExpSetUp::prepare_to_handle_new_raw_data()
    }
 }
 
+void KVExpSetUp::set_global_pointers()
+{
+   // Make any global pointers to the individual arrays (e.g. gFazia) point to our arrays
+   TIter next_array(&fMDAList);
+   KVMultiDetArray* mda;
+   while ((mda = (KVMultiDetArray*)next_array())) {
+      mda->set_global_pointers();
+   }
+}
+
 void KVExpSetUp::copy_fired_parameters_to_recon_param_list()
 {
    TIter next_array(&fMDAList);
@@ -33,6 +33,7 @@ protected:
 #endif
    void prepare_to_handle_new_raw_data();
    void copy_fired_parameters_to_recon_param_list();
+   void set_global_pointers();
 
 public:
 
@@ -13,6 +13,9 @@
 #include <KVRangeTableGeoNavigator.h>
 #include <KVNamedParameter.h>
 #include <KVDataAnalyser.h>
+#include <KVMultiDetArraySnapshot.h>
+#include <TMD5.h>
+#include <TEnv.h>
 
 ClassImp(KVGeoImport)
 
@@ -76,6 +79,11 @@ void KVGeoImport::ImportGeometry(Double_t dTheta, Double_t dPhi,
    // This is done by sending out "particles" from (0,0,0) or (x,y,z) (if SetOrigin(x,y,z) was called)
    // in all directions between (ThetaMin,ThetaMax) - with respect to Z-axis - and (PhiMin,PhiMax) - cylindrical
    // angle in the (X,Y)-plane, over a grid of step dTheta in Theta and dPhi in Phi.
+   //
+   // If snapshots are enabled for the dataset of the array (see KVMultiDetArraySnapshot), the directions
+   // in which something new (detector, detector volume or trajectory) was found are written in a snapshot
+   // file. As long as the geometry, the scan parameters and the naming of detectors do not change,
+   // only these directions are used the next time the array is built, which gives the same result.
 
    Int_t ndets0 = fArray->GetDetectors()->GetEntries();
 
@@ -83,29 +91,60 @@ void KVGeoImport::ImportGeometry(Double_t dTheta, Double_t dPhi,
    KVNucleus* nuc = evt->AddParticle();
    nuc->SetZAandE(1, 1, 1);
 
-   Info("ImportGeometry",
-        "Importing geometry in angular ranges : Theta=[%f,%f:%f] Phi=[%f,%f:%f]", ThetaMin, ThetaMax, dTheta, PhiMin, PhiMax, dPhi);
-   if (fOrigin)
-      Info("ImportGeometry",
-           "Origin for geometry = (%f,%f,%f)", fOrigin->x(), fOrigin->y(), fOrigin->z());
+   unique_ptr<KVMultiDetArraySnapshot> snapshot;
+   TString checksum;
+   std::vector<Double_t> snap_theta, snap_phi;
+   Bool_t replay = kFALSE;
+   if (fCreateArray && KVMultiDetArraySnapshot::IsEnabled(fArray)) {
+      snapshot.reset(new KVMultiDetArraySnapshot(fArray));
+      checksum = GetScanChecksum(dTheta, dPhi, ThetaMin, PhiMin, ThetaMax, PhiMax);
+      replay = snapshot->ReadScanDirections(fArray, checksum, snap_theta, snap_phi);
+   }
+
    Int_t count = 0;
-   if (!KVDataAnalyser::IsRunningBatchAnalysis())
-      std::cout << "\xd" << "Info in <KVGeoImport::ImportGeometry>: tested " << count << " directions" << std::flush;
-   for (Double_t theta = ThetaMin; theta <= ThetaMax; theta += dTheta) {
-      for (Double_t phi = PhiMin; phi <= PhiMax; phi += dPhi) {
-         nuc->SetTheta(theta);
-         nuc->SetPhi(phi);
-         fLastDetector = nullptr;
-         PropagateEvent(evt.get(), fOrigin);
-         count++;
-         if (!KVDataAnalyser::IsRunningBatchAnalysis())
-            std::cout << "\xd" << "Info in <KVGeoImport::ImportGeometry>: tested " << count << " directions" << std::flush;
+   // propagate particle in given direction, returns kTRUE if anything new was found
+   auto propagate = [&](Double_t theta, Double_t phi) {
+      Int_t ndets = fArray->GetDetectors()->GetEntries();
+      Int_t ntraj = fArray->GetTrajectories()->GetEntries();
+      Int_t npaths = fDetectorPaths.GetEntries();
+      nuc->SetTheta(theta);
+      nuc->SetPhi(phi);
+      fLastDetector = nullptr;
+      PropagateEvent(evt.get(), fOrigin);
+      count++;
+      if (!KVDataAnalyser::IsRunningBatchAnalysis())
+         std::cout << "\xd" << "Info in <KVGeoImport::ImportGeometry>: tested " << count << " directions" << std::flush;
+      return (fArray->GetDetectors()->GetEntries() > ndets || fArray->GetTrajectories()->GetEntries() > ntraj
+              || fDetectorPaths.GetEntries() > npaths);
+   };
+
+   if (replay) {
+      Info("ImportGeometry",
+           "Using %d directions from snapshot %s", (Int_t)snap_theta.size(), snapshot->GetScanFile(fArray).Data());
+      for (size_t i = 0; i < snap_theta.size(); ++i) propagate(snap_theta[i], snap_phi[i]);
+   }
+   else {
+      Info("ImportGeometry",
+           "Importing geometry in angular ranges : Theta=[%f,%f:%f] Phi=[%f,%f:%f]", ThetaMin, ThetaMax, dTheta, PhiMin, PhiMax, dPhi);
+      if (fOrigin)
+         Info("ImportGeometry",
+              "Origin for geometry = (%f,%f,%f)", fOrigin->x(), fOrigin->y(), fOrigin->z());
+      if (!KVDataAnalyser::IsRunningBatchAnalysis())
+         std::cout << "\xd" << "Info in <KVGeoImport::ImportGeometry>: tested " << count << " directions" << std::flush;
+      for (Double_t theta = ThetaMin; theta <= ThetaMax; theta += dTheta) {
+         for (Double_t phi = PhiMin; phi <= PhiMax; phi += dPhi) {
+            if (propagate(theta, phi) && snapshot) {
+               snap_theta.push_back(theta);
+               snap_phi.push_back(phi);
+            }
+         }
       }
    }
    if (KVDataAnalyser::IsRunningBatchAnalysis())
       std::cout << "Info in <KVGeoImport::ImportGeometry>: tested " << count << " directions" << std::endl;
    else
       std::cout << std::endl;
+   if (snapshot && !replay) snapshot->WriteScanDirections(fArray, checksum, snap_theta, snap_phi);
 
    Info("ImportGeometry",
         "Imported %d detectors into array", fArray->GetDetectors()->GetEntries() - ndets0);
@@ -140,6 +179,39 @@ void KVGeoImport::ImportGeometry(Double_t dTheta, Double_t dPhi,
    }
 }
 
+TString KVGeoImport::GetScanChecksum(Double_t dTheta, Double_t dPhi,
+                                     Double_t ThetaMin, Double_t PhiMin, Double_t ThetaMax, Double_t PhiMax) const
+{
+   // MD5 checksum of all inputs which determine the result of ImportGeometry() with the given arguments:
+   // the geometry itself, the origin, the accepted detector names, the detector plugin, any formats and
+   // correspondance lists used to name detectors and structures, and the version of KaliVeda.
+   //
+   // Used to check that a snapshot of the directions of the scan (see KVMultiDetArraySnapshot) is up to date.
+
+   TString inputs = Form("%s|%s|%s|%.10g|%.10g|%.10g|%.10g|%.10g|%.10g",
+                         KVMultiDetArraySnapshot::GetGeometryChecksum(GetGeometry()).Data(), GetKVVersion(),
+                         fDetectorPlugin.Data(), dTheta, dPhi, ThetaMin, PhiMin, ThetaMax, PhiMax);
+   if (fOrigin) inputs += Form("|origin=%.10g,%.10g,%.10g", fOrigin->x(), fOrigin->y(), fOrigin->z());
+   if (fCheckDetVolNames) {
+      for (int i = 0; i < fAcceptedDetectorNames.GetNpar(); ++i)
+         inputs += Form("|accept=%s", fAcceptedDetectorNames.GetNameAt(i));
+   }
+   inputs += Form("|detfmt=%s", fDetNameFmt.Data());
+   for (int i = 0; i < fStrucNameFmt.GetEntries(); ++i) {
+      KVNamedParameter* fmt = fStrucNameFmt.GetParameter(i);
+      inputs += Form("|strucfmt=%s:%s", fmt->GetName(), fmt->GetString());
+   }
+   if (fDetStrucNameCorrespList) {
+      TIter next(fDetStrucNameCorrespList->GetTable());
+      TEnvRec* rec;
+      while ((rec = (TEnvRec*)next())) inputs += Form("|%s:%s", rec->GetName(), rec->GetValue());
+   }
+   TMD5 md5;
+   md5.Update((const UChar_t*)inputs.Data(), inputs.Length());
+   md5.Final();
+   return md5.AsString();
+}
+
 void KVGeoImport::SetLastDetector(KVDetector* d)
 {
    fLastDetector = d;
@@ -76,6 +76,8 @@ class KVGeoImport : public KVGeoNavigator {
    KVDetector* GetCurrentDetector();
    KVDetector* BuildDetector(TString det_name, TGeoVolume* det_vol);
    void AddLayer(KVDetector*, TGeoVolume*);
+   TString GetScanChecksum(Double_t dTheta, Double_t dPhi, Double_t ThetaMin, Double_t PhiMin,
+                           Double_t ThetaMax, Double_t PhiMax) const;
    KVNameValueList fAcceptedDetectorNames;
    Bool_t fCheckDetVolNames;
 
@@ -78,12 +78,46 @@ void KVGroupReconstructor::Process()
    //   - identification can be inhibited (for all groups) by calling KVGroupReconstructor::SetDoIdentification(false);
    //   - calibration can be inhibited (for all groups) by calling KVGroupReconstructor::SetDoCalibration(false);
 
+   ReconstructAndIdentify();
+   CalibrateIfRequired();
+}
+
+void KVGroupReconstructor::ReconstructAndIdentify()
+{
+   // First part of Process(): reconstruct particles in group, then identify them
+   // (unless identification is inhibited, see SetDoIdentification())
+
+   ReconstructParticles();
+   IdentifyIfRequired();
+}
+
+void KVGroupReconstructor::ReconstructParticles()
+{
+   // First step of ReconstructAndIdentify(): reconstruct particles in group
+
    nfireddets = 0;
    Reconstruct();
+}
+
+void KVGroupReconstructor::IdentifyIfRequired()
+{
+   // Second step of ReconstructAndIdentify(): identify particles reconstructed in group
+   // (unless identification is inhibited, see SetDoIdentification())
+
    if (GetEventFragment()->GetMult() == 0) {
       return;
    }
    if (fDoIdentification) Identify();
+}
+
+void KVGroupReconstructor::CalibrateIfRequired()
+{
+   // Second part of Process(): calibrate particles reconstructed in group
+   // (unless calibration is inhibited, see SetDoCalibration())
+
+   if (GetEventFragment()->GetMult() == 0) {
+      return;
+   }
    if (fDoCalibration) Calibrate();
 }
 
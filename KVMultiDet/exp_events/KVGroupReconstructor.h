@@ -83,6 +83,10 @@ public:
    static KVGroupReconstructor* Factory(const TString& plugin = "");
 
    void Process();
+   void ReconstructAndIdentify();
+   void ReconstructParticles();
+   void IdentifyIfRequired();
+   void CalibrateIfRequired();
    void Reconstruct();
    virtual void Identify();
    void Calibrate();
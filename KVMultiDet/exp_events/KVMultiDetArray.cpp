@@ -40,6 +40,9 @@
 #include <KVNamedParameter.h>
 #include <KVCalibrator.h>
 #include <KVDBParameterSet.h>
+#include "KVMultiDetArraySnapshot.h"
+#include "KVRunTransitionPlanner.h"
+#include <set>
 #ifdef WITH_OPENGL
 #include <TGLViewer.h>
 #include <TVirtualPad.h>
@@ -63,6 +66,7 @@ KVMultiDetArray* gMultiDetArray = nullptr;
 Bool_t KVMultiDetArray::fCloseGeometryNow = kTRUE;
 Bool_t KVMultiDetArray::fBuildTarget = kFALSE;
 Bool_t KVMultiDetArray::fMakeMultiDetectorSetParameters = kTRUE;
+Bool_t KVMultiDetArray::fMakingWorkingCopy = kFALSE;
 
 ClassImp(KVMultiDetArray)
 
@@ -117,7 +121,8 @@ void KVMultiDetArray::init()
    fROOTGeometry = gEnv->GetValue("KVMultiDetArray.ROOTGeometry", kTRUE);
    fFilterType = kFilterType_Full;
 
-//   fGeoManager = 0;
+   fGeoManager = nullptr;
+   fIsWorkingCopy = fMakingWorkingCopy;
    fNavigator = 0;
    fUpDater = 0;
 
@@ -130,6 +135,7 @@ void KVMultiDetArray::init()
    SetOwnsDetectors();
 
    fHandledRawData = false;
+   fRunTransitions = nullptr;
 }
 
 //___________________________________________________________________________________
@@ -138,6 +144,7 @@ KVMultiDetArray::~KVMultiDetArray()
    //destroy (delete) the MDA and all the associated structure, detectors etc.
 
    SafeDelete(fHitGroups);
+   SafeDelete(fRunTransitions);
    //destroy all identification telescopes
    if (fIDTelescopes && fIDTelescopes->TestBit(kNotDeleted)) {
       fIDTelescopes->Delete();
@@ -171,7 +178,17 @@ KVMultiDetArray::~KVMultiDetArray()
    }
 
    if (fNavigator) {
-      if (gGeoManager) {
+      // the geometry of a working copy is never the global gGeoManager of the main array
+      // (but the arrays making up a working copy of a KVExpSetUp share the geometry of the copy)
+      if (fGeoManager) {
+         // the geometry being deleted must be the current one
+         TGeoManager* main_geometry = (gGeoManager == fGeoManager ? nullptr : gGeoManager);
+         gGeoManager = fGeoManager;
+         delete fGeoManager;
+         fGeoManager = nullptr;
+         gGeoManager = main_geometry;
+      }
+      else if (gGeoManager && fNavigator->GetGeometry() == gGeoManager) {
          delete gGeoManager;
          gGeoManager = nullptr;
       }
@@ -998,14 +1015,22 @@ void KVMultiDetArray::DetectEvent(KVEvent* event, KVReconstructedEvent* rec_even
       while ((grp_tch = (KVGroup*) nxt_grp())) {
          grp_tch->ClearHitDetectors();
       }
+      // group indices are looked up once, not for every particle
+      static const Int_t detected = KVParticle::GetGroupIndex("DETECTED");
+      static const Int_t undetected = KVParticle::GetGroupIndex("UNDETECTED");
+      static const Int_t no_hit = KVParticle::GetGroupIndex("NO HIT");
+      static const Int_t dead_zone = KVParticle::GetGroupIndex("DEAD ZONE");
+      static const Int_t geo_incoherency = KVParticle::GetGroupIndex("GEOMETRY INCOHERENCY");
+      static const Int_t neutron = KVParticle::GetGroupIndex("NEUTRON");
+      static const Int_t no_energy = KVParticle::GetGroupIndex("NO ENERGY");
       while ((part = event->GetNextParticle())) {
-         if (part->BelongsToGroup("DETECTED") ||
-               (part->BelongsToGroup("UNDETECTED") &&
-                !part->BelongsToGroup("NO HIT") &&
-                !part->BelongsToGroup("DEAD ZONE") &&
-                !part->BelongsToGroup("GEOMETRY INCOHERENCY") &&
-                !part->BelongsToGroup("NEUTRON") &&
-                !part->BelongsToGroup("NO ENERGY"))
+         if (part->BelongsToGroupIndex(detected) ||
+               (part->BelongsToGroupIndex(undetected) &&
+                !part->BelongsToGroupIndex(no_hit) &&
+                !part->BelongsToGroupIndex(dead_zone) &&
+                !part->BelongsToGroupIndex(geo_incoherency) &&
+                !part->BelongsToGroupIndex(neutron) &&
+                !part->BelongsToGroupIndex(no_energy))
             ) {
             KVDetector* last_det = 0;
             if (part->GetParameters()->HasParameter("STOPPING DETECTOR"))
@@ -1408,82 +1433,150 @@ void KVMultiDetArray::SetArrayACQParams()
    // This implementation does nothing: override it in derived classes if needed.
 }
 
+KVRunTransitionPlanner* KVMultiDetArray::get_run_transitions()
+{
+   // Returns the object used to plan incremental changes of calibrators and grids between runs,
+   // or nullptr if incremental updates are disabled (see KVRunTransitionPlanner::IsEnabled())
+
+   TString ds = GetDataSet();
+   if (ds == "" && gDataSet) ds = gDataSet->GetName();
+   if (!KVRunTransitionPlanner::IsEnabled(ds)) {
+      SafeDelete(fRunTransitions);
+      return nullptr;
+   }
+   if (!fRunTransitions) fRunTransitions = new KVRunTransitionPlanner;
+   return fRunTransitions;
+}
+
+Bool_t KVMultiDetArray::set_calibrator_parameters(KVCalibrator* cal, KVDBParameterSet* dbps)
+{
+   // Set parameters of calibrator from database record. Returns kFALSE if the number of parameters is wrong.
+
+   if (dbps->GetParamNumber() > cal->GetNumberParams()) {
+      Warning("SetCalibratorParameters", "Wrong number of parameters (%d) for calibrator %s for detector %s : should be %d",
+              dbps->GetParamNumber(), dbps->GetTitle(), dbps->GetName(), cal->GetNumberParams());
+      dbps->Print();
+      return kFALSE;
+   }
+   for (int i = 0; i < dbps->GetParamNumber(); ++i) {
+      if (i >= cal->GetNumberParams())
+         cal->SetParameter(i, 0);
+      else
+         cal->SetParameter(i, dbps->GetParameter(i));
+   }
+   cal->SetStatus(true);
+   return kTRUE;
+}
+
+KVCalibrator* KVMultiDetArray::make_calibrator(KVDetector* det, KVDBParameterSet* dbps)
+{
+   // Create calibrator for detector from database record and add it to the detector.
+   // Returns nullptr if no calibrator could be added to the detector.
+
+   KVNameValueList class_options;
+   KVString clop;
+   if (dbps->HasParameter("CalibOptions")) clop = dbps->GetStringParameter("CalibOptions");
+   if (clop != "") {
+      clop.Begin(",");
+      while (!clop.End()) {
+         KVString clopp = clop.Next(true);
+         clopp.Begin("=");
+         KVString par(clopp.Next(true)), val(clopp.Next(true));
+         class_options.SetValue(par, val);
+      }
+   }
+   KVCalibrator* cal = KVCalibrator::MakeCalibrator(dbps->GetStringParameter("CalibClass"));
+   cal->SetType(dbps->GetTitle());
+   if (clop != "") {
+      try {
+         cal->SetOptions(class_options);
+      }
+      catch (std::exception& e) {
+         Error("SetCalibratorParameters",
+               "Problem for %s [%s] : %s", det->GetName(), cal->GetType(), e.what());
+         delete cal;
+         return nullptr;
+      }
+   }
+   cal->SetInputSignalType(dbps->GetStringParameter("SignalIn"));
+   cal->SetOutputSignalType(dbps->GetStringParameter("SignalOut"));
+   if (!det->AddCalibrator(cal, dbps->GetParameters())) {
+      // Calibrator invalid - probably input signal is not defined for detector
+      // N.B. 'cal' deleted by KVDetector::AddCalibrator
+      return nullptr;
+   }
+   set_calibrator_parameters(cal, dbps);
+   return cal;
+}
+
 void KVMultiDetArray::SetCalibratorParameters(KVDBRun* r, const TString& myname)
 {
    // Sets up calibrators for all detectors with a defined calibration for run
    // Set parameters for all detectors with links to table "Calibrations" for run
    // If 'myname' is given, we look in "myname.Calibrations"
+   //
+   // Unless incremental updates are disabled (see KVRunTransitionPlanner), the calibrators
+   // set up for the previous run are compared with the database records for the new run:
+   // the calibrators of detectors whose records have not changed are kept as they are,
+   // those of detectors whose records only differ by the values of the parameters are given
+   // the new values, and only the others are removed and created again.
 
-   //Reset all calibrators of all detectors first
-   TIter next(GetDetectors());
-   KVDetector* kvd;
-   while ((kvd = (KVDetector*) next())) kvd->RemoveCalibrators();
+   KVRunTransitionPlanner* planner = get_run_transitions();
 
    TString tabname = (myname != "" ? Form("%s.Calibrations", myname.Data()) : "Calibrations");
    Info("SetCalibratorParameters", "For array %s in table %s", GetName(), tabname.Data());
    KVRList* run_links = r->GetLinks(tabname);
    if (run_links) Info("SetCalibratorParameters", "Found %d calibrations for this run", run_links->GetEntries());
    else {
+      //Reset all calibrators of all detectors
+      TIter next(GetDetectors());
+      KVDetector* kvd;
+      while ((kvd = (KVDetector*) next())) kvd->RemoveCalibrators();
+      if (planner) planner->ForgetCalibrations();
       Warning("SetCalibratorParameters", "Got no links for %s", tabname.Data());
       r->GetKeys()->ls();
       return;
    }
+
+   // database records for each detector, in the order of the links
+   std::map<KVDetector*, std::vector<KVDBParameterSet*> > records;
    TIter nxt_link(run_links);
    KVDBParameterSet* dbps;
    while ((dbps = (KVDBParameterSet*)nxt_link())) {
-
       KVDetector* det = GetDetector(dbps->GetName());
       if (!det) {
          Warning("SetCalibratorParameters", "Got parameters for unknown detector: %s", dbps->GetName());
          continue;
       }
+      records[det].push_back(dbps);
+   }
 
-      KVNameValueList class_options;
-      KVString clop;
-      if (dbps->HasParameter("CalibOptions")) clop = dbps->GetStringParameter("CalibOptions");
-      if (clop != "") {
-         clop.Begin(",");
-         while (!clop.End()) {
-            KVString clopp = clop.Next(true);
-            clopp.Begin("=");
-            KVString par(clopp.Next(true)), val(clopp.Next(true));
-            class_options.SetValue(par, val);
-         }
-      }
-      KVCalibrator* cal = KVCalibrator::MakeCalibrator(dbps->GetStringParameter("CalibClass"));
-      cal->SetType(dbps->GetTitle());
-      if (clop != "") {
-         try {
-            cal->SetOptions(class_options);
-         }
-         catch (std::exception& e) {
-            Error("SetCalibratorParameters",
-                  "Problem for %s [%s] : %s", det->GetName(), cal->GetType(), e.what());
-            delete cal;
-            continue;
-         }
-      }
-      cal->SetInputSignalType(dbps->GetStringParameter("SignalIn"));
-      cal->SetOutputSignalType(dbps->GetStringParameter("SignalOut"));
-      if (!det->AddCalibrator(cal, dbps->GetParameters())) {
-         // Calibrator invalid - probably input signal is not defined for detector
-         // N.B. 'cal' deleted by KVDetector::AddCalibrator
+   TIter next(GetDetectors());
+   KVDetector* det;
+   while ((det = (KVDetector*) next())) {
+      std::map<KVDetector*, std::vector<KVDBParameterSet*> >::iterator it = records.find(det);
+      if (it == records.end()) {
+         // no calibration for this run
+         det->RemoveCalibrators();
+         if (planner) planner->ForgetCalibrations(det);
          continue;
       }
-
-      if (dbps->GetParamNumber() > cal->GetNumberParams()) {
-         Warning("SetCalibratorParameters", "Wrong number of parameters (%d) for calibrator %s for detector %s : should be %d",
-                 dbps->GetParamNumber(), dbps->GetTitle(), dbps->GetName(), cal->GetNumberParams());
-         dbps->Print();
+      const std::vector<KVDBParameterSet*>& det_records = it->second;
+      KVRunTransitionPlanner::EAction action = (planner ? planner->PlanCalibrations(det, det_records) : KVRunTransitionPlanner::kRebuild);
+      if (action == KVRunTransitionPlanner::kKeep) continue;
+      if (action == KVRunTransitionPlanner::kReparameterise) {
+         const std::vector<KVCalibrator*>& cals = *planner->GetCalibrators(det);
+         for (size_t i = 0; i < det_records.size(); ++i) {
+            if (cals[i]) set_calibrator_parameters(cals[i], det_records[i]);
+         }
          continue;
       }
-      for (int i = 0; i < dbps->GetParamNumber(); ++i) {
-         if (i >= cal->GetNumberParams())
-            cal->SetParameter(i, 0);
-         else
-            cal->SetParameter(i, dbps->GetParameter(i));
-      }
-      cal->SetStatus(true);
+      det->RemoveCalibrators();
+      std::vector<KVCalibrator*> cals;
+      cals.reserve(det_records.size());
+      for (std::vector<KVDBParameterSet*>::const_iterator rec = det_records.begin(); rec != det_records.end(); ++rec)
+         cals.push_back(make_calibrator(det, *rec));
+      if (planner) planner->SetCalibrators(det, cals);
    }
 }
 
@@ -1727,6 +1820,139 @@ KVMultiDetArray* KVMultiDetArray::MakeMultiDetector(const Char_t* dataset_name,
    return mda;
 }
 
+KVMultiDetArray* KVMultiDetArray::MakeWorkingCopy()
+{
+   // Create and return a working copy of this array, for use in parallel processing of events
+   // (see KVReconstructionPipeline). The copy is deleted by the caller.
+   //
+   // The copy is built for the same dataset and run as this array, and has its own detectors,
+   // acquisition parameters, ID telescopes, groups, trajectories and target, i.e. all the
+   // state which is modified while handling and reconstructing an event.
+   // The following are shared with this array and are not read again:
+   //   - identification grids (kept by gIDGridManager: KVIDGraph::Identify is reentrant)
+   //   - the experimental database (gExpDB) from which calibration parameters are set
+   //   - range tables used for energy loss calculations (KVMaterial::GetRangeTable())
+   //
+   // The ROOT geometry of the copy is built in its own TGeoManager, which is deleted with
+   // the copy. gGeoManager, gMultiDetArray and any other global pointers to this array
+   // (e.g. gFazia) are unchanged.
+   //
+   // To update the copy for a new run, call SetParameters(run) for the copy after doing it
+   // for this array. As the dataset updaters set parameters through the global pointers,
+   // these point to the copy while it is updated, and are then restored.
+   // Use HasSameCalibrationsAs() to check that the copy has the same calibrations and
+   // grids as this array.
+
+   if (fDataSet == "") {
+      Error("MakeWorkingCopy", "Only arrays built with MakeMultiDetector() can be copied");
+      return nullptr;
+   }
+   KVMultiDetArray* main_array = gMultiDetArray;
+   TGeoManager* main_geometry = gGeoManager;
+   gMultiDetArray = nullptr;
+   gGeoManager = nullptr;
+   fMakingWorkingCopy = kTRUE;
+
+   KVMultiDetArray* copy = MakeMultiDetector(fDataSet, fCurrentRun ? (Int_t)fCurrentRun : -1);
+
+   fMakingWorkingCopy = kFALSE;
+   if (copy) {
+      if (gGeoManager != main_geometry) copy->fGeoManager = gGeoManager;
+      if (copy->IsA() != IsA()) {
+         Error("MakeWorkingCopy", "Copy of %s array is of class %s",
+               IsA()->GetName(), copy->IsA()->GetName());
+         SafeDelete(copy);
+      }
+   }
+   gMultiDetArray = main_array;
+   gGeoManager = main_geometry;
+   set_global_pointers();
+   return copy;
+}
+
+KVMultiDetArray::global_pointers_t KVMultiDetArray::make_global()
+{
+   // For a working copy of an array, make gMultiDetArray, gGeoManager and any other global pointers
+   // (see set_global_pointers()) point to this array and its geometry, and return their previous values
+   // to be given to restore_global().
+   // Nothing is changed for any other array.
+
+   global_pointers_t globals(gMultiDetArray, gGeoManager);
+   if (fIsWorkingCopy && gMultiDetArray != this) {
+      gMultiDetArray = this;
+      if (fGeoManager) gGeoManager = fGeoManager;
+      set_global_pointers();
+   }
+   return globals;
+}
+
+void KVMultiDetArray::restore_global(const global_pointers_t& globals)
+{
+   // Restore global pointers changed by make_global()
+
+   if (gMultiDetArray == globals.first) return;
+   gMultiDetArray = globals.first;
+   gGeoManager = globals.second;
+   if (gMultiDetArray) gMultiDetArray->set_global_pointers();
+}
+
+Bool_t KVMultiDetArray::HasSameCalibrationsAs(const KVMultiDetArray* other) const
+{
+   // Returns kTRUE if the detectors of this array have the same calibrators (same class, type, status &
+   // parameters) as the detectors with the same names in the other array, and if all ID telescopes
+   // have the same identification grids as the telescopes with the same names in the other array.
+   //
+   // Use to check that a working copy of an array (see MakeWorkingCopy()) has been correctly
+   // updated for a new run.
+
+   TIter next_det(GetDetectors());
+   KVDetector* det;
+   while ((det = (KVDetector*)next_det())) {
+      KVDetector* other_det = other->GetDetector(det->GetName());
+      if (!other_det) {
+         Error("HasSameCalibrationsAs", "No detector %s in %s", det->GetName(), other->GetName());
+         return kFALSE;
+      }
+      KVList* cals = det->GetListOfCalibrators();
+      KVList* other_cals = other_det->GetListOfCalibrators();
+      Int_t ncal = (cals ? cals->GetEntries() : 0);
+      if (ncal != (other_cals ? other_cals->GetEntries() : 0)) {
+         Error("HasSameCalibrationsAs", "%s: different number of calibrators", det->GetName());
+         return kFALSE;
+      }
+      for (Int_t i = 0; i < ncal; ++i) {
+         KVCalibrator* cal = (KVCalibrator*)cals->At(i);
+         KVCalibrator* other_cal = (KVCalibrator*)other_cals->At(i);
+         Bool_t same = (cal->IsA() == other_cal->IsA()) && !strcmp(cal->GetType(), other_cal->GetType())
+                       && cal->GetStatus() == other_cal->GetStatus() && cal->GetNumberParams() == other_cal->GetNumberParams();
+         for (Int_t p = 0; same && p < cal->GetNumberParams(); ++p) same = (cal->GetParameter(p) == other_cal->GetParameter(p));
+         if (!same) {
+            Error("HasSameCalibrationsAs", "%s: calibrator %s is different", det->GetName(), cal->GetType());
+            return kFALSE;
+         }
+      }
+   }
+   TIter next_idt(GetListOfIDTelescopes());
+   KVIDTelescope* idt;
+   while ((idt = (KVIDTelescope*)next_idt())) {
+      KVIDTelescope* other_idt = (KVIDTelescope*)other->GetListOfIDTelescopes()->FindObject(idt->GetName());
+      if (!other_idt) {
+         Error("HasSameCalibrationsAs", "No ID telescope %s in %s", idt->GetName(), other->GetName());
+         return kFALSE;
+      }
+      const KVList* grids = idt->GetListOfIDGrids();
+      const KVList* other_grids = other_idt->GetListOfIDGrids();
+      Int_t ngr = (grids ? grids->GetEntries() : 0);
+      Bool_t same = (ngr == (other_grids ? other_grids->GetEntries() : 0));
+      for (Int_t i = 0; same && i < ngr; ++i) same = (grids->At(i) == other_grids->At(i));
+      if (!same) {
+         Error("HasSameCalibrationsAs", "%s: identification grids are different", idt->GetName());
+         return kFALSE;
+      }
+   }
+   return kTRUE;
+}
+
 KVUpDater* KVMultiDetArray::GetUpDater()
 {
    // Return pointer to KVUpDater defined by dataset for this multidetector, the class used
@@ -1764,7 +1990,9 @@ void KVMultiDetArray::SetParameters(UInt_t run)
          ds = gDataSetManager->GetDataSet(fDataSet.Data());
    }
    if (ds) {
+      global_pointers_t globals = make_global();
       GetUpDater()->SetParameters(run);
+      restore_global(globals);
       SetBit(kParamsSet);
    }
 }
@@ -1784,7 +2012,9 @@ void KVMultiDetArray::SetRunIdentificationParameters(UShort_t run)
          ds = gDataSetManager->GetDataSet(fDataSet.Data());
    }
    if (ds) {
+      global_pointers_t globals = make_global();
       GetUpDater()->SetIdentificationParameters(run);
+      restore_global(globals);
       SetBit(kIDParamsSet);
    }
 }
@@ -1804,7 +2034,9 @@ void KVMultiDetArray::SetRunCalibrationParameters(UShort_t run)
          ds = gDataSetManager->GetDataSet(fDataSet.Data());
    }
    if (ds) {
+      global_pointers_t globals = make_global();
       GetUpDater()->SetCalibrationParameters(run);
+      restore_global(globals);
       SetBit(kCalParamsSet);
    }
 }
@@ -1881,8 +2113,24 @@ Bool_t KVMultiDetArray::ReadGridsFromAsciiFile(const Char_t* grids) const
    // which does not.
    //
    // Returns kFALSE if there is a problem reading the file
+   //
+   // Nothing is read while a working copy of the array is being built (see MakeWorkingCopy()):
+   // the grids read for the main array are shared by all copies.
+   //
+   // If snapshots are enabled (see KVMultiDetArraySnapshot), the grids are read from the snapshot
+   // of the file if it is up to date, and the snapshot is written after reading the file otherwise.
 
-   if (gIDGridManager->ReadAsciiFile(grids)) {
+   if (fMakingWorkingCopy) return kTRUE;
+   Bool_t ok;
+   if (KVMultiDetArraySnapshot::IsEnabled(this)) {
+      KVMultiDetArraySnapshot snapshot(this);
+      ok = snapshot.ReadGrids(grids);
+      if (!ok && (ok = gIDGridManager->ReadAsciiFile(grids)))
+         snapshot.WriteGrids(grids, gIDGridManager->GetLastReadGrids());
+   }
+   else
+      ok = gIDGridManager->ReadAsciiFile(grids);
+   if (ok) {
       TIter next(gIDGridManager->GetLastReadGrids());
       KVIDGraph* gr;
       while ((gr = (KVIDGraph*)next())) FillListOfIDTelescopes(gr);
@@ -2158,7 +2406,7 @@ Double_t KVMultiDetArray::GetTargetEnergyLossCorrection(KVReconstructedNucleus*
 TGeoManager* KVMultiDetArray::GetGeometry() const
 {
    // Return pointer to the (ROOT) geometry of the array.
-   return gGeoManager;
+   return fGeoManager ? fGeoManager : gGeoManager;
 }
 
 KVGeoNavigator* KVMultiDetArray::GetNavigator() const
@@ -2645,6 +2893,96 @@ void KVMultiDetArray::SetGridsInTelescopes(UInt_t run)
 {
    // For each grid which is valid for this run, we call the KVIDTelescope::SetIDGrid method
    // of each associated ID telescope.
+   //
+   // Grids are shared by the main array and its working copies (see MakeWorkingCopy()),
+   // and each grid only knows the ID telescopes of the main array: we use the telescope
+   // of this array with the same name.
+
+   set_grids_in_telescopes(run);
+   // grids of telescopes may have been changed by other means: next update must be a full one
+   if (fRunTransitions) fRunTransitions->ForgetGrids();
+}
+
+void KVMultiDetArray::UpdateGridsInTelescopes(UInt_t run)
+{
+   // Set the grids valid for this run in all ID telescopes, removing any grids previously set.
+   //
+   // Unless incremental updates are disabled (see KVRunTransitionPlanner), if the grids were previously set
+   // by this method for another run, nothing is done if exactly the same grids are valid for the new run,
+   // and otherwise only the telescopes associated with a grid which is valid for one of the runs but not
+   // the other have their grids changed.
+
+   KVRunTransitionPlanner* planner = get_run_transitions();
+   if (planner) planner->IndexGrids(gIDGridManager->GetGrids());
+
+   if (!planner || !planner->HasGridsApplied()) {
+      TIter next_idt(GetListOfIDTelescopes());
+      KVIDTelescope* idt;
+      while ((idt = (KVIDTelescope*) next_idt())) idt->RemoveGrids();
+      set_grids_in_telescopes(run);
+      if (planner) planner->SetGridsApplied(run);
+      return;
+   }
+   if (planner->SameGrids(run)) return;
+
+   // telescopes associated with grids which are added or removed
+   std::vector<KVIDGraph*> grids;
+   planner->GetGridChanges(run, grids);
+   std::set<KVIDTelescope*> changed;
+   for (std::vector<KVIDGraph*>::iterator it = grids.begin(); it != grids.end(); ++it) {
+      TIter nxtid((*it)->GetIDTelescopes());
+      KVIDTelescope* idt;
+      while ((idt = (KVIDTelescope*) nxtid())) {
+         KVIDTelescope* my_idt = get_grid_telescope(idt);
+         if (my_idt) changed.insert(my_idt);
+      }
+   }
+   for (std::set<KVIDTelescope*>::iterator it = changed.begin(); it != changed.end(); ++it)(*it)->RemoveGrids();
+
+   // set all grids for the new run in these telescopes, in the same order as SetGridsInTelescopes()
+   planner->GetGrids(run, grids);
+   for (std::vector<KVIDGraph*>::iterator it = grids.begin(); it != grids.end(); ++it) {
+      TIter nxtid((*it)->GetIDTelescopes());
+      KVIDTelescope* idt;
+      while ((idt = (KVIDTelescope*) nxtid())) {
+         KVIDTelescope* my_idt = get_grid_telescope(idt);
+         if (my_idt && changed.count(my_idt)) my_idt->SetIDGrid(*it);
+      }
+   }
+   planner->SetGridsApplied(run);
+}
+
+KVIDTelescope* KVMultiDetArray::get_grid_telescope(KVIDTelescope* idt) const
+{
+   // Telescope of this array corresponding to the (main array) telescope associated with a grid
+
+   KVIDTelescope* my_idt = GetIDTelescope(idt->GetName());
+   if (my_idt) return my_idt;
+   if (!fIsWorkingCopy && !fMakingWorkingCopy) return idt;
+   return nullptr;
+}
+
+void KVMultiDetArray::set_grids_in_telescopes(UInt_t run)
+{
+   // Set grids valid for run in associated ID telescopes (see SetGridsInTelescopes()).
+   // If incremental updates are enabled, the grids valid for the run are found using the interval
+   // index of KVRunTransitionPlanner.
+
+   KVRunTransitionPlanner* planner = get_run_transitions();
+   if (planner) {
+      planner->IndexGrids(gIDGridManager->GetGrids());
+      std::vector<KVIDGraph*> grids;
+      planner->GetGrids(run, grids);
+      for (std::vector<KVIDGraph*>::iterator it = grids.begin(); it != grids.end(); ++it) {
+         TIter nxtid((*it)->GetIDTelescopes());
+         KVIDTelescope* idt;
+         while ((idt = (KVIDTelescope*) nxtid())) {
+            KVIDTelescope* my_idt = get_grid_telescope(idt);
+            if (my_idt) my_idt->SetIDGrid(*it);
+         }
+      }
+      return;
+   }
    TIter next(gIDGridManager->GetGrids());
    KVIDGraph* gr = 0;
    while ((gr = (KVIDGraph*) next())) {
@@ -2653,7 +2991,8 @@ void KVMultiDetArray::SetGridsInTelescopes(UInt_t run)
          TIter nxtid(gr->GetIDTelescopes());
          KVIDTelescope* idt;
          while ((idt = (KVIDTelescope*) nxtid())) {
-            idt->SetIDGrid(gr);
+            KVIDTelescope* my_idt = get_grid_telescope(idt);
+            if (my_idt) my_idt->SetIDGrid(gr);
          }
       }
    }
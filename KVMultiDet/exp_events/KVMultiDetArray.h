@@ -14,6 +14,7 @@
 
 #include <KVFileReader.h>
 #include <KVGeoDNTrajectory.h>
+#include <utility>
 class KVIDGraph;
 class KVTarget;
 class KVTelescope;
@@ -47,6 +48,9 @@ class KVExpSetUp;
 class KVExpDB;
 class KVDBTable;
 class KVDBRun;
+class KVDBParameterSet;
+class KVCalibrator;
+class KVRunTransitionPlanner;
 
 /**
   \class KVMultiDetArray
@@ -66,6 +70,7 @@ protected:
    static Bool_t fCloseGeometryNow;
    static Bool_t fBuildTarget;
    static Bool_t fMakeMultiDetectorSetParameters;
+   static Bool_t fMakingWorkingCopy;
 
    KVTarget* fTarget;          //target used in experiment
    enum {
@@ -96,6 +101,8 @@ protected:
    Int_t fFilterType;//! type of filtering (used by DetectEvent)
 
    KVRangeTableGeoNavigator* fNavigator;//! for propagating particles through array geometry
+   TGeoManager* fGeoManager;//! ROOT geometry belonging to a working copy of the array (see MakeWorkingCopy())
+   Bool_t fIsWorkingCopy;//! kTRUE for arrays created by MakeWorkingCopy()
 
    KVUniqueNameList fTrajectories;//! list of all possible trajectories through detectors of array
 
@@ -108,6 +115,8 @@ protected:
 
    KVNameValueList fReconParameters;//! general purpose list of parameters for storing information on data reconstruction
 
+   KVRunTransitionPlanner* fRunTransitions;//! changes of calibrators & grids between runs (see UpdateGridsInTelescopes())
+
    virtual void RenumberGroups();
    virtual void BuildGeometry()
    {
@@ -120,6 +129,12 @@ protected:
 
    int try_all_doubleID_telescopes(KVDetector* de, KVDetector* e, TCollection* l);
    bool try_a_doubleIDtelescope(TString uri, KVDetector* de, KVDetector* e, TCollection* l);
+
+   KVRunTransitionPlanner* get_run_transitions();
+   KVCalibrator* make_calibrator(KVDetector*, KVDBParameterSet*);
+   Bool_t set_calibrator_parameters(KVCalibrator*, KVDBParameterSet*);
+   KVIDTelescope* get_grid_telescope(KVIDTelescope*) const;
+   void set_grids_in_telescopes(UInt_t run);
    bool try_upper_and_lower_doubleIDtelescope(TString uri, KVDetector* de, KVDetector* e, TCollection* l);
    int try_all_singleID_telescopes(KVDetector* d, TCollection* l);
    bool try_a_singleIDtelescope(TString uri, KVDetector* d, TCollection* l);
@@ -159,6 +174,14 @@ protected:
    virtual void PerformClosedROOTGeometryOperations();
 
    virtual void copy_fired_parameters_to_recon_param_list();
+   virtual void set_global_pointers()
+   {
+      // Override in child classes which set a global pointer (e.g. gFazia) in their constructor,
+      // in order to make it point to this object again
+   }
+   typedef std::pair<KVMultiDetArray*, TGeoManager*> global_pointers_t;
+   global_pointers_t make_global();
+   void restore_global(const global_pointers_t&);
 
    TString GetFileName(KVExpDB*, const Char_t* meth, const Char_t* keyw);
    unique_ptr<KVFileReader> GetKVFileReader(KVExpDB* db, const Char_t* meth, const Char_t* keyw);
@@ -293,6 +316,13 @@ public:
       return TestBit(kIsBuilt);
    }
    static KVMultiDetArray* MakeMultiDetector(const Char_t* dataset_name, Int_t run = -1, TString classname = "KVMultiDetArray");
+   KVMultiDetArray* MakeWorkingCopy();
+   Bool_t IsWorkingCopy() const
+   {
+      // kTRUE for arrays created by MakeWorkingCopy()
+      return fIsWorkingCopy;
+   }
+   Bool_t HasSameCalibrationsAs(const KVMultiDetArray*) const;
 
    Bool_t IsBeingDeleted()
    {
@@ -386,6 +416,7 @@ public:
    void CalculateDetectorSegmentationIndex();
    virtual void AnalyseGroupAndReconstructEvent(KVReconstructedEvent* recev, KVGroup* grp);
    virtual void SetGridsInTelescopes(UInt_t run);
+   virtual void UpdateGridsInTelescopes(UInt_t run);
    void FillListOfIDTelescopes(KVIDGraph* gr) const;
 
    void Draw(Option_t* option = "");
@@ -0,0 +1,285 @@
+//Created by KVClassFactory on Sat Oct 17 15:10:41 2026
+
+#include "KVMultiDetArraySnapshot.h"
+#include "KVMultiDetArray.h"
+#include "KVDataSet.h"
+#include "KVIDGraph.h"
+#include "KVIDGridManager.h"
+#include "KVNameValueList.h"
+#include "TBufferFile.h"
+#include "TFile.h"
+#include "TGeoManager.h"
+#include "TGeoMaterial.h"
+#include "TGeoMatrix.h"
+#include "TGeoMedium.h"
+#include "TGeoNode.h"
+#include "TGeoShape.h"
+#include "TGeoVolume.h"
+#include "TGraph.h"
+#include "TList.h"
+#include "TMD5.h"
+#include "TSystem.h"
+
+ClassImp(KVMultiDetArraySnapshot)
+
+const Int_t KVMultiDetArraySnapshot::fgVersion = 1;
+
+namespace {
+   void md5_add(TMD5& md5, const TString& s)
+   {
+      md5.Update((const UChar_t*)s.Data(), s.Length() + 1);
+   }
+   void md5_add(TMD5& md5, const Double_t* d, Int_t n)
+   {
+      md5.Update((const UChar_t*)d, n * sizeof(Double_t));
+   }
+   TString dataset_of_array(const KVMultiDetArray* array)
+   {
+      TString ds = array->GetDataSet();
+      if (ds == "" && gDataSet) ds = gDataSet->GetName();
+      return ds;
+   }
+}
+
+KVMultiDetArraySnapshot::KVMultiDetArraySnapshot(const KVMultiDetArray* array)
+   : KVBase("KVMultiDetArraySnapshot", "Snapshot files of multidetector array")
+{
+   // Handle snapshot files for the dataset of the given array
+
+   fDataSet = dataset_of_array(array);
+   fDirectory = GetWORKDIRFilePath(Form("multidet_snapshots/%s", fDataSet.Data()));
+}
+
+Bool_t KVMultiDetArraySnapshot::IsEnabled(const KVMultiDetArray* array)
+{
+   // Returns kTRUE if snapshots are to be used when building the array, i.e. if the
+   // (possibly dataset-dependent) variable
+   //
+   //     KVMultiDetArray.Snapshot:  yes
+   //
+   // is set in the .kvrootrc file
+
+   TString ds = dataset_of_array(array);
+   if (ds == "") return kFALSE;
+   return GetDataSetEnv(ds, "KVMultiDetArray.Snapshot", kFALSE);
+}
+
+TString KVMultiDetArraySnapshot::GetScanFile(const KVMultiDetArray* array) const
+{
+   // Full path to the file containing the geometry scan directions for the array
+
+   return Form("%s/%s.scan.root", fDirectory.Data(), array->GetName());
+}
+
+TString KVMultiDetArraySnapshot::GetGridsFile(const Char_t* gridfile) const
+{
+   // Full path to the file containing the grids read from the given ASCII file
+
+   return Form("%s/%s.grids.root", fDirectory.Data(), gSystem->BaseName(gridfile));
+}
+
+TString KVMultiDetArraySnapshot::GetGeometryChecksum(TGeoManager* geo)
+{
+   // Calculate MD5 checksum of everything in the ROOT geometry which may change the
+   // result of a scan of the geometry: for each volume, its name, shape (all parameters),
+   // material, and the name, volume and position of each of its daughter nodes.
+
+   TMD5 md5;
+   TIter next(geo->GetListOfVolumes());
+   TGeoVolume* vol;
+   while ((vol = (TGeoVolume*)next())) {
+      md5_add(md5, vol->GetName());
+      TGeoShape* shape = vol->GetShape();
+      if (shape) {
+         md5_add(md5, shape->ClassName());
+         TBufferFile buf(TBuffer::kWrite);
+         shape->Streamer(buf);
+         md5.Update((const UChar_t*)buf.Buffer(), buf.Length());
+      }
+      TGeoMedium* med = vol->GetMedium();
+      if (med && med->GetMaterial()) {
+         TGeoMaterial* mat = med->GetMaterial();
+         md5_add(md5, mat->GetName());
+         Double_t props[] = { mat->GetA(), mat->GetZ(), mat->GetDensity() };
+         md5_add(md5, props, 3);
+      }
+      for (Int_t i = 0; i < vol->GetNdaughters(); ++i) {
+         TGeoNode* node = vol->GetNode(i);
+         md5_add(md5, node->GetName());
+         md5_add(md5, node->GetVolume()->GetName());
+         TGeoMatrix* mat = node->GetMatrix();
+         md5_add(md5, mat->GetTranslation(), 3);
+         md5_add(md5, mat->GetRotationMatrix(), 9);
+      }
+   }
+   md5.Final();
+   return md5.AsString();
+}
+
+TString KVMultiDetArraySnapshot::GetFileChecksum(const Char_t* path)
+{
+   // MD5 checksum of the contents of the file (empty string if file cannot be read)
+
+   TMD5* md5 = TMD5::FileChecksum(path);
+   if (!md5) return "";
+   TString s = md5->AsString();
+   delete md5;
+   return s;
+}
+
+TFile* KVMultiDetArraySnapshot::open_snapshot(const TString& filename, const TString& checksum) const
+{
+   // Open snapshot file if it exists and was written with the current version of the format
+   // and the same checksum of its inputs. Returns nullptr otherwise.
+
+   if (gSystem->AccessPathName(filename)) return nullptr;
+   TDirectory* work_dir = gDirectory;   //keep pointer to current directory
+   TFile* f = TFile::Open(filename);
+   work_dir->cd();
+   if (!f || f->IsZombie()) {
+      delete f;
+      return nullptr;
+   }
+   KVNameValueList* info = (KVNameValueList*)f->Get("SnapshotInfo");
+   Bool_t ok = (info && info->GetIntValue("Version") == fgVersion && info->GetTStringValue("Checksum") == checksum);
+   delete info;
+   if (!ok) {
+      Info("open_snapshot", "Snapshot %s is out of date and will be rewritten", filename.Data());
+      delete f;
+      return nullptr;
+   }
+   return f;
+}
+
+Bool_t KVMultiDetArraySnapshot::write_snapshot(const TString& filename, const KVNameValueList& info, const TCollection& objects) const
+{
+   // Write snapshot file with the given information and objects (each written with its name as key).
+   // The file is first written with a temporary name, then renamed, so that other
+   // processes never read a partially-written file.
+
+   if (gSystem->AccessPathName(fDirectory) && gSystem->mkdir(fDirectory, kTRUE) < 0) {
+      Warning("write_snapshot", "Cannot create directory %s", fDirectory.Data());
+      return kFALSE;
+   }
+   TString tmp = Form("%s.%d", filename.Data(), gSystem->GetPid());
+   TDirectory* work_dir = gDirectory;   //keep pointer to current directory
+   TFile f(tmp, "RECREATE");
+   Bool_t ok = !f.IsZombie();
+   if (ok) {
+      f.WriteTObject(&info, "SnapshotInfo");
+      TIter next(&objects);
+      TObject* obj;
+      while ((obj = next())) f.WriteTObject(obj, obj->GetName(), "SingleKey");
+   }
+   f.Close();
+   work_dir->cd();
+   if (!ok || gSystem->Rename(tmp, filename)) {
+      gSystem->Unlink(tmp);
+      return kFALSE;
+   }
+   Info("write_snapshot", "Wrote snapshot %s", filename.Data());
+   return kTRUE;
+}
+
+Bool_t KVMultiDetArraySnapshot::ReadScanDirections(const KVMultiDetArray* array, const TString& checksum,
+      std::vector<Double_t>& theta, std::vector<Double_t>& phi) const
+{
+   // Read directions (in degrees) of geometry scan for the array, if a snapshot exists with the given checksum
+   // (see KVGeoImport::ImportGeometry()). Returns kFALSE if no valid snapshot exists.
+
+   TFile* f = open_snapshot(GetScanFile(array), checksum);
+   if (!f) return kFALSE;
+   TGraph* dirs = (TGraph*)f->Get("Directions");
+   Bool_t ok = (dirs != nullptr);
+   if (ok) {
+      theta.assign(dirs->GetX(), dirs->GetX() + dirs->GetN());
+      phi.assign(dirs->GetY(), dirs->GetY() + dirs->GetN());
+      delete dirs;
+   }
+   delete f;
+   return ok;
+}
+
+Bool_t KVMultiDetArraySnapshot::WriteScanDirections(const KVMultiDetArray* array, const TString& checksum,
+      const std::vector<Double_t>& theta, const std::vector<Double_t>& phi) const
+{
+   // Write snapshot of the directions (in degrees) of geometry scan for the array with the given checksum
+   // of the geometry and scan parameters
+
+   KVNameValueList info;
+   info.SetValue("Version", fgVersion);
+   info.SetValue("Checksum", checksum.Data());
+   info.SetValue("DataSet", fDataSet.Data());
+   info.SetValue("Array", array->GetName());
+   info.SetValue("Class", array->ClassName());
+   info.SetValue("KaliVeda", GetKVVersion());
+
+   TGraph dirs((Int_t)theta.size(), theta.data(), phi.data());
+   dirs.SetName("Directions");
+   TList objects;
+   objects.Add(&dirs);
+   return write_snapshot(GetScanFile(array), info, objects);
+}
+
+namespace {
+   TString grids_checksum(const Char_t* gridfile)
+   {
+      // checksum of grid file contents, full path and version of KaliVeda used to read it
+      TString file_md5 = KVMultiDetArraySnapshot::GetFileChecksum(gridfile);
+      if (file_md5 == "") return "";
+      TMD5 md5;
+      md5_add(md5, file_md5);
+      md5_add(md5, gridfile);
+      md5_add(md5, KVBase::GetKVVersion());
+      md5.Final();
+      return md5.AsString();
+   }
+}
+
+Bool_t KVMultiDetArraySnapshot::ReadGrids(const Char_t* gridfile) const
+{
+   // Add to gIDGridManager the grids read from the ASCII file, if a snapshot of them exists
+   // corresponding to the current contents of the file. As for KVIDGridManager::ReadAsciiFile(),
+   // the grids can then be accessed with gIDGridManager->GetLastReadGrids().
+   //
+   // Returns kFALSE if no valid snapshot exists.
+
+   TString checksum = grids_checksum(gridfile);
+   if (checksum == "") return kFALSE;
+   TFile* f = open_snapshot(GetGridsFile(gridfile), checksum);
+   if (!f) return kFALSE;
+   KVIDGraph::SetAutoAdd(kFALSE);
+   TList* grids = (TList*)f->Get("Grids");
+   KVIDGraph::SetAutoAdd();
+   Bool_t ok = (grids != nullptr);
+   if (ok) {
+      gIDGridManager->AddGrids(grids);
+      Info("ReadGrids", "Read %d grids from snapshot of %s", grids->GetEntries(), gridfile);
+      delete grids;
+   }
+   delete f;
+   return ok;
+}
+
+Bool_t KVMultiDetArraySnapshot::WriteGrids(const Char_t* gridfile, const TCollection* grids) const
+{
+   // Write snapshot of the grids read from the ASCII file
+
+   TString checksum = grids_checksum(gridfile);
+   if (checksum == "") return kFALSE;
+   KVNameValueList info;
+   info.SetValue("Version", fgVersion);
+   info.SetValue("Checksum", checksum.Data());
+   info.SetValue("DataSet", fDataSet.Data());
+   info.SetValue("Source", gridfile);
+   info.SetValue("KaliVeda", GetKVVersion());
+
+   TList list;
+   list.SetName("Grids");
+   TIter next(grids);
+   TObject* obj;
+   while ((obj = next())) list.Add(obj);
+   TList objects;
+   objects.Add(&list);
+   return write_snapshot(GetGridsFile(gridfile), info, objects);
+}
@@ -0,0 +1,84 @@
+//Created by KVClassFactory on Sat Oct 17 15:10:41 2026
+
+#ifndef __KVMULTIDETARRAYSNAPSHOT_H
+#define __KVMULTIDETARRAYSNAPSHOT_H
+
+#include "KVBase.h"
+#include <vector>
+
+class KVMultiDetArray;
+class KVNameValueList;
+class TCollection;
+class TGeoManager;
+class TFile;
+
+/**
+\class KVMultiDetArraySnapshot
+\brief Snapshot files of the time-consuming steps of building a multidetector array
+\ingroup Geometry
+
+Building a multidetector array with KVMultiDetArray::MakeMultiDetector() may take a long time
+compared to the rest of a short batch job, mainly due to:
+
+ - the scan of the ROOT geometry by KVGeoImport::ImportGeometry(), which propagates particles in
+   hundreds of thousands of directions in order to find all detectors and trajectories;
+ - the reading of identification grids from ASCII files by KVMultiDetArray::ReadGridsFromAsciiFile().
+
+When snapshots are enabled for a dataset by setting
+
+~~~~
+[dataset].KVMultiDetArray.Snapshot:   yes
+~~~~
+
+the results of these steps are written the first time in ROOT files in the user's working directory,
+`$(KV_WORK_DIR)/multidet_snapshots/[dataset]/`, and are read back by later jobs instead of repeating
+them:
+
+ - `[array].scan.root`: the directions of the geometry scan in which new detectors, detector volumes
+   or trajectories were found. Only these directions are propagated when the array is next built,
+   which sets up exactly the same detectors, trajectories and groups;
+ - `[gridfile].grids.root`: the grids read from each ASCII grid file.
+
+Each file contains a KVNameValueList `SnapshotInfo` with the version of the snapshot format and a checksum
+(MD5) of all inputs used to produce it: for the geometry scan, the full geometry (volumes, shapes, materials,
+node positions), the parameters of the scan and the detector naming conventions; for the grids, the contents
+of the ASCII file. A snapshot is only used if its version and checksum correspond to the current inputs,
+otherwise it is rewritten, so that any change to the source files invalidates it automatically.
+
+Snapshot files are written under a temporary name and then renamed, so that jobs running
+in parallel never read a partially-written file.
+*/
+class KVMultiDetArraySnapshot : public KVBase {
+
+   static const Int_t fgVersion;// version of snapshot file format
+
+   TString fDataSet;// name of dataset
+   TString fDirectory;// directory containing snapshot files for dataset
+
+   TFile* open_snapshot(const TString& filename, const TString& checksum) const;
+   Bool_t write_snapshot(const TString& filename, const KVNameValueList& info, const TCollection& objects) const;
+
+public:
+   KVMultiDetArraySnapshot(const KVMultiDetArray*);
+   virtual ~KVMultiDetArraySnapshot() {}
+
+   static Bool_t IsEnabled(const KVMultiDetArray*);
+
+   TString GetScanFile(const KVMultiDetArray*) const;
+   TString GetGridsFile(const Char_t* gridfile) const;
+
+   static TString GetGeometryChecksum(TGeoManager*);
+   static TString GetFileChecksum(const Char_t* path);
+
+   Bool_t ReadScanDirections(const KVMultiDetArray*, const TString& checksum,
+                             std::vector<Double_t>& theta, std::vector<Double_t>& phi) const;
+   Bool_t WriteScanDirections(const KVMultiDetArray*, const TString& checksum,
+                              const std::vector<Double_t>& theta, const std::vector<Double_t>& phi) const;
+
+   Bool_t ReadGrids(const Char_t* gridfile) const;
+   Bool_t WriteGrids(const Char_t* gridfile, const TCollection* grids) const;
+
+   ClassDef(KVMultiDetArraySnapshot, 0) //Snapshot files of the time-consuming steps of building a multidetector array
+};
+
+#endif
@@ -87,7 +87,7 @@ void KVRawDataAnalyser::ProcessRun()
    //loop over events in file
    while ((nevents-- ? fRunFile->GetNextEvent() : kFALSE) && !AbortProcessingLoop()) {
 
-      gMultiDetArray->HandleRawDataEvent(fRunFile);
+      HandleRawDataEvent();
       preAnalysis();
       //call user's analysis. stop if returns kFALSE.
       if (!Analysis()) break;
@@ -112,6 +112,14 @@ void KVRawDataAnalyser::ProcessRun()
 }
 
 
+void KVRawDataAnalyser::HandleRawDataEvent()
+{
+   // Called for each event read from the raw data file, just before Analysis().
+   // By default the event is decoded by gMultiDetArray.
+
+   gMultiDetArray->HandleRawDataEvent(fRunFile);
+}
+
 void KVRawDataAnalyser::SubmitTask()
 {
    // Perform analysis of chosen runs
@@ -36,6 +36,7 @@ protected:
    KVString fCombinedOutputFile;// optional name for single results file with trees and histos
 
    void ProcessRun();
+   virtual void HandleRawDataEvent();
 
    void AbortDuringRunProcessing();
 
@@ -4,11 +4,13 @@
 #include "KVRawDataReconstructor.h"
 #include "KVDataSet.h"
 #include "KVDataRepositoryManager.h"
+#include "KVReconstructionPipeline.h"
+#include "KVReconEventColumns.h"
 
 ClassImp(KVRawDataReconstructor)
 
 KVRawDataReconstructor::KVRawDataReconstructor()
-   : KVRawDataAnalyser()
+   : KVRawDataAnalyser(), fPipeline(nullptr), fColumns(nullptr)
 {
    // Default constructor
    Info("KVRawDataReconstructor", "Constructed");
@@ -19,6 +21,10 @@ KVRawDataReconstructor::KVRawDataReconstructor()
 KVRawDataReconstructor::~KVRawDataReconstructor()
 {
    // Destructor
+#ifdef WITH_CPP11
+   SafeDelete(fPipeline);
+#endif
+   SafeDelete(fColumns);
 }
 
 void KVRawDataReconstructor::InitAnalysis()
@@ -31,7 +37,10 @@ void KVRawDataReconstructor::InitAnalysis()
 
 void KVRawDataReconstructor::InitRun()
 {
-   fEvRecon.reset(new KVEventReconstructor(gMultiDetArray, fRecev));
+   // Open the output file and create the tree for reconstructed events of the new run.
+   //
+   // Unless KVRawDataReconstructor.Pipeline.QueueSize=0, the reconstruction pipeline is
+   // set up (see KVReconstructionPipeline)
 
    // get dataset to which we must associate new run
    KVDataSet* OutputDataset =
@@ -49,17 +58,93 @@ void KVRawDataReconstructor::InitRun()
                        );
 
    //leaves for reconstructed events
-   KVEvent::MakeEventBranch(fRecTree, "ReconEvent", fRecev->ClassName(), fRecev);
+   SafeDelete(fColumns);
+   if (!strcmp(GetDataSetEnv(GetDataSet()->GetName(), "KVRawDataReconstructor.Format", "object"), "columnar")) {
+      fColumns = new KVReconEventColumns;
+      fColumns->SetParametersFromEnv(GetDataSet()->GetName());
+      if (fColumns->MakeBranches(fRecTree, fRecev->ClassName()))
+         Info("InitRun", "Reconstructed events written in columnar format");
+      else {
+         Warning("InitRun", "Events of class %s cannot be written in columnar format: object format used instead",
+                 fRecev->ClassName());
+         SafeDelete(fColumns);
+      }
+   }
+   if (!fColumns)
+      KVEvent::MakeEventBranch(fRecTree, "ReconEvent", fRecev->ClassName(), fRecev);
 
    Info("InitRun", "Created reconstructed data tree %s : %s", fRecTree->GetName(), fRecTree->GetTitle());
+
+   Int_t nslots = (Int_t)GetDataSetEnv(GetDataSet()->GetName(), "KVRawDataReconstructor.Pipeline.QueueSize", 64.);
+#ifdef WITH_CPP11
+   if (nslots > 0) {
+      Int_t nworkers = (Int_t)GetDataSetEnv(GetDataSet()->GetName(), "KVRawDataReconstructor.Pipeline.Workers", 1.);
+      // update working copies of the array made for previous runs, then make any more we need.
+      // any copy which does not have the same calibrations & grids as the main array is discarded.
+      KVList bad_copies;
+      TIter next_copy(&fArrayCopies);
+      KVMultiDetArray* copy;
+      while ((copy = (KVMultiDetArray*)next_copy())) {
+         copy->SetParameters(fRunNumber);
+         if (!copy->HasSameCalibrationsAs(gMultiDetArray)) {
+            Error("InitRun", "Working copy of array not correctly updated for run %d: it will not be used", fRunNumber);
+            bad_copies.Add(copy);
+         }
+      }
+      TIter next_bad(&bad_copies);
+      while ((copy = (KVMultiDetArray*)next_bad())) fArrayCopies.Remove(copy);
+      bad_copies.Delete();
+      while (fArrayCopies.GetEntries() < nworkers - 1) {
+         if (!(copy = gMultiDetArray->MakeWorkingCopy())) {
+            Warning("InitRun", "Failed to make working copy of array: using %d worker(s)", fArrayCopies.GetEntries() + 1);
+            break;
+         }
+         fArrayCopies.Add(copy);
+      }
+      fPipeline = new KVReconstructionPipeline(fRecTree, &fRecev, nslots);
+      fPipeline->SetColumnWriter(fColumns);
+      fPipeline->AddWorker(gMultiDetArray);
+      next_copy.Reset();
+      while ((copy = (KVMultiDetArray*)next_copy())) fPipeline->AddWorker(copy);
+      fPipeline->Start();
+      Info("InitRun", "Reconstruction pipeline with %u slots and %u worker(s)", fPipeline->GetNumberOfSlots(), fPipeline->GetNumberOfWorkers());
+      return;
+   }
+#else
+   if (nslots > 0) Warning("InitRun", "Reconstruction pipeline requires C++11: events will be reconstructed sequentially");
+#endif
+   fEvRecon.reset(new KVEventReconstructor(gMultiDetArray, fRecev));
+}
+
+void KVRawDataReconstructor::HandleRawDataEvent()
+{
+   // Reader stage of the pipeline: decode the event into the array of the next free worker
+
+#ifdef WITH_CPP11
+   if (fPipeline) {
+      fPipeline->NextArray()->HandleRawDataEvent(fRunFile);
+      return;
+   }
+#endif
+   KVRawDataAnalyser::HandleRawDataEvent();
 }
 
 Bool_t KVRawDataReconstructor::Analysis()
 {
+   // Reconstruct the current event and write it in the output tree.
+   // With the pipeline, the event is handed to the reconstruction worker.
+
+#ifdef WITH_CPP11
+   if (fPipeline) {
+      fPipeline->Submit(GetEventNumber());
+      return kTRUE;
+   }
+#endif
    if (gMultiDetArray->HandledRawData()) {
       fEvRecon->ReconstructEvent(gMultiDetArray->GetFiredDataParameters());
       fEvRecon->GetEvent()->SetNumber(GetEventNumber());
-      fRecTree->Fill();
+      if (fColumns) fColumns->Fill(fEvRecon->GetEvent());
+      else fRecTree->Fill();
       fEvRecon->GetEvent()->Clear();
    }
 
@@ -69,6 +154,14 @@ Bool_t KVRawDataReconstructor::Analysis()
 void KVRawDataReconstructor::EndRun()
 {
    Info("KVRawDataReconstructor", "EndRun");
+#ifdef WITH_CPP11
+   if (fPipeline) {
+      // wait for all events to be reconstructed & written
+      fPipeline->Finish();
+      fPipeline->PrintStatistics();
+      SafeDelete(fPipeline);
+   }
+#endif
    fRecev->Clear();
    fRecFile->cd();
    WriteBatchInfo(fRecTree);
@@ -84,6 +177,7 @@ void KVRawDataReconstructor::EndRun()
 void KVRawDataReconstructor::EndAnalysis()
 {
    Info("KVRawDataReconstructor", "EndAnalysis");
+   fArrayCopies.Delete();
 
 }
 
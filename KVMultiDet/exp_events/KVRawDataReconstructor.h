@@ -6,11 +6,41 @@
 
 #include "KVEventReconstructor.h"
 #include "KVRawDataAnalyser.h"
+#include "KVList.h"
+
+class KVReconstructionPipeline;
+class KVReconEventColumns;
 
 /**
    \class KVRawDataReconstructor
  \brief Manage task of reconstruction of physical events from raw data
  \ingroup Reconstruction
+
+ Reading & decoding of raw data, event reconstruction and writing of the reconstructed events
+ are performed by the different stages of a KVReconstructionPipeline, so that writing the output
+ tree runs concurrently with reconstruction, and several events can be reconstructed in parallel.
+ Reconstructed events are written in the same order as they are read. The throughput of each
+ stage is printed at the end of each run. The pipeline is configured by the following
+ (possibly dataset-dependent) variables:
+
+~~~~
+KVRawDataReconstructor.Pipeline.QueueSize: 64
+KVRawDataReconstructor.Pipeline.Workers: 1
+~~~~
+
+ With a queue size of 0, all stages are performed sequentially for each event.
+ Each additional worker uses a working copy of the array (see KVMultiDetArray::MakeWorkingCopy()),
+ made at the beginning of the first run and updated for each subsequent run.
+
+ Reconstructed events are written in the `ReconEvent` branch of the `ReconEvents` tree, unless
+ the (possibly dataset-dependent) variable
+
+~~~~
+KVRawDataReconstructor.Format: columnar
+~~~~
+
+ is set, in which case they are written in the columnar format of KVReconEventColumns
+ (unless events of the class used cannot be stored in this format, see KVReconEventColumns::CanStore()).
   */
 
 class KVRawDataReconstructor : public KVRawDataAnalyser {
@@ -19,6 +49,12 @@ class KVRawDataReconstructor : public KVRawDataAnalyser {
    KVReconstructedEvent* fRecev;
    TFile* fRecFile;
    TTree* fRecTree;
+   KVReconstructionPipeline* fPipeline;//!
+   KVReconEventColumns* fColumns;//! writer for columnar format, if used
+   KVList fArrayCopies;//! working copies of the array for additional reconstruction workers
+
+protected:
+   virtual void HandleRawDataEvent();
 
 public:
    KVRawDataReconstructor();
@@ -0,0 +1,688 @@
+//Created by KVClassFactory on Sat Oct 17 16:42:08 2026
+
+#include "KVReconEventColumns.h"
+#include "KVReconstructedEvent.h"
+#include "KVReconstructedNucleus.h"
+#include "KVDataSet.h"
+#include "KVMultiDetArray.h"
+#include "KVNameValueList.h"
+#include "TFile.h"
+#include "TKey.h"
+#include "TLeaf.h"
+#include "TList.h"
+#include "TObjArray.h"
+#include "TObjString.h"
+#include "TBaseClass.h"
+#include "TDataMember.h"
+#include "TTree.h"
+#include "TVector3.h"
+#include <algorithm>
+#include <iterator>
+
+ClassImp(KVReconEventColumns)
+
+const Int_t KVReconEventColumns::fgVersion = 1;
+const UInt_t KVReconEventColumns::fgFlagMask = KVParticle::kIsOK | KVParticle::kIsOKSet
+      | KVReconstructedNucleus::kIsIdentified | KVReconstructedNucleus::kIsCalibrated | KVReconstructedNucleus::kCoherency
+      | KVReconstructedNucleus::kZMeasured | KVReconstructedNucleus::kAMeasured;
+const Int_t KVReconEventColumns::fgMaxParameters = 32;
+
+namespace {
+   Bool_t parse_parameter(const TString& spec, TString& name, Char_t& type)
+   {
+      // "NAME/T" => name="NAME", type='T' ('I' or 'D'). Just "NAME" => type='D'
+      Ssiz_t slash = spec.Last('/');
+      name = (slash < 0 ? spec : spec(0, slash));
+      type = (slash < 0 || slash == spec.Length() - 1 ? 'D' : spec[slash + 1]);
+      return (name != "" && (type == 'I' || type == 'D'));
+   }
+   TString persistent_members(TClass* cl, TClass* base)
+   {
+      // Persistent (non-static) data members of class cl and of all its base classes which derive
+      // from base, excluding those of base itself
+      TString members;
+      if (!cl || cl == base || !cl->InheritsFrom(base)) return members;
+      if (cl->GetClassVersion() > 0) {
+         TIter next(cl->GetListOfDataMembers());
+         TDataMember* dm;
+         while ((dm = (TDataMember*)next())) {
+            if (dm->IsPersistent() && !(dm->Property() & kIsStatic)) members += Form(" %s::%s", cl->GetName(), dm->GetName());
+         }
+      }
+      TIter next_base(cl->GetListOfBases());
+      TBaseClass* bc;
+      while ((bc = (TBaseClass*)next_base())) members += persistent_members(bc->GetClassPointer(), base);
+      return members;
+   }
+   TString branch_name(const Char_t* prefix, const TString& name)
+   {
+      // only alphanumeric characters and '_' are used in branch names
+      TString b(prefix);
+      for (Int_t i = 0; i < name.Length(); ++i) b.Append(isalnum(name[i]) ? name[i] : '_');
+      return b;
+   }
+}
+
+KVReconEventColumns::KVReconEventColumns()
+   : KVBase("KVReconEventColumns", "Columnar storage of reconstructed events"),
+     fTree(nullptr), fCurrentTree(nullptr), fWriting(kFALSE), fInfo(nullptr), fDetNamesDict(nullptr), fIDTelDict(nullptr),
+     fEvent(nullptr), fReadDetNames(kFALSE), fReadIDTel(kFALSE), fCapacity(0), fNumber(0), fMult(0), fEvParMask(0)
+{
+   resize(64);
+}
+
+KVReconEventColumns::~KVReconEventColumns()
+{
+   // The format information and name dictionaries belong to the user info of the tree
+   // and are not deleted
+
+   SafeDelete(fEvent);
+}
+
+std::vector<KVReconEventColumns::column> KVReconEventColumns::get_columns()
+{
+   // All columns (branches) with the current addresses of their values
+
+   std::vector<column> c = {
+      {"Number", 'i', &fNumber, kFALSE},
+      {"Mult", 'I', &fMult, kFALSE}
+   };
+   if (!fEvParNames.empty()) c.push_back({"EvParMask", 'i', &fEvParMask, kFALSE});
+   for (size_t i = 0; i < fEvParNames.size(); ++i)
+      c.push_back({fEvParBranches[i].Data(), fEvParTypes[i], fEvParTypes[i] == 'I' ? (void*)&fEvParInt[i] : (void*)&fEvParDouble[i], kFALSE});
+   column particle_columns[] = {
+      {"Z", 'b', fZ.data(), kTRUE},
+      {"A", 'b', fA.data(), kTRUE},
+      {"E", 'F', fE.data(), kTRUE},
+      {"Theta", 'F', fTheta.data(), kTRUE},
+      {"Phi", 'F', fPhi.data(), kTRUE},
+      {"RealZ", 'F', fRealZ.data(), kTRUE},
+      {"RealA", 'F', fRealA.data(), kTRUE},
+      {"TargetEnergyLoss", 'F', fTargetEnergyLoss.data(), kTRUE},
+      {"Status", 'S', fStatus.data(), kTRUE},
+      {"NSegDet", 'S', fNSegDet.data(), kTRUE},
+      {"Flags", 'i', fFlags.data(), kTRUE},
+      {"DetNames", 'I', fDetNames.data(), kTRUE},
+      {"IDTel", 'I', fIDTel.data(), kTRUE}
+   };
+   c.insert(c.end(), std::begin(particle_columns), std::end(particle_columns));
+   if (!fParNames.empty()) c.push_back({"ParMask", 'i', fParMask.data(), kTRUE});
+   for (size_t i = 0; i < fParNames.size(); ++i)
+      c.push_back({fParBranches[i].Data(), fParTypes[i], fParTypes[i] == 'I' ? (void*)fParInt[i].data() : (void*)fParDouble[i].data(), kTRUE});
+   return c;
+}
+
+void KVReconEventColumns::resize(Int_t n)
+{
+   // Change size of arrays of particle quantities, and update branch addresses
+
+   fCapacity = n;
+   fZ.resize(n);
+   fA.resize(n);
+   fE.resize(n);
+   fTheta.resize(n);
+   fPhi.resize(n);
+   fRealZ.resize(n);
+   fRealA.resize(n);
+   fTargetEnergyLoss.resize(n);
+   fStatus.resize(n);
+   fNSegDet.resize(n);
+   fFlags.resize(n);
+   fDetNames.resize(n);
+   fIDTel.resize(n);
+   fParMask.resize(n);
+   for (size_t i = 0; i < fParNames.size(); ++i) {
+      if (fParTypes[i] == 'I') fParInt[i].resize(n);
+      else fParDouble[i].resize(n);
+   }
+   set_addresses();
+}
+
+void KVReconEventColumns::set_addresses()
+{
+   // Set addresses of all branches of the tree
+
+   if (!fTree) return;
+   std::vector<column> columns = get_columns();
+   for (std::vector<column>::iterator c = columns.begin(); c != columns.end(); ++c) {
+      if (fTree->GetBranch(c->name)) fTree->SetBranchAddress(c->name, c->address);
+   }
+}
+
+TString KVReconEventColumns::parameter_list(const std::vector<TString>& names, const std::vector<Char_t>& types) const
+{
+   // Space-separated list of "NAME/T" for parameters
+
+   TString list;
+   for (size_t i = 0; i < names.size(); ++i) {
+      if (i) list += " ";
+      list += Form("%s/%c", names[i].Data(), types[i]);
+   }
+   return list;
+}
+
+Bool_t KVReconEventColumns::add_parameter(std::vector<TString>& names, std::vector<Char_t>& types, const TString& name, Char_t type, const Char_t* what)
+{
+   // Add parameter to list if not already present and maximum number of parameters not reached.
+   // Returns kTRUE if the parameter is in the list.
+
+   if (std::find(names.begin(), names.end(), name) != names.end()) return kTRUE;
+   if (type != 'I' && type != 'D') {
+      Warning("add_parameter", "%s parameter %s: type must be 'I' (integer) or 'D' (floating-point), not '%c'", what, name.Data(), type);
+      return kFALSE;
+   }
+   if ((Int_t)names.size() == fgMaxParameters) {
+      TString tag = Form(" %s.%s ", what, name.Data());
+      if (!fIgnoredParameters.Contains(tag)) {
+         Warning("add_parameter", "Maximum number (%d) of %s parameters reached: %s will not be stored", fgMaxParameters, what, name.Data());
+         fIgnoredParameters += tag;
+      }
+      return kFALSE;
+   }
+   names.push_back(name);
+   types.push_back(type);
+   return kTRUE;
+}
+
+void KVReconEventColumns::set_parameter_columns(const TString& particle_pars, const TString& event_pars)
+{
+   // Set up columns for particle and event parameters given as space-separated lists of "NAME/T"
+
+   fParNames.clear();
+   fParTypes.clear();
+   fEvParNames.clear();
+   fEvParTypes.clear();
+   KVString list(particle_pars);
+   list.Begin(" ");
+   while (!list.End()) {
+      TString name;
+      Char_t type;
+      if (parse_parameter(list.Next(), name, type)) add_parameter(fParNames, fParTypes, name, type, "particle");
+   }
+   list = event_pars;
+   list.Begin(" ");
+   while (!list.End()) {
+      TString name;
+      Char_t type;
+      if (parse_parameter(list.Next(), name, type)) add_parameter(fEvParNames, fEvParTypes, name, type, "event");
+   }
+   fParBranches.clear();
+   for (size_t i = 0; i < fParNames.size(); ++i) fParBranches.push_back(branch_name("par_", fParNames[i]));
+   fEvParBranches.clear();
+   for (size_t i = 0; i < fEvParNames.size(); ++i) fEvParBranches.push_back(branch_name("evpar_", fEvParNames[i]));
+   fParInt.assign(fParNames.size(), std::vector<Int_t>());
+   fParDouble.assign(fParNames.size(), std::vector<Double_t>());
+   fEvParInt.assign(fEvParNames.size(), 0);
+   fEvParDouble.assign(fEvParNames.size(), 0.);
+   resize(fCapacity);
+}
+
+void KVReconEventColumns::AddParticleParameter(const Char_t* name, Char_t type)
+{
+   // Store the values of the given parameter of each particle (see KVParticle::GetParameters())
+   // in branch `par_[name]`, either as integer (type='I') or floating-point (type='D') values.
+   //
+   // Must be called before MakeBranches().
+
+   if (fTree) {
+      Error("AddParticleParameter", "Must be called before MakeBranches()");
+      return;
+   }
+   if (add_parameter(fParNames, fParTypes, name, type, "particle"))
+      set_parameter_columns(parameter_list(fParNames, fParTypes), parameter_list(fEvParNames, fEvParTypes));
+}
+
+void KVReconEventColumns::AddEventParameter(const Char_t* name, Char_t type)
+{
+   // Store the values of the given parameter of each event (see KVEvent::GetParameters())
+   // in branch `evpar_[name]`, either as integer (type='I') or floating-point (type='D') values.
+   //
+   // Must be called before MakeBranches().
+
+   if (fTree) {
+      Error("AddEventParameter", "Must be called before MakeBranches()");
+      return;
+   }
+   if (add_parameter(fEvParNames, fEvParTypes, name, type, "event"))
+      set_parameter_columns(parameter_list(fParNames, fParTypes), parameter_list(fEvParNames, fEvParTypes));
+}
+
+void KVReconEventColumns::AddParametersFromEvent(const KVReconstructedEvent* e)
+{
+   // Add columns for all integer and floating-point parameters of the event and its particles
+   // which are not already stored. Call for a sample of events before calling MakeBranches().
+
+   if (fTree) {
+      Error("AddParametersFromEvent", "Must be called before MakeBranches()");
+      return;
+   }
+   Bool_t added = kFALSE;
+   KVNameValueList* pars = e->GetParameters();
+   for (Int_t j = 0; j < pars->GetNpar(); ++j) {
+      KVNamedParameter* p = pars->GetParameter(j);
+      if (p->IsInt() || p->IsDouble()) {
+         size_t n = fEvParNames.size();
+         add_parameter(fEvParNames, fEvParTypes, p->GetName(), p->IsInt() ? 'I' : 'D', "event");
+         added |= (fEvParNames.size() > n);
+      }
+   }
+   for (Int_t i = 1; i <= e->GetMult(); ++i) {
+      pars = e->GetParticle(i)->GetParameters();
+      for (Int_t j = 0; j < pars->GetNpar(); ++j) {
+         KVNamedParameter* p = pars->GetParameter(j);
+         if (p->IsInt() || p->IsDouble()) {
+            size_t n = fParNames.size();
+            add_parameter(fParNames, fParTypes, p->GetName(), p->IsInt() ? 'I' : 'D', "particle");
+            added |= (fParNames.size() > n);
+         }
+      }
+   }
+   if (added) set_parameter_columns(parameter_list(fParNames, fParTypes), parameter_list(fEvParNames, fEvParTypes));
+}
+
+void KVReconEventColumns::SetParametersFromEnv(const Char_t* dataset)
+{
+   // Add columns for the particle and event parameters given by the (possibly dataset-dependent) variables
+   //
+   //~~~~
+   //    KVReconEventColumns.ParticleParameters:   IDCODE/I ECODE/I
+   //    KVReconEventColumns.EventParameters:
+   //~~~~
+   //
+   // Each parameter is given as `NAME/I` (integer) or `NAME/D` (floating-point).
+   // Must be called before MakeBranches().
+
+   TString particle_pars = parameter_list(fParNames, fParTypes) + " "
+                           + GetDataSetEnv(dataset, "KVReconEventColumns.ParticleParameters", "IDCODE/I ECODE/I");
+   TString event_pars = parameter_list(fEvParNames, fEvParTypes) + " "
+                        + GetDataSetEnv(dataset, "KVReconEventColumns.EventParameters", "");
+   set_parameter_columns(particle_pars, event_pars);
+}
+
+Bool_t KVReconEventColumns::CanStore(const Char_t* event_class)
+{
+   // \returns kTRUE if events of the given class, and their particles, can be stored in columnar format
+   // without any loss of data, i.e. if neither the event class nor the class of its particles add any
+   // persistent data members to those of KVReconstructedEvent and KVReconstructedNucleus.
+   // Otherwise, prints the members which would not be stored.
+   //
+   // The identification results (KVIdentificationResult) of the particles are never stored.
+
+   TClass* cl = TClass::GetClass(event_class);
+   if (!cl || !cl->InheritsFrom("KVReconstructedEvent")) {
+      ::Error("KVReconEventColumns::CanStore", "Unknown event class %s", event_class);
+      return kFALSE;
+   }
+   TString members = persistent_members(cl, KVReconstructedEvent::Class());
+   KVReconstructedEvent* event = (KVReconstructedEvent*)cl->New();
+   members += persistent_members(event->AddParticle()->IsA(), KVReconstructedNucleus::Class());
+   delete event;
+   if (members != "") {
+      ::Error("KVReconEventColumns::CanStore", "Events of class %s cannot be stored in columnar format: members%s would be lost",
+              event_class, members.Data());
+      return kFALSE;
+   }
+   return kTRUE;
+}
+
+Bool_t KVReconEventColumns::MakeBranches(TTree* tree, const Char_t* event_class)
+{
+   // Create the branches for writing events of the given class in the tree.
+   // The format information and name dictionaries are added to the user info list of the tree,
+   // and will be written with it.
+   //
+   // Returns kFALSE (and nothing is done) if events of this class cannot be stored without loss of data
+   // (see CanStore()).
+
+   if (!CanStore(event_class)) return kFALSE;
+   fTree = fCurrentTree = tree;
+   fWriting = kTRUE;
+   fInfo = new KVNameValueList("KVReconEventColumns", "Columnar format of reconstructed events");
+   fInfo->SetValue("Version", fgVersion);
+   fInfo->SetValue("EventClass", event_class);
+   fInfo->SetValue("ParticleParameters", parameter_list(fParNames, fParTypes).Data());
+   fInfo->SetValue("EventParameters", parameter_list(fEvParNames, fEvParTypes).Data());
+   fInfo->SetValue("MaxMult", 0);
+   fDetNamesDict = new TObjArray;
+   fDetNamesDict->SetName("KVReconEventColumns.DetNames");
+   fDetNamesDict->SetOwner();
+   fIDTelDict = new TObjArray;
+   fIDTelDict->SetName("KVReconEventColumns.IDTel");
+   fIDTelDict->SetOwner();
+   tree->GetUserInfo()->Add(fInfo);
+   tree->GetUserInfo()->Add(fDetNamesDict);
+   tree->GetUserInfo()->Add(fIDTelDict);
+   fDetNamesIndex.clear();
+   fIDTelIndex.clear();
+
+   std::vector<column> columns = get_columns();
+   for (std::vector<column>::iterator c = columns.begin(); c != columns.end(); ++c) {
+      tree->Branch(c->name, c->address, c->per_particle ? Form("%s[Mult]/%c", c->name, c->type) : Form("%s/%c", c->name, c->type));
+   }
+   return kTRUE;
+}
+
+Int_t KVReconEventColumns::encode(std::map<TString, Int_t>& index, TObjArray* dict, const TString& name)
+{
+   // Returns id of name in dictionary, adding it if necessary. Returns -1 for an empty name.
+
+   if (name == "") return -1;
+   std::map<TString, Int_t>::iterator it = index.find(name);
+   if (it != index.end()) return it->second;
+   Int_t id = dict->GetEntriesFast();
+   dict->Add(new TObjString(name));
+   index[name] = id;
+   return id;
+}
+
+Int_t KVReconEventColumns::Fill(const KVReconstructedEvent* e)
+{
+   // Fill the branches with the event and call TTree::Fill() for the tree.
+   // Returns the value returned by TTree::Fill().
+
+   fNumber = e->GetNumber();
+   fMult = e->GetMult();
+   if (fMult > fCapacity) resize(TMath::Max(2 * fCapacity, fMult));
+   if (fMult > fInfo->GetIntValue("MaxMult")) fInfo->SetValue("MaxMult", fMult);
+
+   fEvParMask = 0;
+   for (size_t j = 0; j < fEvParNames.size(); ++j) {
+      KVNamedParameter* p = e->GetParameters()->FindParameter(fEvParNames[j]);
+      if (p) fEvParMask |= (1u << j);
+      if (fEvParTypes[j] == 'I') fEvParInt[j] = (p ? p->GetInt() : 0);
+      else fEvParDouble[j] = (p ? p->GetDouble() : 0.);
+   }
+
+   for (Int_t i = 0; i < fMult; ++i) {
+      const KVReconstructedNucleus* nuc = e->GetParticle(i + 1);
+      fZ[i] = nuc->GetZ();
+      fA[i] = nuc->GetA();
+      fE[i] = nuc->GetEnergy();
+      fTheta[i] = nuc->GetTheta();
+      fPhi[i] = nuc->GetPhi();
+      fRealZ[i] = nuc->fRealZ;
+      fRealA[i] = nuc->fRealA;
+      fTargetEnergyLoss[i] = nuc->fTargetEnergyLoss;
+      fStatus[i] = nuc->fAnalStatus;
+      fNSegDet[i] = nuc->fNSegDet;
+      fFlags[i] = nuc->TestBits(fgFlagMask);
+      fDetNames[i] = encode(fDetNamesIndex, fDetNamesDict, nuc->fDetNames);
+      fIDTel[i] = encode(fIDTelIndex, fIDTelDict, nuc->fIDTelName);
+      fParMask[i] = 0;
+      for (size_t j = 0; j < fParNames.size(); ++j) {
+         KVNamedParameter* p = nuc->GetParameters()->FindParameter(fParNames[j]);
+         if (p) fParMask[i] |= (1u << j);
+         if (fParTypes[j] == 'I') fParInt[j][i] = (p ? p->GetInt() : 0);
+         else fParDouble[j][i] = (p ? p->GetDouble() : 0.);
+      }
+   }
+   return fTree->Fill();
+}
+
+KVNameValueList* KVReconEventColumns::get_info(TTree* t)
+{
+   // Format information in user info of tree, nullptr if tree is not in columnar format
+
+   return t ? (KVNameValueList*)t->GetUserInfo()->FindObject("KVReconEventColumns") : nullptr;
+}
+
+Bool_t KVReconEventColumns::IsColumnar(TTree* tree)
+{
+   // Returns kTRUE if tree (or the first tree of a TChain) contains reconstructed events in columnar format
+
+   if (!tree || !tree->GetBranch("Mult")) return kFALSE; // for a TChain, GetBranch() loads the first tree
+   return get_info(tree->GetTree()) != nullptr;
+}
+
+Bool_t KVReconEventColumns::read_columns(const column& c) const
+{
+   // Returns kTRUE if column is to be read. Event number, multiplicity, Z, A, flags and parameter masks
+   // are always read, as are the IDCODE and ECODE parameters used to select particles for analysis
+   // (see KVMultiDetArray::AcceptParticleForAnalysis()).
+
+   if (fReadColumns == "") return kTRUE;
+   TString name(c.name);
+   if (name == "Number" || name == "Mult" || name == "Z" || name == "A" || name == "Flags" || name == "EvParMask" || name == "ParMask"
+         || name == "par_IDCODE" || name == "par_ECODE") return kTRUE;
+   fReadColumns.Begin(" ,");
+   while (!fReadColumns.End()) {
+      KVString col = fReadColumns.Next();
+      if (name == col || name == branch_name("par_", col) || name == branch_name("evpar_", col)) return kTRUE;
+   }
+   return kFALSE;
+}
+
+Bool_t KVReconEventColumns::configure(TTree* t)
+{
+   // Set up reading of current tree t (of TChain): format information, name dictionaries, parameter columns,
+   // size of arrays and status of branches
+
+   fCurrentTree = t;
+   fInfo = get_info(t);
+   if (!fInfo) {
+      Error("configure", "Tree %s does not contain events in columnar format", t ? t->GetName() : "(null)");
+      return kFALSE;
+   }
+   if (fInfo->GetIntValue("Version") > fgVersion) {
+      Error("configure", "Tree %s was written with a more recent version (%d) of the format", t->GetName(), fInfo->GetIntValue("Version"));
+      return kFALSE;
+   }
+   fDetNamesDict = (TObjArray*)t->GetUserInfo()->FindObject("KVReconEventColumns.DetNames");
+   fIDTelDict = (TObjArray*)t->GetUserInfo()->FindObject("KVReconEventColumns.IDTel");
+   TString particle_pars = fInfo->GetTStringValue("ParticleParameters");
+   TString event_pars = fInfo->GetTStringValue("EventParameters");
+   if (particle_pars != parameter_list(fParNames, fParTypes) || event_pars != parameter_list(fEvParNames, fEvParTypes))
+      set_parameter_columns(particle_pars, event_pars);
+
+   // arrays must be big enough for the largest multiplicity in the tree
+   Int_t max_mult = TMath::Max(fInfo->GetIntValue("MaxMult"), 1);
+   TLeaf* mult = t->GetLeaf("Mult");
+   if (mult) max_mult = TMath::Max(max_mult, mult->GetMaximum());
+   resize(TMath::Max(max_mult, fCapacity));
+
+   std::vector<column> columns = get_columns();
+   for (std::vector<column>::iterator c = columns.begin(); c != columns.end(); ++c) {
+      if (fTree->GetBranch(c->name)) fTree->SetBranchStatus(c->name, read_columns(*c));
+   }
+   fReadDetNames = fDetNamesDict && fTree->GetBranch("DetNames") && fTree->GetBranchStatus("DetNames");
+   fReadIDTel = fIDTelDict && fTree->GetBranch("IDTel") && fTree->GetBranchStatus("IDTel");
+   return kTRUE;
+}
+
+Bool_t KVReconEventColumns::ConnectTree(TTree* tree, const KVString& columns)
+{
+   // Set up reading of events from the tree (TTree or TChain).
+   //
+   // \param[in] tree tree containing events in columnar format (see IsColumnar())
+   // \param[in] columns space- or comma-separated list of the columns to read (all if empty).
+   //                    Particle & event parameters can be given with or without their `par_` or `evpar_` prefix.
+   //
+   // An event of the class which was written is created: it will be filled by each call to GetEntry(),
+   // and can be retrieved with GetEvent().
+   //
+   // When reading a TChain outside of a TSelector, it is not necessary to call TChain::SetNotify():
+   // GetEntry() takes care of changes of tree.
+
+   if (!IsColumnar(tree)) {
+      Error("ConnectTree", "Tree %s does not contain events in columnar format", tree ? tree->GetName() : "(null)");
+      return kFALSE;
+   }
+   fTree = tree;
+   fWriting = kFALSE;
+   fReadColumns = columns;
+   if (!configure(tree->GetTree())) return kFALSE;
+   TClass* cl = TClass::GetClass(fInfo->GetStringValue("EventClass"));
+   if (!cl || !cl->InheritsFrom("KVReconstructedEvent")) {
+      Error("ConnectTree", "Unknown event class %s", fInfo->GetStringValue("EventClass"));
+      return kFALSE;
+   }
+   if (!fEvent || fEvent->IsA() != cl) {
+      SafeDelete(fEvent);
+      fEvent = (KVReconstructedEvent*)cl->New();
+   }
+   return kTRUE;
+}
+
+Bool_t KVReconEventColumns::Notify()
+{
+   // Called when a new tree of a TChain is loaded (see TChain::SetNotify(), KVReconEventSelector::Notify()):
+   // read the format information and name dictionaries of the new tree
+
+   if (!fTree || fWriting) return kTRUE;
+   TTree* t = fTree->GetTree();
+   if (t && t != fCurrentTree) return configure(t);
+   return kTRUE;
+}
+
+void KVReconEventColumns::FillEvent(KVReconstructedEvent* e)
+{
+   // Fill the event with the current values of the columns (i.e. after calling TTree::GetEntry()).
+   //
+   // If the multidetector array exists, the particles are associated with their reconstruction trajectories,
+   // detectors and identification telescopes, and the same treatment is applied to the event as when reading
+   // it in object format (see KVReconstructedEvent::LinkToArray()).
+
+   e->Clear();
+   e->SetNumber(fNumber);
+   for (size_t j = 0; j < fEvParNames.size(); ++j) {
+      if (!(fEvParMask & (1u << j))) continue;
+      if (fEvParTypes[j] == 'I') e->GetParameters()->SetValue(fEvParNames[j], fEvParInt[j]);
+      else e->GetParameters()->SetValue(fEvParNames[j], fEvParDouble[j]);
+   }
+   for (Int_t i = 0; i < fMult; ++i) {
+      KVReconstructedNucleus* nuc = e->AddParticle();
+      nuc->SetZandA(fZ[i], fA[i]);
+      if (fE[i] > 0) {
+         TVector3 dir;
+         dir.SetMagThetaPhi(1., fTheta[i] * TMath::DegToRad(), fPhi[i] * TMath::DegToRad());
+         nuc->SetMomentum(fE[i], dir);
+      }
+      nuc->fRealZ = fRealZ[i];
+      nuc->fRealA = fRealA[i];
+      nuc->fTargetEnergyLoss = fTargetEnergyLoss[i];
+      nuc->fAnalStatus = fStatus[i];
+      nuc->fNSegDet = fNSegDet[i];
+      nuc->ResetBit(fgFlagMask);
+      nuc->SetBit(fFlags[i] & fgFlagMask);
+      if (fReadDetNames && fDetNames[i] >= 0 && fDetNames[i] < fDetNamesDict->GetEntriesFast())
+         nuc->fDetNames = ((TObjString*)fDetNamesDict->At(fDetNames[i]))->GetString();
+      if (fReadIDTel && fIDTel[i] >= 0 && fIDTel[i] < fIDTelDict->GetEntriesFast())
+         nuc->fIDTelName = ((TObjString*)fIDTelDict->At(fIDTel[i]))->GetString();
+      for (size_t j = 0; j < fParNames.size(); ++j) {
+         if (!(fParMask[i] & (1u << j))) continue;
+         if (fParTypes[j] == 'I') nuc->GetParameters()->SetValue(fParNames[j], fParInt[j][i]);
+         else nuc->GetParameters()->SetValue(fParNames[j], fParDouble[j][i]);
+      }
+      if (fReadDetNames) nuc->LinkToArray(KVReconstructedNucleus::Class_Version());
+   }
+   e->LinkToArray();
+}
+
+Int_t KVReconEventColumns::GetEntry(Long64_t entry)
+{
+   // Read entry of the tree (or TChain) and fill the event returned by GetEvent().
+   // Returns the number of bytes read.
+
+   Long64_t local = fTree->LoadTree(entry);
+   if (local < 0) return 0;
+   if (!Notify()) return 0;
+   Int_t nbytes = fTree->GetTree()->GetEntry(local);
+   FillEvent(fEvent);
+   return nbytes;
+}
+
+Bool_t KVReconEventColumns::Convert(const Char_t* input, const Char_t* output, Long64_t scan_events,
+                                    const Char_t* treename, const Char_t* branchname)
+{
+   // Convert a file containing reconstructed events written in object format (KVEvent::MakeEventBranch())
+   // to a file with the same events in columnar format.
+   //
+   // \param[in] input name of file to convert
+   // \param[in] output name of new file
+   // \param[in] scan_events columns are created for all integer & floating-point event and particle parameters found in
+   //                        this number of events at the start of the file, as well as those defined by SetParametersFromEnv()
+   // \param[in] treename name of tree in input file, used also for new tree
+   // \param[in] branchname name of branch containing events in input file
+   //
+   // The new tree has the same name and title as the original, and a copy of its user info list.
+   // All other objects in the input file are copied to the output file.
+   //
+   // Events are read without any multidetector array, so that they are converted exactly as they were written.
+   // Files of events which cannot be stored without loss of data (see CanStore()) are not converted.
+
+   TDirectory* work_dir = gDirectory;   //keep pointer to current directory
+   TFile* fin = TFile::Open(input);
+   work_dir->cd();
+   if (!fin || fin->IsZombie()) {
+      ::Error("KVReconEventColumns::Convert", "Cannot open file %s", input);
+      delete fin;
+      return kFALSE;
+   }
+   TTree* tin = (TTree*)fin->Get(treename);
+   if (!tin || !tin->GetBranch(branchname)) {
+      ::Error("KVReconEventColumns::Convert", "No tree %s with branch %s in file %s", treename, branchname, input);
+      delete fin;
+      return kFALSE;
+   }
+   if (!CanStore(tin->GetBranch(branchname)->GetClassName())) {
+      delete fin;
+      return kFALSE;
+   }
+   KVMultiDetArray* array = gMultiDetArray;
+   gMultiDetArray = nullptr;
+
+   KVReconstructedEvent* event = nullptr;
+   tin->SetBranchAddress(branchname, &event);
+   KVReconEventColumns columns;
+   columns.SetParametersFromEnv(gDataSet ? gDataSet->GetName() : "");
+   Long64_t nevents = tin->GetEntries();
+   for (Long64_t i = 0; i < TMath::Min(scan_events, nevents); ++i) {
+      tin->GetEntry(i);
+      columns.AddParametersFromEvent(event);
+   }
+
+   TFile fout(output, "RECREATE");
+   Bool_t ok = !fout.IsZombie();
+   if (ok) {
+      // copy all other objects (most recent cycle only)
+      TIter next_key(fin->GetListOfKeys());
+      TKey* key;
+      KVString copied;
+      while ((key = (TKey*)next_key())) {
+         if (!strcmp(key->GetName(), treename) || copied.Contains(Form(" %s ", key->GetName()))) continue;
+         copied += Form(" %s ", key->GetName());
+         TObject* obj = key->ReadObj();
+         fout.cd();
+         if (obj->InheritsFrom("TTree")) {
+            TTree* copy = ((TTree*)obj)->CloneTree(-1, "fast");
+            copy->Write();
+            delete copy;
+         }
+         else if (!obj->InheritsFrom("TDirectory")) fout.WriteTObject(obj, key->GetName());
+         delete obj;
+      }
+      fout.cd();
+      TTree* tout = new TTree(treename, tin->GetTitle());
+      TIter next_info(tin->GetUserInfo());
+      TObject* obj;
+      while ((obj = next_info())) tout->GetUserInfo()->Add(obj->Clone());
+      TString event_class = (event ? event->ClassName() : tin->GetBranch(branchname)->GetClassName());
+      columns.MakeBranches(tout, event_class);
+      for (Long64_t i = 0; i < nevents; ++i) {
+         tin->GetEntry(i);
+         columns.Fill(event);
+         if (i && !(i % 100000)) ::Info("KVReconEventColumns::Convert", "%lld/%lld events", i, nevents);
+      }
+      tout->Write();
+      ::Info("KVReconEventColumns::Convert", "Converted %lld events: %s (%lld bytes) => %s (%lld bytes)",
+             nevents, input, fin->GetSize(), output, fout.GetSize());
+      delete tout;
+   }
+   fout.Close();
+   work_dir->cd();
+   tin->ResetBranchAddresses();
+   delete event;
+   delete fin;
+   gMultiDetArray = array;
+   return ok;
+}
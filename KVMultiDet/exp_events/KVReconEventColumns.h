@@ -0,0 +1,179 @@
+//Created by KVClassFactory on Sat Oct 17 16:42:08 2026
+
+#ifndef __KVRECONEVENTCOLUMNS_H
+#define __KVRECONEVENTCOLUMNS_H
+
+#include "KVBase.h"
+#include "KVString.h"
+#include <map>
+#include <vector>
+
+class KVReconstructedEvent;
+class KVNameValueList;
+class TObjArray;
+class TTree;
+
+/**
+\class KVReconEventColumns
+\brief Columnar storage of reconstructed events in a TTree
+\ingroup Reconstruction
+
+Reconstructed events are normally written with KVEvent::MakeEventBranch(), i.e. each event is a single
+object in one branch, and every particle is streamed with the names of its detectors and identification
+telescope, its list of parameters and all of its identification results. Reading any
+quantity requires the whole event to be deserialised.
+
+This class writes and reads reconstructed events in a columnar format: each quantity is stored in its own
+branch of the TTree, with one entry per particle for the particle quantities. The names of the detectors
+(reconstruction trajectory) and of the identification telescope of each particle are replaced by integer
+ids, the corresponding names being stored once per TTree (in its user info list).
+
+| Branch             | Type     | Content                                                                |
+|--------------------|----------|------------------------------------------------------------------------|
+| `Number`           | UInt_t   | event number (KVEvent::GetNumber())                                    |
+| `Mult`             | Int_t    | number of particles in the event                                       |
+| `EvParMask`        | UInt_t   | bit \f$i\f$ set if the event has the \f$i\f$th event parameter         |
+| `evpar_[name]`     | I or D   | value of event parameter `[name]`                                      |
+| `Z[Mult]`          | UChar_t  | atomic number                                                          |
+| `A[Mult]`          | UChar_t  | mass number                                                            |
+| `E[Mult]`          | Float_t  | kinetic energy [MeV]                                                   |
+| `Theta[Mult]`      | Float_t  | polar angle [deg]                                                      |
+| `Phi[Mult]`        | Float_t  | azimuthal angle [deg]                                                  |
+| `RealZ[Mult]`      | Float_t  | Z returned by identification                                           |
+| `RealA[Mult]`      | Float_t  | A returned by identification                                           |
+| `TargetEnergyLoss[Mult]` | Float_t | calculated energy loss in target [MeV]                           |
+| `Status[Mult]`     | Short_t  | reconstruction status (KVReconstructedNucleus::GetStatus())            |
+| `NSegDet[Mult]`    | Short_t  | number of independent detectors hit                                   |
+| `Flags[Mult]`      | UInt_t   | identified/calibrated/Z measured/A measured/coherency/OK flags         |
+| `DetNames[Mult]`   | Int_t    | id of the names of the detectors on the reconstruction trajectory      |
+| `IDTel[Mult]`      | Int_t    | id of the name of the identifying telescope (-1 if none)               |
+| `ParMask[Mult]`    | UInt_t   | bit \f$i\f$ set if the particle has the \f$i\f$th particle parameter   |
+| `par_[name][Mult]` | I or D   | value of particle parameter `[name]`                                   |
+
+Only the parameters of the events and particles which are declared before the branches are created are stored
+(up to 32 of each), see AddEventParameter(), AddParticleParameter(), AddParametersFromEvent() and SetParametersFromEnv().
+The identification results (KVIdentificationResult) of the particles are not stored. Events of classes which add
+persistent data members to KVReconstructedEvent, or whose particles add persistent data members to KVReconstructedNucleus
+(e.g. KVFAZIAReconNuc), cannot be stored in this format: MakeBranches() and Convert() refuse them (see CanStore()).
+Kinematical quantities are stored in single precision.
+
+### Writing
+
+~~~~{.cpp}
+KVReconEventColumns columns;
+columns.SetParametersFromEnv(gDataSet->GetName());
+columns.MakeBranches(tree, event->ClassName());
+...
+columns.Fill(event);   // fills the branches and calls tree->Fill()
+~~~~
+
+Reconstruction (KVRawDataReconstructor) writes events in this format if the (possibly dataset-dependent)
+variable `KVRawDataReconstructor.Format` is set to `columnar`. Existing files of reconstructed events
+can be converted with Convert().
+
+### Reading
+
+KVReconEventSelector (and hence any analysis of reconstructed data) recognises trees in this format
+automatically: the events seen by the analysis are rebuilt from the columns, and if the multidetector array
+exists, the particles are associated with their reconstruction trajectories, detectors and identification telescopes
+as when reading events in the object format (see KVReconstructedEvent::LinkToArray()).
+In order to read only some of the columns, call KVReconEventSelector::SetReadColumns() in the
+InitAnalysis() method of the analysis class. Any other quantities of the particles are left with their default values.
+
+~~~~{.cpp}
+KVReconEventColumns columns;
+columns.ConnectTree(tree, "Z A E Theta");
+KVReconstructedEvent* event = columns.GetEvent();
+for (Long64_t i = 0; i < tree->GetEntries(); ++i) {
+   columns.GetEntry(i);
+   ...
+}
+~~~~
+
+The branches can of course also be used directly with TTree::Draw(), e.g. `tree->Draw("E:Theta", "Z==2")`.
+*/
+class KVReconEventColumns : public KVBase {
+
+   struct column {
+      const Char_t* name;
+      Char_t type;
+      void* address;
+      Bool_t per_particle;
+   };
+
+   TTree* fTree;//! tree being written or read
+   TTree* fCurrentTree;//! current tree of TChain being read
+   Bool_t fWriting;//! kTRUE when writing
+   KVNameValueList* fInfo;//! format information (in user info of tree)
+   TObjArray* fDetNamesDict;//! names of detectors corresponding to each id (in user info of tree)
+   TObjArray* fIDTelDict;//! names of identification telescopes corresponding to each id (in user info of tree)
+   std::map<TString, Int_t> fDetNamesIndex;//! ids of detector names (writing)
+   std::map<TString, Int_t> fIDTelIndex;//! ids of identification telescope names (writing)
+   KVReconstructedEvent* fEvent;//! event filled by GetEntry()
+   KVString fReadColumns;//! columns to read (all if empty)
+   Bool_t fReadDetNames, fReadIDTel;//! kTRUE if detector & identification telescope names are read
+   TString fIgnoredParameters;//! parameters which could not be added
+
+   Int_t fCapacity;//! size of arrays of particle quantities
+   UInt_t fNumber;//!
+   Int_t fMult;//!
+   UInt_t fEvParMask;//!
+   std::vector<UChar_t> fZ, fA;//!
+   std::vector<Float_t> fE, fTheta, fPhi, fRealZ, fRealA, fTargetEnergyLoss;//!
+   std::vector<Short_t> fStatus, fNSegDet;//!
+   std::vector<UInt_t> fFlags, fParMask;//!
+   std::vector<Int_t> fDetNames, fIDTel;//!
+
+   std::vector<TString> fParNames, fEvParNames;//! names of particle & event parameters
+   std::vector<Char_t> fParTypes, fEvParTypes;//! types of particle & event parameters ('I' or 'D')
+   std::vector<std::vector<Int_t> > fParInt;//! values of integer particle parameters
+   std::vector<std::vector<Double_t> > fParDouble;//! values of floating-point particle parameters
+   std::vector<Int_t> fEvParInt;//! values of integer event parameters
+   std::vector<Double_t> fEvParDouble;//! values of floating-point event parameters
+   std::vector<TString> fParBranches, fEvParBranches;//! names of parameter branches
+
+   static const Int_t fgVersion;// version of format
+   static const UInt_t fgFlagMask;// particle flags which are stored
+   static const Int_t fgMaxParameters;// maximum number of particle/event parameters
+
+   std::vector<column> get_columns();
+   void resize(Int_t);
+   void set_addresses();
+   void set_parameter_columns(const TString& particle_pars, const TString& event_pars);
+   TString parameter_list(const std::vector<TString>&, const std::vector<Char_t>&) const;
+   Bool_t add_parameter(std::vector<TString>&, std::vector<Char_t>&, const TString&, Char_t, const Char_t*);
+   Bool_t read_columns(const column&) const;
+   Bool_t configure(TTree*);
+   Int_t encode(std::map<TString, Int_t>&, TObjArray*, const TString&);
+   static KVNameValueList* get_info(TTree*);
+
+public:
+   KVReconEventColumns();
+   virtual ~KVReconEventColumns();
+
+   void AddParticleParameter(const Char_t* name, Char_t type = 'D');
+   void AddEventParameter(const Char_t* name, Char_t type = 'D');
+   void AddParametersFromEvent(const KVReconstructedEvent*);
+   void SetParametersFromEnv(const Char_t* dataset = "");
+   static Bool_t CanStore(const Char_t* event_class);
+   Bool_t MakeBranches(TTree*, const Char_t* event_class);
+   Int_t Fill(const KVReconstructedEvent*);
+
+   static Bool_t IsColumnar(TTree*);
+   Bool_t ConnectTree(TTree*, const KVString& columns = "");
+   virtual Bool_t Notify();
+   void FillEvent(KVReconstructedEvent*);
+   Int_t GetEntry(Long64_t entry);
+   KVReconstructedEvent* GetEvent() const
+   {
+      // Event filled by GetEntry(), created by ConnectTree() with the class of the events which were written
+      return fEvent;
+   }
+
+   static Bool_t Convert(const Char_t* input, const Char_t* output, Long64_t scan_events = 100,
+                         const Char_t* treename = "ReconEvents", const Char_t* branchname = "ReconEvent");
+
+   ClassDef(KVReconEventColumns, 0) //Columnar storage of reconstructed events in a TTree
+};
+
+#endif
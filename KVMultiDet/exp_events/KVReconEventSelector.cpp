@@ -5,9 +5,15 @@
 
 #include <KVClassFactory.h>
 #include <KVReconDataAnalyser.h>
+#include <KVReconEventColumns.h>
 
 ClassImp(KVReconEventSelector)
 
+KVReconEventSelector::~KVReconEventSelector()
+{
+   SafeDelete(fColumns);
+}
+
 
 void KVReconEventSelector::Init(TTree* tree)
 {
@@ -22,6 +28,36 @@ void KVReconEventSelector::Init(TTree* tree)
    }
 }
 
+Bool_t KVReconEventSelector::Notify()
+{
+   // For data in columnar format, update reader for new tree of TChain
+
+   if (fColumns) fColumns->Notify();
+   return KVEventSelector::Notify();
+}
+
+Bool_t KVReconEventSelector::ConnectEventColumns(TTree* tree)
+{
+   // Called by Init(): if tree contains events in columnar format (see KVReconEventColumns),
+   // set up reading of the columns given to SetReadColumns() (all if none given)
+
+   if (!KVReconEventColumns::IsColumnar(tree)) return kFALSE;
+   if (!fColumns) fColumns = new KVReconEventColumns;
+   if (!fColumns->ConnectTree(tree, fReadColumns)) return kFALSE;
+   if (fReadColumns != "") Info("ConnectEventColumns", "Reading columns: %s", fReadColumns.Data());
+   SetEvent(fColumns->GetEvent());
+   return kTRUE;
+}
+
+Int_t KVReconEventSelector::GetEntry(Long64_t entry, Int_t getall)
+{
+   // For data in columnar format, the event is filled from the columns after reading the entry
+
+   Int_t nbytes = KVEventSelector::GetEntry(entry, getall);
+   if (fColumns && GetEvent() == fColumns->GetEvent()) fColumns->FillEvent(GetEvent());
+   return nbytes;
+}
+
 void KVReconEventSelector::Make(const Char_t* kvsname)
 {
    // Generate a new recon data analysis selector class
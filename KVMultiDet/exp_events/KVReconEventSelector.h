@@ -8,22 +8,32 @@
 #include "KVDBRun.h"
 #include "KVReconstructedEvent.h"
 
+class KVReconEventColumns;
+
 /**
    \class KVReconEventSelector
 \brief Base class for user analysis of reconstructed data
 \ingroup Analysis
+
+Reconstructed events can be analysed either in the object format (branch `ReconEvent` written by KVEvent::MakeEventBranch())
+or in the columnar format written by KVReconEventColumns, which is recognised automatically. In the latter case
+the analysis can be restricted to reading only some of the columns with SetReadColumns(). Note that the
+identification results of the particles (KVReconstructedNucleus::GetIdentificationResult()) are not stored
+in the columnar format.
 */
 
 class KVReconEventSelector : public KVEventSelector {
    KVDBRun* fCurrentRun;//current run being analysed
+   KVReconEventColumns* fColumns;//! reader for events in columnar format
+   KVString fReadColumns;//! columns to read for events in columnar format (all if empty)
 
 public:
-   KVReconEventSelector(TTree* arg1 = 0) : KVEventSelector(arg1), fCurrentRun(nullptr)
+   KVReconEventSelector(TTree* arg1 = 0) : KVEventSelector(arg1), fCurrentRun(nullptr), fColumns(nullptr)
    {
       SetBranchName("ReconEvent");
       SetParticleConditionsParticleClassName("KVReconstructedNucleus");
    }
-   virtual ~KVReconEventSelector() {}
+   virtual ~KVReconEventSelector();
 
    void SetCurrentRun(KVDBRun* r)
    {
@@ -34,6 +44,18 @@ public:
       return fCurrentRun;
    }
    void Init(TTree* tree);
+   Bool_t Notify();
+   Bool_t ConnectEventColumns(TTree*);
+   Int_t GetEntry(Long64_t entry, Int_t getall = 0);
+   void SetReadColumns(const KVString& columns)
+   {
+      // For data in columnar format (see KVReconEventColumns), read only the given columns,
+      // e.g. "Z A E Theta Phi". Call in InitAnalysis().
+      //
+      // Event number, multiplicity, Z, A, flags and the IDCODE and ECODE parameters are always read.
+      // The other quantities of the particles have their default values.
+      fReadColumns = columns;
+   }
 
    Int_t GetEventNumber()
    {
@@ -57,27 +57,7 @@ void KVReconstructedEvent::Streamer(TBuffer& R__b)
 
    if (R__b.IsReading()) {
       R__b.ReadClassBuffer(KVReconstructedEvent::Class(), this);
-      // if the multidetector object exists, update some informations
-      // concerning the detectors etc. hit by this particle
-      if (gMultiDetArray) {
-         // reset raw data in detectors if found in parameter list
-         gMultiDetArray->SetRawDataFromReconEvent(fParameters);
-         //set angles
-         KVReconstructedNucleus* par;
-         for (KVEvent::Iterator it = begin(); it != end(); ++it) {
-            par = it.get_pointer<KVReconstructedNucleus>();
-            if (HasMeanAngles())
-               par->GetAnglesFromReconstructionTrajectory("mean");
-            else
-               par->GetAnglesFromReconstructionTrajectory("random");
-            //reconstruct fAnalStatus information for unidentified KVReconstructedNucleus
-            if (!par->IsIdentified() && par->GetStatus() == 99)        //AnalStatus has not been set for particles in group
-               if (par->GetGroup())
-                  KVReconstructedNucleus::AnalyseParticlesInGroup(par->GetGroup());
-            // apply identification & calibration code selection
-            gMultiDetArray->AcceptParticleForAnalysis(par);
-         }
-      }
+      LinkToArray();
    }
    else {
       R__b.WriteClassBuffer(KVReconstructedEvent::Class(), this);
@@ -85,6 +65,36 @@ void KVReconstructedEvent::Streamer(TBuffer& R__b)
 }
 
 
+//_______________________________________________________________________________________//
+
+void KVReconstructedEvent::LinkToArray()
+{
+   // Called after reading the event from a file (see Streamer() and KVReconEventColumns):
+   // if the multidetector object exists, update some informations
+   // concerning the detectors etc. hit by the particles, set their angles
+   // and apply the identification & calibration code selection
+
+   if (gMultiDetArray) {
+      // reset raw data in detectors if found in parameter list
+      gMultiDetArray->SetRawDataFromReconEvent(fParameters);
+      //set angles
+      KVReconstructedNucleus* par;
+      for (KVEvent::Iterator it = begin(); it != end(); ++it) {
+         par = it.get_pointer<KVReconstructedNucleus>();
+         if (HasMeanAngles())
+            par->GetAnglesFromReconstructionTrajectory("mean");
+         else
+            par->GetAnglesFromReconstructionTrajectory("random");
+         //reconstruct fAnalStatus information for unidentified KVReconstructedNucleus
+         if (!par->IsIdentified() && par->GetStatus() == 99)        //AnalStatus has not been set for particles in group
+            if (par->GetGroup())
+               KVReconstructedNucleus::AnalyseParticlesInGroup(par->GetGroup());
+         // apply identification & calibration code selection
+         gMultiDetArray->AcceptParticleForAnalysis(par);
+      }
+   }
+}
+
 //______________________________________________________________________________________//
 
 Bool_t KVReconstructedEvent::AnalyseDetectors(TList* kvtl)
@@ -89,6 +89,7 @@ public:
       // in first round (methods IdentifyEvent() and CalibrateEvent()).
    }
    void MergeEventFragments(TCollection*, Option_t* opt = "");
+   void LinkToArray();
 
    ClassDef(KVReconstructedEvent, 2)    //Base class for reconstructed experimental multiparticle events
 };
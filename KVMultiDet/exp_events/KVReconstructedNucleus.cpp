@@ -83,31 +83,7 @@ void KVReconstructedNucleus::Streamer(TBuffer& R__b)
          R__b.ReadClassBuffer(KVReconstructedNucleus::Class(), this, R__v, R__s, R__c);
       // if the multidetector object exists, update some informations
       // concerning the detectors etc. hit by this particle
-      if (gMultiDetArray) {
-         MakeDetectorList();
-         fReconTraj = nullptr;
-         RebuildReconTraj();
-         fIDTelescope = nullptr;
-         if (fIDTelName != "") fIDTelescope = gMultiDetArray->GetIDTelescope(fIDTelName.Data());
-         if (fReconTraj) {
-            if (R__v < 16) fNSegDet = fReconTraj->GetNumberOfIndependentIdentifications(); // fNSegDet/fAnalStatus non-persistent before v.16
-         }
-         else {
-            TIter next_det(&fDetList);
-            KVDetector* det;
-            while ((det = (KVDetector*)next_det())) {
-               det->AddHit(this);
-               if (det->IsDetecting()) { //to be coherent with AddDetector() method
-                  if (R__v < 16) fNSegDet += det->GetSegment();  // fNSegDet/fAnalStatus non-persistent before v.16
-                  //modify detector's counters depending on particle's identification state
-                  if (IsIdentified())
-                     det->IncrementIdentifiedParticles();
-                  else
-                     det->IncrementUnidentifiedParticles();
-               }
-            }
-         }
-      }
+      LinkToArray(R__v);
    }
    else {
       R__b.WriteClassBuffer(KVReconstructedNucleus::Class(), this);
@@ -116,6 +92,44 @@ void KVReconstructedNucleus::Streamer(TBuffer& R__b)
 
 //___________________________________________________________________________
 
+void KVReconstructedNucleus::LinkToArray(Version_t R__v)
+{
+   // Called after reading the particle from a file (see Streamer() and KVReconEventColumns):
+   // if the multidetector object exists, use the names of the detectors and the identification
+   // telescope to associate the particle with its reconstruction trajectory, detectors and
+   // identification telescope.
+   //
+   // \param[in] R__v class version with which particle was written
+
+   if (gMultiDetArray) {
+      MakeDetectorList();
+      fReconTraj = nullptr;
+      RebuildReconTraj();
+      fIDTelescope = nullptr;
+      if (fIDTelName != "") fIDTelescope = gMultiDetArray->GetIDTelescope(fIDTelName.Data());
+      if (fReconTraj) {
+         if (R__v < 16) fNSegDet = fReconTraj->GetNumberOfIndependentIdentifications(); // fNSegDet/fAnalStatus non-persistent before v.16
+      }
+      else {
+         TIter next_det(&fDetList);
+         KVDetector* det;
+         while ((det = (KVDetector*)next_det())) {
+            det->AddHit(this);
+            if (det->IsDetecting()) { //to be coherent with AddDetector() method
+               if (R__v < 16) fNSegDet += det->GetSegment();  // fNSegDet/fAnalStatus non-persistent before v.16
+               //modify detector's counters depending on particle's identification state
+               if (IsIdentified())
+                  det->IncrementIdentifiedParticles();
+               else
+                  det->IncrementUnidentifiedParticles();
+            }
+         }
+      }
+   }
+}
+
+//___________________________________________________________________________
+
 void KVReconstructedNucleus::PrintStatusString() const
 {
    switch (GetStatus()) {
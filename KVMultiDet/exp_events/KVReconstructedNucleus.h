@@ -18,6 +18,8 @@
 */
 class KVReconstructedNucleus: public KVNucleus {
 
+   friend class KVReconEventColumns;
+
 protected:
    const KVReconNucTrajectory* fReconTraj;//! trajectory used to reconstruct particle
    KVString fDetNames; // list of names of detectors through which particle passed
@@ -43,6 +45,7 @@ protected:
 
    void MakeDetectorList();
    void RebuildReconTraj();
+   void LinkToArray(Version_t);
 public:
    void ReplaceReconTraj(const TString& traj_name);
 
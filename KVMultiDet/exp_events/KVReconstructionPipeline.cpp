@@ -0,0 +1,251 @@
+//Created by KVClassFactory on Sat Oct 17 14:05:12 2026
+
+#include "KVReconstructionPipeline.h"
+
+#ifdef WITH_CPP11
+#include "KVEventReconstructor.h"
+#include "KVMultiDetArray.h"
+#include "KVReconstructedEvent.h"
+#include "KVReconEventColumns.h"
+#include "KVThreadPool.h"
+#include "TTree.h"
+#include "TError.h"
+#ifdef USING_ROOT6
+#include "TROOT.h"
+#endif
+
+namespace {
+   double seconds(std::chrono::steady_clock::duration d)
+   {
+      return std::chrono::duration<double>(d).count();
+   }
+   double rate(Long64_t n, double s)
+   {
+      return s > 0 ? n / s : 0.;
+   }
+}
+
+KVReconstructionPipeline::KVReconstructionPipeline(TTree* tree, KVReconstructedEvent** branch_address, unsigned int nslots)
+   : fTree(tree), fBranchAddress(branch_address), fSavedBranchEvent(*branch_address), fColumns(nullptr),
+     fCurrentWorker(nullptr), fNextToRead(0), fNextToWrite(0), fFinished(false),
+     fWallTime(0), fReaderWait(0), fReaderRecon(0), fWriterBusy(0), fEventsRead(0), fEventsWritten(0), fStarted(false)
+{
+   // \param[in] tree the tree to fill with reconstructed events
+   // \param[in] branch_address address of the pointer given to KVEvent::MakeEventBranch for the tree
+   // \param[in] nslots maximum number of events in the pipeline at any one time
+   //
+   // The events used for each slot are of the same class as *branch_address
+
+   if (!nslots) nslots = 1;
+   fSlots.resize(nslots);
+   for (auto& s : fSlots) {
+      s.event = (KVReconstructedEvent*)fSavedBranchEvent->IsA()->New();
+      s.state = SlotState::kFree;
+   }
+}
+
+KVReconstructionPipeline::~KVReconstructionPipeline()
+{
+   // Any events still in the pipeline are written before the worker and writer threads are stopped
+
+   if (fStarted && !fFinished) Finish();
+   fPool.reset();
+   fWorkers.clear();
+   for (auto& s : fSlots) delete s.event;
+}
+
+void KVReconstructionPipeline::AddWorker(KVMultiDetArray* array)
+{
+   // Add a reconstruction worker using the given array.
+   // Each worker must have its own array: events are decoded into the array by the reader stage
+   // and then reconstructed by the worker, while other workers treat other events.
+   // Use KVMultiDetArray::MakeWorkingCopy() to obtain arrays for additional workers.
+   //
+   // Must be called before Start().
+
+   std::unique_ptr<recon_worker> w(new recon_worker);
+   w->array = array;
+   w->recon.reset(new KVEventReconstructor(array, fSavedBranchEvent));
+   w->busy = false;
+   w->busy_time = clock_type::duration(0);
+   w->events = 0;
+   fWorkers.push_back(std::move(w));
+}
+
+void KVReconstructionPipeline::Start()
+{
+   // Start the writer thread and, if there is more than one worker, the reconstruction threads
+
+#ifdef USING_ROOT6
+   ROOT::EnableThreadSafety();
+#endif
+   if (fWorkers.size() > 1) {
+      for (auto& w : fWorkers) w->recon->SetSerializeCalibration();
+      fPool.reset(new KVThreadPool(fWorkers.size()));
+   }
+   fStartTime = clock_type::now();
+   fStarted = true;
+   fWriter = std::thread(&KVReconstructionPipeline::write_events, this);
+}
+
+KVMultiDetArray* KVReconstructionPipeline::NextArray()
+{
+   // Reader stage: call after reading each new event from the raw data file.
+   // Blocks until a slot is available in the pipeline and a worker is free.
+   //
+   // \returns the array into which the event must be decoded (KVMultiDetArray::HandleRawDataEvent)
+   // before calling Submit()
+
+   auto t0 = clock_type::now();
+   std::unique_lock<std::mutex> lock(fMutex);
+   fSlotChanged.wait(lock, [this]() {
+      if (slot(fNextToRead).state != SlotState::kFree) return false;
+      for (auto& w : fWorkers) {
+         if (!w->busy) return true;
+      }
+      return false;
+   });
+   for (auto& w : fWorkers) {
+      if (!w->busy) {
+         fCurrentWorker = w.get();
+         break;
+      }
+   }
+   fCurrentWorker->busy = true;
+   slot(fNextToRead).state = SlotState::kReserved;
+   fReaderWait += clock_type::now() - t0;
+   return fCurrentWorker->array;
+}
+
+void KVReconstructionPipeline::Submit(Long64_t event_number)
+{
+   // Reader stage: hand the event which was decoded into the array given by NextArray()
+   // to its worker for reconstruction. The reconstructed event will have the given number.
+   //
+   // Events for which the array did not handle any data (KVMultiDetArray::HandledRawData()
+   // is false) are not reconstructed and not written, but keep their place in the ordering.
+
+   recon_worker* w = fCurrentWorker;
+   event_slot* s;
+   bool handled = w->array->HandledRawData();
+   {
+      std::unique_lock<std::mutex> lock(fMutex);
+      s = &slot(fNextToRead);
+      ++fNextToRead;
+      ++fEventsRead;
+      if (!handled) {
+         s->state = SlotState::kSkip;
+         w->busy = false;
+      }
+   }
+   if (!handled) {
+      fSlotChanged.notify_all();
+      fSlotReady.notify_one();
+      return;
+   }
+   if (fPool) {
+      fPool->Submit([ = ]() {
+         reconstruct(w, *s, event_number);
+      });
+   }
+   else {
+      auto t0 = clock_type::now();
+      reconstruct(w, *s, event_number);
+      fReaderRecon += clock_type::now() - t0;
+   }
+}
+
+void KVReconstructionPipeline::reconstruct(recon_worker* w, event_slot& s, Long64_t event_number)
+{
+   // Reconstruction stage: reconstruct event in array of worker into event of slot
+
+   auto t0 = clock_type::now();
+   w->recon->SetEvent(s.event);
+   w->recon->ReconstructEvent(w->array->GetFiredDataParameters());
+   s.event->SetNumber(event_number);
+   auto dt = clock_type::now() - t0;
+   {
+      std::unique_lock<std::mutex> lock(fMutex);
+      w->busy_time += dt;
+      ++w->events;
+      w->busy = false;
+      s.state = SlotState::kReady;
+   }
+   fSlotReady.notify_one();
+   fSlotChanged.notify_all();
+}
+
+void KVReconstructionPipeline::write_events()
+{
+   // Writer stage: fill the tree with each reconstructed event in the order they were read
+
+   for (;;) {
+      event_slot* s;
+      {
+         std::unique_lock<std::mutex> lock(fMutex);
+         fSlotReady.wait(lock, [this]() {
+            SlotState st = slot(fNextToWrite).state;
+            return st == SlotState::kReady || st == SlotState::kSkip || (fFinished && fNextToWrite == fNextToRead);
+         });
+         s = &slot(fNextToWrite);
+         if (s->state != SlotState::kReady && s->state != SlotState::kSkip) return;
+      }
+      if (s->state == SlotState::kReady) {
+         auto t0 = clock_type::now();
+         if (fColumns) fColumns->Fill(s->event);
+         else {
+            *fBranchAddress = s->event;
+            fTree->Fill();
+         }
+         fWriterBusy += clock_type::now() - t0;
+         ++fEventsWritten;
+      }
+      {
+         std::unique_lock<std::mutex> lock(fMutex);
+         s->state = SlotState::kFree;
+         ++fNextToWrite;
+      }
+      fSlotChanged.notify_all();
+   }
+}
+
+void KVReconstructionPipeline::Finish()
+{
+   // Wait for all events in the pipeline to be reconstructed and written, then stop the writer thread.
+   // The pointer used for the tree branch is reset to its original value.
+
+   if (fPool) fPool->Wait();
+   {
+      std::unique_lock<std::mutex> lock(fMutex);
+      fFinished = true;
+   }
+   fSlotReady.notify_all();
+   if (fWriter.joinable()) fWriter.join();
+   *fBranchAddress = fSavedBranchEvent;
+   fWallTime = clock_type::now() - fStartTime;
+}
+
+void KVReconstructionPipeline::PrintStatistics() const
+{
+   // Print the number of events treated by each stage of the pipeline, the time spent working
+   // and the corresponding throughput. Call after Finish().
+   //
+   // A stage whose busy time is close to the total time is the bottleneck of the pipeline.
+
+   double wall = seconds(fWallTime);
+   double reader = wall - seconds(fReaderWait) - seconds(fReaderRecon);
+   ::Info("KVReconstructionPipeline::PrintStatistics", "%lld events in %.1f s (%.1f evts/s) using %u worker(s) and %u slots",
+          fEventsRead, wall, rate(fEventsRead, wall), GetNumberOfWorkers(), GetNumberOfSlots());
+   ::Info("KVReconstructionPipeline::PrintStatistics", "  read+decode : %lld events, busy %.1f s (%.1f evts/s), waited %.1f s",
+          fEventsRead, reader, rate(fEventsRead, reader), seconds(fReaderWait));
+   for (size_t i = 0; i < fWorkers.size(); ++i) {
+      double busy = seconds(fWorkers[i]->busy_time);
+      ::Info("KVReconstructionPipeline::PrintStatistics", "  reconstruct [%zu] : %lld events, busy %.1f s (%.1f evts/s)",
+             i, fWorkers[i]->events, busy, rate(fWorkers[i]->events, busy));
+   }
+   double writer = seconds(fWriterBusy);
+   ::Info("KVReconstructionPipeline::PrintStatistics", "  write : %lld events, busy %.1f s (%.1f evts/s)",
+          fEventsWritten, writer, rate(fEventsWritten, writer));
+}
+
+#endif
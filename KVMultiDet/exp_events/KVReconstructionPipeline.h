@@ -0,0 +1,134 @@
+//Created by KVClassFactory on Sat Oct 17 14:05:12 2026
+
+#ifndef __KVRECONSTRUCTIONPIPELINE_H
+#define __KVRECONSTRUCTIONPIPELINE_H
+
+#include "KVConfig.h"
+
+#ifdef WITH_CPP11
+#include "Rtypes.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class KVMultiDetArray;
+class KVEventReconstructor;
+class KVReconstructedEvent;
+class KVReconEventColumns;
+class KVThreadPool;
+class TTree;
+
+/**
+\class KVReconstructionPipeline
+\brief Bounded multi-stage pipeline for reconstruction of raw data
+\ingroup Reconstruction
+
+The reconstruction of raw data is split into three stages connected by a ring of
+event slots of fixed size:
+
+ -# the reader stage (thread calling NextArray() and Submit()) reads each event from the raw
+    data file and decodes it into the array state of a free reconstruction worker;
+ -# each reconstruction worker (one per array state added with AddWorker()) reconstructs
+    the event with its own KVEventReconstructor into the slot reserved for it;
+ -# the writer stage (a dedicated thread) fills the output TTree with the reconstructed events
+    in the order in which they were read.
+
+When the ring of slots is full the reader stage blocks until the writer has caught up, so
+that memory use is bounded by the number of slots. With a single worker, reconstruction is
+performed by the reader thread itself, and only writing the output tree is done concurrently.
+With several workers (using working copies of the array, see KVMultiDetArray::MakeWorkingCopy()),
+reconstruction is performed in parallel but calibration by only one worker at a time, as is
+identification unless EventReconstruction.ParallelIdentification is 'yes'
+(see KVEventReconstructor::SetSerializeCalibration()).
+
+If a KVReconEventColumns writer is given with SetColumnWriter(), the writer stage fills the
+tree with each event in columnar format instead.
+
+Each stage measures the time it spends working, which can be printed with PrintStatistics().
+
+This class is not available in the interpreter (no dictionary is generated for it), and requires
+C++11 or later.
+*/
+class KVReconstructionPipeline {
+
+   enum class SlotState { kFree, kReserved, kReady, kSkip };
+
+   struct event_slot {
+      KVReconstructedEvent* event;
+      SlotState state;
+   };
+   struct recon_worker {
+      KVMultiDetArray* array;
+      std::unique_ptr<KVEventReconstructor> recon;
+      bool busy;
+      std::chrono::steady_clock::duration busy_time;
+      Long64_t events;
+   };
+
+   using clock_type = std::chrono::steady_clock;
+
+   TTree* fTree;// output tree
+   KVReconstructedEvent** fBranchAddress;// address of pointer used for tree branch
+   KVReconstructedEvent* fSavedBranchEvent;// initial value of *fBranchAddress
+   KVReconEventColumns* fColumns;// writer for columnar format, if used
+
+   std::vector<event_slot> fSlots;
+   std::vector<std::unique_ptr<recon_worker> > fWorkers;
+   std::unique_ptr<KVThreadPool> fPool;
+   std::thread fWriter;
+   std::mutex fMutex;
+   std::condition_variable fSlotChanged;// signalled by workers & writer
+   std::condition_variable fSlotReady;// signalled by reader & workers
+
+   recon_worker* fCurrentWorker;// worker given by last call to NextArray()
+   Long64_t fNextToRead;// sequence number of next event handed to reader
+   Long64_t fNextToWrite;// sequence number of next event to write
+   bool fFinished;
+
+   clock_type::time_point fStartTime;
+   clock_type::duration fWallTime, fReaderWait, fReaderRecon, fWriterBusy;
+   Long64_t fEventsRead, fEventsWritten;
+   bool fStarted;
+
+   void write_events();
+   void reconstruct(recon_worker*, event_slot&, Long64_t event_number);
+   event_slot& slot(Long64_t seq)
+   {
+      return fSlots[seq % fSlots.size()];
+   }
+
+public:
+   KVReconstructionPipeline(TTree* tree, KVReconstructedEvent** branch_address, unsigned int nslots);
+   virtual ~KVReconstructionPipeline();
+
+   KVReconstructionPipeline(const KVReconstructionPipeline&) = delete;
+   KVReconstructionPipeline& operator=(const KVReconstructionPipeline&) = delete;
+
+   void AddWorker(KVMultiDetArray*);
+   void SetColumnWriter(KVReconEventColumns* c)
+   {
+      // Fill the tree using the given writer for events in columnar format. Must be called before Start().
+      fColumns = c;
+   }
+   void Start();
+
+   KVMultiDetArray* NextArray();
+   void Submit(Long64_t event_number);
+   void Finish();
+
+   unsigned int GetNumberOfWorkers() const
+   {
+      return fWorkers.size();
+   }
+   unsigned int GetNumberOfSlots() const
+   {
+      return fSlots.size();
+   }
+   void PrintStatistics() const;
+};
+
+#endif
+#endif
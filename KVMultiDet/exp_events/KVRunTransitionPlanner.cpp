@@ -0,0 +1,245 @@
+//Created by KVClassFactory on Sat Oct 17 18:05:37 2026
+
+#include "KVRunTransitionPlanner.h"
+#include "KVCalibrator.h"
+#include "KVDBParameterSet.h"
+#include "KVDetector.h"
+#include "KVIDGraph.h"
+#include "KVIDGridManager.h"
+#include "KVNamedParameter.h"
+#include "TSeqCollection.h"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+ClassImp(KVRunTransitionPlanner)
+
+KVRunTransitionPlanner::KVRunTransitionPlanner()
+   : KVBase("KVRunTransitionPlanner", "Plans changes to calibrators and grids between runs"),
+     fGridList(nullptr), fGridModifications(0), fAppliedSegment(-1), fGridsApplied(kFALSE), fNumberOfActions(3, 0)
+{
+   // Default constructor
+}
+
+Bool_t KVRunTransitionPlanner::IsEnabled(const Char_t* dataset)
+{
+   // Returns kTRUE unless incremental updates of calibrators and grids are disabled by setting the
+   // (possibly dataset-dependent) variable
+   //
+   //     KVMultiDetArray.IncrementalRunUpdates:  no
+   //
+   // in the .kvrootrc file
+
+   return GetDataSetEnv(dataset, "KVMultiDetArray.IncrementalRunUpdates", kTRUE);
+}
+
+void KVRunTransitionPlanner::get_signature(const std::vector<KVDBParameterSet*>& records, TString& structure, std::vector<Double_t>& parameters)
+{
+   // Separate the contents of the records into the numerical values of the calibration parameters,
+   // and everything else (name, type, other parameters with their values): calibrators set up from records
+   // with the same structure only differ by the values of their parameters
+
+   structure = "";
+   parameters.clear();
+   for (std::vector<KVDBParameterSet*>::const_iterator it = records.begin(); it != records.end(); ++it) {
+      KVDBParameterSet* dbps = *it;
+      structure += Form("%s|%d|", dbps->GetTitle(), dbps->GetParamNumber());
+      const KVNameValueList& pars = dbps->GetParameters();
+      for (Int_t i = 0; i < pars.GetNpar(); ++i) {
+         KVNamedParameter* par = pars.GetParameter(i);
+         structure += par->GetName();
+         if (i < dbps->GetParamNumber()) parameters.push_back(dbps->GetParameter(i));
+         else {
+            structure += "=";
+            structure += par->GetString();
+         }
+         structure += "|";
+      }
+      structure += "\n";
+   }
+}
+
+Bool_t KVRunTransitionPlanner::calibrators_unchanged(KVDetector* det, const calibrations& cals) const
+{
+   // kTRUE if the detector has exactly the calibrators which were created for it
+
+   KVList* list = det->GetListOfCalibrators();
+   Int_t n = (list ? list->GetEntries() : 0);
+   Int_t i = 0;
+   for (std::vector<KVCalibrator*>::const_iterator it = cals.calibrators.begin(); it != cals.calibrators.end(); ++it) {
+      if (!*it) continue;
+      if (i >= n || list->At(i) != *it) return kFALSE;
+      ++i;
+   }
+   return i == n;
+}
+
+KVRunTransitionPlanner::EAction KVRunTransitionPlanner::PlanCalibrations(KVDetector* det, const std::vector<KVDBParameterSet*>& records)
+{
+   // Decide what has to be done to the calibrators of the detector in order to set them up with the given
+   // database records (in the order of the links of the run):
+   //
+   //  - kKeep: the calibrators are already set up from records with the same contents
+   //  - kReparameterise: the calibrators were set up from records with the same structure:
+   //    the calibrators given by GetCalibrators() (in the same order as the records, nullptr for any record
+   //    for which no calibrator was created) just need the parameters of the new records
+   //  - kRebuild: all calibrators must be removed and created again. After doing so,
+   //    call SetCalibrators() with the new calibrators.
+   //
+   // The new records become the reference for the next run in all cases.
+
+   calibrations& cals = fCalibrations[det];
+   EAction action = kRebuild;
+   Bool_t known = !cals.records.empty() && calibrators_unchanged(det, cals);
+   if (known && records == cals.records) action = kKeep;
+   else {
+      TString structure;
+      std::vector<Double_t> parameters;
+      get_signature(records, structure, parameters);
+      if (known && structure == cals.structure) action = (parameters == cals.parameters ? kKeep : kReparameterise);
+      cals.structure = structure;
+      cals.parameters.swap(parameters);
+   }
+   cals.records = records;
+   if (action == kRebuild) cals.calibrators.assign(records.size(), nullptr);
+   ++fNumberOfActions[action];
+   return action;
+}
+
+void KVRunTransitionPlanner::SetCalibrators(KVDetector* det, const std::vector<KVCalibrator*>& cals)
+{
+   // Calibrators created for the detector for each of the records given to PlanCalibrations()
+   // (nullptr for any record for which no calibrator was created)
+
+   fCalibrations[det].calibrators = cals;
+}
+
+const std::vector<KVCalibrator*>* KVRunTransitionPlanner::GetCalibrators(KVDetector* det) const
+{
+   // Calibrators created for the detector for each of its current records (nullptr for any record for
+   // which no calibrator was created)
+
+   std::map<KVDetector*, calibrations>::const_iterator it = fCalibrations.find(det);
+   return (it == fCalibrations.end() ? nullptr : &it->second.calibrators);
+}
+
+void KVRunTransitionPlanner::ForgetCalibrations(KVDetector* det)
+{
+   // Forget the calibrations of the detector (all detectors if det = nullptr), which will be
+   // rebuilt for the next run
+
+   if (det) fCalibrations.erase(det);
+   else fCalibrations.clear();
+}
+
+Bool_t KVRunTransitionPlanner::IndexGrids(const TSeqCollection* grids)
+{
+   // Make sure the interval index corresponds to the current list of grids, and the current
+   // list of runs of each grid. Returns kTRUE if the index had to be (re)built, in which case the grids currently
+   // set in the telescopes are no longer known (see ForgetGrids()).
+   //
+   // Changes are detected with KVIDGridManager::GetModificationCount(), so that nothing
+   // has to be done for each grid if nothing changed.
+
+   if (grids == fGridList && KVIDGridManager::GetModificationCount() == fGridModifications) return kFALSE;
+   fGridList = grids;
+   fGridModifications = KVIDGridManager::GetModificationCount();
+   fGrids.clear();
+   fGrids.reserve(grids->GetEntries());
+   TIter next(grids);
+   KVIDGraph* gr;
+   while ((gr = (KVIDGraph*)next())) fGrids.push_back(gr);
+   index_grids();
+   ForgetGrids();
+   return kTRUE;
+}
+
+void KVRunTransitionPlanner::index_grids()
+{
+   // Build interval index of run ranges of grids.
+   // The run list of each grid is decomposed into intervals of consecutive runs, and the bounds of all
+   // intervals divide the run number axis into segments [fBoundaries[i],fBoundaries[i+1]), each associated
+   // with the list of grids valid for all of its runs (in the same order as in gIDGridManager)
+
+   std::vector<std::vector<std::pair<Int_t, Int_t> > > intervals(fGrids.size());
+   fBoundaries.clear();
+   for (size_t g = 0; g < fGrids.size(); ++g) {
+      IntArray runs = fGrids[g]->GetRuns().GetArray();
+      std::sort(runs.begin(), runs.end());
+      for (size_t i = 0; i < runs.size();) {
+         size_t j = i;
+         while (j + 1 < runs.size() && runs[j + 1] <= runs[j] + 1) ++j;
+         intervals[g].push_back(std::make_pair(runs[i], runs[j]));
+         fBoundaries.push_back(runs[i]);
+         fBoundaries.push_back(runs[j] + 1);
+         i = j + 1;
+      }
+   }
+   std::sort(fBoundaries.begin(), fBoundaries.end());
+   fBoundaries.erase(std::unique(fBoundaries.begin(), fBoundaries.end()), fBoundaries.end());
+   fSegmentGrids.assign(fBoundaries.empty() ? 0 : fBoundaries.size() - 1, std::vector<Int_t>());
+   for (size_t g = 0; g < fGrids.size(); ++g) {
+      for (std::vector<std::pair<Int_t, Int_t> >::const_iterator it = intervals[g].begin(); it != intervals[g].end(); ++it) {
+         size_t first = std::lower_bound(fBoundaries.begin(), fBoundaries.end(), it->first) - fBoundaries.begin();
+         size_t last = std::lower_bound(fBoundaries.begin(), fBoundaries.end(), it->second + 1) - fBoundaries.begin();
+         for (size_t s = first; s < last; ++s) fSegmentGrids[s].push_back(g);
+      }
+   }
+}
+
+Int_t KVRunTransitionPlanner::GetGridSegment(Int_t run) const
+{
+   // Index of the segment of the run number axis containing the run. All runs with the same
+   // segment have the same grids. Returns -2 if no grids are valid for the run.
+
+   std::vector<Int_t>::const_iterator it = std::upper_bound(fBoundaries.begin(), fBoundaries.end(), run);
+   if (it == fBoundaries.begin() || it == fBoundaries.end()) return -2;
+   Int_t s = (it - fBoundaries.begin()) - 1;
+   return (fSegmentGrids[s].empty() ? -2 : s);
+}
+
+void KVRunTransitionPlanner::GetGrids(Int_t run, std::vector<KVIDGraph*>& grids) const
+{
+   // Fill vector with all grids valid for run, in the same order as in gIDGridManager
+
+   grids.clear();
+   Int_t s = GetGridSegment(run);
+   if (s < 0) return;
+   for (std::vector<Int_t>::const_iterator it = fSegmentGrids[s].begin(); it != fSegmentGrids[s].end(); ++it)
+      grids.push_back(fGrids[*it]);
+}
+
+void KVRunTransitionPlanner::GetGridChanges(Int_t run, std::vector<KVIDGraph*>& changed) const
+{
+   // Fill vector with all grids which are valid either for the run or for the run of the grids
+   // currently set in the telescopes, but not both (only meaningful if HasGridsApplied() is kTRUE)
+
+   changed.clear();
+   static const std::vector<Int_t> none;
+   Int_t s_new = GetGridSegment(run);
+   const std::vector<Int_t>& new_grids = (s_new < 0 ? none : fSegmentGrids[s_new]);
+   const std::vector<Int_t>& old_grids = (fAppliedSegment < 0 ? none : fSegmentGrids[fAppliedSegment]);
+   std::vector<Int_t> diff;
+   std::set_symmetric_difference(old_grids.begin(), old_grids.end(), new_grids.begin(), new_grids.end(),
+                                 std::back_inserter(diff));
+   for (std::vector<Int_t>::const_iterator it = diff.begin(); it != diff.end(); ++it)
+      changed.push_back(fGrids[*it]);
+}
+
+void KVRunTransitionPlanner::SetGridsApplied(Int_t run)
+{
+   // Call when the grids set in the telescopes are exactly those valid for run
+
+   fAppliedSegment = GetGridSegment(run);
+   fGridsApplied = kTRUE;
+}
+
+void KVRunTransitionPlanner::Print(Option_t*) const
+{
+   // Print statistics on calibration plans and grid index
+
+   std::cout << "KVRunTransitionPlanner : calibrations of " << fCalibrations.size() << " detectors" << std::endl;
+   std::cout << "   kept: " << fNumberOfActions[kKeep] << "  reparameterised: " << fNumberOfActions[kReparameterise]
+             << "  rebuilt: " << fNumberOfActions[kRebuild] << std::endl;
+   std::cout << "   " << fGrids.size() << " grids indexed in " << fSegmentGrids.size() << " run segments" << std::endl;
+}
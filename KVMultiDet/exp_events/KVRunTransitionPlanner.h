@@ -0,0 +1,128 @@
+//Created by KVClassFactory on Sat Oct 17 18:05:37 2026
+
+#ifndef __KVRUNTRANSITIONPLANNER_H
+#define __KVRUNTRANSITIONPLANNER_H
+
+#include "KVBase.h"
+#include <map>
+#include <vector>
+
+class KVCalibrator;
+class KVDBParameterSet;
+class KVDetector;
+class KVIDGraph;
+class TSeqCollection;
+
+/**
+\class KVRunTransitionPlanner
+\brief Plans the minimal changes to calibrators and identification grids when the run changes
+\ingroup Calibration
+
+Each time the run changes, KVMultiDetArray::SetCalibratorParameters() and KVUpDater::SetIDGrids()
+used to remove all calibrators and identification grids from all detectors and telescopes, and then
+rebuild them all from the database records and grids valid for the new run, even though in most
+cases consecutive runs share almost all of their calibrations and grids. This class, which belongs to
+the array (one for each array, and each working copy of an array), keeps the state needed to find
+what really changes between two runs:
+
+ - calibrations: for each detector, the database records (KVDBParameterSet) which were used to set up
+   its calibrators, together with their structure (calibrator type & class, signals, options,
+   parameter names) and the numerical values of their parameters. PlanCalibrations() then tells
+   whether, for the new run, the calibrators can be kept as they are, only need new parameter values
+   (KVCalibrator::SetParameter()), or have to be rebuilt;
+ - grids: an interval index of the run ranges of all grids in gIDGridManager, which divides the run number axis
+   into segments in which the set of valid grids is constant. Finding the grids for a run is a binary search
+   instead of a test of the run list of every grid, two runs in the same segment have exactly
+   the same grids, and for runs in different segments only the telescopes associated with grids which
+   are valid for one run but not the other need to have their grids changed
+   (see KVMultiDetArray::UpdateGridsInTelescopes()).
+
+If the calibrators of a detector were changed by anything other than KVMultiDetArray::SetCalibratorParameters(),
+they are always rebuilt. The grid index is rebuilt whenever the list of grids in gIDGridManager,
+or the list of runs of any grid, changes (see KVIDGridManager::GetModificationCount()).
+
+Incremental updates can be switched off by setting the (possibly dataset-dependent) variable
+
+~~~~
+KVMultiDetArray.IncrementalRunUpdates:   no
+~~~~
+
+in which case all calibrators and grids are rebuilt for each run as before.
+*/
+class KVRunTransitionPlanner : public KVBase {
+
+public:
+   enum EAction {
+      kKeep,            // calibrators unchanged
+      kReparameterise,  // same calibrators, new parameter values
+      kRebuild          // calibrators must be removed and created again
+   };
+
+private:
+   struct calibrations {
+      std::vector<KVDBParameterSet*> records;// database records used to set up calibrators
+      TString structure;// everything except numerical values of parameters
+      std::vector<Double_t> parameters;// numerical values of parameters of all records
+      std::vector<KVCalibrator*> calibrators;// calibrator created for each record (nullptr if none)
+   };
+   std::map<KVDetector*, calibrations> fCalibrations;//! state of calibrations of each detector
+
+   std::vector<KVIDGraph*> fGrids;//! grids in order of list in gIDGridManager
+   const TSeqCollection* fGridList;//! list of grids which was indexed
+   UInt_t fGridModifications;//! value of KVIDGridManager::GetModificationCount() when grids were indexed
+   std::vector<Int_t> fBoundaries;//! run numbers at which set of valid grids changes
+   std::vector<std::vector<Int_t> > fSegmentGrids;//! indices of grids valid in each segment [fBoundaries[i],fBoundaries[i+1])
+   Int_t fAppliedSegment;//! segment of grids currently set in telescopes (-1 if none or unknown, -2 if none valid)
+   Bool_t fGridsApplied;//! kTRUE if grids in telescopes are known to correspond to fAppliedSegment
+
+   std::vector<Int_t> fNumberOfActions;//! number of calibration plans of each type
+
+   static void get_signature(const std::vector<KVDBParameterSet*>&, TString&, std::vector<Double_t>&);
+   Bool_t calibrators_unchanged(KVDetector*, const calibrations&) const;
+   void index_grids();
+
+public:
+   KVRunTransitionPlanner();
+   virtual ~KVRunTransitionPlanner() {}
+
+   static Bool_t IsEnabled(const Char_t* dataset);
+
+   EAction PlanCalibrations(KVDetector*, const std::vector<KVDBParameterSet*>&);
+   void SetCalibrators(KVDetector*, const std::vector<KVCalibrator*>&);
+   const std::vector<KVCalibrator*>* GetCalibrators(KVDetector*) const;
+   void ForgetCalibrations(KVDetector* = nullptr);
+
+   Bool_t IndexGrids(const TSeqCollection* grids);
+   Int_t GetGridSegment(Int_t run) const;
+   void GetGrids(Int_t run, std::vector<KVIDGraph*>& grids) const;
+   void GetGridChanges(Int_t run, std::vector<KVIDGraph*>& changed) const;
+   Bool_t HasGridsApplied() const
+   {
+      // kTRUE if the grids currently set in the telescopes are those of a known run (see SetGridsApplied())
+      return fGridsApplied;
+   }
+   Bool_t SameGrids(Int_t run) const
+   {
+      // kTRUE if the grids valid for run are exactly those currently set in the telescopes
+      return fGridsApplied && GetGridSegment(run) == fAppliedSegment;
+   }
+   void SetGridsApplied(Int_t run);
+   void ForgetGrids()
+   {
+      // Call when the grids in the telescopes are changed by any other means than
+      // KVMultiDetArray::UpdateGridsInTelescopes(): the next update will be a full one
+      fGridsApplied = kFALSE;
+      fAppliedSegment = -1;
+   }
+
+   Int_t GetNumberOfActions(EAction a) const
+   {
+      // Number of times PlanCalibrations() returned the given action
+      return fNumberOfActions[a];
+   }
+   void Print(Option_t* = "") const;
+
+   ClassDef(KVRunTransitionPlanner, 0) //Plans the minimal changes to calibrators and identification grids when the run changes
+};
+
+#endif
@@ -120,16 +120,13 @@ void KVUpDater::SetIdentificationParameters(UInt_t run)
 void KVUpDater::SetIDGrids(UInt_t run)
 {
    // Use global ID grid manager gIDGridManager to set identification grids for all
-   // ID telescopes for this run. First, any previously set grids are removed.
-   // Then all grids for current run are set in the associated ID telescopes.
+   // ID telescopes for this run. Any previously set grids are removed, and all grids
+   // for current run are set in the associated ID telescopes: see
+   // KVMultiDetArray::UpdateGridsInTelescopes(), which only changes the grids of
+   // telescopes whose grids are different for the new run.
 
    cout << "--> Setting Identification Grids" << endl;
-   TIter next_idt(fArray->GetListOfIDTelescopes());
-   KVIDTelescope* idt;
-   while ((idt = (KVIDTelescope*) next_idt())) {
-      idt->RemoveGrids();
-   }
-   fArray->SetGridsInTelescopes(run);
+   fArray->UpdateGridsInTelescopes(run);
 }
 
 //_______________________________________________________________//
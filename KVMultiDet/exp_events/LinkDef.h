@@ -21,6 +21,7 @@
 #endif
 #endif
 #pragma link C++ class KVReconEventSelector+;
+#pragma link C++ class KVReconEventColumns+;
 #pragma link C++ class KVReconNucTrajectory+;
 #pragma link C++ class KVReconstructedNucleus-;//customised streamer
 #pragma link C++ class KVDetectorEvent+;
@@ -38,5 +39,7 @@
 #pragma link C++ class KVMultiDetArray+;
 #pragma link C++ class KVASMultiDetArray+;
 #pragma link C++ class KVGeoImport+;
+#pragma link C++ class KVMultiDetArraySnapshot+;
+#pragma link C++ class KVRunTransitionPlanner+;
 #pragma link C++ class KVArrayMult+;
 #endif
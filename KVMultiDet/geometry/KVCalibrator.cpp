@@ -1,9 +1,299 @@
 #include "KVCalibrator.h"
 #include "Riostream.h"
+#include "TEnv.h"
+#include "TMath.h"
+#include <algorithm>
 using namespace std;
 
 ClassImp(KVCalibrator)
 
+Int_t KVCalibrator::fgFastPaths = -1;
+
+Bool_t KVCalibrator::IsFastPaths()
+{
+   // Returns kTRUE if fast paths are used (see class description). By default this is given by
+   //
+   //~~~~~~~~~~~~~~
+   // KVCalibrator.FastPaths:   yes
+   //~~~~~~~~~~~~~~
+
+   if (fgFastPaths < 0) fgFastPaths = gEnv->GetValue("KVCalibrator.FastPaths", kTRUE);
+   return fgFastPaths;
+}
+
+Bool_t KVCalibrator::parse_polynomial(TString formula, std::vector<Int_t>& pars)
+{
+   // Returns kTRUE if formula is a polynomial in x, in which case pars[i] is the index of
+   // the parameter multiplying x**i (-1 if there is no such term).
+   //
+   // Recognised formulas are `polN` or `polN(0)`, and any sum of terms which are products of one
+   // parameter `[i]` with any number of factors `x`, `x^n`, `x**n`, `pow(x,n)`, `TMath::Power(x,n)` or `TMath::Sq(x)`.
+   // Each parameter and each power of x may only appear once.
+
+   pars.clear();
+   formula.ReplaceAll(" ", "");
+   formula.ReplaceAll("**", "^");
+   if (formula.BeginsWith("pol")) {
+      TString deg = formula(3, formula.Length() - 3);
+      if (deg.EndsWith("(0)")) deg.Remove(deg.Length() - 3);
+      if (!deg.IsDigit()) return kFALSE;
+      for (Int_t i = 0; i <= deg.Atoi(); ++i) pars.push_back(i);
+      return kTRUE;
+   }
+   while (formula.BeginsWith("(") && formula.EndsWith(")")) {
+      // remove enclosing parentheses, if they do match each other
+      Int_t depth = 0, i = 0;
+      for (; i < formula.Length() - 1; ++i) {
+         if (formula[i] == '(') ++depth;
+         else if (formula[i] == ')') --depth;
+         if (!depth) break;
+      }
+      if (i < formula.Length() - 1) break;
+      formula = formula(1, formula.Length() - 2);
+   }
+   // split into terms & factors at zero depth of parentheses
+   std::vector<std::vector<TString> > terms(1, std::vector<TString>(1));
+   Int_t depth = 0;
+   for (Int_t i = 0; i < formula.Length(); ++i) {
+      Char_t c = formula[i];
+      if (c == '(') ++depth;
+      else if (c == ')') --depth;
+      if (!depth && c == '+') terms.push_back(std::vector<TString>(1));
+      else if (!depth && c == '*') terms.back().push_back("");
+      else terms.back().back().Append(c);
+   }
+   std::vector<Int_t> used;
+   for (std::vector<std::vector<TString> >::iterator t = terms.begin(); t != terms.end(); ++t) {
+      Int_t par = -1, power = 0;
+      for (std::vector<TString>::iterator f = t->begin(); f != t->end(); ++f) {
+         TString n;
+         if (f->BeginsWith("[") && f->EndsWith("]") && (n = (*f)(1, f->Length() - 2)).IsDigit()) {
+            if (par > -1) return kFALSE;
+            par = n.Atoi();
+         }
+         else if (*f == "x") ++power;
+         else if (*f == "TMath::Sq(x)") power += 2;
+         else if (f->BeginsWith("x^") && (n = (*f)(2, f->Length() - 2)).IsDigit()) power += n.Atoi();
+         else if (f->BeginsWith("pow(x,") && f->EndsWith(")") && (n = (*f)(6, f->Length() - 7)).IsDigit()) power += n.Atoi();
+         else if (f->BeginsWith("TMath::Power(x,") && f->EndsWith(")") && (n = (*f)(15, f->Length() - 16)).IsDigit()) power += n.Atoi();
+         else return kFALSE;
+      }
+      if (par < 0 || std::find(used.begin(), used.end(), par) != used.end()) return kFALSE;
+      used.push_back(par);
+      if (power >= (Int_t)pars.size()) pars.resize(power + 1, -1);
+      if (pars[power] > -1) return kFALSE;
+      pars[power] = par;
+   }
+   return kTRUE;
+}
+
+void KVCalibrator::set_formula(const TString& formula)
+{
+   // Called whenever the calibration function changes, with the formula used to define it (if any)
+
+   fFormula = formula;
+   if (!parse_polynomial(fFormula, fPolyPars)) fPolyPars.clear();
+   ParametersChanged();
+}
+
+Bool_t KVCalibrator::init_compiled_function() const
+{
+   // Called (before use) whenever the parameters of the calibration function change.
+   // Returns kTRUE if compiled_eval() and compiled_derivative() can be used instead of the TF1.
+   //
+   // Here we set up the coefficients of a polynomial formula, and check that we get the same values
+   // as the TF1 (otherwise the formula was not interpreted correctly and only the TF1 is used).
+   //
+   // Override in derived classes which implement their own compiled calibration function.
+
+   if (fPolyPars.empty() || !fCalibFunc) return kFALSE;
+   fPolyCoefs.assign(fPolyPars.size(), 0.);
+   for (size_t i = 0; i < fPolyPars.size(); ++i) {
+      if (fPolyPars[i] < 0) continue;
+      if (fPolyPars[i] >= fCalibFunc->GetNpar()) {
+         fPolyPars.clear();
+         return kFALSE;
+      }
+      fPolyCoefs[i] = fCalibFunc->GetParameter(fPolyPars[i]);
+   }
+   Double_t xmin, xmax;
+   fCalibFunc->GetRange(xmin, xmax);
+   Double_t test[] = {xmin, 0.5 * (xmin + xmax), xmax, xmin + 0.3 * (xmax - xmin)};
+   for (int i = 0; i < 4; ++i) {
+      Double_t a = compiled_eval(test[i]), b = fCalibFunc->Eval(test[i]);
+      if (TMath::Abs(a - b) > 1.e-9 * (TMath::Abs(a) + TMath::Abs(b)) + 1.e-300) {
+         fPolyPars.clear();
+         return kFALSE;
+      }
+   }
+   return kTRUE;
+}
+
+Double_t KVCalibrator::compiled_eval(Double_t x) const
+{
+   // Compiled version of the calibration function: Horner's rule for a polynomial formula
+
+   Double_t y = 0;
+   for (Int_t k = fPolyCoefs.size() - 1; k >= 0; --k) y = y * x + fPolyCoefs[k];
+   return y;
+}
+
+Double_t KVCalibrator::compiled_derivative(Double_t x) const
+{
+   // Derivative of compiled version of the calibration function: Horner's rule for a polynomial formula
+
+   Double_t d = 0;
+   for (Int_t k = fPolyCoefs.size() - 1; k > 0; --k) d = d * x + k * fPolyCoefs[k];
+   return d;
+}
+
+const KVCalibrator::brackets& KVCalibrator::get_brackets(Long64_t context) const
+{
+   // Values of the calibration function at regularly-spaced points in its range, for the given context
+   // (see inversion_context()). They are calculated the first time they are needed for each set of parameters.
+
+   std::map<Long64_t, brackets>::iterator it = fBrackets.find(context);
+   if (it != fBrackets.end()) return it->second;
+   brackets& b = fBrackets[context];
+   const Int_t npoints = 33;
+   Double_t xmin, xmax;
+   fCalibFunc->GetRange(xmin, xmax);
+   b.x.resize(npoints);
+   b.f.resize(npoints);
+   for (Int_t i = 0; i < npoints; ++i) {
+      b.x[i] = xmin + i * (xmax - xmin) / (npoints - 1);
+      b.f[i] = eval(b.x[i]);
+   }
+   b.monotonic = (xmax > xmin);
+   Bool_t increasing = (b.f[1] > b.f[0]);
+   for (Int_t i = 1; b.monotonic && i < npoints; ++i) {
+      b.monotonic = (increasing ? b.f[i] > b.f[i - 1] : b.f[i] < b.f[i - 1]);
+   }
+   if (b.monotonic && fCompiled) b.monotonic = derivative_keeps_sign(b.x, increasing);
+   if (b.monotonic && !increasing) {
+      // store in order of increasing values of the function
+      std::reverse(b.x.begin(), b.x.end());
+      std::reverse(b.f.begin(), b.f.end());
+   }
+   return b;
+}
+
+Bool_t KVCalibrator::derivative_keeps_sign(const std::vector<Double_t>& x, Bool_t increasing) const
+{
+   // Called for compiled functions whose values at the points x are strictly increasing or decreasing:
+   // check that the derivative does not change sign anywhere in the range, so that the function really is monotonic.
+   //
+   // For polynomial formulas this is exact: on each interval [x[i-1],x[i]] the derivative is written in the
+   // Bernstein basis, and cannot vanish if all of its coefficients have the required sign (the test is
+   // conservative, i.e. it may reject some monotonic polynomials, which are then inverted with ProtectedGetX()).
+   // For other compiled functions, only the sign of the derivative at each point x[i] can be checked.
+
+   Double_t sign = (increasing ? 1. : -1.);
+   if (fPolyPars.empty()) {
+      for (size_t i = 0; i < x.size(); ++i) {
+         if (!(sign * compiled_derivative(x[i]) > 0)) return kFALSE;
+      }
+      return kTRUE;
+   }
+   Int_t m = (Int_t)fPolyCoefs.size() - 2; // degree of derivative
+   if (m < 0) return kFALSE;
+   std::vector<Double_t> d(m + 1), e;
+   for (Int_t k = 0; k <= m; ++k) d[k] = (k + 1) * fPolyCoefs[k + 1];
+   for (size_t i = 1; i < x.size(); ++i) {
+      // coefficients e[k] of derivative d(a+h*t) as polynomial in t, for t in [0,1]
+      Double_t a = x[i - 1], h = x[i] - x[i - 1];
+      e = d;
+      for (Int_t j = 0; j < m; ++j) {
+         for (Int_t k = m - 1; k >= j; --k) e[k] += a * e[k + 1];
+      }
+      Double_t hk = 1;
+      for (Int_t k = 0; k <= m; ++k) {
+         e[k] *= hk;
+         hk *= h;
+      }
+      // Bernstein coefficients: sum over k<=j of e[k]*C(j,k)/C(m,k)
+      for (Int_t j = 0; j <= m; ++j) {
+         Double_t bj = 0, r = 1;
+         for (Int_t k = 0; k <= j; ++k) {
+            bj += r * e[k];
+            if (k < m) r *= Double_t(j - k) / (m - k);
+         }
+         if (!(sign * bj > 0)) return kFALSE;
+      }
+   }
+   return kTRUE;
+}
+
+Double_t KVCalibrator::fast_inversion(Double_t y, const brackets& b) const
+{
+   // Invert monotonic calibration function using the brackets:
+   //
+   //  - if y is outside the range of values of the function, InversionFailure() returns kTRUE and the
+   //    value of x corresponding to the nearest limit is returned, as with ProtectedGetX()
+   //  - polynomials of degree 1 are inverted directly
+   //  - otherwise we find the two successive values of the function between which y lies, and use Newton's method
+   //    (falling back to bisection if necessary) or, if the derivative of the function is not known, the Illinois method.
+
+   fInversionFail = kFALSE;
+   if (y < b.f.front()) {
+      fInversionFail = kTRUE;
+      return b.x.front();
+   }
+   if (y > b.f.back()) {
+      fInversionFail = kTRUE;
+      return b.x.back();
+   }
+   if (fCompiled && fPolyCoefs.size() == 2) return (y - fPolyCoefs[0]) / fPolyCoefs[1];
+
+   size_t k = std::lower_bound(b.f.begin(), b.f.end(), y) - b.f.begin();
+   if (b.f[k] == y) return b.x[k];
+   // here b.f[k-1] < y < b.f[k]
+   Double_t lo = b.x[k - 1], hi = b.x[k], flo = b.f[k - 1] - y, fhi = b.f[k] - y;
+   const Double_t tolerance = 1.e-10;
+   const Int_t max_iterations = 100;
+
+   if (fCompiled) {
+      // Newton's method: we keep lo & hi such that f(lo)<y<f(hi) (x values may be in either order)
+      Double_t x = lo - flo * (hi - lo) / (fhi - flo);
+      for (Int_t i = 0; i < max_iterations; ++i) {
+         Double_t fx = eval(x) - y;
+         if (fx == 0) return x;
+         if (fx < 0) lo = x;
+         else hi = x;
+         Double_t d = compiled_derivative(x);
+         Double_t xn = (d != 0 ? x - fx / d : lo);
+         if (!((xn - lo) * (xn - hi) < 0)) xn = 0.5 * (lo + hi);  // outside bracket (or NaN): bisection
+         if (TMath::Abs(xn - x) <= tolerance * TMath::Max(1., TMath::Abs(xn))) return xn;
+         x = xn;
+      }
+      return x;
+   }
+
+   // Illinois method
+   Double_t x = lo, x_prev;
+   Int_t side = 0;
+   for (Int_t i = 0; i < max_iterations; ++i) {
+      x_prev = x;
+      x = (lo * fhi - hi * flo) / (fhi - flo);
+      if (i && TMath::Abs(x - x_prev) <= tolerance * TMath::Max(1., TMath::Abs(x))) break;
+      Double_t fx = eval(x) - y;
+      if (fx == 0) break;
+      if (fx < 0) {
+         lo = x;
+         flo = fx;
+         if (side == -1) fhi *= 0.5;
+         side = -1;
+      }
+      else {
+         hi = x;
+         fhi = fx;
+         if (side == 1) flo *= 0.5;
+         side = 1;
+      }
+   }
+   return x;
+}
+
 void KVCalibrator::adjust_range_of_inverse_calibration()
 {
    // For an inverse calibration, the limits [min,max] given in the options concern the Y-values,
@@ -168,6 +458,26 @@ KVCalibrator* KVCalibrator::MakeCalibrator(const Char_t* type)
    return c;
 }
 
+void KVCalibrator::ComputeBatch(Int_t n, KVCalibrator* const* cals, const Double_t* x, Double_t* y, const KVNameValueList& par)
+{
+   // Compute calibrated values y[i] for inputs x[i] with calibrators cals[i], i=0,...,n-1.
+   //
+   // This is equivalent to calling Compute() for each calibrator, but the list of extra parameters is only
+   // built once, and the compiled polynomial functions of base KVCalibrator objects are evaluated directly.
+   // For inverted calibrations, the failure of inversion is signalled by setting y[i] to NaN.
+
+   Bool_t fast = IsFastPaths();
+   for (Int_t i = 0; i < n; ++i) {
+      KVCalibrator* cal = cals[i];
+      if (fast && cal->IsA() == KVCalibrator::Class() && !cal->fUseInverseFunction && cal->init_fast_paths())
+         y[i] = cal->KVCalibrator::compiled_eval(x[i]);
+      else {
+         y[i] = cal->Compute(x[i], par);
+         if (cal->fUseInverseFunction && cal->InversionFailure()) y[i] = TMath::QuietNaN();
+      }
+   }
+}
+
 void KVCalibrator::SetOptions(const KVNameValueList& opt)
 {
    // Used to set up a function calibrator from infos in a calibration parameter file.
@@ -209,6 +519,7 @@ void KVCalibrator::SetOptions(const KVNameValueList& opt)
    }
    else
       fCalibFunc = new TF1("KVCalibrator::fCalibFunc", opt.GetStringValue("func"), opt.GetDoubleValue("min"), opt.GetDoubleValue("max"));
+   set_formula(opt.GetStringValue("func"));
 }
 
 //TGraph* KVCalibrator::MakeGraph(Double_t xmin, Double_t xmax,
@@ -5,6 +5,8 @@
 #include "TRef.h"
 #include "KVDetector.h"
 #include "TF1.h"
+#include <map>
+#include <vector>
 
 /**
   \class KVCalibrator
@@ -69,6 +71,31 @@
   Det_A14_SomeCalibration
   ~~~~~~~~~~~~~
 
+  ### Fast paths
+  Evaluating the TF1 of the calibration, and above all inverting it with TF1::GetX() (see ProtectedGetX()),
+  for every signal of every detector in every event is expensive. Therefore:
+
+  - if the formula is recognised as a polynomial (`pol1`, `pol2`, ..., or any sum of terms such as `[0]+[1]*x+[2]*x*x`,
+    `[i]*pow(x,n)`, `[i]*x^n`, `[i]*TMath::Sq(x)`), it is evaluated directly using Horner's rule.
+    Derived classes can provide their own compiled version of the calibration function and its derivative (see e.g. KVLightEnergyCsI);
+  - inversion of the function uses a table of its values at regularly-spaced points in its range, which is calculated
+    once (for each set of parameters) and gives a bracket containing the solution, followed by
+    Newton's method (if the derivative is known) or the Illinois method. Polynomials of degree 1 are inverted directly.
+    This is only done for functions which are monotonic in their range, in which case the solution is the same as with
+    ProtectedGetX(), including if the value lies outside the range of the function (InversionFailure() returns kTRUE).
+    Monotonicity is proved for polynomials, but for other functions it is only checked at the tabulated points
+    (values of the function, and of its derivative if known): a function which is not monotonic between two of these
+    points may then be inverted to a different solution than with ProtectedGetX();
+  - ComputeBatch() computes the calibrated values for many calibrators (e.g. all detectors of an array)
+    in a single call.
+
+  The generic TF1 methods are used for any other case. Fast paths can be disabled by setting
+
+  ~~~~~~~~~~~~~
+  KVCalibrator.FastPaths:   no
+  ~~~~~~~~~~~~~
+
+  in your `.kvrootrc` file, or by calling SetFastPaths(kFALSE).
  */
 
 class KVCalibrator: public KVBase {
@@ -83,17 +110,72 @@ class KVCalibrator: public KVBase {
    Double_t    fInputMax;           // required maximum input signal for inverse calibration
    mutable Bool_t fInversionFail;   // problem inverting calibration function
 
+   struct brackets {
+      std::vector<Double_t> x, f;// values of function f(x) at regularly-spaced points in its range
+      Bool_t monotonic;// kTRUE if values f are strictly increasing or decreasing
+   };
+   TString     fFormula;                     //! formula used to define calibration function, if any
+   mutable std::vector<Int_t> fPolyPars;     //! index of parameter multiplying each power of x, if formula is a polynomial
+   mutable std::vector<Double_t> fPolyCoefs; //! coefficients of each power of x, if formula is a polynomial
+   mutable UInt_t fParVersion;               //! incremented whenever parameters or range of function change
+   mutable UInt_t fFastVersion;              //! value of fParVersion when fast paths were last initialised
+   mutable Bool_t fCompiled;                 //! kTRUE if compiled_eval() & compiled_derivative() can be used
+   mutable std::map<Long64_t, brackets> fBrackets;//! brackets for inversion of function in each context
+   static Int_t fgFastPaths;// 1 if fast paths are used, 0 if not, -1 if not yet known
+
+   static Bool_t parse_polynomial(TString formula, std::vector<Int_t>& pars);
+   void set_formula(const TString&);
+   Bool_t init_fast_paths() const
+   {
+      // (Re)initialise fast paths if parameters have changed. Returns kTRUE if compiled function can be used
+      if (fFastVersion != fParVersion) {
+         fBrackets.clear();
+         fCompiled = init_compiled_function();
+         fFastVersion = fParVersion;
+      }
+      return fCompiled;
+   }
+   const brackets& get_brackets(Long64_t context) const;
+   Bool_t derivative_keeps_sign(const std::vector<Double_t>& x, Bool_t increasing) const;
+   Double_t fast_inversion(Double_t y, const brackets&) const;
+
 protected:
    void SetCalibFunction(TF1* f)
    {
       // Set function for calibration. Delete any previous function.
       SafeDelete(fCalibFunc);
       fCalibFunc = f;
+      set_formula("");
    }
    TF1* GetCalibFunction() const
    {
       return fCalibFunc;
    }
+   void ParametersChanged() const
+   {
+      // Call after changing the parameters or the range of the calibration function by any other means
+      // than SetParameter() or SetStatus(): cached values used by fast paths are recalculated
+      ++fParVersion;
+   }
+   virtual Bool_t init_compiled_function() const;
+   virtual Double_t compiled_eval(Double_t x) const;
+   virtual Double_t compiled_derivative(Double_t x) const;
+   virtual Long64_t inversion_context() const
+   {
+      // Brackets used to invert the calibration function are calculated once for each set of parameters and
+      // for each value returned by this method, which should identify any quantities other than the parameters on which
+      // the function depends (see KVLightEnergyCsI). Returning -1 disables the fast inversion.
+      //
+      // By default the fast inversion is used if the function is compiled, or is defined by a formula
+      // (in which case it depends only on its parameters).
+      return (fCompiled || fFormula != "" ? 0 : -1);
+   }
+   Double_t eval(Double_t x) const
+   {
+      // Value of calibration function for x, using compiled version if possible
+      if (IsFastPaths() && init_fast_paths()) return compiled_eval(x);
+      return fCalibFunc->Eval(x);
+   }
    Double_t do_inversion(Double_t x) const
    {
       // Invert calibration function to find input value corresponding to output value x.
@@ -101,6 +183,14 @@ protected:
       // In case of problems with the inversion (x not included in the range of values of the
       // function) InversionFail() will return kTRUE.
 
+      if (IsFastPaths()) {
+         init_fast_paths();
+         Long64_t context = inversion_context();
+         if (context > -1) {
+            const brackets& b = get_brackets(context);
+            if (b.monotonic) return fast_inversion(x, b);
+         }
+      }
       int status;
       Double_t res = ProtectedGetX(fCalibFunc, x, status); // fCalibFunc->GetX(x);
       fInversionFail = (status != 0);
@@ -114,11 +204,14 @@ protected:
    void adjust_range_of_inverse_calibration();
 public:
    KVCalibrator()
-      : KVBase("Calibrator", "KVCalibrator"), fDetector(nullptr), fCalibFunc(nullptr), fReady(kFALSE), fUseInverseFunction(kFALSE), fInputMin(99), fInputMax(-1), fInversionFail(kFALSE) {}
+      : KVBase("Calibrator", "KVCalibrator"), fDetector(nullptr), fCalibFunc(nullptr), fReady(kFALSE), fUseInverseFunction(kFALSE), fInputMin(99), fInputMax(-1), fInversionFail(kFALSE),
+        fParVersion(1), fFastVersion(0), fCompiled(kFALSE) {}
    KVCalibrator(const TString& formula, const TString& type)
-      : KVBase("Calibrator", type), fDetector(nullptr), fCalibFunc(new TF1("KVCalibrator::fCalibFunc", formula)), fReady(kFALSE), fUseInverseFunction(kFALSE), fInputMin(99), fInputMax(-1), fInversionFail(kFALSE)
+      : KVBase("Calibrator", type), fDetector(nullptr), fCalibFunc(new TF1("KVCalibrator::fCalibFunc", formula)), fReady(kFALSE), fUseInverseFunction(kFALSE), fInputMin(99), fInputMax(-1), fInversionFail(kFALSE),
+        fParVersion(1), fFastVersion(0), fCompiled(kFALSE)
    {
       // Set up calibrator using mathematical formula
+      set_formula(formula);
    }
    virtual ~KVCalibrator()
    {
@@ -132,7 +225,10 @@ public:
    }
    void SetParameter(int i, Double_t par_val) const
    {
-      if (fCalibFunc) fCalibFunc->SetParameter(i, par_val);
+      if (fCalibFunc) {
+         fCalibFunc->SetParameter(i, par_val);
+         ParametersChanged();
+      }
    }
    Double_t GetParameter(int i) const
    {
@@ -144,6 +240,7 @@ public:
       if (ready)
          if (IsUseInverseFunction())
             adjust_range_of_inverse_calibration();
+      ParametersChanged();
    }
    Bool_t GetStatus() const
    {
@@ -161,13 +258,13 @@ public:
    {
       // Compute calibrated value from input x
 
-      return (fUseInverseFunction ? do_inversion(x) : fCalibFunc->Eval(x));
+      return (fUseInverseFunction ? do_inversion(x) : eval(x));
    }
    virtual Double_t Invert(Double_t x, const KVNameValueList&) const
    {
       // Compute value of input for given output value (inverted calibration)
 
-      return (!fUseInverseFunction ? do_inversion(x) : fCalibFunc->Eval(x));
+      return (!fUseInverseFunction ? do_inversion(x) : eval(x));
    }
    Double_t operator()(Double_t x, const KVNameValueList& par = "")
    {
@@ -177,6 +274,20 @@ public:
    //virtual TGraph* MakeGraph(Double_t xmin, Double_t xmax, Int_t npoints = 50) const;
 
    static KVCalibrator* MakeCalibrator(const Char_t* type);
+   static void ComputeBatch(Int_t n, KVCalibrator* const* cals, const Double_t* x, Double_t* y,
+                            const KVNameValueList& par = "");
+
+   static Bool_t IsFastPaths();
+   static void SetFastPaths(Bool_t on = kTRUE)
+   {
+      // Enable or disable fast paths for all calibrators (see class description)
+      fgFastPaths = on;
+   }
+   Bool_t HasCompiledFunction() const
+   {
+      // kTRUE if a compiled version of the calibration function is used instead of the TF1 (see class description)
+      return IsFastPaths() && fCalibFunc && init_fast_paths();
+   }
 
    virtual void SetOptions(const KVNameValueList&);
    void SetInputSignalType(const TString& type)
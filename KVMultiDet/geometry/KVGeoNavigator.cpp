@@ -267,11 +267,24 @@ void KVGeoNavigator::PropagateEvent(KVEvent* TheEvent, TVector3* TheOrigin)
    // By default, propagates particles from (0,0,0) (world coordinates),
    // unless a different origin is given.
 
-   ResetTrackID();
+   std::vector<KVNucleus*> particles;
+   particles.reserve(TheEvent->GetMult());
    KVNucleus* part;
-   while ((part = TheEvent->GetNextParticle())) {
-      PropagateParticle(part, TheOrigin);
-   }
+   while ((part = TheEvent->GetNextParticle())) particles.push_back(part);
+   PropagateParticles(particles, TheOrigin);
+}
+
+void KVGeoNavigator::PropagateParticles(std::vector<KVNucleus*>& particles, TVector3* TheOrigin)
+{
+   // Propagate a set of particles through the geometry.
+   //
+   // By default, propagates particles from (0,0,0) (world coordinates),
+   // unless a different origin is given.
+   //
+   // Default implementation calls PropagateParticle() for each particle in turn.
+
+   ResetTrackID();
+   for (auto part : particles) PropagateParticle(part, TheOrigin);
 }
 
 void KVGeoNavigator::ParticleEntersNewVolume(KVNucleus*)
@@ -10,6 +10,7 @@
 #include "KVDetector.h"
 #include <KVNameValueList.h>
 #include <TGeoMatrix.h>
+#include <vector>
 class KVNucleus;
 class KVEvent;
 class TGeoManager;
@@ -152,6 +153,7 @@ public:
    Bool_t GetNameCorrespondance(const Char_t*, TString&);
 
    void PropagateEvent(KVEvent*, TVector3* TheOrigin = 0);
+   virtual void PropagateParticles(std::vector<KVNucleus*>&, TVector3* TheOrigin = 0);
    virtual void PropagateParticle(KVNucleus*, TVector3* TheOrigin = 0);
    virtual void ParticleEntersNewVolume(KVNucleus*);
 
@@ -1,10 +1,13 @@
 #include "KVRangeTableGeoNavigator.h"
 #include <TGeoMaterial.h>
+#include <TMath.h>
 #include <TGeoManager.h>
 #include <TGeoVolume.h>
 #include <TGeoNode.h>
 #include "KVNucleus.h"
 #include <KVIonRangeTableMaterial.h>
+#include <algorithm>
+#include <map>
 
 ClassImp(KVRangeTableGeoNavigator)
 
@@ -30,6 +33,16 @@ void KVRangeTableGeoNavigator::ParticleEntersNewVolume(KVNucleus* part)
    //
    // The (cumulated) energy losses in the active layers of all hit detectors
    // are updated with the energy lost by this particle
+   //
+   // When propagating several particles together (see PropagateParticles()), this method
+   // only records the volumes crossed by the particle.
+
+   if (fRecordSegments) {
+      TGeoMaterial* material = GetCurrentVolume()->GetMaterial();
+      KVIonRangeTableMaterial* irmat = fRangeTable->GetMaterial(material);
+      if (irmat) fSegments.push_back(Segment(irmat, material, GetStepSize(), GetCurrentPath(), GetCurrentNode()));
+      return;
+   }
 
    Double_t de = 0;
    Double_t e = part->GetEnergy();
@@ -47,6 +60,7 @@ void KVRangeTableGeoNavigator::ParticleEntersNewVolume(KVNucleus* part)
    TGeoMaterial* material = GetCurrentVolume()->GetMaterial();
    KVIonRangeTableMaterial* irmat = 0;
    if ((irmat = fRangeTable->GetMaterial(material))) {
+      Double_t e_incident = e;
       de = irmat->GetLinearDeltaEOfIon(
               part->GetZ(), part->GetA(), e, GetStepSize(), 0.,
               material->GetTemperature(),
@@ -62,38 +76,17 @@ void KVRangeTableGeoNavigator::ParticleEntersNewVolume(KVNucleus* part)
       //initial energy
       if (!part->GetPInitial()) part->SetE0();
 
-      TString absorber_name;
-      KVDetector* theDet = GetDetectorFromPath(GetCurrentPath());
-      Bool_t active_layer = kFALSE;
-      if (theDet) {
-         if (!theDet->IsSingleLayer()) {
-            absorber_name.Form("%s/%s", theDet->GetName(), GetCurrentNode()->GetName());
-            if (strncmp(GetCurrentNode()->GetName(), "ACTIVE", 6) == 0) active_layer = kTRUE;
-         }
-         else {
-            absorber_name = theDet->GetName();
-            active_layer = kTRUE;
-         }
-      }
-      else
-         absorber_name = irmat->GetName();
-
-      if (part->GetZ()) {
-         part->GetParameters()->SetValue(Form("DE:%s", absorber_name.Data()), de);
-         if (active_layer) {
-            // update energy loss in active layer of detector
-            Double_t E = theDet->GetEnergyLoss() + de;
-            theDet->SetEnergyLoss(E);
-            //theDet->AddHit(part);//don't put a reference to simulated particle in detector
-         }
-      }
+      AddEnergyLossInAbsorber(part, irmat, GetCurrentPath(), GetCurrentNode(), de);
       //part->GetParameters()->SetValue(Form("Xin:%s", absorber_name.Data()), GetEntryPoint().X());
       //part->GetParameters()->SetValue(Form("Yin:%s", absorber_name.Data()), GetEntryPoint().Y());
       //part->GetParameters()->SetValue(Form("Zin:%s", absorber_name.Data()), GetEntryPoint().Z());
       if (StopPropagation()) {
          // If particle stops in this volume, we use as 'exit point' the point corresponding to
          // the calculated range of the particle
-         Double_t r = irmat->GetRangeOfLastDE() / irmat->GetDensity();
+         // (range is recalculated here rather than using KVIonRangeTableMaterial::GetRangeOfLastDE(),
+         // which is not set by the reentrant energy loss calculations)
+         Double_t r = TMath::Min(irmat->GetLinearRangeOfIon(part->GetZ(), part->GetA(), e_incident, 0.,
+                                 material->GetTemperature(), material->GetPressure()), GetStepSize());
          TVector3 path = GetExitPoint() - GetEntryPoint();
          TVector3 midVol = GetEntryPoint() + (r / path.Mag()) * path;
          //part->GetParameters()->SetValue(Form("Xout:%s", absorber_name.Data()), midVol.X());
@@ -117,6 +110,147 @@ void KVRangeTableGeoNavigator::ParticleEntersNewVolume(KVNucleus* part)
    }
 }
 
+void KVRangeTableGeoNavigator::AddEnergyLossInAbsorber(KVNucleus* part, KVIonRangeTableMaterial* irmat, const TString& path,
+      TGeoNode* node, Double_t de)
+{
+   // Store energy loss de of particle in the absorber corresponding to the given path & node
+   // as a parameter "DE:[absorber name]" of the particle, and add it to the energy loss of the
+   // detector if the absorber is its active layer.
+
+   TString absorber_name;
+   KVDetector* theDet = GetDetectorFromPath(path);
+   Bool_t active_layer = kFALSE;
+   if (theDet) {
+      if (!theDet->IsSingleLayer()) {
+         absorber_name.Form("%s/%s", theDet->GetName(), node->GetName());
+         if (strncmp(node->GetName(), "ACTIVE", 6) == 0) active_layer = kTRUE;
+      }
+      else {
+         absorber_name = theDet->GetName();
+         active_layer = kTRUE;
+      }
+   }
+   else
+      absorber_name = irmat->GetName();
+
+   if (part->GetZ()) {
+      part->GetParameters()->SetValue(Form("DE:%s", absorber_name.Data()), de);
+      if (active_layer) {
+         // update energy loss in active layer of detector
+         Double_t E = theDet->GetEnergyLoss() + de;
+         theDet->SetEnergyLoss(E);
+         //theDet->AddHit(part);//don't put a reference to simulated particle in detector
+      }
+   }
+}
+
+void KVRangeTableGeoNavigator::PropagateParticles(std::vector<KVNucleus*>& particles, TVector3* TheOrigin)
+{
+   // Propagate a set of particles through the geometry, calculating energy losses of all
+   // particles in each successive volume with a single call to
+   // KVIonRangeTableMaterial::GetLinearEResOfIons() for each material.
+   //
+   // As trajectories are straight lines, the volumes crossed by each particle are first found
+   // (see KVGeoNavigator::PropagateParticle()). Then the energy losses of all particles in the
+   // first volume they cross are calculated, then in the second volume, and so on, until all
+   // particles have either stopped or left the geometry. Results are the same as
+   // for calling PropagateParticle() for each particle.
+   //
+   // If tracking is activated (SetTracking()), particles are propagated one by one.
+
+   if (IsTracking()) {
+      KVGeoNavigator::PropagateParticles(particles, TheOrigin);
+      return;
+   }
+   ResetTrackID();
+
+   Int_t npart = particles.size();
+   std::vector<std::vector<Segment> > segments(npart);
+   std::vector<TString> deadzone(npart);
+   std::vector<Double_t> energy(npart);
+   std::vector<Int_t> nsteps(npart, 0);// number of volumes crossed by each particle
+   std::vector<Bool_t> alive(npart);
+
+   // find volumes crossed by each particle
+   fRecordSegments = kTRUE;
+   size_t max_segments = 0;
+   for (int i = 0; i < npart; ++i) {
+      KVNucleus* part = particles[i];
+      fSegments.clear();
+      KVGeoNavigator::PropagateParticle(part, TheOrigin);
+      segments[i].swap(fSegments);
+      max_segments = std::max(max_segments, segments[i].size());
+      // if particle stops before dead zone, it should not be flagged
+      if (part->GetParameters()->HasParameter("DEADZONE")) {
+         deadzone[i] = part->GetParameters()->GetStringValue("DEADZONE");
+         part->GetParameters()->RemoveParameter("DEADZONE");
+      }
+      energy[i] = part->GetEnergy();
+      alive[i] = (energy[i] > fCutOffEnergy);
+   }
+   fRecordSegments = kFALSE;
+
+   // calculate energy losses in each successive volume
+   std::map<TGeoMaterial*, std::vector<Int_t> > batches;
+   std::vector<Int_t> Z, A;
+   std::vector<Double_t> E, D, Eres;
+   for (size_t step = 0; step < max_segments; ++step) {
+      batches.clear();
+      for (int i = 0; i < npart; ++i) {
+         if (alive[i] && step < segments[i].size()) batches[segments[i][step].fGeoMaterial].push_back(i);
+      }
+      if (batches.empty()) break;
+      for (auto& batch : batches) {
+         TGeoMaterial* material = batch.first;
+         std::vector<Int_t>& index = batch.second;
+         Int_t n = index.size();
+         Z.resize(n);
+         A.resize(n);
+         E.resize(n);
+         D.resize(n);
+         Eres.resize(n);
+         for (int j = 0; j < n; ++j) {
+            KVNucleus* part = particles[index[j]];
+            Z[j] = part->GetZ();
+            A[j] = part->GetA();
+            E[j] = energy[index[j]];
+            D[j] = segments[index[j]][step].fStep;
+         }
+         segments[index[0]][step].fMaterial->GetLinearEResOfIons(n, Z.data(), A.data(), E.data(), D.data(), Eres.data(),
+               nullptr, material->GetTemperature(), material->GetPressure());
+         for (int j = 0; j < n; ++j) {
+            Int_t i = index[j];
+            KVNucleus* part = particles[i];
+            if (!nsteps[i]) {
+               //set flag to say that particle has been slowed down
+               part->SetIsDetected();
+               //If this is the first absorber that the particle crosses, we set a "reminder" of its
+               //initial energy
+               if (!part->GetPInitial()) part->SetE0();
+            }
+            segments[i][step].fStep = E[j] - Eres[j]; // store energy loss in place of step
+            energy[i] = Eres[j];
+            if (energy[i] <= fCutOffEnergy) {
+               energy[i] = 0.;
+               alive[i] = kFALSE;
+            }
+            ++nsteps[i];
+         }
+      }
+   }
+
+   // store energy losses of particles in absorbers & detectors
+   for (int i = 0; i < npart; ++i) {
+      KVNucleus* part = particles[i];
+      for (int step = 0; step < nsteps[i]; ++step) {
+         Segment& seg = segments[i][step];
+         AddEnergyLossInAbsorber(part, seg.fMaterial, seg.fPath, seg.fNode, seg.fStep);
+      }
+      if (nsteps[i]) part->SetEnergy(energy[i]);
+      if (alive[i] && deadzone[i] != "") part->GetParameters()->SetValue("DEADZONE", deadzone[i].Data());
+   }
+}
+
 void KVRangeTableGeoNavigator::InitialiseTrack(KVNucleus* part, TVector3* TheOrigin)
 {
    // Start a new track to visualise trajectory of nucleus through the array
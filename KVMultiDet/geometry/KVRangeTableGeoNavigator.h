@@ -4,6 +4,9 @@
 #include "TVirtualGeoTrack.h"
 #include "KVGeoNavigator.h"
 #include "KVIonRangeTable.h"
+class KVIonRangeTableMaterial;
+class TGeoMaterial;
+class TGeoNode;
 
 /**
  \class KVRangeTableGeoNavigator
@@ -58,6 +61,22 @@ class KVRangeTableGeoNavigator : public KVGeoNavigator {
    TVirtualGeoTrack* fCurrentTrack;//! current track of nucleus being propagated
    Double_t fTrackTime;//! track "clock"
 
+   // volume of known material crossed by a particle
+   struct Segment {
+      KVIonRangeTableMaterial* fMaterial;
+      TGeoMaterial* fGeoMaterial;
+      Double_t fStep;
+      TString fPath;
+      TGeoNode* fNode;
+      Segment() : fMaterial(nullptr), fGeoMaterial(nullptr), fStep(0), fNode(nullptr) {}
+      Segment(KVIonRangeTableMaterial* m, TGeoMaterial* g, Double_t s, const TString& p, TGeoNode* n)
+         : fMaterial(m), fGeoMaterial(g), fStep(s), fPath(p), fNode(n) {}
+   };
+   Bool_t fRecordSegments;//! set when only recording the volumes crossed by particles
+   std::vector<Segment> fSegments;//! volumes crossed by current particle
+
+   void AddEnergyLossInAbsorber(KVNucleus* part, KVIonRangeTableMaterial* irmat, const TString& path, TGeoNode* node, Double_t de);
+
    void InitialiseTrack(KVNucleus* part, TVector3* TheOrigin);
    void AddPointToCurrentTrack(Double_t x, Double_t y, Double_t z)
    {
@@ -69,7 +88,7 @@ class KVRangeTableGeoNavigator : public KVGeoNavigator {
 public:
    KVRangeTableGeoNavigator(TGeoManager* g, KVIonRangeTable* r)
       : KVGeoNavigator(g), fRangeTable(r), fCutOffEnergy(1.e-3), fCurrentTrack(nullptr),
-        fTrackTime(0.)
+        fTrackTime(0.), fRecordSegments(kFALSE)
    {}
    virtual ~KVRangeTableGeoNavigator() {}
    void SetCutOffKEForPropagation(Double_t e)
@@ -83,6 +102,7 @@ public:
 
    virtual void ParticleEntersNewVolume(KVNucleus*);
    virtual void PropagateParticle(KVNucleus*, TVector3* TheOrigin = 0);
+   virtual void PropagateParticles(std::vector<KVNucleus*>&, TVector3* TheOrigin = 0);
 
    Bool_t CheckIonForRangeTable(Int_t Z, Int_t A)
    {
@@ -49,21 +49,6 @@ Bool_t KVIDGCsI::IsIdentifiable(Double_t x, Double_t y, TString* reject) const
 
 //_______________________________________________________________________________________________//
 
-// small utility class which adds the IMF line to the identifier list when constructed,
-// and removes it when it goes out of scope i.e. whenever the program leaves the Identify method
-struct add_remove_imf_line {
-   KVList* idlines;
-   KVIDLine* imfline;
-   add_remove_imf_line(KVList* l, KVIDLine* i) : idlines(l), imfline(i)
-   {
-      if (imfline) idlines->AddLast(imfline);
-   }
-   ~add_remove_imf_line()
-   {
-      if (imfline) idlines->Remove(imfline);
-   }
-};
-
 void KVIDGCsI::Identify(Double_t x, Double_t y, KVIdentificationResult* idr) const
 {
    // Set Z and A of nucleus based on position in R-L grid
@@ -75,34 +60,37 @@ void KVIDGCsI::Identify(Double_t x, Double_t y, KVIdentificationResult* idr) con
    //  the integer A is not necessarily = nint(floating-point A): for example, if no 5He line is drawn in the grid
    //  (which is usually the case), there will be no isotopically-identified particle with GetA()=5, although
    //  there may be particles with GetRealA() between 4.5 and 5.5
+   //
+   // The IMF line is used as an extra identification line (see GetIdentificationLines()).
+   // The grid is not modified: this method can be called concurrently by several threads.
 
-   add_remove_imf_line IMF(fIdentifiers, IMFLine);
+   IdentificationContext& ctx = GetThreadContext();
 
    if (!IsIdentifiable(x, y)) {
       //point below gamma line
-      const_cast < KVIDGCsI* >(this)->fICode = kICODE10;
-      idr->IDquality = fICode;
+      ctx.fICode = kICODE10;
+      idr->IDquality = ctx.fICode;
       idr->Z = 0;
       idr->A = 0;
       idr->IDOK = kTRUE;
       idr->SetComment("gamma");
       return;
    }
-   if (!const_cast<KVIDGCsI*>(this)->FindFourEmbracingLines(x, y, "above")) {
+   if (!FindFourEmbracingLines(x, y, "above", ctx)) {
       //no lines corresponding to point were found
-      const_cast < KVIDGCsI* >(this)->fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
-      idr->IDquality = fICode;
+      ctx.fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
+      idr->IDquality = ctx.fICode;
       idr->SetComment("no identification: (x,y) out of range covered by grid");
       return;
    }
    Int_t Z;
    Double_t A;
-   const_cast < KVIDGCsI* >(this)->IdentZA(x, y, Z, A);
+   IdentZA(x, y, Z, A, ctx);
    idr->Z = Z;
-   idr->A = Aint;
+   idr->A = ctx.Aint;
    idr->PID = A;
-   idr->IDquality = fICode;
-   switch (fICode) {
+   idr->IDquality = ctx.fICode;
+   switch (ctx.fICode) {
 
       case kICODE0:
          idr->SetComment("ok");
@@ -138,7 +126,7 @@ void KVIDGCsI::Identify(Double_t x, Double_t y, KVIdentificationResult* idr) con
          idr->SetComment("no identification: (x,y) out of range covered by grid");
    }
 
-   if (fICode < kICODE4) {
+   if (ctx.fICode < kICODE4) {
       idr->IDOK = kTRUE;
       idr->Zident = kTRUE;
       idr->Aident = kTRUE;
@@ -191,16 +179,16 @@ KVIDZALine* KVIDGCsI::GetZALine(Int_t z, Int_t a, Int_t& index) const
 
 //_________________________________________________________________________//
 
-void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
+void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A, IdentificationContext& ctx) const
 {
    //Finds Z, A and 'real A' for point (x,y) once closest lines to point have been found.
    // Double_t A = mass calculated by interpolation
    //This is a line-for-line copy of the latter part of IdnCsOr, even the same
    //variable names and comments have been used (as much as possible).
 
-   fICode = kICODE0;
+   ctx.fICode = kICODE0;
    A = -1.;
-   Aint = 0;
+   ctx.Aint = 0;
 
 //   if(fIdxClosest==ksups) cout << "*** ";
 //   cout << "ksups = " << ksups << " Zsups = " << Zsups << "  Asups = " << Asups << "  wsups = " << wsups << "  dsups = " << dsups << endl;
@@ -216,40 +204,40 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
    Int_t ix1, ix2;
    yy = y1 = y2 = 0;
    ix1 = ix2 = 0;
-   if (ksup > -1) {
-      if (kinf > -1) {
+   if (ctx.ksup > -1) {
+      if (ctx.kinf > -1) {
          //cout << " /******************* 2 lignes encadrant le point ont ete trouvees ************************/" << endl;
-         Double_t dt = dinf + dsup;     //distance between the 2 lines
-         if (Zinf == Zsup) {
+         Double_t dt = ctx.dinf + ctx.dsup;     //distance between the 2 lines
+         if (ctx.Zinf == ctx.Zsup) {
             //   cout << "      /****************meme Z**************/" << endl;
-            Z = Zinf;
-            Int_t dA = Asup - Ainf;
+            Z = ctx.Zinf;
+            Int_t dA = ctx.Asup - ctx.Ainf;
             Double_t dist = dt / dA;    //distance between the 2 lines normalised to difference in A of lines
             /*** A = Asup ***/
-            if (dinf > dsup) {  //point is closest to upper line, 'sup' line
+            if (ctx.dinf > ctx.dsup) {  //point is closest to upper line, 'sup' line
                ibif = 1;
-               k = ksup;
-               yy = -dsup;
-               A = Asup;
-               Aint = Asup;
-               if (ksups > -1) {        // there is a 'sups' line above the 2 which encadrent le point
-                  y2 = dsups - dsup;
-                  if (Zsups == Zsup) {
+               k = ctx.ksup;
+               yy = -ctx.dsup;
+               A = ctx.Asup;
+               ctx.Aint = ctx.Asup;
+               if (ctx.ksups > -1) {        // there is a 'sups' line above the 2 which encadrent le point
+                  y2 = ctx.dsups - ctx.dsup;
+                  if (ctx.Zsups == ctx.Zsup) {
                      ibif = 0;
                      y2 /= 2.;
-                     ix2 = Asups - Asup;
+                     ix2 = ctx.Asups - ctx.Asup;
                   }
                   else {
-                     if (Zsups > 0)
+                     if (ctx.Zsups > 0)
                         y2 /= 2.;       // 'sups' line is not IMF line
-                     Double_t x2 = wsup;
+                     Double_t x2 = ctx.wsup;
                      x2 = 0.5 * TMath::Max(x2, dist);
                      y2 = TMath::Min(y2, x2);
                      ix2 = 1;
                   }
                }
                else {         // ksups == -1 i.e. no 'sups' line
-                  y2 = wsup;
+                  y2 = ctx.wsup;
                   y2 = 0.5 * TMath::Max(y2, dist);
                   ix2 = 1;
                }
@@ -259,26 +247,26 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             /*** A = Ainf ***/
             else {              //point is closest to lower line, 'inf' line
                ibif = 2;
-               k = kinf;
-               yy = dinf;
-               A = Ainf;
-               Aint = Ainf;
-               if (kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent le point
-                  y1 = 0.5 * (dinfi - dinf);
-                  if (Zinfi == Zinf) {
+               k = ctx.kinf;
+               yy = ctx.dinf;
+               A = ctx.Ainf;
+               ctx.Aint = ctx.Ainf;
+               if (ctx.kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent le point
+                  y1 = 0.5 * (ctx.dinfi - ctx.dinf);
+                  if (ctx.Zinfi == ctx.Zinf) {
                      ibif = 0;
-                     ix1 = Ainfi - Ainf;
+                     ix1 = ctx.Ainfi - ctx.Ainf;
                      y1 = -y1;
                   }
                   else {
-                     Double_t x1 = winf;
+                     Double_t x1 = ctx.winf;
                      x1 = 0.5 * TMath::Max(x1, dist);
                      y1 = -TMath::Min(y1, x1);
                      ix1 = -1;
                   }
                }
                else {         // kinfi = -1 i.e. no 'infi' line
-                  y1 = winf;
+                  y1 = ctx.winf;
                   y1 = -0.5 * TMath::Max(y1, dist);
                   ix1 = -1;
                }
@@ -288,24 +276,24 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
          }
          else {
             //cout << "         /****************Z differents**************/ " << endl;
-            if (Zsup == -1) {   //'sup' is the IMF line
+            if (ctx.Zsup == -1) {   //'sup' is the IMF line
                dt *= 2.;
-               dsup = dt - dinf;
+               ctx.dsup = dt - ctx.dinf;
             }
             /*** Z = Zsup ***/
             ibif = 3;
-            if (dinf > dsup) {  // closest to upper 'sup' line
-               k = ksup;
-               yy = -dsup;
-               Z = Zsup;
-               A = Asup;
-               Aint = Asup;
-               y1 = 0.5 * wsup;
-               if (ksups > -1) {        // there is a 'sups' line above the 2 which encadrent the point
-                  y2 = dsups - dsup;
-                  if (Zsups == Zsup) {
+            if (ctx.dinf > ctx.dsup) {  // closest to upper 'sup' line
+               k = ctx.ksup;
+               yy = -ctx.dsup;
+               Z = ctx.Zsup;
+               A = ctx.Asup;
+               ctx.Aint = ctx.Asup;
+               y1 = 0.5 * ctx.wsup;
+               if (ctx.ksups > -1) {        // there is a 'sups' line above the 2 which encadrent the point
+                  y2 = ctx.dsups - ctx.dsup;
+                  if (ctx.Zsups == ctx.Zsup) {
                      ibif = 2;
-                     ix2 = Asups - Asup;
+                     ix2 = ctx.Asups - ctx.Asup;
                      Double_t x1 = y2 / ix2 / 2.;
                      y1 = TMath::Max(y1, x1);
                      y1 = -TMath::Min(y1, dt / 2.);
@@ -313,7 +301,7 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
                      y2 /= 2.;
                   }
                   else {
-                     if (Zsups > 0)
+                     if (ctx.Zsups > 0)
                         y2 /= 2.;       // 'sups" is not IMF line
                      y2 = TMath::Min(y1, y2);
                      ix2 = 1;
@@ -322,7 +310,7 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
                   }
                }
                else {         // ksups == -1, i.e. no 'sups' line
-                  fICode = kICODE7;     //a gauche de la ligne fragment, Z est alors un Zmin et le plus probable
+                  ctx.fICode = kICODE7;     //a gauche de la ligne fragment, Z est alors un Zmin et le plus probable
                   y2 = y1;
                   ix2 = 1;
                   y1 = -TMath::Min(y1, dt / 2.);
@@ -331,17 +319,17 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             }
             /*** Z = Zinf ***/
             else {              // closest to lower 'inf' line
-               k = kinf;
-               yy = dinf;
-               Z = Zinf;
-               A = Ainf;
-               Aint = Ainf;
-               y2 = 0.5 * winf;
-               if (kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent the point
-                  y1 = dinfi - dinf;
-                  if (Zinfi == Zinf) {
+               k = ctx.kinf;
+               yy = ctx.dinf;
+               Z = ctx.Zinf;
+               A = ctx.Ainf;
+               ctx.Aint = ctx.Ainf;
+               y2 = 0.5 * ctx.winf;
+               if (ctx.kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent the point
+                  y1 = ctx.dinfi - ctx.dinf;
+                  if (ctx.Zinfi == ctx.Zinf) {
                      ibif = 1;
-                     ix1 = Ainfi - Ainf;
+                     ix1 = ctx.Ainfi - ctx.Ainf;
                      Double_t x2 = -y1 / ix1 / 2.;
                      y2 = TMath::Max(y2, x2);
                      y2 = TMath::Min(y2, dt / 2.);
@@ -364,27 +352,27 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             }
          }
       }//if(kinf>-1)...
-      else if (Zsup > 0) {      // 'sup' is not IMF line
+      else if (ctx.Zsup > 0) {      // 'sup' is not IMF line
          //cout<<" /****************** Seule une ligne superieure a ete trouvee *********************/" << endl;
          ibif = 3;
-         k = ksup;
-         yy = -dsup;
-         Z = Zsup;
-         A = Asup;
-         Aint = Asup;
-         y1 = 0.5 * wsup;
-         if (ksups > -1) {      // there is a 'sups' line above the closest line to the point
-            y2 = dsups - dsup;
-            if (Zsups == Zsup) {
+         k = ctx.ksup;
+         yy = -ctx.dsup;
+         Z = ctx.Zsup;
+         A = ctx.Asup;
+         ctx.Aint = ctx.Asup;
+         y1 = 0.5 * ctx.wsup;
+         if (ctx.ksups > -1) {      // there is a 'sups' line above the closest line to the point
+            y2 = ctx.dsups - ctx.dsup;
+            if (ctx.Zsups == ctx.Zsup) {
                ibif = 2;
-               ix2 = Asups - Asup;
+               ix2 = ctx.Asups - ctx.Asup;
                Double_t x1 = y2 / ix2 / 2.;
                y1 = -TMath::Max(y1, x1);
                ix1 = -1;
                y2 /= 2.;
             }
             else {
-               if (Zsups > 0)
+               if (ctx.Zsups > 0)
                   y2 /= 2.;     // 'sups' is not IMF line
                y2 = TMath::Min(y1, y2);
                ix2 = 1;
@@ -393,7 +381,7 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             }
          }
          else {               // no 'sups' line above closest line
-            fICode = kICODE7;   //a gauche de la ligne fragment, Z est alors un Zmin et le plus probable
+            ctx.fICode = kICODE7;   //a gauche de la ligne fragment, Z est alors un Zmin et le plus probable
             y2 = y1;
             ix2 = 1;
             y1 = -y1;
@@ -401,34 +389,34 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
          }
       }
       else {
-         fICode = kICODE8;      //  Z indetermine ou (x,y) hors limites
+         ctx.fICode = kICODE8;      //  Z indetermine ou (x,y) hors limites
       }
    }
-   else if (kinf > -1) {
+   else if (ctx.kinf > -1) {
       //cout <<"/****************** Seule une ligne inferieure a ete trouvee ***********************/" << endl;
       /*** Sep. fragment ***/
-      if (Zinf == -1) {         // 'inf' is IMF line
+      if (ctx.Zinf == -1) {         // 'inf' is IMF line
          //point is above IMF line. Z = Z of last line in grid, A = -1
          k = -1;
          Z = GetZmax();
          A = -1;
-         Aint = 0;
-         fICode = kICODE6;      // au-dessus de la ligne fragment, Z est alors un Zmin
+         ctx.Aint = 0;
+         ctx.fICode = kICODE6;      // au-dessus de la ligne fragment, Z est alors un Zmin
       }
       /*** Ligne de crete (Z,A line)***/
       else {
          ibif = 3;
-         k = kinf;
-         Z = Zinf;
-         A = Ainf;
-         Aint = Ainf;
-         yy = dinf;
-         y2 = 0.5 * winf;
-         if (kinfi > -1) {
-            y1 = dinfi - dinf;
-            if (Zinfi == Zinf) {
+         k = ctx.kinf;
+         Z = ctx.Zinf;
+         A = ctx.Ainf;
+         ctx.Aint = ctx.Ainf;
+         yy = ctx.dinf;
+         y2 = 0.5 * ctx.winf;
+         if (ctx.kinfi > -1) {
+            y1 = ctx.dinfi - ctx.dinf;
+            if (ctx.Zinfi == ctx.Zinf) {
                ibif = 1;
-               ix1 = Ainfi - Ainf;
+               ix1 = ctx.Ainfi - ctx.Ainf;
                Double_t x2 = -y1 / ix1 / 2.;
                y2 = TMath::Max(y2, x2);
                ix2 = 1;
@@ -445,29 +433,29 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             ix1 = -1;
             ix2 = 1;
          }
-         fICode = kICODE7;      // a gauche de la ligne fragment, Z est alors un Zmin et le plus probable
+         ctx.fICode = kICODE7;      // a gauche de la ligne fragment, Z est alors un Zmin et le plus probable
       }
    }
    /*****************Aucune ligne n'a ete trouvee*********************************/
    else {
-      fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
+      ctx.fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
    }
    /****************Test des bornes********************************************/
-   if (k > -1 && fICode == kICODE0) {
+   if (k > -1 && ctx.fICode == kICODE0) {
       if (yy > y2)
-         fICode = kICODE4;      // Z ok, masse hors limite superieure ou egale a A
+         ctx.fICode = kICODE4;      // Z ok, masse hors limite superieure ou egale a A
    }
-   if (k > -1 && (fICode == kICODE0 || fICode == kICODE7)) {
+   if (k > -1 && (ctx.fICode == kICODE0 || ctx.fICode == kICODE7)) {
       if (yy < y1)
-         fICode = kICODE5;      // Z ok, masse hors limite inferieure ou egale a A
+         ctx.fICode = kICODE5;      // Z ok, masse hors limite inferieure ou egale a A
    }
-   if (fICode == kICODE4 || fICode == kICODE5) {
+   if (ctx.fICode == kICODE4 || ctx.fICode == kICODE5) {
       A = -1;
-      Aint = 0;
+      ctx.Aint = 0;
    }
 
    /****************Interpolation de la masse: da = f*log(1+b*dy)********************/
-   if (fICode == kICODE0 || (fICode == kICODE7 && yy <= y2)) {
+   if (ctx.fICode == kICODE0 || (ctx.fICode == kICODE7 && yy <= y2)) {
       Double_t deltaA = 0.;
       Bool_t i = kFALSE;
       Double_t dt, dist = y1 * y2;
@@ -523,7 +511,7 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
       }
    }
    /***************D'autres masses sont-elles possibles ?*************************/
-   if (fICode == kICODE0) {
+   if (ctx.fICode == kICODE0) {
       //cout << "icode = 0, ibif = " << ibif << endl;
       /***Masse superieure***/
       if (ibif == 1 || ibif == 3) {
@@ -531,13 +519,13 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
          //If it has the same Z as the closest line, but was excluded from research for closest line
          //because the point lies outside the endpoints, there remains a doubt about the mass:
          //on rajoute 1 a fICode, effectivement on le met = kICODE1
-         Int_t idx = fIdxClosest;
-         if (idx > -1 && ++idx < GetNumberOfIdentifiers()) {
+         Int_t idx = ctx.fIdxClosest;
+         if (idx > -1 && ++idx < GetIdentificationLines()->GetEntries()) {
             KVIDCsIRLLine* nextline =
-               (KVIDCsIRLLine*) GetIdentifierAt(idx);
+               (KVIDCsIRLLine*) GetIdentificationLineAt(idx);
             if (nextline->GetZ() == Z
                   && !nextline->IsBetweenEndPoints(x, y, "x")) {
-               fICode++;        // Z ok, mais les masses superieures a A sont possibles
+               ctx.fICode++;        // Z ok, mais les masses superieures a A sont possibles
                //cout <<"//on rajoute 1 a fICode, effectivement on le met = kICODE1" << endl;
             }
          }
@@ -548,13 +536,13 @@ void KVIDGCsI::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
          //If it has the same Z as the closest line, but was excluded from research for closest line
          //because the point lies outside the endpoints, there remains a doubt about the mass:
          //on rajoute 2 a fICode, so it can be = kICODE2 or kICODE3
-         Int_t idx = fIdxClosest;
+         Int_t idx = ctx.fIdxClosest;
          if (idx > -1 && --idx >= 0) {
             KVIDCsIRLLine* nextline =
-               (KVIDCsIRLLine*) GetIdentifierAt(idx);
+               (KVIDCsIRLLine*) GetIdentificationLineAt(idx);
             if (nextline->GetZ() == Z
                   && !nextline->IsBetweenEndPoints(x, y, "x")) {
-               fICode += 2;
+               ctx.fICode += 2;
                //cout << "//on rajoute 2 a fICode, so it can be = kICODE2 or kICODE3" << endl;
             }
          }
@@ -575,9 +563,10 @@ void KVIDGCsI::Initialize()
    // The line with the largest Z (Zmax line) is found.
    // IMF & Gamma line pointers are initialised
 
-   // if grid has already been used for identification, IMF_line will be in identifiers list.
+   // grids used for identification with older versions may have IMF_line in identifiers list.
    TObject* imfline = fIdentifiers->FindObject("IMF_line");
    if (imfline) fIdentifiers->Remove(imfline); // remove to avoid problems with CalculateLineWidths
+   fIDLines.Clear();
    KVIDZAGrid::Initialize();
    GammaLine = (KVIDLine*)GetCut("gamma_line");
    if (!GammaLine) {
@@ -592,6 +581,47 @@ void KVIDGCsI::Initialize()
             GetName());
       GetCuts()->ls();
    }
+   fill_id_lines();
+   if (IsUseLineIndex()) BuildLineIndex();
+}
+
+//___________________________________________________________________________________
+
+void KVIDGCsI::fill_id_lines()
+{
+   // list of lines used for identification: identifiers followed by IMF line
+
+   fIDLines.Clear();
+   fIDLines.AddAll(fIdentifiers);
+   if (IMFLine) fIDLines.AddLast(IMFLine);
+}
+
+//___________________________________________________________________________________
+
+void KVIDGCsI::IdentifiersModified()
+{
+   // Lines have been added to, removed from or reordered in the grid.
+   // If the grid has been initialised, the gamma & IMF lines and the list of lines used for
+   // identification are updated (the grid must not be modified while it is used for identification),
+   // before the line index is updated (see KVIDGrid::IdentifiersModified()).
+
+   if (fIDLines.GetEntries()) {
+      GammaLine = (KVIDLine*)GetCut("gamma_line");
+      IMFLine = (KVIDLine*)GetCut("IMF_line");
+      fill_id_lines();
+   }
+   KVIDZAGrid::IdentifiersModified();
+}
+
+//___________________________________________________________________________________
+
+const TSeqCollection* KVIDGCsI::GetIdentificationLines() const
+{
+   // The IMF line is used for identification as if it were the last identifier of the grid.
+   // The list is set up by Initialize(): before that, only the identifiers are used.
+
+   if (fIDLines.GetEntries()) return &fIDLines;
+   return KVIDZAGrid::GetIdentificationLines();
 }
 
 //___________________________________________________________________________________
@@ -12,6 +12,7 @@ $Id: KVIDGCsI.h,v 1.18 2009/04/06 15:09:29 franklan Exp $
 #define KVIDGCsI_H
 
 #include "KVIDZAGrid.h"
+#include "TList.h"
 
 /**
    \class KVIDGCsI
@@ -42,8 +43,13 @@ class KVIDGCsI: public KVIDZAGrid {
 
    KVIDLine* IMFLine;//!
    KVIDLine* GammaLine;//!
+   TList fIDLines;//! identifiers + IMF line, used for identification
+
+   void fill_id_lines();
 
 protected:
+   const TSeqCollection* GetIdentificationLines() const;
+   virtual void IdentifiersModified();
    KVIDLine* GetNearestIDLine(Double_t x, Double_t y,
                               const Char_t* position, Int_t& idx_min,
                               Int_t& idx_max);
@@ -73,7 +79,7 @@ public:
    KVIDZALine* GetZALine(Int_t z, Int_t a, Int_t&) const;
    KVIDZALine* GetZLine(Int_t z, Int_t&) const;
 
-   void IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A);
+   void IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A, IdentificationContext& ctx) const;
    virtual void Initialize();
    virtual TClass* DefaultIDLineClass()
    {
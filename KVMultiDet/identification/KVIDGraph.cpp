@@ -168,6 +168,7 @@ KVIDGraph::~KVIDGraph()
 {
    // Destructor
 
+   KVIDGridManager::GridsModified();
    fIdentifiers->Delete();
    delete fIdentifiers;
    fCuts->Delete();
@@ -185,6 +186,7 @@ void KVIDGraph::Clear(Option_t*)
 
    fIdentifiers->Delete();
    fCuts->Delete();
+   IdentifiersModified();
    fXmin = fYmin = fXmax = fYmax = 0;
    SetXScaleFactor();
    SetYScaleFactor();
@@ -278,6 +280,7 @@ void KVIDGraph::RemoveIdentifier(KVIDentifier* id)
    // Remove and destroy identifier
    fIdentifiers->Remove(id);
    delete id;
+   IdentifiersModified();
    Modified();
 }
 
@@ -288,6 +291,7 @@ void KVIDGraph::RemoveCut(KVIDentifier* cut)
    // Remove and destroy cut
    fCuts->Remove(cut);
    delete cut;
+   IdentifiersModified();
    Modified();
 }
 
@@ -837,6 +841,7 @@ void KVIDGraph::Scale(TF1* sx, TF1* sy)
    if (GetNumberOfCuts() > 0) {
       fCuts->R__FOR_EACH(KVIDentifier, Scale)(sx, sy);
    }
+   UpdateLineIndex();
    Modified();
 }
 
@@ -854,6 +859,7 @@ void KVIDGraph::Scale(Double_t sx, Double_t sy)
    if (GetNumberOfCuts() > 0) {
       fCuts->R__FOR_EACH(KVIDentifier, Scale)(sx, sy);
    }
+   UpdateLineIndex();
 }
 
 //___________________________________________________________________________________
@@ -964,6 +970,7 @@ void KVIDGraph::SetRuns(const KVNumberList& runs)
    // Set list of runs for which grid is valid
    fRunList = runs;
    fPar->SetValue("Runlist", fRunList.AsString());
+   KVIDGridManager::GridsModified();
    Modified();
 }
 
@@ -1002,6 +1009,7 @@ void KVIDGraph::BackwardsCompatibilityFix()
    if (fPar->HasParameter("First run") && fPar->HasParameter("Last run")) {
       fRunList.SetMinMax(fPar->GetIntValue("First run"), fPar->GetIntValue("Last run"));
       fPar->SetValue("Runlist", fRunList.AsString());
+      KVIDGridManager::GridsModified();
       fPar->RemoveParameter("First run");
       fPar->RemoveParameter("Last run");
    }
@@ -1211,6 +1219,7 @@ void KVIDGraph::Streamer(TBuffer& R__b)
 
    if (R__b.IsReading()) {
       R__b.ReadClassBuffer(KVIDGraph::Class(), this);
+      KVIDGridManager::GridsModified();// new list of runs
       TIter nxt_id(fIdentifiers);
       KVIDentifier* id;
       while ((id = (KVIDentifier*)nxt_id())) id->fParent = this;
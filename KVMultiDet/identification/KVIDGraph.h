@@ -61,6 +61,12 @@ protected:
    }
 
    void Scale(Double_t sx = -1, Double_t sy = -1);
+   virtual void UpdateLineIndex() {}
+   virtual void IdentifiersModified()
+   {
+      // Called whenever identifiers or cuts are added to, removed from or reordered in the graph.
+      // Redefine in child classes which keep their own lists of, or pointers to, identifiers or cuts.
+   }
    virtual void ReadFromAsciiFile(std::ifstream& gridfile);
    virtual void WriteToAsciiFile(std::ofstream& gridfile);
    void init();
@@ -120,6 +126,11 @@ public:
    KVIDentifier* GetIdentifier(Int_t Z, Int_t A) const;
    void RemoveIdentifier(KVIDentifier*);
    void RemoveCut(KVIDentifier*);
+   void IdentifierModified()
+   {
+      // Called by identifiers & cuts of the graph when the coordinates of their points are modified
+      UpdateLineIndex();
+   }
 
    TVirtualPad* GetPad() const
    {
@@ -301,6 +312,7 @@ public:
       //if grid is Z-identification only, set mass formula for line
       //according to mass formula of grid
       if (IsOnlyZId()) id->SetMassFormula(GetMassFormula());
+      IdentifiersModified();
       //Modified();
    }
    virtual void AddCut(KVIDentifier* cut)
@@ -312,11 +324,13 @@ public:
       cut->SetVarX(GetVarX());
       cut->SetVarY(GetVarY());
       cut->SetBit(kMustCleanup);
+      IdentifiersModified();
       //Modified();
    }
    void SortIdentifiers()
    {
       fIdentifiers->Sort();
+      IdentifiersModified();
       //Modified();
    }
    Bool_t IsSorted() const
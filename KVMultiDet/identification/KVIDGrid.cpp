@@ -31,6 +31,8 @@ $Id: KVIDGrid.cpp,v 1.60 2009/05/05 15:57:52 franklan Exp $
 #include "TF1.h"
 #include "KVIDZALine.h"
 #include "KVIDCutLine.h"
+#include "TEnv.h"
+#include <algorithm>
 
 
 using namespace std;
@@ -50,6 +52,9 @@ KVIDGrid::KVIDGrid()
 void KVIDGrid::init()
 {
    //Initialisations, used by constructors
+   fUseLineIndex = gEnv->GetValue("KVIDGrid.LineIndex", kTRUE);
+   fIndexNlines = -1;
+   fIndexX0 = fIndexX1 = fIndexBinWidth = 0;
 }
 
 //________________________________________________________________________________
@@ -156,17 +161,35 @@ Int_t KVIDGrid::GetIDLinesEmbracingPoint(const Char_t* direction, Double_t x, Do
    //Replaces contents of fEmbracingLines with subset of ID lines for which IsBetweenEndPoints(x,y,direction) == kTRUE.
    //nlines = number of lines in list
 
-   TIter next(GetIdentifiers());
-   Int_t nlines = 0;
+   return GetIDLinesEmbracingPoint(direction, x, y, fEmbracingLines);
+}
+
+Int_t KVIDGrid::GetIDLinesEmbracingPoint(const Char_t* direction, Double_t x, Double_t y, EmbracingLines_t& lines) const
+{
+   //Replaces contents of 'lines' with subset of identification lines (see GetIdentificationLines())
+   //for which IsBetweenEndPoints(x,y,direction) == kTRUE, together with their indices in the list.
+   //nlines = number of lines in list
+   //
+   //If the line index has been built (see SetUseLineIndex()) and direction="x", only the lines
+   //whose X range overlaps the bin containing x are tested.
+
+   lines.clear();
+   if (HasLineIndex() && IsXAxis(direction)) {
+      if (!(x >= fIndexX0 && x <= fIndexX1)) return 0;
+      const std::vector<Int_t>& bin = fIndexBins[GetIndexBin(x)];
+      for (std::vector<Int_t>::const_iterator it = bin.begin(); it != bin.end(); ++it) {
+         if (x <= fIndexXmax[*it] && x >= fIndexXmin[*it]) lines.push_back(std::make_pair(*it, fIndexLines[*it]));
+      }
+      return lines.size();
+   }
+   TIter next(GetIdentificationLines());
    KVIDLine* line;
-   fEmbracingLines.Clear();
+   Int_t index = 0;
    while ((line = (KVIDLine*) next())) {
-      if (line->IsBetweenEndPoints(x, y, direction)) {
-         fEmbracingLines.Add(line);
-         nlines++;
-      }
+      if (line->IsBetweenEndPoints(x, y, direction)) lines.push_back(std::make_pair(index, line));
+      ++index;
    }
-   return nlines;
+   return lines.size();
 }
 
 //___________________________________________________________________________________
@@ -180,5 +203,112 @@ void KVIDGrid::Initialize()
 
    SortIdentifiers();
    CalculateLineWidths();
+   if (fUseLineIndex) BuildLineIndex();
+   else ClearLineIndex();
+}
+
+//___________________________________________________________________________________
+
+void KVIDGrid::SetUseLineIndex(Bool_t yes)
+{
+   // Enable or disable the use of an index of the identification lines by FindNearestEmbracingIDLine
+   // and FindNextEmbracingLine, used e.g. by KVIDZAGrid::Identify.
+   //
+   // The index divides the X range of the grid into bins and stores for each bin the lines whose
+   // X range overlaps the bin, so that only these lines are considered when looking for lines
+   // embracing a point. Results are identical with or without the index.
+   //
+   // The default value is given by the environment variable
+   //~~~~
+   //KVIDGrid.LineIndex:    yes
+   //~~~~
+   // The index is built by Initialize(). It is rebuilt automatically whenever lines are added to,
+   // removed from or reordered in the grid, or when the points of a line are modified by any method of
+   // KVIDentifier or by the grid editor (see KVIDGraph::IdentifierModified()). If the coordinates of a line
+   // are changed by any other means (e.g. TGraph::SetPoint()), call Initialize() again.
+
+   fUseLineIndex = yes;
+   if (yes) BuildLineIndex();
+   else ClearLineIndex();
+}
+
+//___________________________________________________________________________________
+
+void KVIDGrid::ClearLineIndex()
+{
+   // Delete index of identification lines
+
+   fIndexNlines = -1;
+   fIndexLines.clear();
+   fIndexXmin.clear();
+   fIndexXmax.clear();
+   fIndexBins.clear();
+}
+
+//___________________________________________________________________________________
+
+void KVIDGrid::UpdateLineIndex()
+{
+   // Called when coordinates of lines are modified (see KVIDGraph::IdentifierModified()),
+   // or lines are added, removed or reordered: rebuild index if it was in use
+
+   if (fIndexNlines > -1) BuildLineIndex();
+}
+
+//___________________________________________________________________________________
+
+void KVIDGrid::IdentifiersModified()
+{
+   // Lines have been added to, removed from or reordered in the grid: rebuild the line index
+   // if it was in use, so that it never refers to deleted lines or uses an out-of-date order
+
+   KVIDGraph::IdentifiersModified();
+   UpdateLineIndex();
+}
+
+//___________________________________________________________________________________
+
+void KVIDGrid::BuildLineIndex()
+{
+   // Build index of identification lines (see SetUseLineIndex()).
+   //
+   // The X range covered by all lines is divided into (at most) 4 bins per line.
+   // For each line we store the X range of its endpoints (as used by KVIDLine::IsBetweenEndPoints)
+   // and add it to the list of every bin which this range overlaps.
+
+   ClearLineIndex();
+   const TSeqCollection* lines = GetIdentificationLines();
+   Int_t nlines = lines->GetEntries();
+   if (!nlines) return;
+   fIndexLines.reserve(nlines);
+   fIndexXmin.reserve(nlines);
+   fIndexXmax.reserve(nlines);
+   TIter next(lines);
+   KVIDLine* line;
+   while ((line = (KVIDLine*)next())) {
+      Double_t x1, y1, x2, y2;
+      line->GetStartPoint(x1, y1);
+      line->GetEndPoint(x2, y2);
+      fIndexLines.push_back(line);
+      fIndexXmin.push_back(TMath::Min(x1, x2));
+      fIndexXmax.push_back(TMath::Max(x1, x2));
+   }
+   fIndexX0 = *std::min_element(fIndexXmin.begin(), fIndexXmin.end());
+   fIndexX1 = *std::max_element(fIndexXmax.begin(), fIndexXmax.end());
+   Int_t nbins = TMath::Min(4 * nlines, 4096);
+   fIndexBinWidth = (fIndexX1 - fIndexX0) / nbins;
+   if (fIndexBinWidth <= 0) {
+      // all lines have the same (single) X coordinate
+      nbins = 1;
+      fIndexBinWidth = 1.;
+   }
+   fIndexBins.resize(nbins);
+   for (Int_t i = 0; i < nlines; ++i) {
+      // bins are calculated in the same way as for a point, therefore any x with
+      // xmin <= x <= xmax falls in one of the bins between those of xmin and xmax
+      Int_t bmax = GetIndexBin(fIndexXmax[i]);
+      for (Int_t b = GetIndexBin(fIndexXmin[i]); b <= bmax; ++b) fIndexBins[b].push_back(i);
+   }
+   fIndexNlines = nlines;
 }
 
@@ -20,6 +20,8 @@ $Id: KVIDGrid.h,v 1.51 2009/04/03 14:30:27 franklan Exp $
 #include "TF1.h"
 #include "TClass.h"
 #include "TMath.h"
+#include <vector>
+#include <utility>
 
 /**
 \class KVIDGrid
@@ -72,11 +74,60 @@ Note that this scaling is taken into account also in IsIdentifiable and Identify
 
 class KVIDGrid : public KVIDGraph {
 
-   mutable TObjArray fEmbracingLines;//! temporary array used by GetIDLinesEmbracingPoint
+public:
+   typedef std::vector<std::pair<Int_t, KVIDLine*> > EmbracingLines_t; // lines embracing a point and their indices
+
+private:
+   mutable EmbracingLines_t fEmbracingLines;//! temporary array used by FindNearestEmbracingIDLine (not thread-safe)
+
+   // index of identification lines used to accelerate search of lines embracing a point in X
+   Bool_t fUseLineIndex;//! set to kTRUE to build line index in Initialize()
+   Int_t fIndexNlines;//! number of lines in index, -1 if index not built
+   std::vector<KVIDLine*> fIndexLines;//! identification lines, in the order of GetIdentificationLines()
+   std::vector<Double_t> fIndexXmin;//! smallest X of endpoints of each line
+   std::vector<Double_t> fIndexXmax;//! largest X of endpoints of each line
+   std::vector<std::vector<Int_t> > fIndexBins;//! for each bin in X, indices of lines whose X range overlaps the bin
+   Double_t fIndexX0;//! lower edge of first X bin
+   Double_t fIndexX1;//! upper edge of last X bin
+   Double_t fIndexBinWidth;//! width of X bins
+
+   static Bool_t IsXAxis(const Char_t* axis)
+   {
+      // kTRUE if axis is "x" or "X" (see KVIDLine::IsBetweenEndPoints)
+      return (axis && (axis[0] == 'x' || axis[0] == 'X') && !axis[1]);
+   }
+   Int_t GetIndexBin(Double_t x) const
+   {
+      // Bin of line index containing x (fIndexX0<=x<=fIndexX1)
+      Int_t b = (Int_t)((x - fIndexX0) / fIndexBinWidth);
+      return TMath::Min(b, (Int_t)fIndexBins.size() - 1);
+   }
 
 protected:
 
    void init();
+   Bool_t HasLineIndex() const
+   {
+      // kTRUE if the line index can be used
+      return (fIndexNlines > -1 && fIndexNlines == GetIdentificationLines()->GetEntries());
+   }
+   void BuildLineIndex();
+   void ClearLineIndex();
+   virtual void UpdateLineIndex();
+   virtual void IdentifiersModified();
+   KVIDLine* GetIdentificationLineAt(Int_t index) const
+   {
+      // Return line with given index in list of identification lines (see GetIdentificationLines())
+      if (HasLineIndex()) return fIndexLines[index];
+      return (KVIDLine*)GetIdentificationLines()->At(index);
+   }
+   virtual const TSeqCollection* GetIdentificationLines() const
+   {
+      // List of lines considered by FindNearestEmbracingIDLine and FindNextEmbracingLine:
+      // by default, all identifiers of the grid.
+      // Redefine in child classes which need to use extra lines for identification.
+      return fIdentifiers;
+   }
    void ReadIdentifierFromAsciiFile(TString& name, TString& type, TString& cl, std::ifstream& gridfile);
 
 public:
@@ -86,6 +137,13 @@ public:
 
    KVIDLine* NewLine(const Char_t* idline_class = "");
    Int_t GetIDLinesEmbracingPoint(const Char_t* direction, Double_t x, Double_t y) const;
+   Int_t GetIDLinesEmbracingPoint(const Char_t* direction, Double_t x, Double_t y, EmbracingLines_t& lines) const;
+
+   void SetUseLineIndex(Bool_t yes = kTRUE);
+   Bool_t IsUseLineIndex() const
+   {
+      return fUseLineIndex;
+   }
 
    KVIDLine* FindNearestIDLineFast(Double_t x, Double_t y, const Char_t* position,
                                    Int_t& idx, Int_t& idx_min, Int_t& idx_max, Double_t& dist, Double_t& dist_min, Double_t& dist_max) const
@@ -166,8 +224,23 @@ public:
       // KVIDLine::IsBetweenEndPoints(x,y,axis) returns kTRUE are considered.
       // As we only consider lines between whose endpoints our point lies, this method
       // always gives the correct answer.
+      //
+      // This version uses a temporary array belonging to the grid: it must not be called
+      // by several threads at once. Use the version with an external work array for that.
+
+      return FindNearestEmbracingIDLine(x, y, position, axis, idx, idx_min, idx_max, dist, dist_min, dist_max, fEmbracingLines);
+   }
+
+   KVIDLine* FindNearestEmbracingIDLine(Double_t x, Double_t y, const Char_t* position, const Char_t* axis,
+                                        Int_t& idx, Int_t& idx_min, Int_t& idx_max, Double_t& dist, Double_t& dist_min, Double_t& dist_max,
+                                        EmbracingLines_t& embracing) const
+   {
+      // Reentrant version of FindNearestEmbracingIDLine: the lines embracing the point are
+      // stored in the work array 'embracing' supplied by the caller, so that the grid itself
+      // is not modified and can be used by several threads at the same time (each with its own
+      // work array).
 
-      Int_t nlines = GetIDLinesEmbracingPoint(axis, x, y);
+      Int_t nlines = GetIDLinesEmbracingPoint(axis, x, y, embracing);
       if (!nlines) return 0;   // no lines
       idx_min = 0;                 //minimum index
       idx_max = nlines - 1;        // maximum index
@@ -176,7 +249,7 @@ public:
 
       while (idx_max > idx_min + 1) {
 
-         KVIDLine* line = (KVIDLine*)fEmbracingLines.UncheckedAt(idx);
+         KVIDLine* line = embracing[idx].second;
          Bool_t point_above_line = line->WhereAmI(x, y, position);
 
          if (point_above_line) {
@@ -191,15 +264,16 @@ public:
          }
       }
       //calculate distance of point to the two lines above and below
-      KVIDLine* upper = (KVIDLine*)fEmbracingLines.UncheckedAt(idx_max);
-      KVIDLine* lower = (KVIDLine*)fEmbracingLines.UncheckedAt(idx_min);
+      KVIDLine* upper = embracing[idx_max].second;
+      KVIDLine* lower = embracing[idx_min].second;
       Int_t dummy = 0;
+      Int_t upper_index = embracing[idx_max].first, lower_index = embracing[idx_min].first;
       //if idx_max = nlines-1, the point may be above the last line
       //in which case we put idx_max = -1 (no line above point)
       if (idx_max == nlines - 1) {
          if (upper->WhereAmI(x, y, position)) {
             // above last line
-            idx = idx_min = fIdentifiers->IndexOf(upper); // index of last line
+            idx = idx_min = upper_index; // index of last line
             idx_max = -1;
             dist = dist_min = TMath::Abs(upper->DistanceToLine(x, y, dummy));
             return upper;
@@ -211,7 +285,7 @@ public:
          if (!lower->WhereAmI(x, y, position)) {
             // below first line
             idx_min = -1;
-            idx = idx_max = fIdentifiers->IndexOf(lower); // index of first line
+            idx = idx_max = lower_index; // index of first line
             dist = dist_max = TMath::Abs(lower->DistanceToLine(x, y, dummy));
             return lower;
          }
@@ -220,8 +294,8 @@ public:
       dist_max = TMath::Abs(upper->DistanceToLine(x, y, dummy));
       dist_min = TMath::Abs(lower->DistanceToLine(x, y, dummy));
       // convert indices back to index in main list
-      idx_min = fIdentifiers->IndexOf(lower);
-      idx_max = fIdentifiers->IndexOf(upper);
+      idx_min = lower_index;
+      idx_max = upper_index;
       if (dist_max < dist_min) {
          dist = dist_max;
          idx = idx_max;
@@ -241,12 +315,27 @@ public:
       // Returns pointer to line (or 0x0 if not found) and 'index' contains index of this line (or -1 if no line found)
 
       Int_t ii = index + inc_index;
-      Int_t nlines = GetNumberOfIdentifiers();
       KVIDLine* l = 0;
-      while ((ii > -1 && ii < nlines)) {
-         l = (KVIDLine*)GetIdentifierAt(ii);
-         if (l->IsBetweenEndPoints(x, y, axis)) break;
-         ii += inc_index;
+      Int_t nlines;
+      if (HasLineIndex() && IsXAxis(axis)) {
+         // use precomputed X ranges of lines, same result as KVIDLine::IsBetweenEndPoints(x,y,"x")
+         nlines = fIndexNlines;
+         while ((ii > -1 && ii < nlines)) {
+            if (x <= fIndexXmax[ii] && x >= fIndexXmin[ii]) {
+               l = fIndexLines[ii];
+               break;
+            }
+            ii += inc_index;
+         }
+      }
+      else {
+         const TSeqCollection* lines = GetIdentificationLines();
+         nlines = lines->GetEntries();
+         while ((ii > -1 && ii < nlines)) {
+            l = (KVIDLine*)lines->At(ii);
+            if (l->IsBetweenEndPoints(x, y, axis)) break;
+            ii += inc_index;
+         }
       }
       if (ii < 0 || ii >= nlines) {
          // no line found
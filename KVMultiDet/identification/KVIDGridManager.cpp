@@ -27,6 +27,7 @@ using namespace std;
 
 ClassImp(KVIDGridManager)
 KVIDGridManager* gIDGridManager;
+UInt_t KVIDGridManager::fgModifications = 0;
 
 KVIDGridManager::KVIDGridManager()
 {
@@ -34,6 +35,7 @@ KVIDGridManager::KVIDGridManager()
    //Initialise global pointer gIDGridManager
    //Create list for ID grids
    gIDGridManager = this;
+   GridsModified();
    fGrids = new KVList;
    fGrids->SendModifiedSignals(kTRUE);
    fGrids->Connect("Modified()", "KVIDGridManager", this, "Modified()");
@@ -58,9 +60,30 @@ void KVIDGridManager::AddGrid(KVIDGraph* grid)
 {
    // Add a grid to the collection. It will be deleted by the manager.
 
+   GridsModified();
    fGrids->Add(grid);
 }
 
+void KVIDGridManager::AddGrids(const TCollection* grids)
+{
+   // Add all grids in the collection to the manager, e.g. grids read from a ROOT file
+   // after calling KVIDGraph::SetAutoAdd(kFALSE). They will be deleted by the manager.
+   //
+   // As for ReadAsciiFile(), the list of grids added can be accessed with method
+   // GetLastReadGrids() after calling this method
+
+   fLastReadGrids.Clear();
+   fGrids->Disconnect("Modified()", this, "Modified()");
+   TIter next(grids);
+   KVIDGraph* grid;
+   while ((grid = (KVIDGraph*)next())) {
+      AddGrid(grid);
+      fLastReadGrids.Add(grid);
+   }
+   Modified();                  // emit signal to say something changed
+   fGrids->Connect("Modified()", "KVIDGridManager", this, "Modified()");
+}
+
 void KVIDGridManager::DeleteGrid(KVIDGraph* grid, Bool_t update)
 {
    //Remove grid from manager's list and delete it
@@ -68,6 +91,7 @@ void KVIDGridManager::DeleteGrid(KVIDGraph* grid, Bool_t update)
    //is deleting a list of grids - in this case we don't want to update until the end
 
    if (!update) fGrids->Disconnect("Modified()", this, "Modified()");
+   GridsModified();
    fGrids->Remove(grid);
    delete grid;
    if (!update) fGrids->Connect("Modified()", "KVIDGridManager", this, "Modified()");
@@ -35,6 +35,12 @@ private:
 
    KVList* fGrids;              //collection of all ID graphs handled by manager
    TList fLastReadGrids;        //! list of grids created by last call to ReadAsciiFile
+   static UInt_t fgModifications;// number of changes to the grids or to the runs of any grid
+
+   static void GridsModified()
+   {
+      ++fgModifications;
+   }
 
 protected:
 
@@ -55,9 +61,10 @@ public:
 
    void Clear(Option_t* opt = "");
    Bool_t ReadAsciiFile(const Char_t* filename);
+   void AddGrids(const TCollection* grids);
    const TList* GetLastReadGrids() const
    {
-      // List containing grids created by most recent call to ReadAsciiFile
+      // List containing grids created by most recent call to ReadAsciiFile (or AddGrids)
       return &fLastReadGrids;
    }
    Int_t WriteAsciiFile(const Char_t* filename, const TCollection* selection = 0);
@@ -75,8 +82,16 @@ public:
 
    void Modified()
    {
+      GridsModified();
       Emit("Modified()");
    };                           // *SIGNAL*
+   static UInt_t GetModificationCount()
+   {
+      // Incremented each time a grid is added, removed or deleted, and each time the list of runs
+      // of any grid is changed (KVIDGraph::SetRuns()): if the value has not changed, the runs of
+      // all grids are the same as before.
+      return fgModifications;
+   }
 
    KVList* GetGridsForIDTelescope(const Char_t* label)
    {
@@ -355,6 +355,7 @@ void KVIDLine::ExecuteEvent(Int_t event, Int_t px, Int_t py)
             y = 0;
             break;
          }
+         PointsModified();
 
          // Compute x,y range
          xmin = gPad->GetUxmin();
@@ -235,6 +235,7 @@ void KVIDZAFromZGrid::Identify(Double_t x, Double_t y, KVIdentificationResult* i
    idr->Aident = idr->Zident = kFALSE;
 
    KVIDZAGrid::Identify(x, y, idr);
+   IdentificationContext& ctx = GetThreadContext(); // context used by KVIDZAGrid::Identify
    idr->Zident = kTRUE; // meaning Z identification was attempted, even if it failed
    if (!idr->IDOK) return;
 
@@ -247,24 +248,24 @@ void KVIDZAFromZGrid::Identify(Double_t x, Double_t y, KVIdentificationResult* i
       if (mass_id_success) {
          // mass identification was at least attempted
          // make sure grid's quality code is consistent with KVIdentificationResult
-         const_cast<KVIDZAFromZGrid*>(this)->fICode = idr->IDquality;
+         ctx.fICode = idr->IDquality;
          idr->Aident = kTRUE; // meaning A identification was attempted, even if it failed
       }
       else {
          // the pid falls outside of any mass ranges for a Z which has assigned isotopes
          // therefore although the Z identification was good, we cannot consider this
          // particle to be identified
-         const_cast<KVIDZAFromZGrid*>(this)->fICode = kICODE4;
-         idr->IDquality = fICode; // otherwise identfication result quality code is not coherent with comment (see below)
+         ctx.fICode = kICODE4;
+         idr->IDquality = ctx.fICode; // otherwise identfication result quality code is not coherent with comment (see below)
       }
-      idr->IDOK = (fICode < kICODE4);
+      idr->IDOK = (ctx.fICode < kICODE4);
    }
 
    // ignore isotopic successful isotopic identification if fIgnoreMassID=true
    if (fIgnoreMassID && idr->IDOK && idr->Aident) idr->Aident = false;
 
    // set comments in identification result
-   switch (fICode) {
+   switch (ctx.fICode) {
       case kICODE0:
          idr->SetComment("ok");
          break;
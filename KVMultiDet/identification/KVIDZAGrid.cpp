@@ -24,9 +24,53 @@ $Id: KVIDZAGrid.cpp,v 1.24 2009/05/05 15:57:52 franklan Exp $
 #include "TCanvas.h"
 #include "TROOT.h"
 #include "KVIdentificationResult.h"
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 ClassImp(KVIDZAGrid)
+
+namespace {
+   // Identification contexts of a thread, one for each grid it has used (see KVIDZAGrid::GetThreadContext()).
+   // Contexts are found from the unique identifier of each grid, which is never reused, and are erased
+   // from the contexts of all threads when the grid is deleted.
+   struct thread_contexts {
+      std::mutex mutex;// protects contexts against erasure by the destructor of a grid in another thread
+      std::unordered_map<ULong64_t, KVIDZAGrid::IdentificationContext> contexts;
+      std::atomic<ULong64_t> last_id;// identifier of grid whose context was last used by the thread (0 if none)
+      KVIDZAGrid::IdentificationContext* last;// context last used by the thread
+      thread_contexts();
+      ~thread_contexts();
+   };
+   // all existing thread_contexts objects (never deleted, as grids may be deleted after the end of main())
+   std::mutex& all_threads_mutex()
+   {
+      static std::mutex* m = new std::mutex;
+      return *m;
+   }
+   std::set<thread_contexts*>& all_threads()
+   {
+      static std::set<thread_contexts*>* s = new std::set<thread_contexts*>;
+      return *s;
+   }
+   thread_contexts::thread_contexts() : last_id(0), last(nullptr)
+   {
+      std::lock_guard<std::mutex> lock(all_threads_mutex());
+      all_threads().insert(this);
+   }
+   thread_contexts::~thread_contexts()
+   {
+      std::lock_guard<std::mutex> lock(all_threads_mutex());
+      all_threads().erase(this);
+   }
+   thread_local thread_contexts gThreadContexts;
+
+   std::atomic<ULong64_t> gNextGridId(1);
+}
+
 KVIDZAGrid::KVIDZAGrid()
+   : fGridId(gNextGridId++)
 {
    //default ctor.
    init();
@@ -35,9 +79,22 @@ KVIDZAGrid::KVIDZAGrid()
 KVIDZAGrid::~KVIDZAGrid()
 {
    //default dtor.
+   // The identification contexts of this grid are erased for all threads.
+
+   std::lock_guard<std::mutex> lock(all_threads_mutex());
+   for (std::set<thread_contexts*>::iterator it = all_threads().begin(); it != all_threads().end(); ++it) {
+      thread_contexts* tc = *it;
+      std::lock_guard<std::mutex> lock_tc(tc->mutex);
+      tc->contexts.erase(fGridId);
+      if (tc->last_id == fGridId) {
+         tc->last_id = 0;
+         tc->last = nullptr;
+      }
+   }
 }
 
 KVIDZAGrid::KVIDZAGrid(const KVIDZAGrid& grid)
+   : KVIDGrid(), fGridId(gNextGridId++)
 {
    //Copy constructor
    init();
@@ -66,14 +123,46 @@ void KVIDZAGrid::init()
    //initialisation
    fZMax = 0;
    fZMaxLine = 0;
+}
 
+//_________________________________________________________________________//
+
+void KVIDZAGrid::IdentificationContext::Reset()
+{
+   // Reset all working variables before a new identification
    kinfi = kinf = ksup = ksups = -1;
    dinf = dsup = dinfi = dsups = 0.;
    winf = wsup = winfi = wsups = 0.;
    Zinfi = Zinf = Zsup = Zsups = Ainfi = Ainf = Asup = Asups = 0;
+   Aint = Zint = 0;
    fDistanceClosest = -1.;
    fClosest = fLsups = fLsup = fLinf = fLinfi = 0;
    fIdxClosest = -1;
+   fICode = kICODE8;
+}
+
+//_________________________________________________________________________//
+
+KVIDZAGrid::IdentificationContext& KVIDZAGrid::GetThreadContext() const
+{
+   // Returns the identification context used by Identify() when called for this grid
+   // by the current thread. Each thread has its own context for each grid, therefore
+   // Identify() can be called concurrently for the same grid by different threads.
+   //
+   // After a call to Identify(), GetQualityCode(), GetClosestLine(), etc. return the
+   // values found by the last identification performed by the calling thread.
+   //
+   // Contexts are found from the unique identifier of each grid (never reused, even if a new grid
+   // is created at the address of a deleted one). The context last used by the thread is found without
+   // any lookup, so that GetQualityCode() etc. after Identify() cost nothing.
+   // The contexts of a grid are erased for all threads by its destructor.
+
+   thread_contexts& tc = gThreadContexts;
+   if (tc.last_id.load(std::memory_order_relaxed) == fGridId) return *tc.last;
+   std::lock_guard<std::mutex> lock(tc.mutex);
+   tc.last = &tc.contexts[fGridId];
+   tc.last_id.store(fGridId, std::memory_order_relaxed);
+   return *tc.last;
 }
 
 //_________________________________________________________________________//
@@ -419,7 +508,7 @@ void KVIDZAGrid::DrawLinesWithWidth()
 
 //______________________________________________________________________________________________//
 
-Bool_t KVIDZAGrid::FindFourEmbracingLines(Double_t x, Double_t y, const Char_t* position)
+Bool_t KVIDZAGrid::FindFourEmbracingLines(Double_t x, Double_t y, const Char_t* position, IdentificationContext& ctx) const
 {
    // This method will locate (at most) four lines close to the point (x,y), the point must
    // lie within the endpoints (in X) of each line (the lines "embrace" the point).
@@ -444,55 +533,55 @@ Bool_t KVIDZAGrid::FindFourEmbracingLines(Double_t x, Double_t y, const Char_t*
    // applied regarding the distances to these lines: the lines must have been sorted in order of increasing
    // ordinate before hand in Initialize(), we simply use the order of lines in the list of identifiers.
    // The Z, A, width and distance to each of these lines are stored in the variables
-   //      Zsups, Asups, wsups, dsups
-   // etc. etc. to be used by IdentZA or IdentZ.
+   //      ctx.Zsups, ctx.Asups, ctx.wsups, ctx.dsups
+   // etc. etc. of the IdentificationContext, to be used by IdentZA or IdentZ.
 
-   kinfi = kinf = ksup = ksups = -1;
-   dinf = dsup = dinfi = dsups = 0.;
-   winf = wsup = winfi = wsups = 16000.;
-   Zinfi = Zinf = Zsup = Zsups = Ainfi = Ainf = Asup = Asups = -1;
-   fDistanceClosest = -1.;
-   fClosest = fLsups = fLsup = fLinf = fLinfi = 0;
-   fIdxClosest = -1;
+   ctx.kinfi = ctx.kinf = ctx.ksup = ctx.ksups = -1;
+   ctx.dinf = ctx.dsup = ctx.dinfi = ctx.dsups = 0.;
+   ctx.winf = ctx.wsup = ctx.winfi = ctx.wsups = 16000.;
+   ctx.Zinfi = ctx.Zinf = ctx.Zsup = ctx.Zsups = ctx.Ainfi = ctx.Ainf = ctx.Asup = ctx.Asups = -1;
+   ctx.fDistanceClosest = -1.;
+   ctx.fClosest = ctx.fLsups = ctx.fLsup = ctx.fLinf = ctx.fLinfi = 0;
+   ctx.fIdxClosest = -1;
 
-   fClosest = FindNearestEmbracingIDLine(x, y, position, "x", fIdxClosest, kinf, ksup, fDistanceClosest, dinf, dsup);
+   ctx.fClosest = FindNearestEmbracingIDLine(x, y, position, "x", ctx.fIdxClosest, ctx.kinf, ctx.ksup, ctx.fDistanceClosest, ctx.dinf, ctx.dsup, ctx.fEmbracingLines);
 
-   if (!fClosest) return kFALSE; // no lines found
+   if (!ctx.fClosest) return kFALSE; // no lines found
 
    Int_t dummy = 0;
-   if (kinf > -1 && kinf == fIdxClosest) {
+   if (ctx.kinf > -1 && ctx.kinf == ctx.fIdxClosest) {
       //point is above closest line, closest line is "kinf"
       //need to look for 2 lines above (ksup, ksups) and 1 line below (kinfi)
-      fLinf = fClosest;
-      if (fLinf->InheritsFrom("KVIDZALine")) {
-         winf = ((KVIDZALine*)fLinf)->GetWidth();
-         Zinf = fLinf->GetZ();
-         Ainf = fLinf->GetA();
+      ctx.fLinf = ctx.fClosest;
+      if (ctx.fLinf->InheritsFrom("KVIDZALine")) {
+         ctx.winf = ((KVIDZALine*)ctx.fLinf)->GetWidth();
+         ctx.Zinf = ctx.fLinf->GetZ();
+         ctx.Ainf = ctx.fLinf->GetA();
       }
-      if (ksup > -1) {
-         fLsup = (KVIDLine*)GetIdentifierAt(ksup);
-         if (fLsup->InheritsFrom("KVIDZALine")) {
-            wsup = ((KVIDZALine*)fLsup)->GetWidth();
-            Zsup = fLsup->GetZ();
-            Asup = fLsup->GetA();
+      if (ctx.ksup > -1) {
+         ctx.fLsup = GetIdentificationLineAt(ctx.ksup);
+         if (ctx.fLsup->InheritsFrom("KVIDZALine")) {
+            ctx.wsup = ((KVIDZALine*)ctx.fLsup)->GetWidth();
+            ctx.Zsup = ctx.fLsup->GetZ();
+            ctx.Asup = ctx.fLsup->GetA();
          }
       }
    }
-   else if (ksup > -1 && ksup == fIdxClosest) {
+   else if (ctx.ksup > -1 && ctx.ksup == ctx.fIdxClosest) {
       //point is below closest line, closest line is "ksup"
       //need to look for 1 line above (ksups) and 2 lines below (kinf, kinfi)
-      fLsup = fClosest;
-      if (fLsup->InheritsFrom("KVIDZALine")) {
-         wsup = ((KVIDZALine*)fLsup)->GetWidth();
-         Zsup = fLsup->GetZ();
-         Asup = fLsup->GetA();
+      ctx.fLsup = ctx.fClosest;
+      if (ctx.fLsup->InheritsFrom("KVIDZALine")) {
+         ctx.wsup = ((KVIDZALine*)ctx.fLsup)->GetWidth();
+         ctx.Zsup = ctx.fLsup->GetZ();
+         ctx.Asup = ctx.fLsup->GetA();
       }
-      if (kinf > -1) {
-         fLinf = (KVIDLine*)GetIdentifierAt(kinf);
-         if (fLinf->InheritsFrom("KVIDZALine")) {
-            winf = ((KVIDZALine*)fLinf)->GetWidth();
-            Zinf = fLinf->GetZ();
-            Ainf = fLinf->GetA();
+      if (ctx.kinf > -1) {
+         ctx.fLinf = GetIdentificationLineAt(ctx.kinf);
+         if (ctx.fLinf->InheritsFrom("KVIDZALine")) {
+            ctx.winf = ((KVIDZALine*)ctx.fLinf)->GetWidth();
+            ctx.Zinf = ctx.fLinf->GetZ();
+            ctx.Ainf = ctx.fLinf->GetA();
          }
       }
    }
@@ -503,31 +592,31 @@ Bool_t KVIDZAGrid::FindFourEmbracingLines(Double_t x, Double_t y, const Char_t*
    }
 
 
-   if (kinf > -1) {
+   if (ctx.kinf > -1) {
       // look for kinfi line -> next line below 'inf' line
-      kinfi = kinf;
-      fLinfi = FindNextEmbracingLine(kinfi, -1, x, y, "x");
-      if (!fLinfi) kinfi = -1;   // no 'infi' line found
+      ctx.kinfi = ctx.kinf;
+      ctx.fLinfi = FindNextEmbracingLine(ctx.kinfi, -1, x, y, "x");
+      if (!ctx.fLinfi) ctx.kinfi = -1;   // no 'infi' line found
       else {
-         dinfi = TMath::Abs(fLinfi->DistanceToLine(x, y, dummy));
-         if (fLinfi->InheritsFrom("KVIDZALine")) {
-            winfi = ((KVIDZALine*)fLinfi)->GetWidth();
-            Zinfi = fLinfi->GetZ();
-            Ainfi = fLinfi->GetA();
+         ctx.dinfi = TMath::Abs(ctx.fLinfi->DistanceToLine(x, y, dummy));
+         if (ctx.fLinfi->InheritsFrom("KVIDZALine")) {
+            ctx.winfi = ((KVIDZALine*)ctx.fLinfi)->GetWidth();
+            ctx.Zinfi = ctx.fLinfi->GetZ();
+            ctx.Ainfi = ctx.fLinfi->GetA();
          }
       }
    }
-   if (ksup > -1) {
+   if (ctx.ksup > -1) {
       // look for ksups line -> next line above 'sup' line
-      ksups = ksup;
-      fLsups = FindNextEmbracingLine(ksups, 1, x, y, "x");
-      if (!fLsups) ksups = -1;   // no 'sups' line found
+      ctx.ksups = ctx.ksup;
+      ctx.fLsups = FindNextEmbracingLine(ctx.ksups, 1, x, y, "x");
+      if (!ctx.fLsups) ctx.ksups = -1;   // no 'sups' line found
       else {
-         dsups = TMath::Abs(fLsups->DistanceToLine(x, y, dummy));
-         if (fLsups->InheritsFrom("KVIDZALine")) {
-            wsups = ((KVIDZALine*)fLsups)->GetWidth();
-            Zsups = fLsups->GetZ();
-            Asups = fLsups->GetA();
+         ctx.dsups = TMath::Abs(ctx.fLsups->DistanceToLine(x, y, dummy));
+         if (ctx.fLsups->InheritsFrom("KVIDZALine")) {
+            ctx.wsups = ((KVIDZALine*)ctx.fLsups)->GetWidth();
+            ctx.Zsups = ctx.fLsups->GetZ();
+            ctx.Asups = ctx.fLsups->GetA();
          }
       }
    }
@@ -536,17 +625,18 @@ Bool_t KVIDZAGrid::FindFourEmbracingLines(Double_t x, Double_t y, const Char_t*
 
 //_________________________________________________________________________//
 
-void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
+void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A, IdentificationContext& ctx) const
 {
    //Finds Z, A and 'real A' for point (x,y) once closest lines to point have been found
-   //by calling method FindFourEmbracingLines beforehand.
+   //by calling method FindFourEmbracingLines beforehand with the same context 'ctx'.
+   //The quality code and the integer mass are stored in ctx.fICode and ctx.Aint.
    //This is a line-for-line copy of the latter part of IdnCsOr, even the same
    //variable names and comments have been used (as much as possible).
 
-   fICode = kICODE0;
+   ctx.fICode = kICODE0;
    Z = -1;
    A = -1;
-   Aint = 0;
+   ctx.Aint = 0;
    /*    cout << "kinfi = " << kinfi << " Zinfi = " << Zinfi << "  Ainfi = " << Ainfi << "  winfi = " << winfi << "  dinfi = " << dinfi << endl;
       cout << "kinf = " << kinf << " Zinf = " << Zinf << "  Ainf = " << Ainf << "  winf = " << winf << "  dinf = " << dinf << endl;
       cout << "ksup = " << ksup << " Zsup = " << Zsup << "  Asup = " << Asup << "  wsup = " << wsup << "  dsup = " << dsup << endl;
@@ -558,39 +648,39 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
    Int_t ix1, ix2;
    yy = y1 = y2 = 0;
    ix1 = ix2 = 0;
-   if (ksup > -1) {
-      if (kinf > -1) {
+   if (ctx.ksup > -1) {
+      if (ctx.kinf > -1) {
          //cout << " /******************* 2 lignes encadrant le point ont ete trouvees ************************/" << endl;
-         Double_t dt = dinf + dsup;     //distance between the 2 lines
-         if (Zinf == Zsup) {
+         Double_t dt = ctx.dinf + ctx.dsup;     //distance between the 2 lines
+         if (ctx.Zinf == ctx.Zsup) {
             //   cout << "      /****************meme Z**************/" << endl;
-            Z = Zinf;
-            Int_t dA = Asup - Ainf;
+            Z = ctx.Zinf;
+            Int_t dA = ctx.Asup - ctx.Ainf;
             Double_t dist = dt / dA;    //distance between the 2 lines normalised to difference in A of lines
             /*** A = Asup ***/
-            if (dinf > dsup) {  //point is closest to upper line, 'sup' line
+            if (ctx.dinf > ctx.dsup) {  //point is closest to upper line, 'sup' line
                ibif = 1;
-               k = ksup;
-               yy = -dsup;
-               A = Asup;
-               Aint = Asup;
-               if (ksups > -1) {        // there is a 'sups' line above the 2 which encadrent le point
-                  y2 = dsups - dsup;
-                  if (Zsups == Zsup) {
+               k = ctx.ksup;
+               yy = -ctx.dsup;
+               A = ctx.Asup;
+               ctx.Aint = ctx.Asup;
+               if (ctx.ksups > -1) {        // there is a 'sups' line above the 2 which encadrent le point
+                  y2 = ctx.dsups - ctx.dsup;
+                  if (ctx.Zsups == ctx.Zsup) {
                      ibif = 0;
                      y2 /= 2.;
-                     ix2 = Asups - Asup;
+                     ix2 = ctx.Asups - ctx.Asup;
                   }
                   else {
                      y2 /= 2.;
-                     Double_t x2 = wsup;
+                     Double_t x2 = ctx.wsup;
                      x2 = 0.5 * TMath::Max(x2, dist);
                      y2 = TMath::Min(y2, x2);
                      ix2 = 1;
                   }
                }
                else {         // ksups == -1 i.e. no 'sups' line
-                  y2 = wsup;
+                  y2 = ctx.wsup;
                   y2 = 0.5 * TMath::Max(y2, dist);
                   ix2 = 1;
                }
@@ -600,26 +690,26 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             /*** A = Ainf ***/
             else {              //point is closest to lower line, 'inf' line
                ibif = 2;
-               k = kinf;
-               yy = dinf;
-               A = Ainf;
-               Aint = Ainf;
-               if (kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent le point
-                  y1 = 0.5 * (dinfi - dinf);
-                  if (Zinfi == Zinf) {
+               k = ctx.kinf;
+               yy = ctx.dinf;
+               A = ctx.Ainf;
+               ctx.Aint = ctx.Ainf;
+               if (ctx.kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent le point
+                  y1 = 0.5 * (ctx.dinfi - ctx.dinf);
+                  if (ctx.Zinfi == ctx.Zinf) {
                      ibif = 0;
-                     ix1 = Ainfi - Ainf;
+                     ix1 = ctx.Ainfi - ctx.Ainf;
                      y1 = -y1;
                   }
                   else {
-                     Double_t x1 = winf;
+                     Double_t x1 = ctx.winf;
                      x1 = 0.5 * TMath::Max(x1, dist);
                      y1 = -TMath::Min(y1, x1);
                      ix1 = -1;
                   }
                }
                else {         // kinfi = -1 i.e. no 'infi' line
-                  y1 = winf;
+                  y1 = ctx.winf;
                   y1 = -0.5 * TMath::Max(y1, dist);
                   ix1 = -1;
                }
@@ -631,18 +721,18 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             //cout << "         /****************Z differents**************/ " << endl;
             /*** Z = Zsup ***/
             ibif = 3;
-            if (dinf > dsup) {  // closest to upper 'sup' line
-               k = ksup;
-               yy = -dsup;
-               Z = Zsup;
-               A = Asup;
-               Aint = Asup;
-               y1 = 0.5 * wsup;
-               if (ksups > -1) {        // there is a 'sups' line above the 2 which encadrent the point
-                  y2 = dsups - dsup;
-                  if (Zsups == Zsup) {
+            if (ctx.dinf > ctx.dsup) {  // closest to upper 'sup' line
+               k = ctx.ksup;
+               yy = -ctx.dsup;
+               Z = ctx.Zsup;
+               A = ctx.Asup;
+               ctx.Aint = ctx.Asup;
+               y1 = 0.5 * ctx.wsup;
+               if (ctx.ksups > -1) {        // there is a 'sups' line above the 2 which encadrent the point
+                  y2 = ctx.dsups - ctx.dsup;
+                  if (ctx.Zsups == ctx.Zsup) {
                      ibif = 2;
-                     ix2 = Asups - Asup;
+                     ix2 = ctx.Asups - ctx.Asup;
                      Double_t x1 = y2 / ix2 / 2.;
                      y1 = TMath::Max(y1, x1);
                      y1 = -TMath::Min(y1, dt / 2.);
@@ -658,7 +748,7 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
                   }
                }
                else {         // ksups == -1, i.e. no 'sups' line
-                  fICode = kICODE7;     //a gauche de la ligne fragment, Z est alors un Zmin et le plus probable
+                  ctx.fICode = kICODE7;     //a gauche de la ligne fragment, Z est alors un Zmin et le plus probable
                   y2 = y1;
                   ix2 = 1;
                   y1 = -TMath::Min(y1, dt / 2.);
@@ -667,17 +757,17 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             }
             /*** Z = Zinf ***/
             else {              // closest to lower 'inf' line
-               k = kinf;
-               yy = dinf;
-               Z = Zinf;
-               A = Ainf;
-               Aint = Ainf;
-               y2 = 0.5 * winf;
-               if (kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent the point
-                  y1 = dinfi - dinf;
-                  if (Zinfi == Zinf) {
+               k = ctx.kinf;
+               yy = ctx.dinf;
+               Z = ctx.Zinf;
+               A = ctx.Ainf;
+               ctx.Aint = ctx.Ainf;
+               y2 = 0.5 * ctx.winf;
+               if (ctx.kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent the point
+                  y1 = ctx.dinfi - ctx.dinf;
+                  if (ctx.Zinfi == ctx.Zinf) {
                      ibif = 1;
-                     ix1 = Ainfi - Ainf;
+                     ix1 = ctx.Ainfi - ctx.Ainf;
                      Double_t x2 = -y1 / ix1 / 2.;
                      y2 = TMath::Max(y2, x2);
                      y2 = TMath::Min(y2, dt / 2.);
@@ -700,20 +790,20 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             }
          }
       }//if(kinf>-1)...
-      else if (Zsup > 0) {
+      else if (ctx.Zsup > 0) {
          //cout<<" /****************** Seule une ligne superieure a ete trouvee *********************/" << endl;
          ibif = 3;
-         k = ksup;
-         yy = -dsup;
-         Z = Zsup;
-         A = Asup;
-         Aint = Asup;
-         y1 = 0.5 * wsup;
-         if (ksups > -1) {      // there is a 'sups' line above the closest line to the point
-            y2 = dsups - dsup;
-            if (Zsups == Zsup) {
+         k = ctx.ksup;
+         yy = -ctx.dsup;
+         Z = ctx.Zsup;
+         A = ctx.Asup;
+         ctx.Aint = ctx.Asup;
+         y1 = 0.5 * ctx.wsup;
+         if (ctx.ksups > -1) {      // there is a 'sups' line above the closest line to the point
+            y2 = ctx.dsups - ctx.dsup;
+            if (ctx.Zsups == ctx.Zsup) {
                ibif = 2;
-               ix2 = Asups - Asup;
+               ix2 = ctx.Asups - ctx.Asup;
                Double_t x1 = y2 / ix2 / 2.;
                y1 = -TMath::Max(y1, x1);
                ix1 = -1;
@@ -728,39 +818,39 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
             }
          }
          else {               // no 'sups' line above closest line
-            fICode = kICODE7;   //Z est alors un Zmin et le plus probable
+            ctx.fICode = kICODE7;   //Z est alors un Zmin et le plus probable
             y2 = y1;
             ix2 = 1;
             y1 = -y1;
             ix1 = -1;
          }
          if (yy >= y1)
-            fICode = kICODE0; // we are within the 'natural width' of the last line
+            ctx.fICode = kICODE0; // we are within the 'natural width' of the last line
          else {
-            fICode = kICODE6; // we are too far from first line to extrapolate correctly
-            Z = Zsup - 1; // give Z below first line of grid, but this is an upper limit
+            ctx.fICode = kICODE6; // we are too far from first line to extrapolate correctly
+            Z = ctx.Zsup - 1; // give Z below first line of grid, but this is an upper limit
          }
       }
       else {
-         fICode = kICODE8;      //  Z indetermine ou (x,y) hors limites
+         ctx.fICode = kICODE8;      //  Z indetermine ou (x,y) hors limites
       }
    }
-   else if (kinf > -1) {
+   else if (ctx.kinf > -1) {
 
       //cout <<"/****************** Seule une ligne inferieure a ete trouvee ***********************/" << endl;
 
       ibif = 3;
-      k = kinf;
-      Z = Zinf;
-      A = Ainf;
-      Aint = Ainf;
-      yy = dinf;
-      y2 = 0.5 * winf;
-      if (kinfi > -1) {
-         y1 = dinfi - dinf;
-         if (Zinfi == Zinf) {
+      k = ctx.kinf;
+      Z = ctx.Zinf;
+      A = ctx.Ainf;
+      ctx.Aint = ctx.Ainf;
+      yy = ctx.dinf;
+      y2 = 0.5 * ctx.winf;
+      if (ctx.kinfi > -1) {
+         y1 = ctx.dinfi - ctx.dinf;
+         if (ctx.Zinfi == ctx.Zinf) {
             ibif = 1;
-            ix1 = Ainfi - Ainf;
+            ix1 = ctx.Ainfi - ctx.Ainf;
             Double_t x2 = -y1 / ix1 / 2.;
             y2 = TMath::Max(y2, x2);
             ix2 = 1;
@@ -778,30 +868,30 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
          ix2 = 1;
       }
       if (yy <= y2)
-         fICode = kICODE0; // we are within the 'natural width' of the last line
+         ctx.fICode = kICODE0; // we are within the 'natural width' of the last line
       else
-         fICode = kICODE7; // we are too far from last line to extrapolate correctly
+         ctx.fICode = kICODE7; // we are too far from last line to extrapolate correctly
 
    }
    /*****************Aucune ligne n'a ete trouvee*********************************/
    else {
-      fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
+      ctx.fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
    }
    /****************Test des bornes********************************************/
-   if (k > -1 && fICode == kICODE0) {
+   if (k > -1 && ctx.fICode == kICODE0) {
       if (yy > y2)
-         fICode = kICODE4;      // Z ok, masse hors limite superieure ou egale a A
+         ctx.fICode = kICODE4;      // Z ok, masse hors limite superieure ou egale a A
    }
-   if (k > -1 && (fICode == kICODE0 || fICode == kICODE7)) {
+   if (k > -1 && (ctx.fICode == kICODE0 || ctx.fICode == kICODE7)) {
       if (yy < y1)
-         fICode = kICODE5;      // Z ok, masse hors limite inferieure ou egale a A
+         ctx.fICode = kICODE5;      // Z ok, masse hors limite inferieure ou egale a A
    }
-   if (fICode == kICODE4 || fICode == kICODE5) {
+   if (ctx.fICode == kICODE4 || ctx.fICode == kICODE5) {
       A = -1;
-      Aint = 0;
+      ctx.Aint = 0;
    }
    /****************Interpolation de la masse: da = f*log(1+b*dy)********************/
-   if (fICode == kICODE0) {
+   if (ctx.fICode == kICODE0) {
       Double_t deltaA = 0.;
       Bool_t i = kFALSE;
       Double_t dt, dist = y1 * y2;
@@ -857,18 +947,18 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
       }
    }
    /***************D'autres masses sont-elles possibles ?*************************/
-   if (fICode == kICODE0 && (ibif > 0 && ibif < 4)) {
+   if (ctx.fICode == kICODE0 && (ibif > 0 && ibif < 4)) {
       if (ibif != 2) {        /***Masse superieure***/
          //We look at next line in the complete list of lines, after the closest line.
          //If it has the same Z as the closest line, but was excluded from research for closest line
          //because the point lies outside the endpoints, there remains a doubt about the mass:
          //on rajoute 1 a fICode, effectivement on le met = kICODE1
-         Int_t idx = fIdxClosest; // index of closest line
-         if (idx > -1 && ++idx < GetNumberOfIdentifiers()) {
-            KVIDentifier* nextline = GetIdentifierAt(idx);
+         Int_t idx = ctx.fIdxClosest; // index of closest line
+         if (idx > -1 && ++idx < GetIdentificationLines()->GetEntries()) {
+            KVIDentifier* nextline = GetIdentificationLineAt(idx);
             if (nextline->GetZ() == Z
                   && !((KVIDLine*)nextline)->IsBetweenEndPoints(x, y, "x")) {
-               fICode++;        // Z ok, mais les masses superieures a A sont possibles
+               ctx.fICode++;        // Z ok, mais les masses superieures a A sont possibles
                //cout <<"//on rajoute 1 a fICode, effectivement on le met = kICODE1" << endl;
             }
          }
@@ -878,25 +968,25 @@ void KVIDZAGrid::IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A)
          //If it has the same Z as the closest line, but was excluded from research for closest line
          //because the point lies outside the endpoints, there remains a doubt about the mass:
          //on rajoute 2 a fICode, so it can be = kICODE2 or kICODE3
-         Int_t idx = fIdxClosest;
+         Int_t idx = ctx.fIdxClosest;
          if (idx > -1 && --idx >= 0) {
-            KVIDentifier* nextline = GetIdentifierAt(idx);
+            KVIDentifier* nextline = GetIdentificationLineAt(idx);
             if (nextline->GetZ() == Z
                   && !((KVIDLine*)nextline)->IsBetweenEndPoints(x, y, "x")) {
-               fICode += 2;
+               ctx.fICode += 2;
                //cout << "//on rajoute 2 a fICode, so it can be = kICODE2 or kICODE3" << endl;
             }
          }
       }
    }
 
-   if (fICode < kICODE4) ReCheckQuality(Z, A);
+   if (ctx.fICode < kICODE4) ReCheckQuality(Z, A, ctx);
 
 
    //cout << "Z = " << Z << " A = " << A << " icode = " << fICode << endl;
 }
 
-void KVIDZAGrid::ReCheckQuality(Int_t& Z, Double_t& A)
+void KVIDZAGrid::ReCheckQuality(Int_t& Z, Double_t& A, IdentificationContext& ctx) const
 {
    //Recheck the identification quality using the 'manual' width set for each Z in the parameter list
    //
@@ -926,10 +1016,10 @@ void KVIDZAGrid::ReCheckQuality(Int_t& Z, Double_t& A)
    int aa = TMath::Nint(A);
 
    KVNucleus nn(Z, aa);
-   if (nn.GetLifeTime() < 1e-9) fICode = kICODE5;
+   if (nn.GetLifeTime() < 1e-9) ctx.fICode = kICODE5;
 
 //   if (Z == 1 && aa == 1) da *= .75;
-   if (TMath::Abs(aa - A) > da) fICode = kICODE5;
+   if (TMath::Abs(aa - A) > da) ctx.fICode = kICODE5;
 }
 
 void KVIDZAGrid::SetManualWidth(Double_t manual_width, Double_t manual_width_scaling)
@@ -940,16 +1030,18 @@ void KVIDZAGrid::SetManualWidth(Double_t manual_width, Double_t manual_width_sca
 
 //_________________________________________________________________________//
 
-void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z)
+void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z, IdentificationContext& ctx) const
 {
-   // Finds Z & 'real Z' for point (x,y) once closest lines to point have been found (see GetNearestIDLine).
+   // Finds Z & 'real Z' for point (x,y) once closest lines to point have been found
+   // by calling method FindFourEmbracingLines beforehand with the same context 'ctx'.
+   // The quality code and the integer Z & A are stored in ctx.fICode, ctx.Zint and ctx.Aint.
    // This is is based on the algorithm developed by L. Tassan-Got in IdnCsOr, even the same
    // variable names and comments have been used (as much as possible).
 
-   fICode = kICODE0;
+   ctx.fICode = kICODE0;
    Z = -1;
-   Aint = 0;
-   Zint = 0;
+   ctx.Aint = 0;
+   ctx.Zint = 0;
    /*   cout << "kinfi = " << kinfi << " Zinfi = " << Zinfi << "  Ainfi = " << Ainfi << "  winfi = " << winfi << "  dinfi = " << dinfi << endl;
       cout << "kinf = " << kinf << " Zinf = " << Zinf << "  Ainf = " << Ainf << "  winf = " << winf << "  dinf = " << dinf << endl;
       cout << "ksup = " << ksup << " Zsup = " << Zsup << "  Asup = " << Asup << "  wsup = " << wsup << "  dsup = " << dsup << endl;
@@ -962,32 +1054,32 @@ void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z)
    yy = y1 = y2 = 0;
    ix1 = ix2 = 0;
 
-   if (ksup > -1) {         // there is a line above the point
-      if (kinf > -1) {              // there is a line below the point
+   if (ctx.ksup > -1) {         // there is a line above the point
+      if (ctx.kinf > -1) {              // there is a line below the point
 
          //printf("------------>/*  We found a line above and a line below the point */\n");
 
-         Double_t dt = dinf + dsup;     //distance between the 2 lines
-         Int_t dZ = Zsup - Zinf;
+         Double_t dt = ctx.dinf + ctx.dsup;     //distance between the 2 lines
+         Int_t dZ = ctx.Zsup - ctx.Zinf;
          Double_t dist = dt / (1.0 * dZ);  //distance between the 2 lines normalised to difference in Z of lines
 
          /*** Z = Zsup ***/
-         if (dinf > dsup) {  //point is closest to upper line, 'sup' line
+         if (ctx.dinf > ctx.dsup) {  //point is closest to upper line, 'sup' line
             ibif = 1;
-            k = ksup;
-            yy = -dsup;
-            Z = Zsup;
-            Zint = Zsup;
-            Aint = Asup;
-            if (ksups > -1) {        // there is a 'sups' line above the 2 which encadrent le point
-               y2 = dsups - dsup;
+            k = ctx.ksup;
+            yy = -ctx.dsup;
+            Z = ctx.Zsup;
+            ctx.Zint = ctx.Zsup;
+            ctx.Aint = ctx.Asup;
+            if (ctx.ksups > -1) {        // there is a 'sups' line above the 2 which encadrent le point
+               y2 = ctx.dsups - ctx.dsup;
 
                ibif = 0;
                y2 /= 2.;
-               ix2 = Zsups - Zsup;
+               ix2 = ctx.Zsups - ctx.Zsup;
             }
             else {         // ksups == -1 i.e. no 'sups' line
-               y2 = wsup;
+               y2 = ctx.wsup;
                y2 = 0.5 * TMath::Max(y2, dist);
                ix2 = 1;
             }
@@ -997,21 +1089,21 @@ void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z)
          /*** Z = Zinf ***/
          else {              //point is closest to lower line, 'inf' line
             ibif = 2;
-            k = kinf;
-            yy = dinf;
-            Z = Zinf;
-            Zint = Zinf;
-            Aint = Ainf;
-            if (kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent le point
-               y1 = 0.5 * (dinfi - dinf);
+            k = ctx.kinf;
+            yy = ctx.dinf;
+            Z = ctx.Zinf;
+            ctx.Zint = ctx.Zinf;
+            ctx.Aint = ctx.Ainf;
+            if (ctx.kinfi > -1) {        // there is a 'infi' line below the 2 which encadrent le point
+               y1 = 0.5 * (ctx.dinfi - ctx.dinf);
 
                ibif = 0;
-               ix1 = Zinfi - Zinf;
+               ix1 = ctx.Zinfi - ctx.Zinf;
                y1 = -y1;
 
             }
             else {         // kinfi = -1 i.e. no 'infi' line
-               y1 = winf;
+               y1 = ctx.winf;
                y1 = -0.5 * TMath::Max(y1, dist);
                ix1 = -1;
             }
@@ -1024,17 +1116,17 @@ void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z)
          //printf("------------>/*  Only a line above the point was found, no line below */\n");
          /* This means the point is below the first Z line of the grid (?) */
          ibif = 3;
-         k = ksup;
-         yy = -dsup;
-         Z = Zsup;
-         Zint = Zsup;
-         Aint = Asup;
-         y1 = 0.5 * wsup;
-         if (ksups > -1) {      // there is a 'sups' line above the closest line to the point
-            y2 = dsups - dsup;
+         k = ctx.ksup;
+         yy = -ctx.dsup;
+         Z = ctx.Zsup;
+         ctx.Zint = ctx.Zsup;
+         ctx.Aint = ctx.Asup;
+         y1 = 0.5 * ctx.wsup;
+         if (ctx.ksups > -1) {      // there is a 'sups' line above the closest line to the point
+            y2 = ctx.dsups - ctx.dsup;
 
             ibif = 2;
-            ix2 = Zsups - Zsup;
+            ix2 = ctx.Zsups - ctx.Zsup;
             Double_t x1 = y2 / ix2 / 2.;
             y1 = -TMath::Max(y1, x1);
             ix1 = -1;
@@ -1048,30 +1140,30 @@ void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z)
             ix1 = -1;
          }
          if (yy >= y1)
-            fICode = kICODE0; // we are within the 'natural width' of the last line
+            ctx.fICode = kICODE0; // we are within the 'natural width' of the last line
          else {
-            fICode = kICODE6; // we are too far from first line to extrapolate correctly
-            Z = Zsup - 1; // give Z below first line of grid, but this is an upper limit
-            Zint = Zsup - 1;
-            Aint = 0;
+            ctx.fICode = kICODE6; // we are too far from first line to extrapolate correctly
+            Z = ctx.Zsup - 1; // give Z below first line of grid, but this is an upper limit
+            ctx.Zint = ctx.Zsup - 1;
+            ctx.Aint = 0;
          }
       }
    }  //if(ksup>-1)***************************************************************
-   else if (kinf > -1) {
+   else if (ctx.kinf > -1) {
 
       //printf("------------>/*  Only a line below the point was found, no line above */\n");
       /* This means the point is above the last Z line of the grid (?) */
       ibif = 3;
-      k = kinf;
-      Z = Zinf;
-      Zint = Zinf;
-      Aint = Ainf;
-      yy = dinf;
-      y2 = 0.5 * winf;
-      if (kinfi > -1) { // there is a 'infi' line below the closest line to the point
-         y1 = dinfi - dinf;
+      k = ctx.kinf;
+      Z = ctx.Zinf;
+      ctx.Zint = ctx.Zinf;
+      ctx.Aint = ctx.Ainf;
+      yy = ctx.dinf;
+      y2 = 0.5 * ctx.winf;
+      if (ctx.kinfi > -1) { // there is a 'infi' line below the closest line to the point
+         y1 = ctx.dinfi - ctx.dinf;
          ibif = 1;
-         ix1 = Zinfi - Zinf;
+         ix1 = ctx.Zinfi - ctx.Zinf;
          Double_t x2 = -y1 / ix1 / 2.;
          y2 = TMath::Max(y2, x2);
          ix2 = 1;
@@ -1083,35 +1175,35 @@ void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z)
          ix2 = 1;
       }
       if (yy <= y2)
-         fICode = kICODE0; // we are within the 'natural width' of the last line
+         ctx.fICode = kICODE0; // we are within the 'natural width' of the last line
       else {
-         fICode = kICODE7; // we are too far from last line to extrapolate correctly
-         Z = Zinf + 1; // give Z above last line in grid, it is a lower limit
-         Zint = Zinf + 1;
-         Aint = 0;//calculate mass from Z
+         ctx.fICode = kICODE7; // we are too far from last line to extrapolate correctly
+         Z = ctx.Zinf + 1; // give Z above last line in grid, it is a lower limit
+         ctx.Zint = ctx.Zinf + 1;
+         ctx.Aint = 0;//calculate mass from Z
       }
 
    }
    /*no lines found at all*/
    else {
-      fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
+      ctx.fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
    }
 
 
    /****************Test des bornes********************************************/
-   if (k > -1 && fICode == kICODE0) {
+   if (k > -1 && ctx.fICode == kICODE0) {
       if (yy > y2)
-         fICode = kICODE4;      // Z ok, masse hors limite superieure ou egale a A
+         ctx.fICode = kICODE4;      // Z ok, masse hors limite superieure ou egale a A
    }
-   if (k > -1 && fICode == kICODE0) {
+   if (k > -1 && ctx.fICode == kICODE0) {
       if (yy < y1)
-         fICode = kICODE5;      // Z ok, masse hors limite inferieure ou egale a A
+         ctx.fICode = kICODE5;      // Z ok, masse hors limite inferieure ou egale a A
    }
-   if (fICode == kICODE4 || fICode == kICODE5) Aint = 0;
+   if (ctx.fICode == kICODE4 || ctx.fICode == kICODE5) ctx.Aint = 0;
 
    /****************Interpolation to find 'real Z': dz = f*log(1+b*dy)********************/
 
-   if (fICode < kICODE6) {
+   if (ctx.fICode < kICODE6) {
       Double_t deltaZ = 0.;
       Bool_t i = kFALSE;
       Double_t dt, dist = y1 * y2;
@@ -1167,18 +1259,18 @@ void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z)
       }
    }
    /***************Is there still a doubt about the Z ?*************************/
-   if (fICode == kICODE0 && (ibif > 0 && ibif < 4)) {
+   if (ctx.fICode == kICODE0 && (ibif > 0 && ibif < 4)) {
       /***z superieure***/
       if (ibif != 2) {
          //We look at next line in the complete list of lines, after the closest line.
          //If it was excluded from research for closest line
          //because the point lies outside the endpoints, there remains a doubt about the Z:
          //on rajoute 1 a fICode, effectivement on le met = kICODE1
-         Int_t idx = fIdxClosest;
-         if (idx > -1 && ++idx < GetNumberOfIdentifiers()) {
-            KVIDLine* nextline = (KVIDLine*)GetIdentifierAt(idx);
+         Int_t idx = ctx.fIdxClosest;
+         if (idx > -1 && ++idx < GetIdentificationLines()->GetEntries()) {
+            KVIDLine* nextline = GetIdentificationLineAt(idx);
             if (!nextline->IsBetweenEndPoints(x, y, "x")) {
-               fICode++;        // Z might be bigger than we think
+               ctx.fICode++;        // Z might be bigger than we think
                //cout <<"//on rajoute 1 a fICode, effectivement on le met = kICODE1" << endl;
             }
          }
@@ -1189,11 +1281,11 @@ void KVIDZAGrid::IdentZ(Double_t x, Double_t y, Double_t& Z)
          //If it was excluded from research for closest line
          //because the point lies outside the endpoints, there remains a doubt about the Z:
          //on rajoute 2 a fICode, so it can be = kICODE2 or kICODE3
-         Int_t idx = fIdxClosest;
+         Int_t idx = ctx.fIdxClosest;
          if (idx > -1 && --idx >= 0) {
-            KVIDLine* nextline = (KVIDLine*) GetIdentifierAt(idx);
+            KVIDLine* nextline = GetIdentificationLineAt(idx);
             if (!nextline->IsBetweenEndPoints(x, y, "x")) {
-               fICode += 2;
+               ctx.fICode += 2;
                //cout << "//on rajoute 2 a fICode, so it can be = kICODE2 or kICODE3" << endl;
             }
          }
@@ -1230,31 +1322,36 @@ void KVIDZAGrid::Identify(Double_t x, Double_t y, KVIdentificationResult* idr) c
    // (usual case), then particles between the two lines can have "real" masses
    // between 7.5 and 8.5, but their integer A will be =7 or =9, never 8.
    //
+   // This method does not modify the grid and can be called concurrently by several threads:
+   // all intermediate results are stored in the calling thread's IdentificationContext
+   // (see GetThreadContext()).
+   //
    idr->IDOK = kFALSE;
    idr->Aident = idr->Zident = kFALSE;
 
-   if (!const_cast<KVIDZAGrid*>(this)->FindFourEmbracingLines(x, y, "above")) {
+   IdentificationContext& ctx = GetThreadContext();
+   if (!FindFourEmbracingLines(x, y, "above", ctx)) {
       //no lines corresponding to point were found
-      const_cast < KVIDZAGrid* >(this)->fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
+      ctx.fICode = kICODE8;         // Z indetermine ou (x,y) hors limites
       idr->IDquality = kICODE8;
       idr->SetComment("no identification: (x,y) out of range covered by grid");
       return;
    }
    if (IsOnlyZId()) {
       Double_t Z;
-      const_cast < KVIDZAGrid* >(this)->IdentZ(x, y, Z);
-      idr->IDquality = fICode;
-      if (fICode < kICODE4 || fICode == kICODE7) {
+      IdentZ(x, y, Z, ctx);
+      idr->IDquality = ctx.fICode;
+      if (ctx.fICode < kICODE4 || ctx.fICode == kICODE7) {
          idr->Zident = kTRUE;
       }
-      if (fICode < kICODE4) {
+      if (ctx.fICode < kICODE4) {
          idr->IDOK = kTRUE;
       }
-      idr->Z = Zint;
+      idr->Z = ctx.Zint;
       idr->PID = Z;
-      idr->A = Aint;
+      idr->A = ctx.Aint;
 
-      switch (fICode) {
+      switch (ctx.fICode) {
          case kICODE0:
             idr->SetComment("ok");
             break;
@@ -1287,20 +1384,20 @@ void KVIDZAGrid::Identify(Double_t x, Double_t y, KVIdentificationResult* idr) c
 
       Int_t Z;
       Double_t A;
-      const_cast < KVIDZAGrid* >(this)->IdentZA(x, y, Z, A);
-      idr->IDquality = fICode;
+      IdentZA(x, y, Z, A, ctx);
+      idr->IDquality = ctx.fICode;
       idr->Z = Z;
       idr->PID = A;
 
-      if (fICode < kICODE4 || fICode == kICODE7) {
+      if (ctx.fICode < kICODE4 || ctx.fICode == kICODE7) {
          idr->Zident = kTRUE;
       }
-      idr->A = Aint;
-      if (fICode < kICODE4) {
+      idr->A = ctx.Aint;
+      if (ctx.fICode < kICODE4) {
          idr->Aident = kTRUE;
          idr->IDOK = kTRUE;
       }
-      switch (fICode) {
+      switch (ctx.fICode) {
          case kICODE0:
             idr->SetComment("ok");
             break;
@@ -13,6 +13,7 @@ $Id: KVIDZAGrid.h,v 1.14 2009/04/01 09:38:10 franklan Exp $
 
 #include "KVIDGrid.h"
 #include "TObjArray.h"
+#include <vector>
 
 class KVIDZALine;
 
@@ -27,7 +28,9 @@ particles (if lines for several isotopes of each atomic number are drawn), or so
 
 <h3>Identification quality codes</h3>
 After each identification attempt, the value returned by GetQualityCode() indicates whether the
-identification was successful or not. The meaning of the different codes depends on the type
+identification was successful or not (it refers to the last identification performed with the grid
+by the calling thread: Identify() does not modify the grid, and one grid can be used by several
+threads at the same time). The meaning of the different codes depends on the type
 of identification.
 
 <h4>Z & A (mass & charge) isotopic identification grid</h4>
@@ -68,31 +71,56 @@ protected:
 
    UShort_t fZMax;              //largest Z of lines in grid
    KVIDZALine*  fZMaxLine;//! line with biggest Z and A
+   ULong64_t fGridId;//! unique identifier of grid (never reused), used to find identification contexts
 
    void SetZmax(Int_t z)
    {
       fZMax = z;
    };
 
-   KVIDLine* fClosest;          //!closest line to last-identified point
-   KVIDLine* fLsups;//!
-   KVIDLine* fLsup;//!
-   KVIDLine* fLinf;//!
-   KVIDLine* fLinfi;//!
-   Double_t fDistanceClosest;   //!distance from point to closest line
-   Int_t fIdxClosest;         //!index of closest line in main list fIdentifiers
-   Int_t fICode;                //!code de retour
-
-   Int_t kinfi, kinf, ksup, ksups;//! used by IdentZA and IdentZ
-   Double_t dinf, dsup, dinfi, dsups;//!
-   Double_t winf, wsup, winfi, wsups;//!
-   Int_t Zinfi, Zinf, Zsup, Zsups;//!
-   Int_t Ainfi, Ainf, Asup, Asups;//!
-
-   Int_t Aint;//!mass of line used to identify particle
-   Int_t Zint;//!Z of line used to identify particle
-
-   virtual Bool_t FindFourEmbracingLines(Double_t x, Double_t y, const Char_t* position);
+public:
+   /**
+     \struct IdentificationContext
+     \brief Working variables of a single identification with a KVIDZAGrid
+
+     All quantities determined by FindFourEmbracingLines() and used by IdentZA() or IdentZ() are
+     stored in an object of this type supplied by the caller, so that the grid itself is never
+     modified during identification: one grid can be used by several threads at the same time,
+     as long as each thread uses its own context.
+    */
+   struct IdentificationContext {
+      KVIDLine* fClosest;          //closest line to last-identified point
+      KVIDLine* fLsups;
+      KVIDLine* fLsup;
+      KVIDLine* fLinf;
+      KVIDLine* fLinfi;
+      Double_t fDistanceClosest;   //distance from point to closest line
+      Int_t fIdxClosest;         //index of closest line in main list fIdentifiers
+      Int_t fICode;                //code de retour
+
+      Int_t kinfi, kinf, ksup, ksups;// used by IdentZA and IdentZ
+      Double_t dinf, dsup, dinfi, dsups;
+      Double_t winf, wsup, winfi, wsups;
+      Int_t Zinfi, Zinf, Zsup, Zsups;
+      Int_t Ainfi, Ainf, Asup, Asups;
+
+      Int_t Aint;//mass of line used to identify particle
+      Int_t Zint;//Z of line used to identify particle
+
+      EmbracingLines_t fEmbracingLines;//work array for KVIDGrid::FindNearestEmbracingIDLine
+
+      IdentificationContext()
+      {
+         Reset();
+      }
+      void Reset();
+   };
+
+protected:
+
+   IdentificationContext& GetThreadContext() const;
+
+   virtual Bool_t FindFourEmbracingLines(Double_t x, Double_t y, const Char_t* position, IdentificationContext& ctx) const;
    void init();
 
 public:
@@ -149,32 +177,35 @@ public:
    };
    virtual KVIDZALine* GetZALine(Int_t z, Int_t a, Int_t&) const;
 
-   virtual void IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A);
+   virtual void IdentZA(Double_t x, Double_t y, Int_t& Z, Double_t& A, IdentificationContext& ctx) const;
    virtual TClass* DefaultIDLineClass()
    {
       return TClass::GetClass("KVIDZALine");
    };
-   virtual void IdentZ(Double_t x, Double_t y, Double_t& Z);
+   virtual void IdentZ(Double_t x, Double_t y, Double_t& Z, IdentificationContext& ctx) const;
    Int_t GetQualityCode() const
    {
       // Return quality code for previously-attempted identification
       // Meanings of code values are given in class description
-      return fICode;
+      //
+      // The result refers to the last identification performed with this grid
+      // by the calling thread (see GetThreadContext()).
+      return GetThreadContext().fICode;
    };
 
    virtual void Identify(Double_t x, Double_t y, KVIdentificationResult*) const;
 
    inline KVIDLine* GetClosestLine() const
    {
-      return fClosest;
+      return GetThreadContext().fClosest;
    };
    inline Double_t GetDistanceClosestLine() const
    {
-      return fDistanceClosest;
+      return GetThreadContext().fDistanceClosest;
    };
    inline UChar_t GetIndexClosest() const
    {
-      return fIdxClosest;
+      return GetThreadContext().fIdxClosest;
    };
 
    //virtual void MakeEDeltaEZGrid(Int_t Zmin, Int_t Zmax, Int_t npoints=20, Double_t gamma = 2);//*MENU*
@@ -182,11 +213,11 @@ public:
    KVIDGraph* MakeSubsetGraph(Int_t Zmin, Int_t Zmax, const Char_t* /*graph_class*/ = ""); //*MENU*
    KVIDGraph* MakeSubsetGraph(TList*, TClass* /*graph_class*/ = 0);
 
-   void ReCheckQuality(Int_t& Z, Double_t& A);
+   void ReCheckQuality(Int_t& Z, Double_t& A, IdentificationContext& ctx) const;
 
    void SetManualWidth(Double_t manual_width = .3, Double_t manual_width_scaling = 0.05); //*MENU*
 
-   ClassDef(KVIDZAGrid, 2)     //Base class for 2D Z & A identification grids
+   ClassDef(KVIDZAGrid, 3)     //Base class for 2D Z & A identification grids
 };
 
 class KVIDZGrid : public KVIDZAGrid {
@@ -105,6 +105,16 @@ void KVIDentifier::SetParent(KVIDGraph* p)
 
 //_____________________________________________________________________________________________
 
+void KVIDentifier::PointsModified()
+{
+   // Call after modifying the coordinates of the points: the parent graph is informed
+   // (see KVIDGraph::IdentifierModified())
+
+   if (fParent) fParent->IdentifierModified();
+}
+
+//_____________________________________________________________________________________________
+
 void KVIDentifier::CopyGraph(TGraph* graph)
 {
    // Copy coordinates of points from the TGraph
@@ -116,6 +126,7 @@ void KVIDentifier::CopyGraph(TGraph* graph)
       graph->GetPoint(i, x, y);
       SetPoint(i, x, y);
    }
+   PointsModified();
 }
 
 //_____________________________________________________________________________________________
@@ -131,6 +142,7 @@ void KVIDentifier::CopyGraph(const TGraph& graph)
       graph.GetPoint(i, x, y);
       SetPoint(i, x, y);
    }
+   PointsModified();
 }
 
 //_____________________________________________________________________________________________
@@ -184,6 +196,7 @@ void KVIDentifier::ReadAsciiFile(ifstream& file)
       file >> x >> y;
       SetPoint(i, x, y);
    }
+   PointsModified();
 }
 
 //_____________________________________________________________________________________________
@@ -225,6 +238,7 @@ void KVIDentifier::Scale(Double_t sx, Double_t sy)
       if (sy > 0.)
          fY[i] *= sy;
    }
+   PointsModified();
 }
 
 //_____________________________________________________________________________________________
@@ -268,6 +282,7 @@ void KVIDentifier::Scale(TF1* sx, TF1* sy)
          else fY[ii] = sy->Eval(fY[ii]);
       }
    }
+   PointsModified();
 }
 
 //_____________________________________________________________________________________________
@@ -357,6 +372,7 @@ void KVIDentifier::ExtendLine(Double_t Limit, Option_t* Direction)
    if (ipoint > 0) ipoint = fNpoints - 1;
    fX[ipoint] = newX;
    fY[ipoint] = newY;
+   PointsModified();
    gPad->Modified();
 }
 
@@ -455,6 +471,7 @@ Int_t KVIDentifier::InsertPoint()
 
 //   Print("");
 
+   PointsModified();
    if (gPad) gPad->Modified();
 
    return ifound;
@@ -488,6 +505,7 @@ Int_t KVIDentifier::InsertSmoothPoint()
    for (Int_t ii = fNpoints - 2; ii >= ifound; ii -= 1) SetPoint(ii, fX[ii - 1], fY[ii - 1]);
 
    SetPoint(ifound, newX, newY);
+   PointsModified();
    if (gPad) gPad->Modified();
 
    return ifound;
@@ -544,6 +562,7 @@ Int_t KVIDentifier::ContinueDrawing()
    }
 
    delete gr;
+   PointsModified();
    gPad->Modified();
 
    return np;
@@ -596,6 +615,7 @@ Int_t KVIDentifier::AddPointAtTheEnd()
    Double_t newX = fX[np - 1] + deltaX;
    Double_t newY = aa * newX + bb;
    SetPoint(np, newX, newY);
+   PointsModified();
    if (gPad) gPad->Modified();
    return np + 1;
 
@@ -609,6 +629,7 @@ Int_t KVIDentifier::RemoveFirstPoint()
    if (fNpoints < 2) return -3;
 
    RemovePoint(0);
+   PointsModified();
    if (gPad) gPad->Modified();
    return fNpoints - 1;
 
@@ -623,6 +644,7 @@ Int_t KVIDentifier::RemoveLastPoint()
    if (fNpoints < 2) return -3;
 
    RemovePoint(GetN() - 1);
+   PointsModified();
    if (gPad) gPad->Modified();
    return fNpoints - 1;
 }
@@ -653,6 +675,7 @@ Int_t KVIDentifier::IncreaseNumberOfPoints()
    delete[] nX;
    delete[] nY;
 
+   PointsModified();
    if (gPad) gPad->Modified();
 
    return fNpoints;
@@ -684,6 +707,7 @@ Int_t KVIDentifier::DecreaseNumberOfPoints()
    delete[] nX;
    delete[] nY;
 
+   PointsModified();
    if (gPad) gPad->Modified();
 
    return fNpoints;
@@ -692,6 +716,7 @@ Int_t KVIDentifier::DecreaseNumberOfPoints()
 Int_t KVIDentifier::SortPoints(Bool_t ascending)
 {
    Sort(&TGraph::CompareX, ascending);
+   PointsModified();
    if (gPad) gPad->Modified();
    return 0;
 }
@@ -47,6 +47,7 @@ protected:
    {
       SetName(Form("Z=%d A=%d", GetZ(), GetA()));
    }
+   void PointsModified();
 
 private:
    void init();
@@ -123,6 +123,7 @@ void KVTGIDGrid::Generate(Double_t xmax, Double_t xmin, Int_t ID_min, Int_t ID_m
 
    // delete all previous identification lines
    fIdentifiers->Delete();
+   IdentifiersModified();
    fXmin = fYmin = fXmax = fYmax = 0;
 
    for (Int_t ID = ID_min; ID <= ID_max; ID++) {
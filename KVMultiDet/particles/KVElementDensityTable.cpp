@@ -14,6 +14,7 @@ KVElementDensityTable::KVElementDensityTable(): KVNuclDataTable("KVElementDensit
 {
    // Default constructor
    SetName("ElementDensity");
+   fIgnoreMass = kTRUE;
 }
 
 //________________________________________________________________
@@ -132,6 +133,7 @@ NDT::value* KVElementDensityTable::getNDTvalue(Int_t zz, Int_t aa) const
 KVElementDensity* KVElementDensityTable::FindElementByName(const Char_t* X) const
 {
    // Search table for an element with the given name. Case-insensitive.
+   LoadObjects();
    TString x = X;
    x.ToUpper();
    TIter next(tobj);
@@ -147,6 +149,7 @@ KVElementDensity* KVElementDensityTable::FindElementByName(const Char_t* X) cons
 KVElementDensity* KVElementDensityTable::FindElementBySymbol(const Char_t* X) const
 {
    // Search table for an element with the given symbol. Case-insensitive.
+   LoadObjects();
    TString x = X;
    x.ToUpper();
    TIter next(tobj);
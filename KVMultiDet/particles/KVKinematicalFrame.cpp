@@ -7,16 +7,18 @@
 ClassImp(KVKinematicalFrame)
 
 KVKinematicalFrame::KVKinematicalFrame(const Char_t* name, const KVParticle* original, const KVFrameTransform& trans)
-   : TNamed(name, "Kinematical frame"), fTransform(trans), fParticle((KVParticle*)original->IsA()->New())
+   : TNamed(name, "Kinematical frame"), fTransform(trans), fParticle((KVParticle*)original->IsA()->New()),
+     fOriginal(original), fUpToDate(kFALSE)
 {
    // Create representation of original particle in transformed frame
    // This frame has a name which can be used to retrieve it from a list
-
-   ReapplyTransform(original);
+   //
+   // The transformed particle is only calculated when first accessed with GetParticle()
 }
 
 KVKinematicalFrame::KVKinematicalFrame(const KVFrameTransform& trans, const KVParticle* original)
-   : TNamed(), fTransform(trans), fParticle((KVParticle*)original->IsA()->New())
+   : TNamed(), fTransform(trans), fParticle((KVParticle*)original->IsA()->New()),
+     fOriginal(original), fUpToDate(kFALSE)
 {
    // Create representation of original particle in transformed frame
 
@@ -24,7 +26,7 @@ KVKinematicalFrame::KVKinematicalFrame(const KVFrameTransform& trans, const KVPa
 }
 
 KVKinematicalFrame::KVKinematicalFrame(KVParticle* p, const KVFrameTransform& t)
-   : TNamed(), fTransform(t), fParticle(nullptr)
+   : TNamed(), fTransform(t), fParticle(nullptr), fOriginal(nullptr), fUpToDate(kTRUE)
 {
    // Modify the kinematics of the particle according to the given transformation
    // Recursively update the kinematics in all frames defined for this particle
@@ -34,7 +36,8 @@ KVKinematicalFrame::KVKinematicalFrame(KVParticle* p, const KVFrameTransform& t)
 
 KVKinematicalFrame::KVKinematicalFrame(const KVKinematicalFrame& o)
    : TNamed((const TNamed&)o), fTransform(o.fTransform),
-     fParticle(o.GetParticle() ? (KVParticle*)o.GetParticle()->IsA()->New() : nullptr)
+     fParticle(o.GetParticle() ? (KVParticle*)o.GetParticle()->IsA()->New() : nullptr),
+     fOriginal(o.fOriginal), fUpToDate(kTRUE)
 {
    // Copy constructor required for rootcint (not rootcling)
    if (GetParticle()) o.GetParticle()->Copy(*GetParticle());
@@ -46,17 +49,43 @@ KVKinematicalFrame& KVKinematicalFrame::operator=(const KVKinematicalFrame& o)
 
    if (&o == this) return (*this);
    fTransform = o.fTransform;
+   fOriginal = o.fOriginal;
+   fUpToDate = kTRUE;
    fParticle.reset(o.GetParticle() ? (KVParticle*)o.GetParticle()->IsA()->New() : nullptr);
    if (GetParticle()) o.GetParticle()->Copy(*GetParticle());
    return *this;
 }
 
+void KVKinematicalFrame::calculate() const
+{
+   // Calculate the transformed particle the first time it is accessed with GetParticle().
+   // If several threads access the frame at the same time, the first one does the
+   // calculation while the others wait for it to be finished.
+
+   std::lock_guard<std::mutex> lock(fMutex);
+   if (!fUpToDate.load(std::memory_order_relaxed))
+      const_cast<KVKinematicalFrame*>(this)->ReapplyTransform(fOriginal);
+}
+
 void KVKinematicalFrame::ReapplyTransform(const KVParticle* original)
 {
    // Apply stored kinematical transformation to the particle
 
    original->Copy(*(fParticle.get()));   //copy all information on particle
    fParticle->Transform(fTransform.Inverse());
+   fOriginal = original;
+   fUpToDate = kTRUE;
+}
+
+void KVKinematicalFrame::Reuse(const Char_t* name, const KVParticle* original, const KVFrameTransform& trans)
+{
+   // Recycle this frame (kept by a particle after KVParticle::Clear) as a new frame with the
+   // given name and transformation of the original particle, calculated when first accessed
+
+   SetName(name);
+   fTransform = trans;
+   fOriginal = original;
+   fUpToDate = kFALSE;
 }
 
 void KVKinematicalFrame::ApplyTransform(const KVParticle* original, const KVFrameTransform& trans)
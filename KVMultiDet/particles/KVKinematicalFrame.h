@@ -7,6 +7,8 @@
 #include "TNamed.h"
 #include "KVParticle.h"
 #include "KVFrameTransform.h"
+#include <atomic>
+#include <mutex>
 
 /**
 \class KVKinematicalFrame
@@ -16,11 +18,26 @@
  This class handles transformations between different reference frames for
  KVParticle kinematics. It is a utility class servicing the relevant methods in
  KVParticle.
+
+ When a new frame is defined for a particle (see KVParticle::SetFrame), the transformed
+ particle is only calculated the first time it is accessed with GetParticle(): frames which
+ are defined for all particles of an event but only used for some of them cost nothing more
+ than the storage of the transform. Frames are not deleted when a particle is cleared
+ (KVParticle::Clear), but kept by the particle for re-use, so that after the first few events
+ no new frames (or transformed particles) need to be allocated.
+
+ Several threads can access the same frame at the same time: the transformed particle is
+ calculated by only one of them, and is complete when the others use it.
 */
 
 class KVKinematicalFrame : public TNamed {
    KVFrameTransform       fTransform;    //! kinematical transform wrt 'parent' frame
    unique_ptr<KVParticle> fParticle;     //! kinematically transformed particle
+   const KVParticle*      fOriginal;     //! particle to transform when fParticle is not up to date
+   std::atomic<Bool_t>    fUpToDate;     //! kFALSE until transform is applied to fOriginal
+   mutable std::mutex     fMutex;        //! only one thread calculates fParticle when first accessed
+
+   void calculate() const;
 
 public:
    KVKinematicalFrame(const Char_t* name, const KVParticle* original, const KVFrameTransform& trans);
@@ -32,8 +49,21 @@ public:
 
    KVParticle* GetParticle() const
    {
+      // Returns the transformed particle, calculating it if not already done
+      if (!fUpToDate.load(std::memory_order_acquire)) calculate();
+      return fParticle.get();
+   }
+   KVParticle* GetCachedParticle() const
+   {
+      // Returns the transformed particle without calculating it if not already done:
+      // if IsUpToDate() returns kFALSE its kinematics are not valid
       return fParticle.get();
    }
+   Bool_t IsUpToDate() const
+   {
+      return fUpToDate;
+   }
+   void Reuse(const Char_t* name, const KVParticle* original, const KVFrameTransform& trans);
    const KVParticle* operator->() const
    {
       return (const KVParticle*)GetParticle();
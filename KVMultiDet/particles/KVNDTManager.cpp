@@ -8,6 +8,7 @@
 #include "KVBase.h"
 #include "Riostream.h"
 #include "TObjArray.h"
+#include "TEnv.h"
 
 ClassImp(KVNDTManager)
 
@@ -31,6 +32,9 @@ void KVNDTManager::init()
    // We automatically instantiate a data table of each class which is
    // declared as a "KVNuclDataTable" plugin
    // If a new class is added to the .kvrootrc, there is no need to alter the code.
+   //
+   // If KVNDTManager.BinaryCache is set to 'yes' in the .kvrootrc, each table is set up
+   // from its binary cache file if it exists and is up to date, and the cache is written otherwise.
 
    Arange = 0;
    Zrange = 0;
@@ -41,7 +45,18 @@ void KVNDTManager::init()
       Add((KVNuclDataTable*)TClass::GetClass(plugins.Next())->New());
    }
 
-   Execute("Initialize", "");
+   Bool_t use_cache = gEnv->GetValue("KVNDTManager.BinaryCache", kFALSE);
+   TIter next(this);
+   KVNuclDataTable* tab;
+   while ((tab = (KVNuclDataTable*)next())) {
+      if (use_cache && tab->ReadBinaryCache()) continue;
+      tab->Initialize();
+      tab->BuildDenseArrays();
+      if (use_cache) tab->WriteBinaryCache();
+   }
+
+   const Char_t* table_names[] = {"MassExcess", "LifeTime", "ChargeRadius", "Abundance", "ElementDensity", "SpinParity"};
+   for (int t = 0; t < kNumberOfTables; ++t) fTables[t] = GetTable(table_names[t]);
 
 }
 
@@ -5,8 +5,8 @@
 #define __KVNDTMANAGER_H
 
 #include "KVList.h"
+#include "KVNuclDataTable.h"
 
-class KVNuclDataTable;
 class KVNuclData;
 class TObjArray;
 
@@ -16,14 +16,43 @@ class TObjArray;
 \ingroup NucProp
 
 Allow to navigate between different tables of nuclear data
+
+Each table can be accessed by its name (e.g. `GetValue(z, a, "MassExcess")`), or, for the
+standard tables, using the corresponding ETable value, which avoids searching the list of
+tables by name for each call:
+~~~~{.cpp}
+gNDTManager->GetValue(z, a, KVNDTManager::kMassExcess);
+~~~~
+Values are retrieved from arrays indexed by (Z,A-Z) built when the tables are read
+(see KVNuclDataTable::BuildDenseArrays()).
+
+If the following variable is set in your `.kvrootrc`:
+~~~~
+KVNDTManager.BinaryCache:   yes
+~~~~
+these arrays are written to binary files in the KaliVeda working directory
+(`$HOME/.kaliveda/nucldata_cache`), which are read by later jobs instead of the data files
+(see KVNuclDataTable::ReadBinaryCache()).
 */
 
 class KVNDTManager : public KVList {
 
+public:
+   enum ETable {
+      kMassExcess,
+      kLifeTime,
+      kChargeRadius,
+      kAbundance,
+      kElementDensity,
+      kSpinParity,
+      kNumberOfTables
+   };
+
 protected:
    void init();
    TObjArray* Arange;
    TObjArray* Zrange;
+   KVNuclDataTable* fTables[kNumberOfTables];//! standard tables, indexed by ETable
 
 
 public:
@@ -40,6 +69,29 @@ public:
    const Char_t* GetUnit(Int_t zz, Int_t aa, const Char_t* name) const;
    void PrintTables() const;
 
+   KVNuclDataTable* GetTable(ETable t) const
+   {
+      // \returns standard table (nullptr if not available)
+      return fTables[t];
+   }
+   Bool_t IsInTable(Int_t zz, Int_t aa, ETable t) const
+   {
+      return (fTables[t] && fTables[t]->IsInTable(zz, aa));
+   }
+   Double_t GetValue(Int_t zz, Int_t aa, ETable t) const
+   {
+      // \returns value for nucleus (Z,A) in standard table, -555 if not in table, -666 if no table
+      return (fTables[t] ? fTables[t]->GetValue(zz, aa) : -666);
+   }
+   KVNuclData* GetData(Int_t zz, Int_t aa, ETable t) const
+   {
+      return (fTables[t] ? fTables[t]->GetData(zz, aa) : nullptr);
+   }
+   Bool_t IsMeasured(Int_t zz, Int_t aa, ETable t) const
+   {
+      return (fTables[t] && fTables[t]->IsMeasured(zz, aa));
+   }
+
    ClassDef(KVNDTManager, 1) //Allow to navigate between different tables of nuclear data
 };
 
@@ -2,6 +2,13 @@
 //Author: bonnet
 
 #include "KVNuclDataTable.h"
+#include "KVBase.h"
+#include "TEnv.h"
+#include "TSystem.h"
+#include "TMath.h"
+#include <fstream>
+#include <cstdio>
+#include <cstring>
 
 using namespace NDT;
 
@@ -48,6 +55,9 @@ void KVNuclDataTable::init()
    current_idx = 0;
    NbNuc = 0;
    kcomments = "";
+   fDenseZmax = fDenseNmax = -1;
+   fFromCache = kFALSE;
+   fIgnoreMass = kFALSE;
    SetName("NuclDataTable");
 
 }
@@ -66,6 +76,7 @@ void KVNuclDataTable::GiveIndexToNucleus(Int_t zz, Int_t aa, Int_t ntot)
 NDT::value* KVNuclDataTable::getNDTvalue(Int_t zz, Int_t aa) const
 {
    // Return NDT::value object pointer stored at map position (Z,A).
+   if (!nucMap) return 0;
    return (NDT::value*)nucMap->GetValue(Form("%d:%d", zz, aa));
 }
 
@@ -74,6 +85,10 @@ Bool_t KVNuclDataTable::IsInTable(Int_t zz, Int_t aa) const
 {
    // Returns kTRUE if there is a couple (Z,A) in the table.
 
+   if (HasDenseArrays()) {
+      Int_t pos = dense_position(zz, aa);
+      return (pos > -1 && (fDenseFlags[pos] & kDenseInTable));
+   }
    return (getNDTvalue(zz, aa) != 0);
 }
 
@@ -84,6 +99,11 @@ KVNuclData* KVNuclDataTable::GetData(Int_t zz, Int_t aa) const
    // Don't need to test its presence
    //returns 0 if no such object is present
 
+   LoadObjects();
+   if (HasDenseArrays()) {
+      Int_t pos = dense_position(zz, aa);
+      return (pos > -1 && fDenseIndex[pos] > -1 ? (KVNuclData*)tobj->UncheckedAt(fDenseIndex[pos]) : 0);
+   }
    NDT::value* val = getNDTvalue(zz, aa);
    if (val) return (KVNuclData*)tobj->At(val->Index());
    return 0;
@@ -98,6 +118,10 @@ Double_t KVNuclDataTable::GetValue(Int_t zz, Int_t aa) const
    // Don't need to test the presence of the object
    // returns -555 if no such object is present
 
+   if (HasDenseArrays()) {
+      Int_t pos = dense_position(zz, aa);
+      return (pos > -1 && (fDenseFlags[pos] & kDenseInTable) ? fDenseValue[pos] : -555);
+   }
    KVNuclData* nd = 0;
    if ((nd = GetData(zz, aa)))
       return nd->GetValue();
@@ -111,6 +135,7 @@ void KVNuclDataTable::SetValue(Int_t zz, Int_t aa, Double_t val)
    KVNuclData* nd = 0;
    if ((nd = GetData(zz, aa))) {
       nd->SetValue(val);
+      if (HasDenseArrays()) fDenseValue[dense_position(zz, aa)] = val;
    }
    else
       Error("SetValue", "No existing entry for this nucleus: Z=%d, A=%d", zz, aa);
@@ -142,6 +167,10 @@ Bool_t KVNuclDataTable::IsMeasured(Int_t zz, Int_t aa) const
    // Don't need to test the presence of the object
    // returns "NONE" if no such object is present
 
+   if (HasDenseArrays()) {
+      Int_t pos = dense_position(zz, aa);
+      return (pos > -1 && (fDenseFlags[pos] & kDenseMeasured));
+   }
    KVNuclData* nd = 0;
    if ((nd = GetData(zz, aa)))
       return nd->IsMeasured();
@@ -170,6 +199,7 @@ const Char_t*  KVNuclDataTable::GetReadFileName() const
 KVString KVNuclDataTable::GetCommentsFromFile() const
 {
 
+   LoadObjects();
    return kcomments;
 
 }
@@ -204,3 +234,213 @@ void KVNuclDataTable::InfoOnMeasured() const
 
 
 }
+
+//_____________________________________________
+void KVNuclDataTable::BuildDenseArrays()
+{
+   // Fill arrays indexed by (Z, N=A-Z) with the index, value and status of each nucleus
+   // in the table, which are then used by IsInTable(), GetValue(), IsMeasured() and GetData()
+   // instead of the (Z,A) map.
+   //
+   // This must be called after Initialize() (it is called by KVNDTManager for all its tables),
+   // and again if values of KVNuclData objects in the table are modified other than with SetValue().
+   //
+   // If any nucleus in the table cannot be indexed in this way (A<Z), the map is still used.
+
+   fDenseZmax = fDenseNmax = -1;
+   fDenseIndex.clear();
+   fDenseValue.clear();
+   fDenseFlags.clear();
+   if (!nucMap || !tobj) return;
+
+   std::vector<Int_t> zlist, alist, ilist;
+   Int_t zmax = -1, nmax = -1;
+   TIter next(nucMap);
+   TObject* key;
+   while ((key = next())) {
+      Int_t zz, aa;
+      if (sscanf(key->GetName(), "%d:%d", &zz, &aa) != 2 || zz < 0 || aa < zz) return;
+      zlist.push_back(zz);
+      alist.push_back(aa);
+      ilist.push_back(((NDT::value*)nucMap->GetValue(key))->Index());
+      zmax = TMath::Max(zmax, zz);
+      nmax = TMath::Max(nmax, aa - zz);
+   }
+   if (zmax < 0) return;
+
+   size_t size = (zmax + 1) * (nmax + 1);
+   fDenseIndex.assign(size, -1);
+   fDenseValue.assign(size, 0.);
+   fDenseFlags.assign(size, 0);
+   fDenseZmax = zmax;
+   fDenseNmax = nmax;
+   for (size_t i = 0; i < zlist.size(); ++i) {
+      KVNuclData* nd = (KVNuclData*)tobj->At(ilist[i]);
+      if (!nd) continue;
+      Int_t pos = zlist[i] * (nmax + 1) + alist[i] - zlist[i];
+      fDenseIndex[pos] = ilist[i];
+      fDenseValue[pos] = nd->GetValue();
+      fDenseFlags[pos] = kDenseInTable | (nd->IsMeasured() ? kDenseMeasured : 0);
+   }
+}
+
+//_____________________________________________
+Bool_t KVNuclDataTable::GetDataFilePath(TString& path) const
+{
+   // Full path to the data file for this table, given by variable [name].DataFile
+   // (returns kFALSE if file not found)
+
+   return KVBase::SearchKVFile(gEnv->GetValue(Form("%s.DataFile", GetName()), ""), path, "data");
+}
+
+//_____________________________________________
+TString KVNuclDataTable::GetBinaryCacheFile() const
+{
+   // Full path to binary cache file for this table (in the user's KaliVeda working directory)
+
+   return KVBase::GetWORKDIRFilePath(Form("nucldata_cache/%s.bin", GetName()));
+}
+
+namespace {
+   struct binary_cache_header {
+      // header of binary cache files for nuclear data tables
+      Char_t magic[8];
+      Int_t version;
+      Int_t zmax, nmax, nnuc, ignore_mass;
+      Long64_t source_size;
+      Long_t source_mtime;
+      Char_t source[1024];
+   };
+   const Char_t binary_cache_magic[8] = "KVNDTC";
+   const Int_t binary_cache_version = 1;
+
+   Bool_t fill_header(binary_cache_header& h, const TString& source)
+   {
+      // set header for given data file, kFALSE if file path too long or not accessible
+      FileStat_t fs;
+      if (source.Length() >= (Int_t)sizeof(h.source) || gSystem->GetPathInfo(source, fs)) return kFALSE;
+      memset(&h, 0, sizeof(h));
+      memcpy(h.magic, binary_cache_magic, sizeof(h.magic));
+      h.version = binary_cache_version;
+      h.source_size = fs.fSize;
+      h.source_mtime = fs.fMtime;
+      strcpy(h.source, source.Data());
+      return kTRUE;
+   }
+}
+
+//_____________________________________________
+Bool_t KVNuclDataTable::WriteBinaryCache() const
+{
+   // Write the dense arrays of the table (see BuildDenseArrays()) to the binary cache file
+   // which can be read by ReadBinaryCache() instead of reading the data file.
+   //
+   // The file is first written with a temporary name, then renamed, so that other
+   // processes never read a partially-written file.
+
+   if (!HasDenseArrays()) return kFALSE;
+   binary_cache_header h;
+   TString source;
+   if (!GetDataFilePath(source) || !fill_header(h, source)) return kFALSE;
+   h.zmax = fDenseZmax;
+   h.nmax = fDenseNmax;
+   h.nnuc = NbNuc;
+   h.ignore_mass = fIgnoreMass;
+
+   TString cache = GetBinaryCacheFile();
+   TString dir = gSystem->DirName(cache);
+   if (gSystem->AccessPathName(dir) && gSystem->mkdir(dir, kTRUE) < 0) return kFALSE;
+   TString tmp = Form("%s.%d", cache.Data(), gSystem->GetPid());
+   std::ofstream f(tmp.Data(), std::ios::binary);
+   if (!f.good()) return kFALSE;
+   f.write((const char*)&h, sizeof(h));
+   f.write((const char*)fDenseValue.data(), fDenseValue.size() * sizeof(Double_t));
+   f.write((const char*)fDenseFlags.data(), fDenseFlags.size() * sizeof(UChar_t));
+   f.close();
+   if (!f.good() || gSystem->Rename(tmp, cache)) {
+      gSystem->Unlink(tmp);
+      return kFALSE;
+   }
+   return kTRUE;
+}
+
+//_____________________________________________
+Bool_t KVNuclDataTable::ReadBinaryCache()
+{
+   // Set up the table from the binary cache file written by WriteBinaryCache(), if it
+   // exists and corresponds to the current version of the data file.
+   //
+   // Values can then be retrieved with GetValue(), IsInTable(), IsMeasured() without the data file
+   // ever being read: it will only be read to create the KVNuclData objects if/when they are needed.
+   //
+   // Returns kFALSE if the cache cannot be used, in which case Initialize() should be called.
+
+   binary_cache_header ref, h;
+   TString source;
+   if (!GetDataFilePath(source) || !fill_header(ref, source)) return kFALSE;
+   std::ifstream f(GetBinaryCacheFile().Data(), std::ios::binary);
+   if (!f.good()) return kFALSE;
+   f.read((char*)&h, sizeof(h));
+   if (!f.good() || memcmp(h.magic, ref.magic, sizeof(h.magic)) || h.version != ref.version
+         || h.source_size != ref.source_size || h.source_mtime != ref.source_mtime
+         || strcmp(h.source, ref.source) || h.ignore_mass != fIgnoreMass
+         || h.zmax < 0 || h.nmax < 0) return kFALSE;
+
+   size_t size = (h.zmax + 1) * (h.nmax + 1);
+   fDenseValue.resize(size);
+   fDenseFlags.resize(size);
+   f.read((char*)fDenseValue.data(), size * sizeof(Double_t));
+   f.read((char*)fDenseFlags.data(), size * sizeof(UChar_t));
+   if (!f.good()) {
+      fDenseValue.clear();
+      fDenseFlags.clear();
+      return kFALSE;
+   }
+   fDenseIndex.clear();
+   fDenseZmax = h.zmax;
+   fDenseNmax = h.nmax;
+   NbNuc = h.nnuc;
+   fFromCache = kTRUE;
+   SetTitle(gEnv->GetValue(Form("%s.DataFile", GetName()), ""));
+   return kTRUE;
+}
+
+//_____________________________________________
+void KVNuclDataTable::LoadObjects() const
+{
+   // If the table was set up from the binary cache, read the data file in order
+   // to create the KVNuclData objects.
+   //
+   // This is done the first time that GetData() (or any method using it) is called, possibly by
+   // several threads at the same time: only one of them reads the file, the others wait until it has finished.
+   // The values of the dense arrays, used by GetValue(), IsInTable() and IsMeasured() without the objects,
+   // are not modified, so that these methods can be called by other threads meanwhile.
+
+   if (!fFromCache.load(std::memory_order_acquire)) return;
+   std::lock_guard<std::mutex> lock(fLoadMutex);
+   if (!fFromCache.load(std::memory_order_relaxed)) return;
+   KVNuclDataTable* table = const_cast<KVNuclDataTable*>(this);
+   table->NbNuc = 0;
+   table->Initialize();
+   table->fill_dense_index();
+   fFromCache.store(kFALSE, std::memory_order_release);
+}
+
+void KVNuclDataTable::fill_dense_index()
+{
+   // Fill the indices of the KVNuclData objects of the dense arrays read from the binary cache,
+   // once the objects have been created (see LoadObjects())
+
+   std::vector<Int_t> index(fDenseValue.size(), -1);
+   if (nucMap) {
+      TIter next(nucMap);
+      TObject* key;
+      while ((key = next())) {
+         Int_t zz, aa;
+         if (sscanf(key->GetName(), "%d:%d", &zz, &aa) != 2 || zz < 0 || zz > fDenseZmax || aa < zz || aa - zz > fDenseNmax)
+            continue;
+         index[zz * (fDenseNmax + 1) + aa - zz] = ((NDT::value*)nucMap->GetValue(key))->Index();
+      }
+   }
+   fDenseIndex.swap(index);
+}
@@ -12,6 +12,9 @@
 
 #include "KVString.h"
 #include "KVNuclData.h"
+#include <vector>
+#include <atomic>
+#include <mutex>
 
 /**
   \namespace NDT
@@ -74,6 +77,19 @@ Specific implementations must define the methods:
    ~~~~
    For further detail see the KVLifeTimeTable and KVLifeTime class
 </ul>
+
+### Fast lookup
+Once the table has been read, BuildDenseArrays() fills arrays indexed by (Z, N=A-Z) with the
+value, status and index of each nucleus. These are used by IsInTable(), GetValue(), IsMeasured()
+and GetData() instead of the (Z,A) map (KVNDTManager calls it for all tables it manages).
+If the values of objects returned by GetData() are modified directly, i.e. not using SetValue(),
+BuildDenseArrays() must be called again.
+
+### Binary cache
+The dense arrays can also be written to/read from a binary file (see WriteBinaryCache() and
+ReadBinaryCache()), so that the data file does not need to be read when the table is set up.
+The KVNuclData objects are then only created (by reading the data file) the first time they
+are needed, e.g. by GetData() or GetUnit().
 */
 
 class KVNuclDataTable : public TNamed {
@@ -93,6 +109,36 @@ protected:
    TObjArray* tobj;  //! array where all nucldata objects are
    //TObjArray* tobj_rangeA;  //! array where range of A associated to each Z is stored via KVIntegerList
 
+   enum {
+      kDenseInTable = 1,
+      kDenseMeasured = 2
+   };
+   Int_t fDenseZmax;//! largest Z in dense arrays (-1 if not built)
+   Int_t fDenseNmax;//! largest N=A-Z in dense arrays
+   std::vector<Int_t> fDenseIndex;//! index in tobj of each (Z,N), -1 if not in table
+   std::vector<Double_t> fDenseValue;//! value for each (Z,N)
+   std::vector<UChar_t> fDenseFlags;//! kDenseInTable|kDenseMeasured for each (Z,N)
+   std::atomic<Bool_t> fFromCache;//! table read from binary cache, objects not yet created
+   mutable std::mutex fLoadMutex;//! only one thread creates the objects of a table read from binary cache
+   Bool_t fIgnoreMass;//! for tables which depend only on Z (A=2*Z+1 is used)
+
+   Int_t dense_position(Int_t zz, Int_t aa) const
+   {
+      // \returns position of (Z,A) in dense arrays, -1 if outside of arrays
+      if (fIgnoreMass) aa = 2 * zz + 1;
+      Int_t nn = aa - zz;
+      if (zz < 0 || nn < 0 || zz > fDenseZmax || nn > fDenseNmax) return -1;
+      return zz * (fDenseNmax + 1) + nn;
+   }
+   Bool_t HasDenseArrays() const
+   {
+      return fDenseZmax > -1;
+   }
+   void LoadObjects() const;
+   void fill_dense_index();
+   Bool_t GetDataFilePath(TString& path) const;
+   TString GetBinaryCacheFile() const;
+
    KVNuclData* GetCurrent() const
    {
       return (KVNuclData*)tobj->At(current_idx);
@@ -123,6 +169,10 @@ public:
    const Char_t*   GetReadFileName() const;
    KVString GetCommentsFromFile() const;
 
+   void BuildDenseArrays();
+   Bool_t ReadBinaryCache();
+   Bool_t WriteBinaryCache() const;
+
    ClassDef(KVNuclDataTable, 1) //Store information on nuclei
 
 };
@@ -612,7 +612,7 @@ Double_t KVNucleus::GetMassExcess(Int_t z, Int_t a) const
 
    CheckZAndA(z, a);
 
-   Double_t val = gNDTManager->GetValue(z, a, "MassExcess");
+   Double_t val = gNDTManager->GetValue(z, a, KVNDTManager::kMassExcess);
    if (val == -555) val = GetExtraMassExcess(z, a);
    else {
       // subtract electron mass from experimental atomic mass
@@ -653,7 +653,7 @@ KVMassExcess* KVNucleus::GetMassExcessPtr(Int_t z, Int_t a) const
    //If optional arguments (z,a) are given we return the value for the
    //required nucleus.
    CheckZAndA(z, a);
-   return (KVMassExcess*)gNDTManager->GetData(z, a, "MassExcess");
+   return (KVMassExcess*)gNDTManager->GetData(z, a, KVNDTManager::kMassExcess);
 
 }
 
@@ -666,7 +666,7 @@ KVSpinParity* KVNucleus::GetSpinParityPtr(Int_t z, Int_t a) const
    //If optional arguments (z,a) are given we return the value for the
    //required nucleus.
    CheckZAndA(z, a);
-   return (KVSpinParity*)gNDTManager->GetData(z, a, "SpinParity");
+   return (KVSpinParity*)gNDTManager->GetData(z, a, KVNDTManager::kSpinParity);
 
 }
 
@@ -681,7 +681,7 @@ Double_t KVNucleus::GetSpin(Int_t z, Int_t a) const
 
    CheckZAndA(z, a);
 
-   Double_t val = gNDTManager->GetValue(z, a, "SpinParity");
+   Double_t val = gNDTManager->GetValue(z, a, KVNDTManager::kSpinParity);
    if (val == -555)
       return -1;
    return TMath::Abs(val);
@@ -698,7 +698,7 @@ Double_t KVNucleus::GetParity(Int_t z, Int_t a) const
    //If the nucleus is not included in the mass table, O is returned
 
    CheckZAndA(z, a);
-   Double_t val = gNDTManager->GetValue(z, a, "SpinParity");
+   Double_t val = gNDTManager->GetValue(z, a, KVNDTManager::kSpinParity);
    if (val == -555)
       return 0;
    return TMath::Sign(-1.0, val);
@@ -742,7 +742,7 @@ KVLifeTime* KVNucleus::GetLifeTimePtr(Int_t z, Int_t a) const
    //required nucleus.
 
    CheckZAndA(z, a);
-   return (KVLifeTime*)gNDTManager->GetData(z, a, "LifeTime");
+   return (KVLifeTime*)gNDTManager->GetData(z, a, KVNDTManager::kLifeTime);
 
 }
 
@@ -828,7 +828,7 @@ KVChargeRadius* KVNucleus::GetChargeRadiusPtr(Int_t z, Int_t a) const
    //required nucleus.
 
    CheckZAndA(z, a);
-   return (KVChargeRadius*)gNDTManager->GetData(z, a, "ChargeRadius");
+   return (KVChargeRadius*)gNDTManager->GetData(z, a, KVNDTManager::kChargeRadius);
 
 }
 
@@ -841,7 +841,7 @@ Double_t KVNucleus::GetAbundance(Int_t z, Int_t a) const
    //required nucleus.
 
    CheckZAndA(z, a);
-   return TMath::Max(0.0, gNDTManager->GetValue(z, a, "Abundance"));
+   return TMath::Max(0.0, gNDTManager->GetValue(z, a, KVNDTManager::kAbundance));
 }
 
 //________________________________________________________________________________________
@@ -876,7 +876,7 @@ KVAbundance* KVNucleus::GetAbundancePtr(Int_t z, Int_t a) const
    //required nucleus.
 
    CheckZAndA(z, a);
-   return (KVAbundance*)gNDTManager->GetData(z, a, "Abundance");
+   return (KVAbundance*)gNDTManager->GetData(z, a, KVNDTManager::kAbundance);
 
 }
 
@@ -891,7 +891,7 @@ Bool_t KVNucleus::IsKnown(int z, int a) const
 
    CheckZAndA(z, a);
    //return fMassTable->IsKnown(z,a);
-   return gNDTManager->IsInTable(z, a, "MassExcess");
+   return gNDTManager->IsInTable(z, a, KVNDTManager::kMassExcess);
 }
 
 //________________________________________________________________________________________
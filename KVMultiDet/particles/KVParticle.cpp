@@ -25,6 +25,12 @@ $Id: KVParticle.cpp,v 1.50 2009/04/28 08:59:05 franklan Exp $
 #include "TObjString.h"
 #include "TClass.h"
 #include "KVKinematicalFrame.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 Double_t KVParticle::kSpeedOfLight = TMath::C() * 1.e-07;
 
@@ -32,6 +38,61 @@ using namespace std;
 
 ClassImp(KVParticle)
 
+namespace {
+   // Global registry of group names: each (upper-case) name is given a unique index
+   // the first time it is used, see KVParticle::GetGroupIndex().
+   //
+   // Lookups do not take any lock: they use the current table, which is never modified once published.
+   // Registering a new name (under the mutex) publishes a new table with the name added.
+   // Previous tables are kept until the end of the session, so that a table (and the names it contains)
+   // can still be used by another thread while a new one is published: as the number of different group
+   // names is small, so is the memory used.
+   struct KVParticleGroupTable {
+      std::unordered_map<std::string, Int_t> fIndex;
+      std::vector<std::string> fNames;
+   };
+   struct KVParticleGroupRegistry {
+      std::mutex fMutex;
+      std::vector<std::unique_ptr<KVParticleGroupTable> > fTables;// all tables ever published
+      std::atomic<const KVParticleGroupTable*> fCurrent;
+
+      KVParticleGroupRegistry()
+      {
+         fTables.emplace_back(new KVParticleGroupTable);
+         fCurrent.store(fTables.back().get());
+      }
+      const KVParticleGroupTable& table() const
+      {
+         return *fCurrent.load(std::memory_order_acquire);
+      }
+      Int_t find(const std::string& name) const
+      {
+         const KVParticleGroupTable& t = table();
+         auto it = t.fIndex.find(name);
+         return (it != t.fIndex.end() ? it->second : -1);
+      }
+      Int_t add(const std::string& name)
+      {
+         std::lock_guard<std::mutex> lock(fMutex);
+         const KVParticleGroupTable& t = table();
+         auto it = t.fIndex.find(name);
+         if (it != t.fIndex.end()) return it->second;
+         KVParticleGroupTable* nt = new KVParticleGroupTable(t);
+         Int_t index = nt->fNames.size();
+         nt->fNames.push_back(name);
+         nt->fIndex[name] = index;
+         fTables.emplace_back(nt);
+         fCurrent.store(nt, std::memory_order_release);
+         return index;
+      }
+   };
+   KVParticleGroupRegistry& group_registry()
+   {
+      static KVParticleGroupRegistry registry;
+      return registry;
+   }
+}
+
 
 
 KVParticle::KVParticle() : fParameters("ParticleParameters", "Parameters associated with a particle in an event")
@@ -46,6 +107,7 @@ void KVParticle::init()
    fE0 = 0;
    SetFrameName("");
    fGroups.SetOwner(kTRUE);
+   fGroupBits = 0;
 }
 
 //_________________________________________________________
@@ -83,6 +145,7 @@ KVParticle::~KVParticle()
 {
    //Info("~KVParticle","%p",this);
    Clear();
+   for (auto f : fUnusedFrames) delete f;
 }
 
 //________________________________________________________
@@ -231,7 +294,17 @@ void KVParticle::Clear(Option_t*)
    ResetBit(kIsDetected);
    fParameters.Clear();
    fGroups.Clear();
-   fBoosted.Delete();
+   fGroupBits = 0;
+   if (fBoosted.GetEntries()) {
+      // frames are kept for re-use by SetFrame()
+      TIter next(&fBoosted);
+      KVKinematicalFrame* f;
+      while ((f = (KVKinematicalFrame*)next())) {
+         f->GetCachedParticle()->Clear();
+         fUnusedFrames.push_back(f);
+      }
+      fBoosted.Clear("nodelete");
+   }
 }
 
 //_________________________________________________________________________________________________________
@@ -342,12 +415,15 @@ void KVParticle::AddGroup_Sanscondition(const Char_t* groupname, const Char_t* f
 
    if (BelongsToGroup(sfrom.Data()) && !BelongsToGroup(sgroupname.Data())) {
       fGroups.Add(new TObjString(sgroupname.Data()));
+      Int_t index = GetGroupIndex(sgroupname);
+      if (index < kMaxGroupBits) fGroupBits |= (1ULL << index);
       if (fBoosted.GetEntries()) {
          // recursively add to all boosted particles
+         // (frames which have not yet been calculated will copy the groups when they are)
          TIter it(&fBoosted);
          KVKinematicalFrame* f;
          while ((f = (KVKinematicalFrame*)it())) {
-            f->GetParticle()->AddGroup(sgroupname);
+            if (f->IsUpToDate()) f->GetParticle()->AddGroup(sgroupname);
          }
       }
    }
@@ -378,16 +454,17 @@ void KVParticle::AddGroup(const Char_t* groupname, KVParticleCondition* cond)
 }
 
 //___________________________________________________________________________//
-void KVParticle::SetGroups(KVUniqueNameList* un)
+void KVParticle::SetGroups(const KVUniqueNameList* un)
 {
    //Define for the particle a new list of groups
    //if there is an existing list, it's deleted
    fGroups.Clear();
+   fGroupBits = 0;
    AddGroups(un);
 }
 
 //___________________________________________________________________________//
-void KVParticle::AddGroups(KVUniqueNameList* un)
+void KVParticle::AddGroups(const KVUniqueNameList* un)
 {
    //list of groups added to the current one
    TObjString* os = 0;
@@ -409,7 +486,7 @@ Int_t KVParticle::GetNumberOfDefinedFrames()
    KVKinematicalFrame* p;
    Int_t nf = 0;
    while ((p = (KVKinematicalFrame*)it())) {
-      nf += (1 + p->GetParticle()->GetNumberOfDefinedFrames());
+      nf += (1 + p->GetCachedParticle()->GetNumberOfDefinedFrames());
    }
    return nf;
 }
@@ -421,10 +498,12 @@ Int_t KVParticle::GetNumberOfDefinedGroups(void)
 }
 
 //___________________________________________________________________________//
-KVUniqueNameList* KVParticle::GetGroups() const
+const KVUniqueNameList* KVParticle::GetGroups() const
 {
    //return the KVUniqueNameList pointeur where list of groups are stored
-   return (KVUniqueNameList*)&fGroups;
+   //
+   //The list cannot be modified directly: use AddGroup(), RemoveGroup(), etc.
+   return &fGroups;
 }
 
 //___________________________________________________________________________//
@@ -433,15 +512,56 @@ Bool_t KVParticle::BelongsToGroup(const Char_t* groupname) const
    //Check if particle belong to a given group
    //return kTRUE if groupname="".
    //return kFALSE if no group has be defined
+   //
+   //When the same group is tested for many particles, it is faster to use
+   //BelongsToGroupIndex() with the index given by GetGroupIndex()
 
-   TString sgroupname(groupname);
-   sgroupname.ToUpper();
    //Important for KVEvent::GetNextParticle()
-   if (sgroupname.IsNull()) return kTRUE;
+   if (!groupname || !groupname[0]) return kTRUE;
    //retourne kFALSE si aucun groupe n'est defini
    if (!fGroups.GetEntries()) return kFALSE;
-   if (fGroups.FindObject(sgroupname.Data())) return kTRUE;
-   return kFALSE;
+   //a name which was never registered cannot have been added to any particle
+   return BelongsToGroupIndex(FindGroupIndex(groupname));
+}
+
+//___________________________________________________________________________//
+Int_t KVParticle::GetGroupIndex(const Char_t* groupname)
+{
+   // Return the unique index associated with the given group name (case insensitive).
+   // If the name has never been used before, it is registered with a new index.
+   // Indices are global, i.e. the same for all particles, and never change during a session.
+   //
+   // Use with BelongsToGroupIndex() for fast tests of group membership.
+
+   TString sgroupname(groupname);
+   sgroupname.ToUpper();
+   KVParticleGroupRegistry& reg = group_registry();
+   Int_t index = reg.find(sgroupname.Data());
+   return (index > -1 ? index : reg.add(sgroupname.Data()));
+}
+
+//___________________________________________________________________________//
+Int_t KVParticle::FindGroupIndex(const Char_t* groupname)
+{
+   // Return the index associated with the given group name (case insensitive),
+   // or -1 if no particle was ever added to a group with this name.
+   //
+   // No lock is taken, so this can be used by many threads at once.
+
+   TString sgroupname(groupname);
+   sgroupname.ToUpper();
+   return group_registry().find(sgroupname.Data());
+}
+
+//___________________________________________________________________________//
+const Char_t* KVParticle::GetGroupName(Int_t index)
+{
+   // Return the (upper-case) name of the group with the given index (see GetGroupIndex()),
+   // or "" if index is not valid.
+
+   const KVParticleGroupTable& t = group_registry().table();
+   if (index < 0 || index >= (Int_t)t.fNames.size()) return "";
+   return t.fNames[index].c_str();
 }
 
 //___________________________________________________________________________//
@@ -456,11 +576,13 @@ void KVParticle::RemoveGroup(const Char_t* groupname)
    TObjString* os = 0;
    if ((os = (TObjString*)fGroups.FindObject(sgroupname.Data()))) {
       delete fGroups.Remove(os);
+      Int_t index = FindGroupIndex(sgroupname);
+      if (index >= 0 && index < kMaxGroupBits) fGroupBits &= ~(1ULL << index);
       if (fBoosted.GetEntries()) {
          TIter it(&fBoosted);
          KVKinematicalFrame* f;
          while ((f = (KVKinematicalFrame*)it())) {
-            f->GetParticle()->RemoveGroup(sgroupname);
+            if (f->IsUpToDate()) f->GetParticle()->RemoveGroup(sgroupname);
          }
       }
    }
@@ -472,11 +594,12 @@ void KVParticle::RemoveAllGroups()
    //Remove all groups
    // Apply the method to all particles stored in fBoosted
    fGroups.Clear();
+   fGroupBits = 0;
    if (fBoosted.GetEntries()) {
       TIter it(&fBoosted);
       KVKinematicalFrame* f;
       while ((f = (KVKinematicalFrame*)it())) {
-         f->GetParticle()->RemoveAllGroups();
+         if (f->IsUpToDate()) f->GetParticle()->RemoveAllGroups();
       }
    }
 }
@@ -531,6 +654,8 @@ void KVParticle::ChangeDefaultFrame(const Char_t* newdef, const Char_t* defname)
 
    TString _defname(defname);
    if (_defname == "") _defname = GetFrameName();
+   // calculate kinematics in all frames before modifying tree structure
+   evaluate_all_frames();
    // get list of all parents of new default
    TList parents;
    TString ff = newdef;
@@ -641,7 +766,8 @@ void KVParticle::SetFrame(const Char_t* frame, const KVFrameTransform& ft)
    KVKinematicalFrame* tmp = get_frame(frame);
    if (!tmp) {
       //if this frame has not already been defined, create a new one
-      tmp = new KVKinematicalFrame(frame, this, ft);
+      //(kinematics will be calculated when first accessed)
+      tmp = new_frame(frame, ft);
       fBoosted.Add(tmp);
    }
    else
@@ -661,9 +787,11 @@ KVParticle const* KVParticle::GetFrame(const Char_t* frame, Bool_t warn_and_retu
    // particle (using SetFrame(newframe,...)) or by a transformation of the kinematics in another
    // user-defined frame (using SetFrame(newframe,oldframe,...)).
    //
-   // Note that frames are not "dynamic": if any changes are made to the original particle's kinematics
-   // after definition of a frame, if you want these changes to affect also the other frames you
-   // need to update them by hand by calling KVParticle::UpdateAllFrames().
+   // The kinematics in a frame are calculated the first time it is accessed after SetFrame(), using the
+   // current kinematics of the original particle. After this, frames are not "dynamic": if any changes are
+   // made to the original particle's kinematics, if you want these changes to affect also the frames
+   // which have already been accessed you need to update them by hand by calling KVParticle::UpdateAllFrames().
+   // The first access to a frame can be made by several threads at the same time.
    //
    // Frame names are case insensitive: "CM" or "cm" or "Cm" are all good...
    //
@@ -705,11 +833,15 @@ void KVParticle::UpdateAllFrames()
 {
    // Call this method to update particle kinematics in all defined frames if you change
    // the kinematics of the particle in its original/default frame.
+   //
+   // Frames which have not yet been accessed are left as they are: their kinematics will
+   // be calculated from the current kinematics when they are.
 
    if (fBoosted.GetEntries()) {
       TIter it(&fBoosted);
       KVKinematicalFrame* f;
       while ((f = (KVKinematicalFrame*)it())) {
+         if (!f->IsUpToDate()) continue;
          f->ReapplyTransform(this);
          // recursively apply to all subframes
          f->GetParticle()->UpdateAllFrames();
@@ -733,7 +865,7 @@ KVKinematicalFrame* KVParticle::get_frame(const Char_t* frame) const
    while ((p = f = (KVKinematicalFrame*)it())) {
       if (!_frame.CompareTo(p->GetName(), TString::kIgnoreCase)) break;
       // look for subframe
-      if ((f = p->GetParticle()->get_frame(_frame))) break;
+      if ((f = p->GetCachedParticle()->get_frame(_frame))) break;
    }
    return f;
 }
@@ -752,12 +884,39 @@ KVKinematicalFrame* KVParticle::get_parent_frame(const Char_t* f, KVKinematicalF
    while ((p = (KVKinematicalFrame*)it())) {
       if (!_frame.CompareTo(p->GetName(), TString::kIgnoreCase)) return F;
       // look for subframe
-      if ((r = p->GetParticle()->get_parent_frame(_frame, p))) return r;
+      if ((r = p->GetCachedParticle()->get_parent_frame(_frame, p))) return r;
    }
    return nullptr;
 }
 
 
+KVKinematicalFrame* KVParticle::new_frame(const Char_t* frame, const KVFrameTransform& ft)
+{
+   // PRIVATE method for internal use only
+   // Returns a new frame for this particle, re-using one kept by Clear() if possible
+
+   while (fUnusedFrames.size()) {
+      KVKinematicalFrame* f = fUnusedFrames.back();
+      fUnusedFrames.pop_back();
+      if (f->GetCachedParticle()->IsA() == IsA()) {
+         f->Reuse(frame, this, ft);
+         return f;
+      }
+      delete f;
+   }
+   return new KVKinematicalFrame(frame, this, ft);
+}
+
+void KVParticle::evaluate_all_frames() const
+{
+   // PRIVATE method for internal use only
+   // Calculate kinematics in all frames which have not yet been accessed
+
+   TIter it(&fBoosted);
+   KVKinematicalFrame* f;
+   while ((f = (KVKinematicalFrame*)it())) f->GetParticle()->evaluate_all_frames();
+}
+
 //___________________________________________________________________________//
 
 void KVParticle::SetFrame(const Char_t* newframe, const Char_t* oldframe, const KVFrameTransform& ft)
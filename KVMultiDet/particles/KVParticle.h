@@ -30,6 +30,7 @@ $Id: KVParticle.h,v 1.41 2008/05/21 13:19:56 ebonnet Exp $
 #include "TObjString.h"
 #include "KVNameValueList.h"
 #include "KVFrameTransform.h"
+#include <vector>
 
 class KVKinematicalFrame;
 class KVParticleCondition;
@@ -363,6 +364,14 @@ KVNameValueList::ParticleParameters : Parameters associated with a particle in a
  <frameName=lab>
 ~~~~~~~~~~~~~~~~~~
 
+#### 6. Performance
+The kinematics of the particle in a frame defined with SetFrame() are only calculated the first time
+that the frame is accessed (with GetFrame(), Print(), etc.), so that defining frames for all
+particles in an event (see KVEvent::SetFrame) costs very little for particles which are not then
+looked at in these frames. Clear() does not delete the frames of a particle, which are re-used by
+the next calls to SetFrame(): particles in an event which is cleared and filled again for each
+new event (such as KVEvent) do not need to allocate new frames after the first events.
+
 ### Definition of groups
 AddGroup() and BelongsToGroup() methods allow to sort particles in an event into subsets
 based on various criteria such as "emitted by QP", "backwards emitted", or "include in calorimetry".
@@ -393,6 +402,18 @@ On the contrary if some change is made in the following way :
 part.GetFrame("CM")->AddGroup("titi");
 part.GetFrame("CM")->BelongsToGroup("titi");// this returns kTRUE
 part.BelongsToGroup("titi");// this returns kFALSE
+~~~~~~~~~~~~~~~
+
+Each different group name is given a unique integer index the first time it is used (see GetGroupIndex()),
+which is the same for all particles. Membership of the first KVParticle::kMaxGroupBits groups defined in this way
+is stored as a bitmask in each particle, so that BelongsToGroup() does not need to search through the list of group names.
+When the same group is tested for many particles (e.g. in a loop over an event), the index can be looked up once and
+for all and BelongsToGroupIndex() used instead, which avoids any string manipulation
+(looking up the index of a known group name never takes a lock, and can be done by many threads at once):
+
+~~~~~~~~~~~~~~~{.cpp}
+Int_t qp = KVParticle::GetGroupIndex("QP");
+for(auto& n : event) if(n.BelongsToGroupIndex(qp)) { ... }
 ~~~~~~~~~~~~~~~
  */
 class KVParticle: public TLorentzVector {
@@ -401,11 +422,15 @@ private:
    void print_frames(TString fmt = "") const;
    KVKinematicalFrame* get_frame(const Char_t*) const;
    KVKinematicalFrame* get_parent_frame(const Char_t*, KVKinematicalFrame* F = nullptr) const;
+   KVKinematicalFrame* new_frame(const Char_t*, const KVFrameTransform&);
+   void evaluate_all_frames() const;
 
    TString fName;                       //!non-persistent name field - Is useful
    TString fFrameName;                  //!non-persistent frame name field, sets when calling SetFrame method
    KVList fBoosted;                     //!list of momenta of the particle in different Lorentz-boosted frames
+   std::vector<KVKinematicalFrame*> fUnusedFrames;//!frames kept after Clear() for re-use by SetFrame()
    KVUniqueNameList fGroups;            //!list of TObjString for manage different group name
+   ULong64_t fGroupBits;                //!bit i is set if particle belongs to group with index i (see GetGroupIndex)
    static Double_t kSpeedOfLight;       //speed of light in cm/ns
 
    // TLorentzVector setters should not be used
@@ -486,8 +511,8 @@ protected:
    virtual void AddGroup_Withcondition(const Char_t*, KVParticleCondition*);
    virtual void AddGroup_Sanscondition(const Char_t* groupname, const Char_t* from = "");
    void CreateGroups();
-   void SetGroups(KVUniqueNameList* un);
-   void AddGroups(KVUniqueNameList* un);
+   void SetGroups(const KVUniqueNameList* un);
+   void AddGroups(const KVUniqueNameList* un);
 
 public:
 
@@ -501,13 +526,16 @@ public:
    }
    Int_t GetNumberOfDefinedFrames(void);
    Int_t GetNumberOfDefinedGroups(void);
-   KVUniqueNameList* GetGroups() const;
+   const KVUniqueNameList* GetGroups() const;
 
    enum {
       kIsOK = BIT(14),          //acceptation/rejection flag
       kIsOKSet = BIT(15),       //flag to indicate flag is set
       kIsDetected = BIT(16)     //flag set when particle is slowed by some KVMaterial
    };
+   enum {
+      kMaxGroupBits = 64        //number of groups whose membership is stored in fGroupBits
+   };
 
    static Double_t C();
 
@@ -707,6 +735,17 @@ public:
    void AddGroup(const Char_t* groupname, KVParticleCondition*);
 
    Bool_t BelongsToGroup(const Char_t* groupname) const;
+   Bool_t BelongsToGroupIndex(Int_t index) const
+   {
+      // Check if particle belongs to the group with the given index, as returned by GetGroupIndex().
+      // Returns kFALSE for index<0.
+      if (index < 0) return kFALSE;
+      if (index < kMaxGroupBits) return (fGroupBits >> index) & 1;
+      return fGroups.GetEntries() && fGroups.FindObject(GetGroupName(index));
+   }
+   static Int_t GetGroupIndex(const Char_t* groupname);
+   static Int_t FindGroupIndex(const Char_t* groupname);
+   static const Char_t* GetGroupName(Int_t index);
    void RemoveGroup(const Char_t* groupname);
    void RemoveAllGroups();
    void ListGroups(void) const;
@@ -12,9 +12,19 @@ $Date: 2007/03/26 10:14:56 $
 #include "Riostream.h"
 #include "TSystem.h"
 #include "KVClassFactory.h"
-#include "TPluginManager.h"
 #include "TUUID.h"
+#include "TEnv.h"
+#include "TMD5.h"
+#include "TClass.h"
+#include "TMethodCall.h"
+#include "TFunction.h"
+#include "TMath.h"
+#include "KVLockfile.h"
 #include <utility>
+#include <cctype>
+#include <cstring>
+#include <cmath>
+#include <memory>
 
 using namespace std;
 
@@ -22,6 +32,417 @@ ClassImp(KVParticleCondition)
 
 KVHashList KVParticleCondition::fgOptimized;
 
+#ifdef USING_ROOT6
+namespace {
+   class condition_interpreter {
+      // Recursive-descent parser turning the pseudo-code of a KVParticleCondition into a
+      // tree of lambdas, so that it can be evaluated without any compilation.
+      //
+      // Handles numbers, true/false, arithmetic, comparison and logical operators, brackets,
+      // the most common mathematical functions (TMath:: or std::), and chains of method calls
+      // (with literal arguments) on _NUC_ which are executed using TMethodCall.
+
+      using value_func = std::function<double(const KVNucleus*)>;
+      struct method_call {
+         std::shared_ptr<TMethodCall> method;
+         bool pointer;// method returns a pointer to an object
+      };
+
+      TString fExpr;
+      Ssiz_t fPos;
+      TClass* fParticleClass;
+      bool fOK;
+      bool fInteger;// true if the value returned by the last production is an integer (as in C++)
+
+      value_func fail()
+      {
+         fOK = false;
+         return value_func();
+      }
+      void skip_spaces()
+      {
+         while (fPos < fExpr.Length() && isspace(fExpr[fPos])) ++fPos;
+      }
+      bool accept(const char* tok)
+      {
+         // if next token is tok, consume it and return true
+         skip_spaces();
+         Ssiz_t n = strlen(tok);
+         if (fExpr.Length() - fPos < n || strncmp(fExpr.Data() + fPos, tok, n)) return false;
+         fPos += n;
+         return true;
+      }
+      TString identifier()
+      {
+         // read a (possibly qualified) identifier
+         skip_spaces();
+         Ssiz_t start = fPos;
+         while (fPos < fExpr.Length()) {
+            if (isalnum(fExpr[fPos]) || fExpr[fPos] == '_') ++fPos;
+            else if (fExpr[fPos] == ':' && fPos + 1 < fExpr.Length() && fExpr[fPos + 1] == ':') fPos += 2;
+            else break;
+         }
+         return TString(fExpr(start, fPos - start));
+      }
+      value_func constant(double val, bool integer = true)
+      {
+         fInteger = integer;
+         return [val](const KVNucleus*) {
+            return val;
+         };
+      }
+
+      value_func logical_or()
+      {
+         value_func left = logical_and();
+         while (fOK && accept("||")) {
+            value_func right = logical_and();
+            left = [left, right](const KVNucleus * n) {
+               return double(left(n) || right(n));
+            };
+            fInteger = true;
+         }
+         return left;
+      }
+      value_func logical_and()
+      {
+         value_func left = comparison();
+         while (fOK && accept("&&")) {
+            value_func right = comparison();
+            left = [left, right](const KVNucleus * n) {
+               return double(left(n) && right(n));
+            };
+            fInteger = true;
+         }
+         return left;
+      }
+      value_func comparison()
+      {
+         value_func left = additive();
+         while (fOK) {
+            value_func right;
+            if (accept("==")) {
+               right = additive();
+               left = [left, right](const KVNucleus * n) {
+                  return double(left(n) == right(n));
+               };
+            }
+            else if (accept("!=")) {
+               right = additive();
+               left = [left, right](const KVNucleus * n) {
+                  return double(left(n) != right(n));
+               };
+            }
+            else if (accept("<=")) {
+               right = additive();
+               left = [left, right](const KVNucleus * n) {
+                  return double(left(n) <= right(n));
+               };
+            }
+            else if (accept(">=")) {
+               right = additive();
+               left = [left, right](const KVNucleus * n) {
+                  return double(left(n) >= right(n));
+               };
+            }
+            else if (accept("<")) {
+               right = additive();
+               left = [left, right](const KVNucleus * n) {
+                  return double(left(n) < right(n));
+               };
+            }
+            else if (accept(">")) {
+               right = additive();
+               left = [left, right](const KVNucleus * n) {
+                  return double(left(n) > right(n));
+               };
+            }
+            else break;
+            fInteger = true;
+         }
+         return left;
+      }
+      value_func additive()
+      {
+         value_func left = multiplicative();
+         while (fOK) {
+            value_func right;
+            bool left_int = fInteger;
+            if (accept("+")) {
+               right = multiplicative();
+               left = [left, right](const KVNucleus * n) {
+                  return left(n) + right(n);
+               };
+            }
+            else if (accept("-")) {
+               right = multiplicative();
+               left = [left, right](const KVNucleus * n) {
+                  return left(n) - right(n);
+               };
+            }
+            else break;
+            fInteger = fInteger && left_int;
+         }
+         return left;
+      }
+      value_func multiplicative()
+      {
+         value_func left = unary();
+         while (fOK) {
+            value_func right;
+            bool left_int = fInteger;
+            if (accept("*")) {
+               right = unary();
+               left = [left, right](const KVNucleus * n) {
+                  return left(n) * right(n);
+               };
+            }
+            else if (accept("/")) {
+               right = unary();
+               if (left_int && fInteger) left = [left, right](const KVNucleus * n) {
+                  // integer division
+                  return std::trunc(left(n) / right(n));
+               };
+               else left = [left, right](const KVNucleus * n) {
+                  return left(n) / right(n);
+               };
+            }
+            else if (accept("%")) {
+               right = unary();
+               left = [left, right](const KVNucleus * n) {
+                  return std::fmod(left(n), right(n));
+               };
+            }
+            else break;
+            fInteger = fInteger && left_int;
+         }
+         return left;
+      }
+      value_func unary()
+      {
+         value_func arg;
+         if (accept("!")) {
+            arg = unary();
+            fInteger = true;
+            return [arg](const KVNucleus * n) {
+               return double(!arg(n));
+            };
+         }
+         if (accept("-")) {
+            arg = unary();
+            return [arg](const KVNucleus * n) {
+               return -arg(n);
+            };
+         }
+         if (accept("+")) return unary();
+         return primary();
+      }
+      value_func primary()
+      {
+         skip_spaces();
+         if (fPos >= fExpr.Length()) return fail();
+         if (accept("(")) {
+            value_func f = logical_or();
+            if (!accept(")")) return fail();
+            return f;
+         }
+         if (isdigit(fExpr[fPos]) || fExpr[fPos] == '.') {
+            char* end;
+            double val = strtod(fExpr.Data() + fPos, &end);
+            if (end == fExpr.Data() + fPos) return fail();
+            TString literal = fExpr(fPos, end - fExpr.Data() - fPos);
+            fPos = end - fExpr.Data();
+            bool integer = !literal.Contains(".") && !literal.Contains("e") && !literal.Contains("E");
+            while (fPos < fExpr.Length() && strchr("fFuUlL", fExpr[fPos])) {
+               if (toupper(fExpr[fPos]) == 'F') integer = false;
+               ++fPos;
+            }
+            return constant(val, integer);
+         }
+         TString name = identifier();
+         if (name == "") return fail();
+         if (name == "true" || name == "kTRUE") return constant(1);
+         if (name == "false" || name == "kFALSE") return constant(0);
+         if (name == "_NUC_") return method_chain();
+         if (accept("(")) return function_call(name);
+         return fail();
+      }
+      value_func function_call(TString name)
+      {
+         // mathematical functions of one or two arguments
+         if (name.BeginsWith("TMath::")) name.Remove(0, 7);
+         else if (name.BeginsWith("std::")) name.Remove(0, 5);
+         name.ToLower();
+         std::vector<value_func> args;
+         bool integer_args = true;
+         if (!accept(")")) {
+            do {
+               args.push_back(logical_or());
+               integer_args = integer_args && fInteger;
+            }
+            while (fOK && accept(","));
+            if (!fOK || !accept(")")) return fail();
+         }
+         // result is floating-point except for abs, max & min of integers, and nint
+         fInteger = false;
+         if (args.size() == 1) {
+            value_func a = args[0];
+            if (name == "abs") {
+               fInteger = integer_args;
+               return [a](const KVNucleus * n) {
+                  return std::fabs(a(n));
+               };
+            }
+            if (name == "fabs") return [a](const KVNucleus * n) {
+               return std::fabs(a(n));
+            };
+            if (name == "sqrt") return [a](const KVNucleus * n) {
+               return std::sqrt(a(n));
+            };
+            if (name == "exp") return [a](const KVNucleus * n) {
+               return std::exp(a(n));
+            };
+            if (name == "log") return [a](const KVNucleus * n) {
+               return std::log(a(n));
+            };
+            if (name == "log10") return [a](const KVNucleus * n) {
+               return std::log10(a(n));
+            };
+            if (name == "sin") return [a](const KVNucleus * n) {
+               return std::sin(a(n));
+            };
+            if (name == "cos") return [a](const KVNucleus * n) {
+               return std::cos(a(n));
+            };
+            if (name == "tan") return [a](const KVNucleus * n) {
+               return std::tan(a(n));
+            };
+            if (name == "atan") return [a](const KVNucleus * n) {
+               return std::atan(a(n));
+            };
+            if (name == "floor") return [a](const KVNucleus * n) {
+               return std::floor(a(n));
+            };
+            if (name == "ceil") return [a](const KVNucleus * n) {
+               return std::ceil(a(n));
+            };
+            if (name == "nint") {
+               fInteger = true;
+               return [a](const KVNucleus * n) {
+                  return (double)TMath::Nint(a(n));
+               };
+            }
+         }
+         else if (args.size() == 2) {
+            value_func a = args[0], b = args[1];
+            if (name == "max") {
+               fInteger = integer_args;
+               return [a, b](const KVNucleus * n) {
+                  return std::max(a(n), b(n));
+               };
+            }
+            if (name == "min") {
+               fInteger = integer_args;
+               return [a, b](const KVNucleus * n) {
+                  return std::min(a(n), b(n));
+               };
+            }
+            if (name == "power" || name == "pow") return [a, b](const KVNucleus * n) {
+               return std::pow(a(n), b(n));
+            };
+            if (name == "atan2") return [a, b](const KVNucleus * n) {
+               return std::atan2(a(n), b(n));
+            };
+         }
+         return fail();
+      }
+      value_func method_chain()
+      {
+         // _NUC_->Method1(...)->Method2(...)...
+         // Each method except the last must return a pointer to an object,
+         // the last one a number (or bool).
+         std::vector<method_call> calls;
+         TClass* cl = fParticleClass;
+         while (accept("->")) {
+            if (!cl) return fail();
+            TString meth = identifier();
+            if (meth == "" || !accept("(")) return fail();
+            // arguments (which must be literals) are passed as they are to TMethodCall
+            Ssiz_t start = fPos;
+            int depth = 1;
+            char quote = 0;
+            while (fPos < fExpr.Length() && depth) {
+               char c = fExpr[fPos++];
+               if (quote) {
+                  if (c == '\\') ++fPos;
+                  else if (c == quote) quote = 0;
+               }
+               else if (c == '"' || c == '\'') quote = c;
+               else if (c == '(') ++depth;
+               else if (c == ')') --depth;
+            }
+            if (depth) return fail();
+            TString params = fExpr(start, fPos - 1 - start);
+            if (params.Contains("_NUC_")) return fail();
+            std::shared_ptr<TMethodCall> mc = std::make_shared<TMethodCall>(cl, meth, params);
+            if (!mc->IsValid() || !mc->GetMethod()) return fail();
+            TString rtype = mc->GetMethod()->GetReturnTypeNormalizedName();
+            bool pointer = rtype.EndsWith("*");
+            cl = nullptr;
+            if (pointer) {
+               rtype.ReplaceAll("const", "");
+               rtype.ReplaceAll("*", "");
+               cl = TClass::GetClass(rtype.Strip(TString::kBoth));
+            }
+            calls.push_back({mc, pointer});
+         }
+         if (calls.empty() || calls.back().pointer) return fail();
+         TMethodCall::EReturnType rt = calls.back().method->ReturnType();
+         if (rt != TMethodCall::kLong && rt != TMethodCall::kDouble) return fail();
+         bool as_double = (rt == TMethodCall::kDouble);
+         fInteger = !as_double;
+         // offset of KVNucleus base in particle class used for cast
+         Int_t offset = fParticleClass->GetBaseClassOffset(KVNucleus::Class());
+         if (offset < 0) return fail();
+         return [calls, as_double, offset](const KVNucleus * nuc) {
+            void* obj = (char*)const_cast<KVNucleus*>(nuc) - offset;
+            for (size_t i = 0; i < calls.size() - 1; ++i) {
+               Long_t ptr = 0;
+               calls[i].method->Execute(obj, ptr);
+               if (!ptr) return 0.;
+               obj = (void*)ptr;
+            }
+            if (as_double) {
+               Double_t r = 0;
+               calls.back().method->Execute(obj, r);
+               return r;
+            }
+            Long_t r = 0;
+            calls.back().method->Execute(obj, r);
+            return (double)r;
+         };
+      }
+
+   public:
+      condition_interpreter(const TString& expr, TClass* cl)
+         : fExpr(expr), fPos(0), fParticleClass(cl), fOK(cl != nullptr), fInteger(false)
+      {}
+      std::function<bool(const KVNucleus*)> parse()
+      {
+         // \returns function evaluating the condition, or empty function if the
+         // expression could not be handled
+         if (!fOK) return nullptr;
+         value_func f = logical_or();
+         skip_spaces();
+         if (!fOK || !f || fPos < fExpr.Length()) return nullptr;
+         return [f](const KVNucleus * nuc) {
+            return f(nuc) != 0.;
+         };
+      }
+   };
+}
+#endif
+
 void KVParticleCondition::Set(const KVString& cond)
 {
    //Set particle condition criteria.
@@ -66,7 +487,6 @@ KVParticleCondition::KVParticleCondition(const KVString& cond)
    //   and compiled on the fly before continuing (see method Optimize()).
    fOptimal = nullptr;
    Set(cond);
-   cf = nullptr;
    fOptOK = kFALSE;
    fNUsing = 0;
 }
@@ -93,7 +513,6 @@ KVParticleCondition::KVParticleCondition(const Char_t* cond)
    //   and compiled on the fly before continuing (see method Optimize()).
    fOptimal = nullptr;
    Set(cond);
-   cf = nullptr;
    fOptOK = kFALSE;
    fNUsing = 0;
 }
@@ -103,7 +522,6 @@ KVParticleCondition::KVParticleCondition()
 {
    //default ctor
    fOptimal = nullptr;
-   cf = nullptr;
    fOptOK = kFALSE;
    fNUsing = 0;
 }
@@ -120,7 +538,6 @@ KVParticleCondition::~KVParticleCondition()
          fOptimal = nullptr;
       }
    }
-   SafeDelete(cf);
 }
 
 //_____________________________________________________________________________//
@@ -143,19 +560,7 @@ void KVParticleCondition::Copy(TObject& obj) const
    // if existing optimized version exists in static list, pointer will be reset
    ((KVParticleCondition&) obj).fOptimal = nullptr;
    if (fClassName != "")((KVParticleCondition&) obj).SetParticleClassName(fClassName.Data());
-   if (cf) {
-      ((KVParticleCondition&) obj).SetClassFactory(cf);
-   }
-}
-
-//_____________________________________________________________________________//
-
-void KVParticleCondition::SetClassFactory(KVClassFactory* CF)
-{
-   //PRIVATE METHOD
-   //Used by Copy
-   CreateClassFactory();
-   CF->Copy(*cf);
+   ((KVParticleCondition&) obj).fExtraIncludes = fExtraIncludes;
 }
 
 //_____________________________________________________________________________//
@@ -165,7 +570,6 @@ KVParticleCondition::KVParticleCondition(const KVParticleCondition& obj)
 {
    // Copy constructor. Create new condition which is a copy of existing condition, obj.
    fOptimal = nullptr;
-   cf = nullptr;
    fOptOK = kFALSE;
    fNUsing = 0;
    obj.Copy(*this);
@@ -444,17 +848,199 @@ void KVParticleCondition::AddExtraInclude(const Char_t* inc_file)
    //
    //before the first call to p.Test() (when optimization occurs).
 
-   CreateClassFactory();
-   cf->AddImplIncludeFile(inc_file);
+   fExtraIncludes += Form("%s ", inc_file);
+}
+
+//_____________________________________________________________________________//
+
+KVString KVParticleCondition::GetNormalizedCondition() const
+{
+   // \returns the condition with all non-significant whitespace removed, used to build
+   // the key of the cache of compiled conditions (see GetCacheKey())
+
+   KVString norm;
+   const char* ops = "+-*/&|<>=!";
+   char quote = 0;
+   for (Ssiz_t i = 0; i < fCondition_raw.Length(); ++i) {
+      char c = fCondition_raw[i];
+      if (quote) {
+         // inside string or character literal: copy everything
+         if (c == quote) quote = 0;
+         else if (c == '\\' && i + 1 < fCondition_raw.Length()) {
+            norm += c;
+            c = fCondition_raw[++i];
+         }
+      }
+      else if (c == '"' || c == '\'') quote = c;
+      else if (isspace(c)) {
+         // whitespace is only kept if removing it would join two tokens
+         while (i + 1 < fCondition_raw.Length() && isspace(fCondition_raw[i + 1])) ++i;
+         if (!norm.Length() || i + 1 == fCondition_raw.Length()) continue;
+         char prev = norm[norm.Length() - 1], next = fCondition_raw[i + 1];
+         Bool_t word = (isalnum(prev) || prev == '_') && (isalnum(next) || next == '_');
+         Bool_t op = strchr(ops, prev) && strchr(ops, next);
+         if (!word && !op) continue;
+         c = ' ';
+      }
+      norm += c;
+   }
+   return norm;
+}
+
+KVString KVParticleCondition::GetCacheKey() const
+{
+   // \returns the key used to identify the compiled version of this condition in the
+   // cache directory (see GetCacheDirectory()).
+   //
+   // This is made from an MD5 hash of the condition (with non-significant whitespace removed),
+   // the particle class used for casting (SetParticleClassName()), any extra '#include' files
+   // (AddExtraInclude()), and the versions of ROOT and KaliVeda: a new class is compiled
+   // whenever any of these change.
+
+   TString key = GetNormalizedCondition();
+   key += "|";
+   key += fClassName;
+   key += "|";
+   key += fExtraIncludes;
+   key += "|";
+   key += gROOT->GetVersion();
+#ifdef USING_ROOT6
+   key += gROOT->GetGitCommit();
+#endif
+   key += "|";
+   key += KVBase::GetKVVersion();
+   key += KVBase::GetKVBuildDate();
+#ifdef WITH_GIT_INFOS
+   key += KVBase::gitCommit();
+#endif
+   TMD5 md5;
+   md5.Update((const UChar_t*)key.Data(), key.Length());
+   md5.Final();
+   KVString hash = md5.AsString();
+   hash.Remove(16);
+   return hash;
+}
+
+KVString KVParticleCondition::GetCacheDirectory()
+{
+   // \returns the directory where compiled conditions are stored, which can be set with
+   // ~~~~
+   // KVParticleCondition.CacheDirectory:   [path]
+   // ~~~~
+   // in your `.kvrootrc` file. By default, this is the subdirectory `particle_conditions`
+   // of the KaliVeda user working directory (`$HOME/.kaliveda`).
+
+   KVString dir = gEnv->GetValue("KVParticleCondition.CacheDirectory", "");
+   if (dir == "") dir = KVBase::GetWORKDIRFilePath("particle_conditions");
+   gSystem->ExpandPathName(dir);
+   return dir;
 }
 
 //_____________________________________________________________________________//
 
-void KVParticleCondition::CreateClassFactory() const
+void KVParticleCondition::GenerateOptimizedClass(const KVString& class_name, const KVString& path) const
 {
-   //Initialises KVClassFactory object used for optimization if it doesn't exist
+   //Write the .h and .cpp files for a class inheriting from KVParticleCondition whose
+   //optimized_test() method tests explicitly the condition set by the user.
+   //
+   //If needed, the KVNucleus pointer argument will be upcasted to the type given to SetParticleClassName().
+   //
+   //Files are written in directory 'path' (current working directory if path="").
 
-   if (cf) return;
+   KVClassFactory cf(class_name, "Particle condition to test", "KVParticleCondition");
+   cf.SetInheritAllConstructors(kFALSE); // avoid generating ctor with LambdaFunc argument!!!
+   if (path != "") cf.SetOutputPath(path);
+   //add Test() method
+   cf.AddMethod("optimized_test", "Bool_t", "public", false, true);
+   cf.AddMethodArgument("optimized_test", "const KVNucleus*", "nuc");
+   cf.AddHeaderIncludeFile("KVNucleus.h");
+   KVString incs = fExtraIncludes;
+   incs.Begin(" ");
+   while (!incs.End()) cf.AddImplIncludeFile(incs.Next());
+
+   //write body of method
+   KVString body("   //Optimized Test method for particle condition\n");
+   KVString pointer = "nuc";
+   if (fClassName != "") {
+      pointer.Form("((%s*)nuc)", fClassName.Data());
+      //upcasting pointer - we need to add corresponding #include to '.cpp' file
+      cf.AddImplIncludeFile(Form("%s.h", fClassName.Data()));
+   }
+   KVString tmp;
+   tmp = fCondition;
+   tmp.ReplaceAll("_NUC_", pointer.Data());
+   body += "   return ";
+   body += tmp;
+
+   cf.AddMethodBody("optimized_test", body);
+
+   //generate .cpp and .h for new class
+   cf.GenerateCode();
+}
+
+KVParticleCondition* KVParticleCondition::CompileOptimizedClass(const KVString& class_name, const KVString& path) const
+{
+   //Compile & load (with ACLiC) the class generated by GenerateOptimizedClass() in directory 'path',
+   //or just load the library if it already exists and is up to date.
+   //
+   //Returns a new instance of the class, or nullptr in case of failure.
+
+   KVString imp_file = (path != "" ? Form("%s/%s.cpp", path.Data(), class_name.Data()) : Form("%s.cpp", class_name.Data()));
+   if (gSystem->CompileMacro(imp_file) != 1) return nullptr;
+   TClass* cl = TClass::GetClass(class_name);
+   return (cl ? (KVParticleCondition*)cl->New() : nullptr);
+}
+
+KVParticleCondition* KVParticleCondition::OptimizeWithCache() const
+{
+   //Generate and compile the optimized class in the cache directory (see GetCacheDirectory()),
+   //unless a library for the same condition already exists there, in which case it is just loaded.
+   //
+   //The name of the class is derived from GetCacheKey(), therefore any job using the same
+   //condition with the same versions of ROOT and KaliVeda will use the same library.
+   //A lockfile prevents several jobs sharing the same directory from compiling the
+   //same class at the same time.
+   //
+   //Returns a new instance of the class, or nullptr in case of failure.
+
+   KVString class_name = "KVParticleCondition_" + GetCacheKey();
+
+   // class already loaded by another condition in this process?
+   TClass* cl = TClass::GetClass(class_name, kFALSE, kTRUE);
+   if (cl && cl->IsLoaded()) return (KVParticleCondition*)cl->New();
+
+   KVString dir = GetCacheDirectory();
+   if (gSystem->AccessPathName(dir) && gSystem->mkdir(dir, kTRUE) < 0) {
+      Warning("OptimizeWithCache", "Cannot create cache directory %s", dir.Data());
+      return nullptr;
+   }
+   KVLockfile lock;
+   lock.SetSleeptime(1);
+   lock.SetTimeout(900);// in case a job was killed while holding the lock
+   if (!lock.Lock(Form("%s/%s", dir.Data(), class_name.Data())))
+      Warning("OptimizeWithCache", "Could not lock %s/%s", dir.Data(), class_name.Data());
+
+   KVString lib_file = Form("%s/%s_cpp.%s", dir.Data(), class_name.Data(), gSystem->GetSoExt());
+   KVParticleCondition* optimal = nullptr;
+   if (!gSystem->AccessPathName(lib_file)) {
+      Info("OptimizeWithCache", "Using compiled condition in %s", lib_file.Data());
+      if (gSystem->Load(lib_file) >= 0 && (cl = TClass::GetClass(class_name)) && cl->IsLoaded())
+         optimal = (KVParticleCondition*)cl->New();
+   }
+   if (!optimal) {
+      GenerateOptimizedClass(class_name, dir);
+      optimal = CompileOptimizedClass(class_name, dir);
+   }
+   lock.Release();
+   return optimal;
+}
+
+KVParticleCondition* KVParticleCondition::OptimizeInCurrentDirectory() const
+{
+   //Generate and compile the optimized class in the current working directory,
+   //with a unique name (no cache).
+   //
+   //Returns a new instance of the class, or nullptr in case of failure.
 
    // unique name for new class
    TUUID unique;
@@ -463,25 +1049,59 @@ void KVParticleCondition::CreateClassFactory() const
    new_class.Remove(8);
    new_class.Prepend("KVParticleCondition_");
 
-   //create new class
-   cf = new KVClassFactory(new_class.Data(), "Particle condition to test", "KVParticleCondition");
-   cf->SetInheritAllConstructors(kFALSE); // avoid generating ctor with LambdaFunc argument!!!
+   GenerateOptimizedClass(new_class, "");
+   return CompileOptimizedClass(new_class, "");
 }
 
+#ifdef USING_ROOT6
+KVParticleCondition* KVParticleCondition::OptimizeWithoutCompilation() const
+{
+   //Build a function evaluating the condition directly, without generating or compiling any code.
+   //
+   //This is only possible for conditions using numbers, the usual arithmetic, comparison and
+   //logical operators, common mathematical functions (`TMath::Abs`, `sqrt`, etc.) and methods
+   //of the particle class with literal arguments, e.g.
+   //~~~~{.cpp}
+   //_NUC_->GetZ()>2 && TMath::Abs(_NUC_->GetVpar())<10.
+   //_NUC_->GetParameters()->GetIntValue("IDCODE")==4
+   //~~~~
+   //Each method call costs a little more than in the compiled version.
+   //
+   //Returns a new condition using this function, or nullptr if the condition is not
+   //in the subset handled.
+
+   TClass* cl = TClass::GetClass(fClassName != "" ? fClassName.Data() : "KVNucleus");
+   condition_interpreter interp(fCondition_raw, cl);
+   LambdaFunc f = interp.parse();
+   if (!f) return nullptr;
+   KVParticleCondition* optimal = new KVParticleCondition;
+   optimal->fInterpreted = f;
+   return optimal;
+}
+#endif
+
 void KVParticleCondition::Optimize() const
 {
-   //Generate a new class which inherits from KVParticleCondition but having a Test()
-   //method which tests explicitly the condition which is set by the user.
+   //Replace the string condition by an object which tests it explicitly.
    //
-   //If needed, the KVNucleus pointer argument will be upcasted to the type given to SetParticleClassName().
+   //How this is done depends on the value of
+   //~~~~
+   //KVParticleCondition.Optimization:   cache
+   //~~~~
+   //in your `.kvrootrc` file:
+   //  - `cache` (default): a class inheriting from KVParticleCondition with a Test()
+   //    method implementing the condition is generated & compiled in the cache directory
+   //    (see OptimizeWithCache()), or the library already compiled there by a previous job is loaded;
+   //  - `local`: the class is generated & compiled in the current directory with a unique name,
+   //    each time (see OptimizeInCurrentDirectory());
+   //  - `interpreted`: the condition is evaluated without compilation (see OptimizeWithoutCompilation()).
    //
-   //The new class is added to the list of plugins of type KVParticleCondition,
-   //then an instance of the class is generated and a pointer to it stored in
-   //member KVParticleCondition::fOptimal.
+   //If compilation fails, we try to evaluate the condition without compilation (ROOT6 only).
    //
-   //This object is then used in the Test() method of this object to test the condition.
+   //An instance of the class is stored in member KVParticleCondition::fOptimal,
+   //which is then used in the Test() method of this object to test the condition.
    //
-   //If compilation fails, the condition will evaluate to kFALSE for all subsequent calls.
+   //If all this fails, the condition will evaluate to kFALSE for all subsequent calls.
 
    fOptimal = (KVParticleCondition*)fgOptimized.FindObject(GetName());
    if (fOptimal) {  /* check that the same condition has not already been optimized */
@@ -492,43 +1112,21 @@ void KVParticleCondition::Optimize() const
    }
    Info("Optimize", "Optimization of KVParticleCondition : %s", fCondition.Data());
 
-   CreateClassFactory();
-   KVString created_class_name = cf->GetClassName();
-   //add Test() method
-   cf->AddMethod("optimized_test", "Bool_t", "public", false, true);
-   cf->AddMethodArgument("optimized_test", "const KVNucleus*", "nuc");
-   cf->AddHeaderIncludeFile("KVNucleus.h");
-
-   //write body of method
-   KVString body("   //Optimized Test method for particle condition\n");
-   KVString pointer = "nuc";
-   if (fClassName != "") {
-      pointer.Form("((%s*)nuc)", fClassName.Data());
-      //upcasting pointer - we need to add corresponding #include to '.cpp' file
-      cf->AddImplIncludeFile(Form("%s.h", fClassName.Data()));
+   KVString mode = gEnv->GetValue("KVParticleCondition.Optimization", "cache");
+   KVParticleCondition* optimal = nullptr;
+   if (mode == "cache") optimal = OptimizeWithCache();
+   else if (mode == "local") optimal = OptimizeInCurrentDirectory();
+#ifdef USING_ROOT6
+   if (!optimal) {
+      if (mode != "interpreted") Warning("Optimize", "Compilation failed, trying to evaluate condition without compilation");
+      optimal = OptimizeWithoutCompilation();
    }
-   KVString tmp;
-   tmp = fCondition;
-   tmp.ReplaceAll("_NUC_", pointer.Data());
-   body += "   return ";
-   body += tmp;
-
-   cf->AddMethodBody("optimized_test", body);
+#endif
 
-   //generate .cpp and .h for new class
-   cf->GenerateCode();
-
-   //add plugin for new class
-   gROOT->GetPluginManager()->AddHandler("KVParticleCondition", cf->GetClassName(), cf->GetClassName(),
-                                         Form("%s+", cf->GetImpFileName()), Form("%s()", cf->GetClassName()));
-   //load plugin
-   TPluginHandler* ph;
-   if (!(ph = LoadPlugin("KVParticleCondition", cf->GetClassName()))) {
+   if (!optimal) {
       Error("Optimize", " *** Optimization failed for KVParticleCondition : %s", fCondition.Data());
       Error("Optimize", " *** Use method AddExtraInclude(const Char_t*) to give the names of all necessary header files for compilation of your condition.");
       Fatal("Optimize", " *** THIS CONDITION WILL BE EVALUATED AS kFALSE FOR ALL PARTICLES!!!");
-      delete cf;
-      cf = 0;
       //we set fOptimal to a non-zero value to avoid calling Optimize
       //every time that Test() is called subsequently.
       fOptimal = this;
@@ -536,25 +1134,16 @@ void KVParticleCondition::Optimize() const
       return;
    }
    fOptOK = kTRUE;
-   delete cf;
-   cf = 0;
-   //execute constructor
-   fOptimal = (KVParticleCondition*) ph->ExecPlugin(0);
-
+   fOptimal = optimal;
    Info("Optimize", "fOptimal = %p", fOptimal);
-   if (!fOptimal) {
-      Error("Optimize", " *** Optimization failed for KVParticleCondition : %s", fCondition.Data());
-      Error("Optimize", " *** Use method AddExtraInclude(const Char_t*) to give the names of all necessary header files for compilation of your condition.");
-      Fatal("Optimize", " *** THIS CONDITION WILL BE EVALUATED AS kFALSE FOR ALL PARTICLES!!!");
-      //we set fOptimal to a non-zero value to avoid calling Optimize
-      //every time that Test() is called subsequently.
-      fOptimal = this;
-      fOptOK = kFALSE;
-   }
+
    // add to list of optimized conditions
-   const_cast<KVParticleCondition*>(fOptimal)->SetName(GetName());
-   const_cast<KVParticleCondition*>(fOptimal)->fOptimizedClassName = created_class_name;
-   fgOptimized.Add(const_cast<KVParticleCondition*>(fOptimal));
+   optimal->SetName(GetName());
+   optimal->fOptimizedClassName = optimal->ClassName();
+#ifdef USING_ROOT6
+   if (optimal->fInterpreted) optimal->fOptimizedClassName = "(interpreted)";
+#endif
+   fgOptimized.Add(optimal);
    fOptimal->fNUsing++;
    Info("Optimize", "Success");
 }
@@ -568,10 +1157,7 @@ void KVParticleCondition::Print(Option_t*) const
       cout << " * classname = " << fClassName.Data() << endl;
       cout << " * fOptimal = " << fOptimal << endl;
       cout << " * fNUsing = " << fNUsing << endl;
-      if (cf) {
-         cout << " * classfactory :" << endl;
-         cf->Print();
-      }
+      if (fExtraIncludes != "") cout << " * extra includes = " << fExtraIncludes.Data() << endl;
    }
    else {
       cout << GetName() << endl;
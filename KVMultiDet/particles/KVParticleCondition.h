@@ -23,8 +23,6 @@ $Date: 2007/03/26 10:14:56 $
 #include <functional>
 #endif
 
-class KVClassFactory;
-
 /**
   \class KVParticleCondition
 \brief Handles particle selection criteria for data analysis classes
@@ -58,6 +56,13 @@ Note that the first call to Test() automatically causes the 'optimization' of th
 KVParticleCondition, which means that a class implementing the required condition is generated
 and compiled on the fly before continuing (see method Optimize()).
 
+Compiled conditions are kept in a cache directory (by default `$HOME/.kaliveda/particle_conditions`,
+see variable `KVParticleCondition.CacheDirectory` in `.kvrootrc`) and are simply reloaded by
+any subsequent job using the same condition with the same versions of ROOT and KaliVeda.
+If compilation is not possible or not wanted (`KVParticleCondition.Optimization: interpreted`),
+conditions using only methods of the particle class, numbers and the usual C++ operators
+are evaluated without any compilation (ROOT6 only).
+
 ### Using lambda expressions (only with ROOT6 or later)
 Lambda expressions were introduced in C++11 and provide an easy way to define small functions
 on the fly inside code. The lambda must take a `const KVNucleus*` pointer as argument and return
@@ -91,6 +96,7 @@ class KVParticleCondition : public KVBase {
    using LambdaFunc = std::function<bool(const KVNucleus*)>;
    mutable LambdaFunc fLambdaCondition;
    LambdaFunc fSavedLambda1, fSavedLambda2;// used by || and &&
+   LambdaFunc fInterpreted;//! used for conditions evaluated without compilation
    enum class LogOp { AND, OR } fOpType;
 
    void logical_operator_lambda_condition_test() const
@@ -121,17 +127,28 @@ protected:
 
    mutable const KVParticleCondition* fOptimal;//!
    KVString fClassName;//!
-   mutable KVClassFactory* cf;//! used to generate code for optimisation
+   KVString fExtraIncludes;//! extra '#include' files needed for optimisation
    KVString fOptimizedClassName;//! name of generated class used for optimisation
    mutable Bool_t fOptOK;//!false if optimisation failed (can't load generated code)
 
    void Optimize() const;
-   virtual bool optimized_test(const KVNucleus*) const
+   virtual bool optimized_test(const KVNucleus* nuc) const
    {
+#ifdef USING_ROOT6
+      if (fInterpreted) return fInterpreted(nuc);
+#else
+      (void)nuc;
+#endif
       return kFALSE;
    }
-   void CreateClassFactory() const;
-   void SetClassFactory(KVClassFactory* CF);
+   void GenerateOptimizedClass(const KVString& class_name, const KVString& path) const;
+   KVParticleCondition* CompileOptimizedClass(const KVString& class_name, const KVString& path) const;
+   KVParticleCondition* OptimizeWithCache() const;
+   KVParticleCondition* OptimizeInCurrentDirectory() const;
+#ifdef USING_ROOT6
+   KVParticleCondition* OptimizeWithoutCompilation() const;
+#endif
+   KVString GetNormalizedCondition() const;
 
 public:
 
@@ -167,7 +184,6 @@ public:
       // l3.Test(&N);      ==> returns false
       // ~~~~~~
       fOptimal = nullptr;
-      cf = nullptr;
       fOptOK = kFALSE;
       fNUsing = 0;
    }
@@ -257,6 +273,8 @@ public:
    {
       fgOptimized.Print();
    }
+   static KVString GetCacheDirectory();
+   KVString GetCacheKey() const;
    Bool_t IsSet() const
    {
       // Return kTRUE if a condition/selection has been defined
@@ -0,0 +1,179 @@
+//Created by KVClassFactory on Sat Oct 17 14:05:22 2026
+
+#include "KVInverseRangeTable.h"
+#include "KVIonRangeTableMaterial.h"
+#include "TMath.h"
+
+ClassImp(KVInverseRangeTable)
+
+KVInverseRangeTable::KVInverseRangeTable()
+   : fYmin(0), fDy(0), fEmin(0), fEmax(0), fMaxRelError(0)
+{
+   // Default constructor
+}
+
+KVInverseRangeTable::KVInverseRangeTable(KVIonRangeTableMaterial* mat, Int_t Z, Int_t A, Double_t precision, Int_t max_nodes)
+   : fYmin(0), fDy(0), fEmin(0), fEmax(0), fMaxRelError(0)
+{
+   // Build table for ion (Z,A) in material
+   //
+   // \param precision required upper bound of relative error on interpolated energies
+   // \param max_nodes maximum number of nodes in table
+
+   fEmin = 0.01 * A;
+   fEmax = mat->GetEmaxValid(Z, A);
+   if (fEmax <= fEmin) return;
+
+   Double_t xmin = TMath::Log(fEmin);
+   Double_t xmax = TMath::Log(fEmax);
+   fYmin = LogRange(mat, Z, A, xmin);
+   Double_t ymax = LogRange(mat, Z, A, xmax);
+   if (!(ymax > fYmin)) {
+      Error("KVInverseRangeTable", "range of Z=%d A=%d in %s is not an increasing function of energy",
+            Z, A, mat->GetName());
+      return;
+   }
+
+   // initial table: nodes are calculated by exact inversion of the range function.
+   // each node brackets the following one.
+   Int_t n = 65;
+   fDy = (ymax - fYmin) / (n - 1);
+   fX.resize(n);
+   fX[0] = xmin;
+   fX[n - 1] = xmax;
+   for (int i = 1; i < n - 1; ++i) fX[i] = InvertLogRange(mat, Z, A, fYmin + i * fDy, fX[i - 1], xmax);
+   fSlope.resize(n);
+   // dlog(E)/dlog(R) at each node by finite difference of range function
+   const Double_t dx = 1.e-5;
+   for (int i = 0; i < n; ++i)
+      fSlope[i] = 2 * dx / (LogRange(mat, Z, A, fX[i] + dx) - LogRange(mat, Z, A, fX[i] - dx));
+   LimitSlopes();
+
+   for (;;) {
+      // test interpolation at middle of each interval, keeping the exact values:
+      // if the table has to be refined, they become the new nodes.
+      // only if the error there is small enough is the (much more costly) upper bound calculated
+      std::vector<Double_t> xmid(n - 1);
+      Double_t mid_error = 0;
+      for (int i = 0; i < n - 1; ++i) {
+         Double_t y = fYmin + (i + 0.5) * fDy;
+         xmid[i] = InvertLogRange(mat, Z, A, y, fX[i], fX[i + 1]);
+         Double_t err = TMath::Abs(InterpolateLog(y) - xmid[i]); // ~ relative error on E
+         if (err > mid_error) mid_error = err;
+      }
+      fMaxRelError = -1;
+      if (mid_error <= precision) {
+         fMaxRelError = ErrorBound(mat, Z, A, 0.5 * precision);
+         if (fMaxRelError <= precision) break;
+      }
+      if (2 * n - 1 > max_nodes) {
+         if (fMaxRelError < 0) fMaxRelError = ErrorBound(mat, Z, A, 0.5 * precision);
+         Warning("KVInverseRangeTable", "Z=%d A=%d in %s: required precision %g not reached with %d nodes (max. error=%g)",
+                 Z, A, mat->GetName(), precision, n, fMaxRelError);
+         break;
+      }
+      std::vector<Double_t> x(2 * n - 1), slope(2 * n - 1);
+      for (int i = 0; i < n; ++i) {
+         x[2 * i] = fX[i];
+         slope[2 * i] = fSlope[i];
+      }
+      for (int i = 0; i < n - 1; ++i) {
+         x[2 * i + 1] = xmid[i];
+         slope[2 * i + 1] = 2 * dx / (LogRange(mat, Z, A, xmid[i] + dx) - LogRange(mat, Z, A, xmid[i] - dx));
+      }
+      fX.swap(x);
+      fSlope.swap(slope);
+      n = 2 * n - 1;
+      fDy /= 2;
+      LimitSlopes();
+   }
+}
+
+Double_t KVInverseRangeTable::LogRange(KVIonRangeTableMaterial* mat, Int_t Z, Int_t A, Double_t x) const
+{
+   // \returns log of range for energy E=exp(x)
+   return TMath::Log(mat->GetRangeOfIon(Z, A, TMath::Exp(x)));
+}
+
+Double_t KVInverseRangeTable::InvertLogRange(KVIonRangeTableMaterial* mat, Int_t Z, Int_t A, Double_t y, Double_t x1, Double_t x2) const
+{
+   // Find x=log(E) in [x1,x2] such that log(range)=y, using the Illinois variant of the
+   // regula falsi method (log(range) is nearly linear in log(E))
+
+   Double_t f1 = LogRange(mat, Z, A, x1) - y;
+   Double_t f2 = LogRange(mat, Z, A, x2) - y;
+   if (f1 >= 0) return x1;
+   if (f2 <= 0) return x2;
+   Int_t side = 0;
+   Double_t x = x1;
+   for (int it = 0; it < 100; ++it) {
+      x = (x1 * f2 - x2 * f1) / (f2 - f1);
+      if (TMath::Abs(x2 - x1) < 1.e-12 * (1 + TMath::Abs(x))) break;
+      Double_t f = LogRange(mat, Z, A, x) - y;
+      if (f == 0) break;
+      if (f > 0) {
+         x2 = x;
+         f2 = f;
+         if (side == -1) f1 /= 2;
+         side = -1;
+      }
+      else {
+         x1 = x;
+         f1 = f;
+         if (side == 1) f2 /= 2;
+         side = 1;
+      }
+   }
+   return x;
+}
+
+void KVInverseRangeTable::LimitSlopes()
+{
+   // Fritsch-Carlson limitation of derivatives to ensure monotonicity of interpolation
+
+   int n = fX.size();
+   for (int i = 0; i < n; ++i) if (fSlope[i] < 0) fSlope[i] = 0;
+   for (int i = 0; i < n - 1; ++i) {
+      Double_t delta = (fX[i + 1] - fX[i]) / fDy;
+      if (delta <= 0) {
+         fSlope[i] = fSlope[i + 1] = 0;
+         continue;
+      }
+      Double_t a = fSlope[i] / delta;
+      Double_t b = fSlope[i + 1] / delta;
+      Double_t s = a * a + b * b;
+      if (s > 9) {
+         Double_t tau = 3 / TMath::Sqrt(s);
+         fSlope[i] = tau * a * delta;
+         fSlope[i + 1] = tau * b * delta;
+      }
+   }
+}
+
+Double_t KVInverseRangeTable::ErrorBound(KVIonRangeTableMaterial* mat, Int_t Z, Int_t A, Double_t dx) const
+{
+   // \returns upper bound of the relative error on energies interpolated from the table, for all ranges it covers
+   // \param dx maximum step in log(E) between tested points
+   //
+   // Each interval between nodes is divided into steps of at most dx in log(E). For each step [x1,x2],
+   // y=log(range) is calculated for x1 and x2 (no inversion is needed) and, as both the exact inverse of
+   // the range function and its interpolation h are increasing functions of y, the error on log(E) for all
+   // y in [y1,y2] is at most max(h(y2)-x1, x2-h(y1)). The bound on the error on log(E) therefore exceeds the
+   // largest error at the tested points by at most dx. It is converted into a bound of the relative error
+   // on E.
+
+   Double_t bound = 0;
+   Double_t x1 = fX[0];
+   Double_t h1 = InterpolateLog(TMath::Max(LogRange(mat, Z, A, x1), fYmin));
+   for (size_t i = 0; i < fX.size() - 1; ++i) {
+      Int_t m = TMath::Max(1, TMath::CeilNint((fX[i + 1] - fX[i]) / dx));
+      for (int k = 1; k <= m; ++k) {
+         Double_t x2 = (k == m ? fX[i + 1] : fX[i] + k * (fX[i + 1] - fX[i]) / m);
+         Double_t h2 = InterpolateLog(TMath::Max(LogRange(mat, Z, A, x2), fYmin));
+         bound = TMath::Max(bound, TMath::Max(h2 - x1, x2 - h1));
+         x1 = x2;
+         h1 = h2;
+      }
+   }
+   return TMath::Exp(bound) - 1;
+}
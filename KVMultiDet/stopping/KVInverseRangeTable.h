@@ -0,0 +1,121 @@
+//Created by KVClassFactory on Sat Oct 17 14:05:22 2026
+
+#ifndef __KVINVERSERANGETABLE_H
+#define __KVINVERSERANGETABLE_H
+
+#include "TObject.h"
+#include <vector>
+#include <cmath>
+
+class KVIonRangeTableMaterial;
+
+/**
+  \class KVInverseRangeTable
+  \ingroup Stopping
+  \brief Tabulated inverse of range-energy relation for one ion in one material
+
+  The energy \f$E\f$ of the ion as a function of its range \f$R\f$ is tabulated for
+  equally-spaced values of \f$\log R\f$, using the range function of the material
+  (KVIonRangeTableMaterial::GetRangeOfIon()). Each node of the table is calculated by exact
+  inversion of the range function; the derivative \f$d\log E/d\log R\f$ at each node is also
+  stored, and \f$\log E\f$ is interpolated between nodes using a cubic Hermite spline.
+  The derivatives are limited (Fritsch-Carlson) in order to ensure that the interpolated
+  curve is monotone.
+
+  As nodes are equally spaced, finding the interval for a given range does not require any search:
+  GetEnergy() is therefore much faster than root-finding methods such as TF1::GetX.
+
+  The number of nodes is doubled until an upper bound of the relative error on interpolated
+  energies is less than the required precision (or the maximum number of nodes is reached).
+  The bound, given by GetMaxRelativeError(), holds for all ranges covered by the table: as both the
+  exact inverse of the range function and the (monotone) interpolation are increasing functions of
+  \f$\log R\f$, if the exact energies for \f$\log R=y_1,y_2\f$ are \f$x_1<x_2\f$ (in \f$\log E\f$),
+  then for all \f$y\in[y_1,y_2]\f$ the error on \f$\log E\f$ is at most
+  \f$\max(h(y_2)-x_1, x_2-h(y_1))\f$, where \f$h\f$ is the interpolation. This is evaluated for
+  steps in \f$\log E\f$ of half the required precision covering each interval between nodes
+  (see ErrorBound()). The error at the middle of each interval is tested first, as it is much cheaper.
+
+  The table covers energies from 0.01 MeV/nucleon to the upper limit of validity of the
+  range tables for the ion. For ranges below this interval, GetEnergy() returns -1.
+
+  \sa KVIonRangeTableMaterial::SetUseInverseRangeTables()
+ */
+class KVInverseRangeTable : public TObject {
+
+   Double_t fYmin;                 // log(range) at first node
+   Double_t fDy;                   // step in log(range) between nodes
+   Double_t fEmin;                 // energy at first node
+   Double_t fEmax;                 // energy at last node
+   Double_t fMaxRelError;          // upper bound of relative error on energy
+   std::vector<Double_t> fX;       // log(E) at each node
+   std::vector<Double_t> fSlope;   // dlog(E)/dlog(R) at each node
+
+   Double_t LogRange(KVIonRangeTableMaterial*, Int_t Z, Int_t A, Double_t x) const;
+   Double_t InvertLogRange(KVIonRangeTableMaterial*, Int_t Z, Int_t A, Double_t y, Double_t x1, Double_t x2) const;
+   Double_t InterpolateLog(Double_t y) const
+   {
+      // cubic Hermite interpolation of log(E) for given log(R)=y>=fYmin
+      Double_t u = (y - fYmin) / fDy;
+      size_t i = (size_t)u;
+      if (i >= fX.size() - 1) return fX.back();
+      Double_t t = u - i;
+      Double_t t2 = t * t;
+      Double_t t3 = t2 * t;
+      return (2 * t3 - 3 * t2 + 1) * fX[i] + (t3 - 2 * t2 + t) * fDy * fSlope[i]
+             + (-2 * t3 + 3 * t2) * fX[i + 1] + (t3 - t2) * fDy * fSlope[i + 1];
+   }
+   Double_t Interpolate(Double_t y) const
+   {
+      // interpolated energy for given log(R)=y>=fYmin
+      return std::exp(InterpolateLog(y));
+   }
+   void LimitSlopes();
+   Double_t ErrorBound(KVIonRangeTableMaterial*, Int_t Z, Int_t A, Double_t dx) const;
+
+public:
+   KVInverseRangeTable();
+   KVInverseRangeTable(KVIonRangeTableMaterial* mat, Int_t Z, Int_t A, Double_t precision = 1.e-4, Int_t max_nodes = 16385);
+   virtual ~KVInverseRangeTable() {}
+
+   Double_t GetEnergy(Double_t range) const
+   {
+      // \param range range of ion in \f$g/cm^2\f$
+      // \returns energy of ion in MeV. If range is smaller than the range at the lowest energy
+      // in the table, returns -1; if range is larger than range at highest energy, returns the highest energy.
+
+      if (range <= 0) return 0.;
+      if (fX.size() < 2) return -1.;
+      Double_t y = std::log(range);
+      if (y < fYmin) return -1.;
+      return Interpolate(y);
+   }
+   Double_t GetMinimumRange() const
+   {
+      return std::exp(fYmin);
+   }
+   Double_t GetMaximumRange() const
+   {
+      return std::exp(fYmin + fDy * (fX.size() - 1));
+   }
+   Double_t GetEmin() const
+   {
+      return fEmin;
+   }
+   Double_t GetEmax() const
+   {
+      return fEmax;
+   }
+   Double_t GetMaxRelativeError() const
+   {
+      // Upper bound of the relative error on energies given by GetEnergy() (see class description)
+      return fMaxRelError;
+   }
+   Int_t GetNumberOfNodes() const
+   {
+      return fX.size();
+   }
+
+   ClassDef(KVInverseRangeTable, 0) //Tabulated inverse of range-energy relation for one ion in one material
+};
+
+#endif
@@ -218,6 +218,41 @@ Double_t KVIonRangeTable::GetLinearEResOfIon(const Char_t* mat, Int_t Z, Int_t A
 }
 //________________________________________________________________________________//
 
+void KVIonRangeTable::GetEResOfIons(const Char_t* mat, Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E,
+                                    const Double_t* r, Double_t* Eres, Double_t* DeltaE)
+{
+   // Calculate residual energies (and, if DeltaE is given, energy losses) in MeV of n ions (Z,A)
+   // with incident energies E (MeV) after thicknesses r (in g/cm**2).
+   //
+   // See KVIonRangeTableMaterial::GetEResOfIons()
+
+   KVIonRangeTableMaterial* M = GetMaterial(mat);
+   if (!M) {
+      Warning("GetEResOfIons", "Material %s is unknown", mat);
+      return;
+   }
+   M->GetEResOfIons(n, Z, A, E, r, Eres, DeltaE);
+}
+//________________________________________________________________________________//
+
+void KVIonRangeTable::GetLinearEResOfIons(const Char_t* mat, Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E,
+      const Double_t* d, Double_t* Eres, Double_t* DeltaE, Double_t T, Double_t P)
+{
+   // Calculate residual energies (and, if DeltaE is given, energy losses) in MeV of n ions (Z,A)
+   // with incident energies E (MeV) after thicknesses d (in cm).
+   // Give temperature (degrees C) & pressure (torr) (T,P) for gaseous materials.
+   //
+   // See KVIonRangeTableMaterial::GetLinearEResOfIons()
+
+   KVIonRangeTableMaterial* M = GetMaterial(mat);
+   if (!M) {
+      Warning("GetLinearEResOfIons", "Material %s is unknown", mat);
+      return;
+   }
+   M->GetLinearEResOfIons(n, Z, A, E, d, Eres, DeltaE, T, P);
+}
+//________________________________________________________________________________//
+
 Double_t KVIonRangeTable::GetEIncFromEResOfIon(const Char_t* mat, Int_t Z, Int_t A, Double_t Eres, Double_t e, Double_t isoAmat, Double_t, Double_t)
 {
    // Calculates incident energy (in MeV) of an ion (Z,A) with residual energy Eres (MeV) after thickness e (in g/cm**2).
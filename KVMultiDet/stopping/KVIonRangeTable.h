@@ -133,6 +133,14 @@ public:
    virtual Double_t GetLinearEResOfIon(const Char_t* mat, Int_t Z, Int_t A, Double_t E, Double_t d,
                                        Double_t Amat = 0., Double_t T = -1., Double_t P = -1.);
 
+   // Calculate residual energies (and, if required, energy losses) of n ions (Z,A) with incident energies E (MeV)
+   // after thicknesses r (in g/cm**2) or d (in cm).
+   // Give temperature (degrees C) & pressure (torr) (T,P) for gaseous materials.
+   virtual void GetEResOfIons(const Char_t* mat, Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E,
+                              const Double_t* r, Double_t* Eres, Double_t* DeltaE = nullptr);
+   virtual void GetLinearEResOfIons(const Char_t* mat, Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E,
+                                    const Double_t* d, Double_t* Eres, Double_t* DeltaE = nullptr, Double_t T = -1., Double_t P = -1.);
+
    virtual Double_t GetEIncFromEResOfIon(const Char_t* mat, Int_t Z, Int_t A, Double_t Eres, Double_t e, Double_t isoAmat = 0., Double_t T = -1., Double_t P = -1.);
    virtual Double_t GetLinearEIncFromEResOfIon(const Char_t* mat, Int_t Z, Int_t A, Double_t Eres, Double_t e, Double_t isoAmat = 0., Double_t T = -1., Double_t P = -1.);
 
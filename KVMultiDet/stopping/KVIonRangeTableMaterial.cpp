@@ -8,9 +8,69 @@
 #include "TGeoMaterial.h"
 #include "KVElementDensity.h"
 #include "KVNDTManager.h"
+#include "KVInverseRangeTable.h"
+#include "TEnv.h"
+#ifdef WITH_CPP11
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
 
 using namespace std;
 
+#ifdef WITH_CPP11
+// Inverse range tables of a material, built on demand for each ion (Z,A).
+// Tables are found through atomic pointers (one block of tables for all A of each Z), so that
+// looking up a table which has already been built takes no lock. The mutex is only used to
+// publish new tables & blocks. Tables and blocks are deleted with the cache.
+class KVInverseRangeTableCache {
+public:
+   enum {
+      kMaxZ = 128,// tables are only used for Z < kMaxZ
+      kMaxA = 512 // tables are only used for A < kMaxA
+   };
+   struct block {
+      std::atomic<const KVInverseRangeTable*> fTables[kMaxA];
+      block()
+      {
+         for (int a = 0; a < kMaxA; ++a) fTables[a].store(nullptr, std::memory_order_relaxed);
+      }
+   };
+   std::atomic<block*> fBlocks[kMaxZ];
+   std::mutex fMutex;
+   std::vector<std::unique_ptr<block> > fOwnedBlocks;
+   std::vector<std::unique_ptr<KVInverseRangeTable> > fOwnedTables;
+
+   KVInverseRangeTableCache()
+   {
+      for (int z = 0; z < kMaxZ; ++z) fBlocks[z].store(nullptr, std::memory_order_relaxed);
+   }
+   const KVInverseRangeTable* find(Int_t Z, Int_t A) const
+   {
+      // table for (Z,A) if already built (which may have less than 2 nodes, if building failed)
+      block* b = fBlocks[Z].load(std::memory_order_acquire);
+      return (b ? b->fTables[A].load(std::memory_order_acquire) : nullptr);
+   }
+   const KVInverseRangeTable* add(Int_t Z, Int_t A, std::unique_ptr<KVInverseRangeTable> tab)
+   {
+      // publish table for (Z,A), unless another thread already did so: returns the published table
+      std::lock_guard<std::mutex> lock(fMutex);
+      block* b = fBlocks[Z].load(std::memory_order_relaxed);
+      if (!b) {
+         fOwnedBlocks.emplace_back(b = new block);
+         fBlocks[Z].store(b, std::memory_order_release);
+      }
+      const KVInverseRangeTable* t = b->fTables[A].load(std::memory_order_relaxed);
+      if (t) return t;
+      fOwnedTables.push_back(std::move(tab));
+      t = fOwnedTables.back().get();
+      b->fTables[A].store(t, std::memory_order_release);
+      return t;
+   }
+};
+#endif
+
 ClassImp(KVIonRangeTableMaterial)
 
 KVIonRangeTableMaterial::KVIonRangeTableMaterial()
@@ -27,9 +87,15 @@ KVIonRangeTableMaterial::KVIonRangeTableMaterial()
      fDeltaE(0),
      fEres(0),
      fRange(0),
-     fStopping(0)
+     fStopping(0),
+     fUseInvRangeTables(kFALSE),
+     fInvRangeTablePrecision(1.e-4),
+     fInvRangeTables(nullptr)
 {
    // Default constructor
+#ifdef WITH_CPP11
+   fInvRangeTables = new KVInverseRangeTableCache;
+#endif
 }
 
 KVIonRangeTableMaterial::KVIonRangeTableMaterial(const KVIonRangeTable* tab, const Char_t* name, const Char_t* symbol,
@@ -47,7 +113,10 @@ KVIonRangeTableMaterial::KVIonRangeTableMaterial(const KVIonRangeTable* tab, con
      fDeltaE(0),
      fEres(0),
      fRange(0),
-     fStopping(0)
+     fStopping(0),
+     fUseInvRangeTables(kFALSE),
+     fInvRangeTablePrecision(1.e-4),
+     fInvRangeTables(nullptr)
 {
    // Create new material with given (long) name and symbol
    //        symbol convention: for elements, use element symbol. for compounds, use chemical formula.
@@ -60,8 +129,12 @@ KVIonRangeTableMaterial::KVIonRangeTableMaterial(const KVIonRangeTable* tab, con
    // will be used automatically, unless a different value is given here.
    // Densities of gases are calculated from the molar weight, temperature and pressure.
 
+#ifdef WITH_CPP11
+   fInvRangeTables = new KVInverseRangeTableCache;
+#endif
+
    if (Z > 0 && density < 0) {
-      KVElementDensity* ed = (KVElementDensity*)gNDTManager->GetData(Z, A, "ElementDensity");
+      KVElementDensity* ed = (KVElementDensity*)gNDTManager->GetData(Z, A, KVNDTManager::kElementDensity);
       if (!ed) {
          Warning("KVIonRangeTableMaterial",
                  "No element found in density table with Z=%f, density unknown", Z);
@@ -86,7 +159,10 @@ KVIonRangeTableMaterial::KVIonRangeTableMaterial(const KVIonRangeTableMaterial&
    fDeltaE(0),
    fEres(0),
    fRange(0),
-   fStopping(0)
+   fStopping(0),
+   fUseInvRangeTables(kFALSE),
+   fInvRangeTablePrecision(1.e-4),
+   fInvRangeTables(nullptr)
 {
    // Copy constructor
    // This ctor is used to make a copy of an existing object (for example
@@ -94,6 +170,9 @@ KVIonRangeTableMaterial::KVIonRangeTableMaterial(const KVIonRangeTableMaterial&
    // implement it.
    // If your class allocates memory in its constructor(s) then it is ESSENTIAL :-)
 
+#ifdef WITH_CPP11
+   fInvRangeTables = new KVInverseRangeTableCache;
+#endif
    obj.Copy(*this);
 }
 
@@ -105,6 +184,9 @@ KVIonRangeTableMaterial::~KVIonRangeTableMaterial()
    SafeDelete(fEres);
    SafeDelete(fDeltaE);
    SafeDelete(fStopping);
+#ifdef WITH_CPP11
+   SafeDelete(fInvRangeTables);
+#endif
 }
 
 //________________________________________________________________
@@ -119,7 +201,9 @@ void KVIonRangeTableMaterial::Copy(TObject& obj) const
    //    CastedObj.SetToto( GetToto() );
 
    KVBase::Copy(obj);
-   //KVIonRangeTableMaterial& CastedObj = (KVIonRangeTableMaterial&)obj;
+   KVIonRangeTableMaterial& CastedObj = (KVIonRangeTableMaterial&)obj;
+   CastedObj.fUseInvRangeTables = fUseInvRangeTables;
+   CastedObj.fInvRangeTablePrecision = fInvRangeTablePrecision;
 }
 
 void KVIonRangeTableMaterial::AddCompoundElement(Int_t Z, Int_t A, Int_t Natoms)
@@ -175,6 +259,12 @@ void KVIonRangeTableMaterial::Initialize()
    // Correctly initialize material ready for use
    // For compound or mixed materials, calculate normalised weights of components,
    // effective Z and A, and molar weight of substance
+   //
+   // Use of inverse range tables is set according to environment variables
+   // KVIonRangeTable.InverseRangeTables and KVIonRangeTable.InverseRangeTables.Precision
+
+   SetUseInverseRangeTables(gEnv->GetValue("KVIonRangeTable.InverseRangeTables", kFALSE),
+                            gEnv->GetValue("KVIonRangeTable.InverseRangeTables.Precision", 1.e-4));
 
    fMoleWt = 0.;
    if (IsCompound() || IsMixture()) {
@@ -306,6 +396,7 @@ Double_t KVIonRangeTableMaterial::GetDeltaEOfIon(Int_t Z, Int_t A, Double_t E, D
    // Returns energy lost (in MeV) by ion (Z,A) with energy E (MeV) after thickness e (in g/cm**2).
    // Give Amat to change default (isotopic) mass of material,
 
+   if (GetInverseRangeTable(Z, A, isoAmat)) return E - GetEResOfIon(Z, A, E, e, isoAmat);
    TF1* f = GetDeltaEFunction(e, Z, A, isoAmat);
    return f->Eval(E);
 }
@@ -328,6 +419,12 @@ Double_t KVIonRangeTableMaterial::GetEResOfIon(Int_t Z, Int_t A, Double_t E, Dou
    // Returns energy lost (in MeV) by ion (Z,A) with energy E (MeV) after thickness e (in g/cm**2).
    // Give Amat to change default (isotopic) mass of material,
 
+   if (const KVInverseRangeTable* tab = GetInverseRangeTable(Z, A, isoAmat)) {
+      Double_t R0 = GetRangeOfIon(Z, A, E, isoAmat);
+      if (R0 <= e) return 0.;
+      Double_t eres = tab->GetEnergy(R0 - e);
+      if (eres >= 0) return eres;
+   }
    TF1* f = GetEResFunction(e, Z, A, isoAmat);
    return f->Eval(E);
 }
@@ -344,10 +441,57 @@ Double_t KVIonRangeTableMaterial::GetLinearEResOfIon(Int_t Z, Int_t A, Double_t
    return GetEResOfIon(Z, A, E, e, isoAmat);
 }
 
+void KVIonRangeTableMaterial::GetEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E,
+      const Double_t* e, Double_t* Eres, Double_t* DeltaE)
+{
+   // Calculate residual energies of n ions after crossing given thicknesses of material.
+   //
+   // \param[in] Z,A arrays of ion charges and masses
+   // \param[in] E array of incident energies in MeV
+   // \param[in] e array of thicknesses in \f$g/cm^2\f$
+   // \param[out] Eres array to be filled with residual energies in MeV
+   // \param[out] DeltaE if given, array to be filled with energy losses in MeV
+
+   CalculateEResOfIons(n, Z, A, E, e, 1., Eres);
+   if (DeltaE) for (int i = 0; i < n; ++i) DeltaE[i] = E[i] - Eres[i];
+}
+
+void KVIonRangeTableMaterial::GetLinearEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E,
+      const Double_t* d, Double_t* Eres, Double_t* DeltaE, Double_t T, Double_t P)
+{
+   // Calculate residual energies of n ions after crossing given thicknesses of material.
+   //
+   // \param[in] Z,A arrays of ion charges and masses
+   // \param[in] E array of incident energies in MeV
+   // \param[in] d array of thicknesses in cm
+   // \param[out] Eres array to be filled with residual energies in MeV
+   // \param[out] DeltaE if given, array to be filled with energy losses in MeV
+   // \param[in] T,P temperature (degrees C) & pressure (torr) for gaseous materials.
+
+   SetTemperatureAndPressure(T, P);
+   CalculateEResOfIons(n, Z, A, E, d, GetDensity(), Eres);
+   if (DeltaE) for (int i = 0; i < n; ++i) DeltaE[i] = E[i] - Eres[i];
+}
+
+void KVIonRangeTableMaterial::CalculateEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E,
+      const Double_t* e, Double_t scale, Double_t* Eres)
+{
+   // Calculate residual energies Eres of n ions (Z,A) with incident energies E after thicknesses
+   // scale*e (in \f$g/cm^2\f$).
+   //
+   // Default implementation calls GetEResOfIon() for each ion.
+
+   for (int i = 0; i < n; ++i) Eres[i] = (Z[i] > 0 ? GetEResOfIon(Z[i], A[i], E[i], scale * e[i]) : E[i]);
+}
+
 Double_t KVIonRangeTableMaterial::GetEIncFromEResOfIon(Int_t Z, Int_t A, Double_t Eres, Double_t e, Double_t isoAmat)
 {
    // Calculates incident energy (in MeV) of an ion (Z,A) with residual energy Eres (MeV) after thickness e (in g/cm**2).
    // Give Amat to change default (isotopic) mass of material,
+   if (const KVInverseRangeTable* tab = GetInverseRangeTable(Z, A, isoAmat)) {
+      Double_t einc = tab->GetEnergy(GetRangeOfIon(Z, A, Eres, isoAmat) + e);
+      if (einc >= 0) return einc;
+   }
    GetRangeFunction(Z, A, isoAmat);
    Double_t R0 = fRange->Eval(Eres) + e;
    return fRange->GetX(R0);
@@ -369,6 +513,25 @@ Double_t KVIonRangeTableMaterial::GetEIncFromDeltaEOfIon(Int_t Z, Int_t A, Doubl
 {
    // Calculates incident energy (in MeV) of an ion (Z,A) from energy loss DeltaE (MeV) in thickness e (in g/cm**2).
    // Give Amat to change default (isotopic) mass of material,
+   if (GetInverseRangeTable(Z, A, isoAmat)) {
+      // bisection using residual energies calculated with inverse range table
+      Double_t e1 = 0, e2 = GetEmaxValid(Z, A);
+      Double_t emaxde = GetEIncOfMaxDeltaEOfIon(Z, A, e, isoAmat);
+      if (type == KVIonRangeTable::kEmin) e2 = emaxde;
+      else e1 = emaxde;
+      Double_t f1 = e1 - GetEResOfIon(Z, A, e1, e, isoAmat) - DeltaE;
+      for (int it = 0; it < 200 && (e2 - e1) > 1.e-10 * (e1 + e2); ++it) {
+         Double_t em = 0.5 * (e1 + e2);
+         Double_t fm = em - GetEResOfIon(Z, A, em, e, isoAmat) - DeltaE;
+         if ((fm > 0) == (f1 > 0)) {
+            e1 = em;
+            f1 = fm;
+         }
+         else
+            e2 = em;
+      }
+      return 0.5 * (e1 + e2);
+   }
    GetDeltaEFunction(e, Z, A, isoAmat);
    Double_t e1, e2;
    fDeltaE->GetRange(e1, e2);
@@ -402,6 +565,10 @@ Double_t KVIonRangeTableMaterial::GetPunchThroughEnergy(Int_t Z, Int_t A, Double
    // for all energies above this energy the residual energy is > 0.
    // Give Amat to change default (isotopic) mass of material.
 
+   if (const KVInverseRangeTable* tab = GetInverseRangeTable(Z, A, isoAmat)) {
+      Double_t einc = tab->GetEnergy(e);
+      if (einc >= 0) return einc;
+   }
    return GetRangeFunction(Z, A, isoAmat)->GetX(e);
 }
 
@@ -485,3 +652,34 @@ TGeoMaterial* KVIonRangeTableMaterial::GetTGeoMaterial() const
    else gmat->SetState(TGeoMaterial::kMatStateSolid);
    return gmat;
 }
+
+const KVInverseRangeTable* KVIonRangeTableMaterial::GetInverseRangeTable(Int_t Z, Int_t A, Double_t isoAmat)
+{
+   // \returns tabulated inverse range-energy relation for ion (Z,A), or nullptr if not in use
+   // (see SetUseInverseRangeTables()), or if a non-default isotopic mass of material is given.
+   //
+   // The table is built the first time it is required. This method can be called from
+   // several threads. Tables which have already been built are found without taking any lock.
+   // A new table is built without holding any lock (two threads may build the same
+   // table at the same time, only one is kept), so that building can call GetRangeOfIon() even if it
+   // is itself serialised by a lock (e.g. KVRangeYanezMaterial).
+   //
+   // Tables are only used for Z<128 and A<512.
+
+#ifdef WITH_CPP11
+   if (!fUseInvRangeTables || isoAmat > 0 || Z < 1 || A < 1
+         || Z >= KVInverseRangeTableCache::kMaxZ || A >= KVInverseRangeTableCache::kMaxA) return nullptr;
+   const KVInverseRangeTable* tab = fInvRangeTables->find(Z, A);
+   if (!tab) {
+      std::unique_ptr<KVInverseRangeTable> new_tab(new KVInverseRangeTable(this, Z, A, fInvRangeTablePrecision));
+      tab = fInvRangeTables->add(Z, A, std::move(new_tab));
+   }
+   // tables with less than 2 nodes (failed to build) are kept so that we do not try again
+   return (tab->GetNumberOfNodes() < 2 ? nullptr : tab);
+#else
+   (void)Z;
+   (void)A;
+   (void)isoAmat;
+   return nullptr;
+#endif
+}
@@ -11,6 +11,8 @@
 
 class TGeoMaterial;
 class TF1;
+class KVInverseRangeTable;
+class KVInverseRangeTableCache;
 
 #define RTT  62.36367e+03  // cm^3.Torr.K^-1.mol^-1
 #define ZERO_KELVIN  273.15
@@ -20,6 +22,31 @@ class TF1;
 \brief Material for use in energy loss & range calculations
 \ingroup Stopping
 
+### Inverse range tables
+Calculation of incident energies from residual energy or energy loss, and of residual energies, requires
+the inversion of the range-energy relation, which is usually performed by numerical root-finding (TF1::GetX).
+If SetUseInverseRangeTables() is called, or if the following environment variable is set:
+
+~~~~
+KVIonRangeTable.InverseRangeTables: yes
+~~~~
+
+then for each ion a KVInverseRangeTable is built (the first time it is needed) and used instead:
+this is much faster, with a maximum relative error on calculated energies (an upper bound of the
+error of the interpolation between the nodes of each table, see KVInverseRangeTable) given by
+
+~~~~
+KVIonRangeTable.InverseRangeTables.Precision: 1.e-4
+~~~~
+
+Tables are not used if a non-default isotopic mass of material (isoAmat) is given.
+
+### Calculations for many ions
+GetEResOfIons() and GetLinearEResOfIons() calculate residual energies (and, optionally, energy losses)
+for arrays of ions with different Z, A, incident energies and thicknesses in a single call.
+Derived classes may override CalculateEResOfIons() in order to optimise such calculations
+(see KVedaLossMaterial).
+
 \sa KVIonRangeTable
  */
 
@@ -42,6 +69,14 @@ protected:
    TF1* fRange; // function parameterising range of charged particles in material
    TF1* fStopping; // function parameterising stopping power of charged particles in material
 
+   Bool_t fUseInvRangeTables;//! use tabulated inverse range-energy relations
+   Double_t fInvRangeTablePrecision;//! required precision of tabulated inverse range-energy relations
+   KVInverseRangeTableCache* fInvRangeTables;//! tabulated inverse range-energy relations for each ion
+
+   const KVInverseRangeTable* GetInverseRangeTable(Int_t Z, Int_t A, Double_t isoAmat);
+   virtual void CalculateEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E, const Double_t* e,
+                                    Double_t scale, Double_t* Eres);
+
 public:
    KVIonRangeTableMaterial();
    KVIonRangeTableMaterial(const KVIonRangeTable*, const Char_t* name, const Char_t* symbol, const Char_t* state,
@@ -154,6 +189,11 @@ public:
    virtual Double_t GetEResOfIon(Int_t Z, Int_t A, Double_t E, Double_t e, Double_t isoAmat = 0.);
    virtual Double_t GetLinearEResOfIon(Int_t Z, Int_t A, Double_t E, Double_t e, Double_t isoAmat = 0., Double_t T = -1., Double_t P = -1.);
 
+   void GetEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E, const Double_t* e,
+                      Double_t* Eres, Double_t* DeltaE = nullptr);
+   void GetLinearEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E, const Double_t* d,
+                            Double_t* Eres, Double_t* DeltaE = nullptr, Double_t T = -1., Double_t P = -1.);
+
    virtual Double_t GetEIncFromEResOfIon(Int_t Z, Int_t A, Double_t Eres, Double_t e, Double_t isoAmat = 0.);
    virtual Double_t GetLinearEIncFromEResOfIon(Int_t Z, Int_t A, Double_t Eres, Double_t e, Double_t isoAmat = 0., Double_t T = -1., Double_t P = -1.);
 
@@ -184,10 +224,24 @@ public:
    virtual Double_t GetLinearMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat = 0., Double_t T = -1., Double_t P = -1.);
    virtual Double_t GetLinearEIncOfMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat = 0., Double_t T = -1., Double_t P = -1.);
 
+   void SetUseInverseRangeTables(Bool_t yes = kTRUE, Double_t precision = 1.e-4)
+   {
+      // Use (or not) tabulated inverse range-energy relations with given precision.
+      // Call before using material in different threads.
+      fUseInvRangeTables = yes;
+      fInvRangeTablePrecision = precision;
+   }
+   Bool_t IsUseInverseRangeTables() const
+   {
+      return fUseInvRangeTables;
+   }
+
    Double_t GetRangeOfLastDE() const
    {
       // Returns range (in g/cm) of particle of last calculated dE
       // Divide by density of material to get range in cm.
+      // Only set when using the TF1 functions (GetDeltaEFunction() etc.): reentrant implementations
+      // of GetDeltaEOfIon() (e.g. KVedaLossMaterial) do not modify the state of the material.
       return fRangeOfLastDE;
    }
 
@@ -159,7 +159,7 @@ KVIonRangeTableMaterial* KVRangeYanez::AddElementalMaterial(Int_t z, Int_t a) co
                "Nuclear data tables have not been initialised");
          return nullptr;
       }
-      KVElementDensity* ed = (KVElementDensity*)gNDTManager->GetData(z, a, "ElementDensity");
+      KVElementDensity* ed = (KVElementDensity*)gNDTManager->GetData(z, a, KVNDTManager::kElementDensity);
       if (!ed) {
          Error("AddElementalMaterial",
                "No element found in ElementDensity NDT-table with Z=%d", z);
@@ -251,7 +251,7 @@ KVIonRangeTableMaterial* KVRangeYanez::MakeNaturallyOccuringElementMixture(Int_t
             "Nuclear data tables have not been initialised");
       return nullptr;
    }
-   KVElementDensity* ed = (KVElementDensity*)gNDTManager->GetData(z, z, "ElementDensity");
+   KVElementDensity* ed = (KVElementDensity*)gNDTManager->GetData(z, z, KVNDTManager::kElementDensity);
    if (!ed) {
       Error("AddElementalMaterial",
             "No element found in ElementDensity NDT-table with Z=%d", z);
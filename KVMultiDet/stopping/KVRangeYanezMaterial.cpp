@@ -10,8 +10,19 @@
 #include "KVConfig.h"
 
 #include <KVNucleus.h>
+#ifdef WITH_CPP11
+#include <mutex>
+#endif
 using namespace std;
 
+#ifdef WITH_CPP11
+// the Range C library uses global variables: all calls must be serialised
+static std::recursive_mutex range_lib_mutex;
+#define LOCK_RANGE_LIB std::lock_guard<std::recursive_mutex> range_lib_lock(range_lib_mutex)
+#else
+#define LOCK_RANGE_LIB
+#endif
+
 namespace range {
 # define NELMAX 10
    int nelem;
@@ -241,10 +252,69 @@ Double_t KVRangeYanezMaterial::GetEIncFromEResOfIon(Int_t Z, Int_t A, Double_t E
    // Overrides KVIonRangeTableMaterial method to use the egassap() function of  the Range C library.
    // Calculates incident energy (in MeV) of an ion (Z,A) with residual energy Eres (MeV) after thickness e (in g/cm**2).
    // isotopic mass isoAmat argument is not used.
+   LOCK_RANGE_LIB;
    PrepareRangeLibVariables(Z, A);
    return egassap(fTableType, Zp, Ap, iabso, fAbsorb[0].z, fAbsorb[0].a, e / KVUnits::mg, Eres, &error);
 }
 
+Double_t KVRangeYanezMaterial::GetRangeOfIon(Int_t Z, Int_t A, Double_t E, Double_t isoAmat)
+{
+   // Thread-safe (serialised) version of KVIonRangeTableMaterial::GetRangeOfIon()
+   LOCK_RANGE_LIB;
+   return KVIonRangeTableMaterial::GetRangeOfIon(Z, A, E, isoAmat);
+}
+
+Double_t KVRangeYanezMaterial::GetDeltaEOfIon(Int_t Z, Int_t A, Double_t E, Double_t e, Double_t isoAmat)
+{
+   // Thread-safe (serialised) version of KVIonRangeTableMaterial::GetDeltaEOfIon()
+   LOCK_RANGE_LIB;
+   return KVIonRangeTableMaterial::GetDeltaEOfIon(Z, A, E, e, isoAmat);
+}
+
+Double_t KVRangeYanezMaterial::GetEResOfIon(Int_t Z, Int_t A, Double_t E, Double_t e, Double_t isoAmat)
+{
+   // Thread-safe (serialised) version of KVIonRangeTableMaterial::GetEResOfIon()
+   LOCK_RANGE_LIB;
+   return KVIonRangeTableMaterial::GetEResOfIon(Z, A, E, e, isoAmat);
+}
+
+Double_t KVRangeYanezMaterial::GetEIncFromDeltaEOfIon(Int_t Z, Int_t A, Double_t DeltaE, Double_t e, enum KVIonRangeTable::SolType type, Double_t isoAmat)
+{
+   // Thread-safe (serialised) version of KVIonRangeTableMaterial::GetEIncFromDeltaEOfIon()
+   LOCK_RANGE_LIB;
+   return KVIonRangeTableMaterial::GetEIncFromDeltaEOfIon(Z, A, DeltaE, e, type, isoAmat);
+}
+
+Double_t KVRangeYanezMaterial::GetPunchThroughEnergy(Int_t Z, Int_t A, Double_t e, Double_t isoAmat)
+{
+   // Thread-safe (serialised) version of KVIonRangeTableMaterial::GetPunchThroughEnergy()
+   LOCK_RANGE_LIB;
+   return KVIonRangeTableMaterial::GetPunchThroughEnergy(Z, A, e, isoAmat);
+}
+
+Double_t KVRangeYanezMaterial::GetMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat)
+{
+   // Thread-safe (serialised) version of KVIonRangeTableMaterial::GetMaxDeltaEOfIon()
+   LOCK_RANGE_LIB;
+   return KVIonRangeTableMaterial::GetMaxDeltaEOfIon(Z, A, e, isoAmat);
+}
+
+Double_t KVRangeYanezMaterial::GetEIncOfMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat)
+{
+   // Thread-safe (serialised) version of KVIonRangeTableMaterial::GetEIncOfMaxDeltaEOfIon()
+   LOCK_RANGE_LIB;
+   return KVIonRangeTableMaterial::GetEIncOfMaxDeltaEOfIon(Z, A, e, isoAmat);
+}
+
+void KVRangeYanezMaterial::CalculateEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E, const Double_t* e,
+      Double_t scale, Double_t* Eres)
+{
+   // Thread-safe (serialised) version of KVIonRangeTableMaterial::CalculateEResOfIons()
+   // (the lock is only taken once for all ions)
+   LOCK_RANGE_LIB;
+   KVIonRangeTableMaterial::CalculateEResOfIons(n, Z, A, E, e, scale, Eres);
+}
+
 void KVRangeYanezMaterial::SaveMaterial(ofstream& matfile)
 {
    // Write definition of material in a file in the directory
@@ -8,6 +8,11 @@
  \ingroup Stopping
  \brief Description of absorber for the Range dE/dx and range library
 
+ Calculations use the Range C library, which stores the absorber composition and intermediate results in
+ global variables. All calculations (GetRangeOfIon(), GetDeltaEOfIon(), etc.) are therefore serialised by a
+ mutex shared by all materials, so that they can be called from different threads (although they will not be
+ executed concurrently).
+
  \sa KVRangeYanez
  */
 
@@ -35,6 +40,8 @@ protected:
    Double_t EResFunc(Double_t*, Double_t*);
 
    void MakeFunctionObjects();
+   void CalculateEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E, const Double_t* e,
+                            Double_t scale, Double_t* Eres);
 
 public:
    KVRangeYanezMaterial();
@@ -58,7 +65,14 @@ public:
       fTableType = type;
    };
 
+   virtual Double_t GetRangeOfIon(Int_t Z, Int_t A, Double_t E, Double_t isoAmat = 0.);
+   virtual Double_t GetDeltaEOfIon(Int_t Z, Int_t A, Double_t E, Double_t e, Double_t isoAmat = 0.);
+   virtual Double_t GetEResOfIon(Int_t Z, Int_t A, Double_t E, Double_t e, Double_t isoAmat = 0.);
    virtual Double_t GetEIncFromEResOfIon(Int_t Z, Int_t A, Double_t Eres, Double_t e, Double_t isoAmat = 0.);
+   virtual Double_t GetEIncFromDeltaEOfIon(Int_t Z, Int_t A, Double_t DeltaE, Double_t e, enum KVIonRangeTable::SolType type = KVIonRangeTable::kEmax, Double_t isoAmat = 0.);
+   virtual Double_t GetPunchThroughEnergy(Int_t Z, Int_t A, Double_t e, Double_t isoAmat = 0.);
+   virtual Double_t GetMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat = 0.);
+   virtual Double_t GetEIncOfMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat = 0.);
 
    Int_t GetNElem() const
    {
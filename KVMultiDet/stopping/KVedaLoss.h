@@ -41,7 +41,7 @@ class KVedaLoss : public KVIonRangeTable {
       return kTRUE;
    };
    KVIonRangeTableMaterial* GetMaterialWithNameOrType(const Char_t* material) const;
-   static Bool_t fgNewRangeInversion;// static flag for using new KVedaLossInverseRangeFunction
+   static Bool_t fgNewRangeInversion;// static flag for using new KVedaLossInverseRangeFunction in TF1 functions
 
    void AddMaterial(KVIonRangeTableMaterial*) const;
 
@@ -57,6 +57,11 @@ public:
 
    static void SetUseNewRangeInversion(Bool_t yes = kTRUE)
    {
+      // Deprecated: only concerns the inversion of the range function in the TF1 objects given by
+      // KVedaLossMaterial::GetEResFunction() and KVedaLossMaterial::GetDeltaEFunction()
+      // (KVedaLossInverseRangeFunction if yes=kTRUE, TF1::GetX() otherwise).
+      // GetEResOfIon(), GetEIncFromEResOfIon() etc. always use the exact (and reentrant) inversion
+      // of KVedaLossMaterial::EnergyFromRange().
       fgNewRangeInversion = yes;
    }
    static Bool_t IsUseNewRangeInversion()
@@ -8,6 +8,7 @@
 #include <TF1.h>
 #include "KVedaLossInverseRangeFunction.h"
 #include "KVedaLoss.h"
+#include "KVInverseRangeTable.h"
 
 ClassImp(KVedaLossMaterial)
 
@@ -15,27 +16,29 @@ Bool_t KVedaLossMaterial::fNoLimits = kFALSE;
 KVedaLoss* KVedaLossMaterial::fgTable = nullptr;
 
 KVedaLossMaterial::KVedaLossMaterial()
-   : KVIonRangeTableMaterial(), fInvRange(ZMAX_VEDALOSS, 1),
-     fEmin(ZMAX_VEDALOSS), fEmax(ZMAX_VEDALOSS), fCoeff(ZMAX_VEDALOSS, std::vector<Double_t>(14))
+   : KVIonRangeTableMaterial(), fFuncZ(0), thickness(0.), fInvRange(ZMAX_VEDALOSS, 1),
+     fIonPar(ZMAX_VEDALOSS), fEmin(ZMAX_VEDALOSS), fEmax(ZMAX_VEDALOSS), fCoeff(ZMAX_VEDALOSS, std::vector<Double_t>(14))
 {
    // Default constructor
    for (int i = 0; i < ZMAX_VEDALOSS; i++) {
       fEmin[i] = 0.0;
       fEmax[i] = 500.0;
+      set_range_parameters(i + 1);
    }
    fInvRange.SetOwner();
 }
 
 KVedaLossMaterial::KVedaLossMaterial(const KVIonRangeTable* t, const Char_t* name, const Char_t* type, const Char_t* state,
                                      Double_t density, Double_t Z, Double_t A, Double_t)
-   : KVIonRangeTableMaterial(t, name, type, state, density, Z, A), fInvRange(ZMAX_VEDALOSS, 1),
-     fEmin(ZMAX_VEDALOSS), fEmax(ZMAX_VEDALOSS), fCoeff(ZMAX_VEDALOSS, std::vector<Double_t>(14))
+   : KVIonRangeTableMaterial(t, name, type, state, density, Z, A), fFuncZ(0), thickness(0.), fInvRange(ZMAX_VEDALOSS, 1),
+     fIonPar(ZMAX_VEDALOSS), fEmin(ZMAX_VEDALOSS), fEmax(ZMAX_VEDALOSS), fCoeff(ZMAX_VEDALOSS, std::vector<Double_t>(14))
 {
    // create new material
    fgTable = static_cast<KVedaLoss*>(const_cast<KVIonRangeTable*>(t));
    for (int i = 0; i < ZMAX_VEDALOSS; i++) {
       fEmin[i] = 0.0;
       fEmax[i] = 500.0;
+      set_range_parameters(i + 1);
    }
    fInvRange.SetOwner();
 }
@@ -160,6 +163,7 @@ Bool_t KVedaLossMaterial::ReadRangeTable(FILE* fp)
             return kFALSE;
          }
       }
+      set_range_parameters(count + 1);
       if (fNoLimits) {
          // if we ignore nominal validity limits on incident energy, we must still use energy limits
          // such that all range functions increase monotonically in the energy interval
@@ -203,7 +207,7 @@ Double_t KVedaLossMaterial::EResFunc(Double_t* E, Double_t*)
    // \param E[0] incident energy given in MeV.
    // \returns  residual energy calculated in MeV.
 
-   Double_t R0 = RangeFunc(E, nullptr);
+   Double_t R0 = Range(fFuncPar, E[0]);
    if (R0 < thickness) {// if range < thickness, particle stops: Eres=0
       fRangeOfLastDE = R0;
       return 0.0;
@@ -215,12 +219,258 @@ Double_t KVedaLossMaterial::EResFunc(Double_t* E, Double_t*)
    R0 -= thickness;
 
    // invert range function to get energy after absorber
+   // (KVedaLoss::SetUseNewRangeInversion() only concerns this TF1: GetEResOfIon() etc. use EnergyFromRange())
    if (fgTable->IsUseNewRangeInversion()) {
-      return static_cast<KVedaLossInverseRangeFunction*>(fInvRange[RF_Z])->GetEnergyPerNucleon(R0, riso) * RF_A;
+      return static_cast<KVedaLossInverseRangeFunction*>(fInvRange[fFuncZ])->GetEnergyPerNucleon(R0, fFuncPar.riso) * fFuncPar.A;
    }
    return fRange->GetX(R0);
 }
 
+void KVedaLossMaterial::set_range_parameters(Int_t Z)
+{
+   // Calculate the parts of the range parameters which only depend on the atomic number of the ion,
+   // i.e. on its range table coefficients. Called each time the coefficients for Z are set
+   // (constructor, ReadRangeTable()), they never change afterwards.
+
+   RangeParameters& p = fIonPar[Z - 1];
+   p.par = fCoeff[Z - 1].data();
+   p.A = p.par[1];
+   // below 0.1 MeV/nucleon, log(range) is extrapolated linearly from its values at 0.1 & 0.2 MeV/nucleon
+   Double_t x1 = TMath::Log(0.1);
+   Double_t x2 = TMath::Log(0.2);
+   Double_t y1 = LogRange(p.par, x1);
+   Double_t y2 = LogRange(p.par, x2);
+   p.adm = (y2 - y1) / (x2 - x1);
+   p.adn = (y1 - p.adm * x1);
+   p.riso = 1.;
+   p.emax = 0.;
+}
+
+KVedaLossMaterial::RangeParameters KVedaLossMaterial::GetRangeParameters(Int_t Z, Int_t A, Double_t isoAmat) const
+{
+   // \returns parameters of range function for ion (Z,A) in this material
+   // \param isoAmat If required, the isotopic mass of the material can be given.
+   //
+   // The costly parts (extrapolation of the range below 0.1 MeV/nucleon) only depend on Z and are
+   // calculated once and for all when the range table is read; only the mass-dependent
+   // factors are calculated here. Nothing is modified after the table has been read:
+   // this method can safely be called from any thread.
+
+   RangeParameters p = fIonPar[Z - 1];
+   p.A = A;
+   p.riso = A / p.par[1];
+   if (isoAmat > 0.0) p.riso *= (isoAmat / fAmat);
+   p.emax = GetEmaxValid(Z, A);
+   return p;
+}
+
+Double_t KVedaLossMaterial::Range(const RangeParameters& p, Double_t E) const
+{
+   // \param p parameters for ion obtained from GetRangeParameters()
+   // \param E incident energy in MeV
+   // \returns range calculated in units of \f$g/cm^2\f$
+
+   if (E <= 0) return 0.;
+   Double_t eps = E / p.A;
+   Double_t dleps = TMath::Log(eps);
+   Double_t ran = (eps < 0.1 ? p.adm * dleps + p.adn : LogRange(p.par, dleps));
+   // range in g/cm**2
+   return p.riso * TMath::Exp(ran) * KVUnits::mg;
+}
+
+Double_t KVedaLossMaterial::StoppingPower(const RangeParameters& p, Double_t E) const
+{
+   // \param p parameters for ion obtained from GetRangeParameters()
+   // \param E incident energy in MeV
+   // \returns stopping power calculated in units of \f$MeV/(g/cm^2)\f$
+
+   Double_t eps = E / p.A;
+   Double_t dleps = TMath::Log(eps);
+   if (eps < 0.1) {
+      Double_t ran = p.adm * dleps + p.adn;
+      return E / (p.riso * TMath::Exp(ran) * KVUnits::mg) / p.adm;
+   }
+   Double_t ran = LogRange(p.par, dleps);
+   Double_t drande = LogRangeDerivative(p.par, dleps);
+   return E / (p.riso * TMath::Exp(ran) * KVUnits::mg) / drande;
+}
+
+Double_t KVedaLossMaterial::EnergyFromRange(const RangeParameters& p, Double_t R) const
+{
+   // Inversion of the range function
+   //
+   // \param p parameters for ion obtained from GetRangeParameters()
+   // \param R range in \f$g/cm^2\f$
+   // \returns incident energy in MeV corresponding to range R
+   //
+   // The solution is found by Newton-Raphson iteration on the polynomial parameterisation
+   // of log(range) vs. log(E/A), safeguarded by bisection. Results are limited to the interval
+   // \f$[0,E_{max}]\f$ of validity of the range tables (like TF1::GetX for the range function).
+
+   if (R <= 0) return 0.;
+   Double_t y = TMath::Log(R / (p.riso * KVUnits::mg));
+   Double_t lo = TMath::Log(0.1);
+   if (y < p.adm * lo + p.adn) {
+      // below 0.1 MeV/nucleon: log(range) is linear in log(E/A)
+      return p.A * TMath::Exp((y - p.adn) / p.adm);
+   }
+   Double_t hi = TMath::Log(p.emax / p.A);
+   Double_t ylo = LogRange(p.par, lo);
+   Double_t yhi = LogRange(p.par, hi);
+   if (y >= yhi) return p.emax;
+   // starting point: linear interpolation between limits
+   Double_t x = lo + (y - ylo) / (yhi - ylo) * (hi - lo);
+   for (int it = 0; it < 100; ++it) {
+      Double_t f = LogRange(p.par, x) - y;
+      if (f > 0) hi = x;
+      else lo = x;
+      Double_t d = LogRangeDerivative(p.par, x);
+      Double_t xnew = (d > 0 ? x - f / d : 0.5 * (lo + hi));
+      if (xnew <= lo || xnew >= hi) xnew = 0.5 * (lo + hi);
+      if (TMath::Abs(xnew - x) < 1.e-12 * (1. + TMath::Abs(x))) {
+         x = xnew;
+         break;
+      }
+      x = xnew;
+   }
+   return p.A * TMath::Exp(x);
+}
+
+Double_t KVedaLossMaterial::EIncOfMaxDeltaE(const RangeParameters& p, Double_t e) const
+{
+   // \param p parameters for ion obtained from GetRangeParameters()
+   // \param e thickness in \f$g/cm^2\f$
+   // \returns incident energy in MeV for which energy loss in thickness e is maximum
+   //
+   // Below the punch-through energy the ion stops and the energy loss is equal to the incident energy,
+   // therefore the maximum is found by golden-section search between the punch-through energy and \f$E_{max}\f$.
+
+   Double_t a = EnergyFromRange(p, e);
+   Double_t b = p.emax;
+   if (b <= a) return a;
+   const Double_t gr = 0.5 * (TMath::Sqrt(5.) - 1.);
+   Double_t c = b - gr * (b - a);
+   Double_t d = a + gr * (b - a);
+   Double_t fc = c - ResidualEnergy(p, c, e);
+   Double_t fd = d - ResidualEnergy(p, d, e);
+   while ((b - a) > 1.e-10 * (a + b)) {
+      if (fc > fd) {
+         b = d;
+         d = c;
+         fd = fc;
+         c = b - gr * (b - a);
+         fc = c - ResidualEnergy(p, c, e);
+      }
+      else {
+         a = c;
+         c = d;
+         fc = fd;
+         d = a + gr * (b - a);
+         fd = d - ResidualEnergy(p, d, e);
+      }
+   }
+   return 0.5 * (a + b);
+}
+
+Double_t KVedaLossMaterial::SolveDeltaE(const RangeParameters& p, Double_t DeltaE, Double_t e, Double_t e1, Double_t e2,
+                                        const KVInverseRangeTable* tab) const
+{
+   // Find incident energy in interval [e1,e2] for which energy loss in thickness e is DeltaE,
+   // assuming that the energy loss is monotonic in the interval (bisection).
+   // If given, the inverse range table is used to calculate residual energies.
+
+   Double_t f1 = e1 - ResidualEnergy(p, e1, e, tab) - DeltaE;
+   for (int it = 0; it < 200 && (e2 - e1) > 1.e-10 * (e1 + e2); ++it) {
+      Double_t em = 0.5 * (e1 + e2);
+      Double_t fm = em - ResidualEnergy(p, em, e, tab) - DeltaE;
+      if ((fm > 0) == (f1 > 0)) {
+         e1 = em;
+         f1 = fm;
+      }
+      else
+         e2 = em;
+   }
+   return 0.5 * (e1 + e2);
+}
+
+Double_t KVedaLossMaterial::ResidualEnergy(const RangeParameters& p, Double_t E, Double_t e, const KVInverseRangeTable* tab) const
+{
+   // \returns residual energy (MeV) of ion with incident energy E (MeV) after thickness e (\f$g/cm^2\f$)
+   //
+   // If tab is not null, the inverse range table is used to calculate the residual energy
+   // (unless it is below the lower limit of the table).
+
+   if (!tab) return ResidualEnergy(p, E, e);
+   Double_t R0 = Range(p, E);
+   if (R0 < e) return 0.;
+   Double_t eres = tab->GetEnergy(R0 - e);
+   return (eres >= 0 ? eres : EnergyFromRange(p, R0 - e));
+}
+
+void KVedaLossMaterial::CalculateEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E, const Double_t* e,
+      Double_t scale, Double_t* Eres)
+{
+   // Calculate residual energies Eres of n ions (Z,A) with incident energies E after thicknesses
+   // scale*e (in \f$g/cm^2\f$).
+   //
+   // The ranges of all ions are first calculated together: the range table coefficients for each
+   // ion are copied into contiguous arrays so that the evaluation of the range polynomials
+   // is a simple loop without branches or indirections, which can be vectorised by the compiler.
+   // The inversion of the range function is then performed for each ion which does not stop in
+   // the material.
+
+   std::vector<Double_t> buf(11 * n);
+   Double_t* c[6];
+   for (int k = 0; k < 6; ++k) c[k] = &buf[k * n];
+   Double_t* adm = &buf[6 * n];
+   Double_t* adn = &buf[7 * n];
+   Double_t* lriso = &buf[8 * n];
+   Double_t* x = &buf[9 * n];
+   Double_t* R = &buf[10 * n];
+   std::vector<RangeParameters> p(n);
+
+   // gather parameters for each ion
+   for (int i = 0; i < n; ++i) {
+      if (Z[i] > 0 && CheckIon(Z[i])) {
+         p[i] = GetRangeParameters(Z[i], A[i]);
+         for (int k = 0; k < 6; ++k) c[k][i] = p[i].par[k + 2];
+         adm[i] = p[i].adm;
+         adn[i] = p[i].adn;
+         lriso[i] = TMath::Log(p[i].riso * KVUnits::mg);
+         x[i] = (E[i] > 0 ? TMath::Log(E[i] / A[i]) : 0.);
+      }
+      else {
+         p[i].par = nullptr;
+         for (int k = 0; k < 6; ++k) c[k][i] = 0;
+         adm[i] = adn[i] = lriso[i] = x[i] = 0;
+      }
+   }
+
+   // ranges of all ions
+   const Double_t xlow = TMath::Log(0.1);
+   for (int i = 0; i < n; ++i) {
+      Double_t xi = x[i];
+      Double_t poly = c[0][i] + xi * (c[1][i] + xi * (c[2][i] + xi * (c[3][i] + xi * (c[4][i] + xi * c[5][i]))));
+      Double_t lin = adm[i] * xi + adn[i];
+      R[i] = TMath::Exp((xi < xlow ? lin : poly) + lriso[i]) - scale * e[i];
+   }
+
+   // residual energies
+   for (int i = 0; i < n; ++i) {
+      if (!p[i].par) {
+         // neutral particles or unknown ions are not slowed down
+         Eres[i] = E[i];
+         continue;
+      }
+      if (E[i] <= 0 || R[i] <= 0) {
+         Eres[i] = 0.;
+         continue;
+      }
+      const KVInverseRangeTable* tab = GetInverseRangeTable(Z[i], A[i], 0.);
+      Double_t eres = (tab ? tab->GetEnergy(R[i]) : -1.);
+      Eres[i] = (eres >= 0 ? eres : EnergyFromRange(p[i], R[i]));
+   }
+}
 
 TF1* KVedaLossMaterial::GetRangeFunction(Int_t Z, Int_t A, Double_t isoAmat)
 {
@@ -228,36 +478,18 @@ TF1* KVedaLossMaterial::GetRangeFunction(Int_t Z, Int_t A, Double_t isoAmat)
    // charged particles \f$Z,A\f$ in this material.
    // \param isoAmat If required, the isotopic mass of the material can be given.
 
-   RF_Z = Z;
-   RF_A = A;
-   // get parameters for this Z
-   par = &fCoeff[Z - 1];
-   // set up polynomial
-   Double_t x1 = TMath::Log(0.1);
-   Double_t x2 = TMath::Log(0.2);
-   ran = 0.0;
-   for (int j = 2; j < 7; j++)
-      ran += (*par)[j + 1] * TMath::Power(x2, (Double_t)(j - 1));
-   ran += (*par)[2];
-   Double_t y2 = ran;
-   ran = 0.0;
-   for (int jj = 2; jj < 7; jj++)
-      ran += (*par)[jj + 1] * TMath::Power(x1, (Double_t)(jj - 1));
-   ran += (*par)[2];
-   Double_t y1 = ran;
-   adm = (y2 - y1) / (x2 - x1);
-   adn = (y1 - adm * x1);
-   riso = RF_A / (*par)[1];
-   if (isoAmat > 0.0) riso *= (isoAmat / fAmat);
+   fFuncZ = Z;
+   fFuncPar = GetRangeParameters(Z, A, isoAmat);
 
    fRange->SetRange(0., GetEmaxValid(Z, A));
 
    /*
     * New inversion of range-energy curve (if KVedaLoss::fgNewRangeInversion=kTRUE)
+    * used by the TF1 returned by GetEResFunction() and GetDeltaEFunction()
     */
    if (fgTable->IsUseNewRangeInversion()) {
       if (!fInvRange[Z]) {
-         fInvRange[Z] = new KVedaLossInverseRangeFunction(fRange, A, riso);
+         fInvRange[Z] = new KVedaLossInverseRangeFunction(fRange, A, fFuncPar.riso);
       }
    }
 
@@ -270,27 +502,8 @@ TF1* KVedaLossMaterial::GetStoppingFunction(Int_t Z, Int_t A, Double_t isoAmat)
    // charged particles \f$Z,A\f$ in this material.
    // \param isoAmat If required, the isotopic mass of the material can be given.
 
-   RF_Z = Z;
-   RF_A = A;
-   // get parameters for this Z
-   par = &fCoeff[Z - 1];
-   // set up polynomial
-   Double_t x1 = TMath::Log(0.1);
-   Double_t x2 = TMath::Log(0.2);
-   ran = 0.0;
-   for (int j = 2; j < 7; j++)
-      ran += (*par)[j + 1] * TMath::Power(x2, (Double_t)(j - 1));
-   ran += (*par)[2];
-   Double_t y2 = ran;
-   ran = 0.0;
-   for (int jj = 2; jj < 7; jj++)
-      ran += (*par)[jj + 1] * TMath::Power(x1, (Double_t)(jj - 1));
-   ran += (*par)[2];
-   Double_t y1 = ran;
-   adm = (y2 - y1) / (x2 - x1);
-   adn = (y1 - adm * x1);
-   riso = RF_A / (*par)[1];
-   if (isoAmat > 0.0) riso *= (isoAmat / fAmat);
+   fFuncZ = Z;
+   fFuncPar = GetRangeParameters(Z, A, isoAmat);
    fStopping->SetRange(0., GetEmaxValid(Z, A));
    return fStopping;
 }
@@ -301,21 +514,7 @@ Double_t KVedaLossMaterial::RangeFunc(Double_t* E, Double_t*)
    // \param E[0] energy is given in MeV.
    // \returns range calculated in units of \f$g/cm^2\f$
 
-   eps = E[0] / RF_A;
-   dleps = TMath::Log(eps);
-   if (eps < 0.1)
-      ran = adm * dleps + adn;
-   else {
-      DLEP = dleps;
-      ran = (*par)[2] + (*par)[3] * DLEP;
-      ran += (*par)[4] * (DLEP *= dleps);
-      ran += (*par)[5] * (DLEP *= dleps);
-      ran += (*par)[6] * (DLEP *= dleps);
-      ran += (*par)[7] * (DLEP *= dleps);
-   }
-
-   // range in g/cm**2
-   return riso * TMath::Exp(ran) * KVUnits::mg;
+   return Range(fFuncPar, E[0]);
 }
 
 Double_t KVedaLossMaterial::StoppingFunc(Double_t* E, Double_t*)
@@ -324,22 +523,7 @@ Double_t KVedaLossMaterial::StoppingFunc(Double_t* E, Double_t*)
    // \param E[0] energy is given in MeV.
    // \returns stopping power calculated in units of \f$Mev/(g/cm^2)\f$
 
-   eps = E[0] / RF_A;
-   dleps = TMath::Log(eps);
-   if (eps < 0.1) {
-      ran = adm * dleps + adn;
-      drande = E[0] / (riso * TMath::Exp(ran) * KVUnits::mg) / adm;
-      return drande;
-   }
-   DLEP = dleps;
-   ran = (*par)[2] + (*par)[3] * DLEP;
-   drande = (*par)[3];
-   for (int i = 4; i < 8; i++) {
-      drande += (i - 2) * (*par)[i] * DLEP;
-      ran += (*par)[i] * (DLEP *= dleps);
-   }
-   // range in g/cm**2
-   return E[0] / (riso * TMath::Exp(ran) * KVUnits::mg) / drande;
+   return StoppingPower(fFuncPar, E[0]);
 }
 
 TF1* KVedaLossMaterial::GetDeltaEFunction(Double_t e, Int_t Z, Int_t A, Double_t isoAmat)
@@ -374,8 +558,7 @@ Double_t KVedaLossMaterial::GetRangeOfIon(Int_t Z, Int_t A, Double_t E, Double_t
    // \param isoAmat change default (isotopic) mass of material,
 
    if (Z == 0) return 0.0; //only charged particles
-   TF1* f = GetRangeFunction(Z, A, isoAmat);
-   return f->Eval(E);
+   return Range(GetRangeParameters(Z, A, isoAmat), E);
 }
 
 Double_t KVedaLossMaterial::GetDeltaEOfIon(Int_t Z, Int_t A, Double_t E, Double_t e, Double_t isoAmat)
@@ -386,8 +569,7 @@ Double_t KVedaLossMaterial::GetDeltaEOfIon(Int_t Z, Int_t A, Double_t E, Double_
    // \param isoAmat change default (isotopic) mass of material,
 
    if (Z == 0) return 0.0; //only charged particles
-   TF1* f = GetDeltaEFunction(e, Z, A, isoAmat);
-   return f->Eval(E);
+   return E - GetEResOfIon(Z, A, E, e, isoAmat);
 }
 
 Double_t KVedaLossMaterial::GetEResOfIon(Int_t Z, Int_t A, Double_t E, Double_t e,
@@ -399,8 +581,7 @@ Double_t KVedaLossMaterial::GetEResOfIon(Int_t Z, Int_t A, Double_t E, Double_t
    // \param isoAmat change default (isotopic) mass of material,
 
    if (Z == 0) return 0.0; //only charged particles
-   TF1* f = GetEResFunction(e, Z, A, isoAmat);
-   return f->Eval(E);
+   return ResidualEnergy(GetRangeParameters(Z, A, isoAmat), E, e, GetInverseRangeTable(Z, A, isoAmat));
 }
 
 Double_t KVedaLossMaterial::GetPunchThroughEnergy(Int_t Z, Int_t A, Double_t e, Double_t isoAmat)
@@ -411,11 +592,11 @@ Double_t KVedaLossMaterial::GetPunchThroughEnergy(Int_t Z, Int_t A, Double_t e,
    // \param isoAmat change default (isotopic) mass of material,
 
    if (Z == 0) return 0.0; //only charged particles
-   GetRangeFunction(Z, A, isoAmat);
-   if (fgTable->IsUseNewRangeInversion()) {
-      return static_cast<KVedaLossInverseRangeFunction*>(fInvRange[Z])->GetEnergyPerNucleon(e, riso) * A;
+   if (const KVInverseRangeTable* tab = GetInverseRangeTable(Z, A, isoAmat)) {
+      Double_t einc = tab->GetEnergy(e);
+      if (einc >= 0) return einc;
    }
-   return fRange->GetX(e);
+   return EnergyFromRange(GetRangeParameters(Z, A, isoAmat), e);
 }
 
 Double_t KVedaLossMaterial::GetEIncFromEResOfIon(Int_t Z, Int_t A, Double_t Eres, Double_t e, Double_t isoAmat)
@@ -424,12 +605,47 @@ Double_t KVedaLossMaterial::GetEIncFromEResOfIon(Int_t Z, Int_t A, Double_t Eres
    // \param isoAmat change default (isotopic) mass of material,
 
    if (Z == 0) return 0.0; //only charged particles
-   GetRangeFunction(Z, A, isoAmat);
-   Double_t R0 = fRange->Eval(Eres) + e;
-   if (fgTable->IsUseNewRangeInversion()) {
-      return static_cast<KVedaLossInverseRangeFunction*>(fInvRange[Z])->GetEnergyPerNucleon(R0, riso) * A;
+   RangeParameters p = GetRangeParameters(Z, A, isoAmat);
+   if (const KVInverseRangeTable* tab = GetInverseRangeTable(Z, A, isoAmat)) {
+      Double_t einc = tab->GetEnergy(Range(p, Eres) + e);
+      if (einc >= 0) return einc;
    }
-   return fRange->GetX(R0);
+   return EnergyFromRange(p, Range(p, Eres) + e);
+}
+
+Double_t KVedaLossMaterial::GetEIncFromDeltaEOfIon(Int_t Z, Int_t A, Double_t DeltaE, Double_t e, enum KVIonRangeTable::SolType type, Double_t isoAmat)
+{
+   // Calculates incident energy (in MeV) of an ion (Z,A) from energy loss DeltaE (MeV) in thickness e (in \f$g/cm^2\f$).
+   // \param type choice of solution: below (KVIonRangeTable::kEmin) or above (KVIonRangeTable::kEmax) the maximum energy loss
+   // \param isoAmat change default (isotopic) mass of material,
+
+   if (Z == 0) return 0.0; //only charged particles
+   RangeParameters p = GetRangeParameters(Z, A, isoAmat);
+   const KVInverseRangeTable* tab = GetInverseRangeTable(Z, A, isoAmat);
+   Double_t emaxde = EIncOfMaxDeltaE(p, e);
+   if (type == KVIonRangeTable::kEmin) return SolveDeltaE(p, DeltaE, e, 0., emaxde, tab);
+   return SolveDeltaE(p, DeltaE, e, emaxde, p.emax, tab);
+}
+
+Double_t KVedaLossMaterial::GetMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat)
+{
+   // Calculate maximum energy loss (in MeV) of ion (Z,A) in given thickness e (in \f$g/cm^2\f$).
+   // \param isoAmat change default (isotopic) mass of material,
+
+   if (Z == 0) return 0.0; //only charged particles
+   RangeParameters p = GetRangeParameters(Z, A, isoAmat);
+   Double_t E = EIncOfMaxDeltaE(p, e);
+   return E - ResidualEnergy(p, E, e);
+}
+
+Double_t KVedaLossMaterial::GetEIncOfMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat)
+{
+   // Calculate incident energy (in MeV) corresponding to maximum energy loss of ion (Z,A)
+   // in given thickness e (in \f$g/cm^2\f$).
+   // \param isoAmat change default (isotopic) mass of material,
+
+   if (Z == 0) return 0.0; //only charged particles
+   return EIncOfMaxDeltaE(GetRangeParameters(Z, A, isoAmat), e);
 }
 
 void KVedaLossMaterial::GetParameters(Int_t Zion, Int_t& Aion, std::vector<Double_t>& rangepar)
@@ -11,6 +11,7 @@
 
 class TGeoMaterial;
 class KVedaLoss;
+class KVInverseRangeTable;
 
 // maximum atomic number included in range tables
 #define ZMAX_VEDALOSS 100
@@ -21,21 +22,62 @@ class KVedaLoss;
   \ingroup Stopping
   \brief Description of material in the KVedaLoss range table
 
+  ### Thread safety
+  All methods GetRangeOfIon(), GetDeltaEOfIon(), GetEResOfIon(), GetPunchThroughEnergy(),
+  GetEIncFromEResOfIon(), GetEIncFromDeltaEOfIon(), GetMaxDeltaEOfIon() and GetEIncOfMaxDeltaEOfIon()
+  are reentrant and can be called concurrently from different threads: they only use the
+  (immutable) range table coefficients read from file, via the RangeParameters for each ion
+  obtained from GetRangeParameters() and the const methods Range(), StoppingPower(),
+  ResidualEnergy() and EnergyFromRange() which do not modify the state of the material.
+  The inversion of the range function in these methods is always exact (Newton's method on
+  the range parameterisation, see EnergyFromRange()), whatever KVedaLoss::SetUseNewRangeInversion().
+
+  The TF1 objects returned by GetRangeFunction(), GetDeltaEFunction(), GetEResFunction() and
+  GetStoppingFunction() (e.g. for drawing) are shared by all users of the material and are not
+  thread-safe. KVedaLoss::SetUseNewRangeInversion() only concerns these functions.
+
   \sa KVedaLoss
  */
 class KVedaLossMaterial : public KVIonRangeTableMaterial {
 
+public:
+   /// Parameters of range function for a given ion (Z,A) in this material
+   struct RangeParameters {
+      const Double_t* par;//! range table coefficients for Z of ion
+      Double_t A;         // mass of ion
+      Double_t riso;      // correction for isotopic mass of ion and/or material
+      Double_t adm;       // slope of log(range) vs. log(E/A) below 0.1 MeV/nucleon
+      Double_t adn;       // intercept of log(range) vs. log(E/A) below 0.1 MeV/nucleon
+      Double_t emax;      // maximum incident energy for which calculation is valid
+   };
+
 private:
    static KVedaLoss* fgTable;
    // internal variables used by RangeFunc/DeltaEFunc
-   Double_t RF_Z;
-   Double_t RF_A;
-   std::vector<Double_t>* par;
-   Double_t ran, adm, dleps, adn, riso, eps, DLEP, drande;
+   RangeParameters fFuncPar;//! parameters for ion used by TF1 functions
+   Int_t fFuncZ;//! Z of ion used by TF1 functions
    Double_t thickness; // in g/cm**2
    TObjArray fInvRange; //KVedaLossInverseRangeFunction objects
+   std::vector<RangeParameters> fIonPar;//! Z-dependent range parameters (par, adm, adn), set when coefficients are read
+
+   static Double_t LogRange(const Double_t* par, Double_t x)
+   {
+      // polynomial parameterisation of log(range) as a function of x=log(E/A)
+      return par[2] + x * (par[3] + x * (par[4] + x * (par[5] + x * (par[6] + x * par[7]))));
+   }
+   static Double_t LogRangeDerivative(const Double_t* par, Double_t x)
+   {
+      // derivative of LogRange() with respect to x=log(E/A)
+      return par[3] + x * (2 * par[4] + x * (3 * par[5] + x * (4 * par[6] + x * 5 * par[7])));
+   }
+   void set_range_parameters(Int_t Z);
+   Double_t SolveDeltaE(const RangeParameters&, Double_t DeltaE, Double_t e, Double_t e1, Double_t e2,
+                        const KVInverseRangeTable* tab = nullptr) const;
 
 protected:
+   void CalculateEResOfIons(Int_t n, const Int_t* Z, const Int_t* A, const Double_t* E, const Double_t* e,
+                            Double_t scale, Double_t* Eres);
+
    std::vector<Double_t> fEmin;        //Z-dependent minimum energy/nucleon for calculation to be valid
    std::vector<Double_t> fEmax;        //Z-dependent maximum energy/nucleon for calculation to be valid
    std::vector< std::vector<Double_t> > fCoeff;   //parameters for range tables
@@ -90,13 +132,31 @@ public:
       fNoLimits = on;
    };
 
+   virtual Double_t GetEIncFromDeltaEOfIon(Int_t Z, Int_t A, Double_t DeltaE, Double_t e, enum KVIonRangeTable::SolType type = KVIonRangeTable::kEmax, Double_t isoAmat = 0.);
+   virtual Double_t GetMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat = 0.);
+   virtual Double_t GetEIncOfMaxDeltaEOfIon(Int_t Z, Int_t A, Double_t e, Double_t isoAmat = 0.);
+
+   RangeParameters GetRangeParameters(Int_t Z, Int_t A, Double_t isoAmat = 0.) const;
+   Double_t Range(const RangeParameters&, Double_t E) const;
+   Double_t StoppingPower(const RangeParameters&, Double_t E) const;
+   Double_t EnergyFromRange(const RangeParameters&, Double_t R) const;
+   Double_t ResidualEnergy(const RangeParameters& p, Double_t E, Double_t e) const
+   {
+      // \returns residual energy (MeV) of ion with incident energy E (MeV) after thickness e (\f$g/cm^2\f$)
+      Double_t R0 = Range(p, E);
+      if (R0 < e) return 0.;
+      return EnergyFromRange(p, R0 - e);
+   }
+   Double_t ResidualEnergy(const RangeParameters& p, Double_t E, Double_t e, const KVInverseRangeTable* tab) const;
+   Double_t EIncOfMaxDeltaE(const RangeParameters&, Double_t e) const;
+
    void GetParameters(Int_t Zion, Int_t& Aion, std::vector<Double_t>& rangepar);
    static Bool_t CheckIon(Int_t Z)
    {
       return (Z > 0 && Z <= ZMAX_VEDALOSS);
    }
 
-   ClassDef(KVedaLossMaterial, 4) //Description of material properties used by KVedaLoss range calculation
+   ClassDef(KVedaLossMaterial, 5) //Description of material properties used by KVedaLoss range calculation
 };
 
 #endif
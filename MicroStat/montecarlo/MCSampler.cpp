@@ -3,6 +3,17 @@
 
 #include "MCSampler.h"
 #include "TRandom.h"
+#include "TRandom3.h"
+#include "TMath.h"
+#include "RVersion.h"
+#ifdef WITH_CPP11
+#include "KVThreadPool.h"
+#include <memory>
+#include <vector>
+#endif
+#ifdef USING_ROOT6
+#include "TROOT.h"
+#endif
 
 #include <TGraph.h>
 #include <TMultiGraph.h>
@@ -11,6 +22,19 @@
 
 ClassImp(MicroStat::MCSampler)
 
+namespace {
+   UInt_t stream_seed(ULong64_t seed, ULong64_t call, ULong64_t batch)
+   {
+      // seed of random generator for given batch of events of given call to GenerateEvents:
+      // splitmix64 hash of seed, call & batch numbers (never 0, which means 'random seed' for TRandom3)
+      ULong64_t z = seed + 0x9e3779b97f4a7c15ULL * (1 + call) + 0xbf58476d1ce4e5b9ULL * (1 + batch);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      z ^= (z >> 31);
+      UInt_t s = (UInt_t)(z >> 32);
+      return s ? s : 1;
+   }
+}
 
 namespace MicroStat {
 
@@ -22,6 +46,12 @@ namespace MicroStat {
       fTheLegend = 0;
       fLegendProbaMin = 0;
       fModifyMasses = kFALSE;
+      fThreadPool = nullptr;
+      fRandomSeed = 0;
+      fRandomSeedSet = kFALSE;
+      fGenerateCalls = 0;
+      fWeightTableN = 0;
+      fWeightTableEmin = fWeightTableStep = 0;
    }
 
    void MCSampler::initialiseWeightList()
@@ -50,6 +80,9 @@ namespace MicroStat {
       // Destructor
 
       SafeDelete(fWeightList);
+#ifdef WITH_CPP11
+      delete fThreadPool;
+#endif
    }
 
    void MCSampler::SetEventList(TTree* t, const TString& branchname)
@@ -63,6 +96,8 @@ namespace MicroStat {
       }
       fPartition = 0;
       fBranch->SetAddress(&fPartition);
+      fPartitionArrays.Clear();
+      ResetWeightTable();
    }
 
    void MCSampler::SetStatWeight(const TString& w)
@@ -74,6 +109,7 @@ namespace MicroStat {
       if (!fWeight) {
          Error("SetStatWeight", "class %s not found", w.Data());
       }
+      ResetWeightTable();
    }
 
    void MCSampler::UpdateMasses()
@@ -84,30 +120,249 @@ namespace MicroStat {
       while ((n = fPartition->GetNextParticle())) n->SetA(n->GetA());
    }
 
+   void MCSampler::SetNumberOfThreads(UInt_t nthreads)
+   {
+      // Use multi-threaded mode with the given number of threads
+      // (if nthreads=0, the number of hardware threads of the machine).
+      // See class description.
+
+#ifdef WITH_CPP11
+#ifdef USING_ROOT6
+      ROOT::EnableThreadSafety();
+#endif
+      delete fThreadPool;
+      fThreadPool = new KVThreadPool(nthreads);
+      Info("SetNumberOfThreads", "Using %u threads", fThreadPool->GetNumberOfThreads());
+#else
+      Warning("SetNumberOfThreads", "Multi-threaded mode requires C++11: %u threads requested, using 1", nthreads);
+#endif
+   }
+
+   void MCSampler::fillPartitionArrays()
+   {
+      // Read all partitions from the tree into the in-memory list used in multi-threaded mode
+      // (only done once for each list of partitions)
+
+      if (fPartitionArrays.GetN() == fPartitions) return;
+      fPartitionArrays.Clear();
+      for (Long64_t i = 0; i < fPartitions; i++) {
+         GetPartition(i);
+         if (fModifyMasses) UpdateMasses();
+         fPartitionArrays.Add(fPartition);
+      }
+   }
+
    void MCSampler::CalculateWeights(Double_t excitation_energy)
    {
       // calculate weights of all partitions for the given excitation energy
-      // (in MeV) of the initial compound nucleus
+      // (in MeV) of the initial compound nucleus.
+      //
+      // If a table of weights has been set up with SetWeightTable() and the excitation energy
+      // is inside its range, the weights are interpolated from the table instead.
+      //
+      // The weight of partition i is GetWeight(i). The table used by PickRandomChannel()
+      // to pick channels according to their weights is also updated.
 
       //Info("CalculateWeights","Calculating channel weights for E*=%f",excitation_energy);
 
+      computeWeights(excitation_energy, kTRUE);
+      buildAliasTable();
+   }
+
+   void MCSampler::computeWeights(Double_t excitation_energy, Bool_t use_table)
+   {
+      // Set the weights of all partitions for the given excitation energy, either
+      // by interpolation in the table of weights (if use_table=kTRUE and E* is in its range)
+      // or by calculation with the statistical weight class
+
       if (!fWeightList) initialiseWeightList();
 
       fSumWeights = 0;
 
+      Int_t row = -1;
+      Double_t frac = 0.;
+      if (use_table && fWeightTableN > 1) {
+         Double_t x = (excitation_energy - fWeightTableEmin) / fWeightTableStep;
+         if (x >= 0 && x <= fWeightTableN - 1) {
+            row = TMath::Min((Int_t)x, fWeightTableN - 2);
+            frac = x - row;
+         }
+      }
+      if (row < 0 && !fThreadPool) {
+         // sequential mode: partitions are read from the tree
+         for (int i = 0; i < fPartitions; i++) {
+            StatWeight* w = (StatWeight*)fWeightList->ConstructedAt(i);
+            GetPartition(i);
+            if (fModifyMasses) UpdateMasses();
+            w->SetWeight(fPartition, excitation_energy + fPartition->GetChannelQValue());
+            w->SetIndex(i);
+            fSumWeights += w->GetWeight();
+
+            //std::cout << i << "   Q=" << fPartition->GetChannelQValue() << "   weight=" << w->GetWeight() << endl;
+         }
+         return;
+      }
+
+      fillPartitionArrays();
       for (int i = 0; i < fPartitions; i++) {
          StatWeight* w = (StatWeight*)fWeightList->ConstructedAt(i);
-         GetPartition(i);
-         if (fModifyMasses) UpdateMasses();
-         w->SetWeight(fPartition, excitation_energy + fPartition->GetChannelQValue());
          w->SetIndex(i);
-         fSumWeights += w->GetWeight();
+      }
+#ifdef WITH_CPP11
+      if (fThreadPool) {
+         // multi-threaded mode: each thread treats a contiguous range of channels.
+         // The partial sums of weights are added in the same order whatever the number of threads.
+         const Long64_t nchunks = 4 * fThreadPool->GetNumberOfThreads();
+         const Long64_t chunk_size = (fPartitions + nchunks - 1) / nchunks;
+         std::vector<Double_t> partial_sums(nchunks, 0.);
+         for (Long64_t c = 0; c < nchunks; ++c) {
+            Long64_t first = c * chunk_size;
+            Long64_t last = TMath::Min(first + chunk_size, fPartitions);
+            if (first >= last) break;
+            fThreadPool->Submit([ =, &partial_sums]() {
+               partial_sums[c] = (row < 0 ? computeWeights(first, last, excitation_energy)
+                                  : interpolateWeights(first, last, excitation_energy, row, frac));
+            });
+         }
+         fThreadPool->Wait();
+         for (auto s : partial_sums) fSumWeights += s;
+         return;
+      }
+#endif
+      fSumWeights = interpolateWeights(0, fPartitions, excitation_energy, row, frac);
+   }
+
+   Double_t MCSampler::computeWeights(Long64_t first, Long64_t last, Double_t excitation_energy)
+   {
+      // Calculate weights of partitions [first,last) of the in-memory list of partitions.
+      // Returns the sum of their weights.
+
+      Double_t sum = 0;
+      for (Long64_t i = first; i < last; ++i) {
+         StatWeight* w = (StatWeight*)fWeightList->UncheckedAt(i);
+         w->SetWeight(fPartitionArrays, i, excitation_energy + fPartitionArrays.GetQValue(i));
+         sum += w->GetWeight();
+      }
+      return sum;
+   }
+
+   Double_t MCSampler::interpolateWeights(Long64_t first, Long64_t last, Double_t excitation_energy, Int_t row, Double_t frac)
+   {
+      // Interpolate weights of partitions [first,last) between rows 'row' and 'row+1' of the table of weights.
+      // Between two non-zero weights the interpolation is linear in log(weight) as a function of
+      // log(E*+Q), i.e. of the log of the energy available to the partition, which is exact for
+      // weights varying as a power of E*+Q; otherwise it is linear in E*.
+      // Returns the sum of the weights.
+
+      const Double_t* w0 = &fWeightTable[row * fPartitions];
+      const Double_t* w1 = w0 + fPartitions;
+      const Double_t estar0 = fWeightTableEmin + row * fWeightTableStep;
+      Double_t sum = 0;
+      for (Long64_t i = first; i < last; ++i) {
+         Double_t E = excitation_energy + fPartitionArrays.GetQValue(i);
+         Double_t E0 = estar0 + fPartitionArrays.GetQValue(i);
+         Double_t w;
+         if (w0[i] > 0 && w1[i] > 0 && E0 > 0 && E > 0)
+            w = w0[i] * TMath::Power(w1[i] / w0[i], TMath::Log(E / E0) / TMath::Log((E0 + fWeightTableStep) / E0));
+         else w = w0[i] + frac * (w1[i] - w0[i]);
+         if (E <= 0) w = 0;
+         ((StatWeight*)fWeightList->UncheckedAt(i))->SetInterpolatedWeight(w, E > 0 ? E : 0.);
+         sum += w;
+      }
+      return sum;
+   }
 
-         //std::cout << i << "   Q=" << fPartition->GetChannelQValue() << "   weight=" << w->GetWeight() << endl;
+   void MCSampler::SetWeightTable(Double_t emin, Double_t emax, Int_t npoints)
+   {
+      // Calculate the weights of all partitions for npoints values of E* from emin to emax (in MeV)
+      // and store them in a table. Subsequent calls to CalculateWeights() for E* in this range
+      // (including those made by PlotProbabilities(), PlotMultiplicities() and GenerateEvents())
+      // interpolate the weights from the table instead of calculating them.
+      //
+      // The table holds npoints*(number of partitions) values of type Double_t.
+      // It is deleted by ResetWeightTable() and when the list of partitions, the statistical weight
+      // or the nuclear masses are changed.
+
+      ResetWeightTable();
+      if (npoints < 2 || emax <= emin) {
+         Error("SetWeightTable", "Need at least 2 points and emax>emin");
+         return;
+      }
+      Info("SetWeightTable", "Calculating table of weights for %d partitions at %d values of E* (%.1f MB)",
+           (Int_t)fPartitions, npoints, npoints * fPartitions * sizeof(Double_t) / 1024. / 1024.);
+      std::vector<Double_t> table(npoints * fPartitions);
+      Double_t step = (emax - emin) / (npoints - 1);
+      for (Int_t k = 0; k < npoints; ++k) {
+         computeWeights(emin + k * step, kFALSE);
+         Double_t* row = &table[k * fPartitions];
+         for (Long64_t i = 0; i < fPartitions; ++i) row[i] = GetWeight(i)->GetWeight();
       }
+      fWeightTable.swap(table);
+      fWeightTableEmin = emin;
+      fWeightTableStep = step;
+      fWeightTableN = npoints;
+      // weights currently held correspond to emax
+      buildAliasTable();
+   }
+
+   void MCSampler::ResetWeightTable()
+   {
+      // Delete the table of weights (see SetWeightTable()): all weights will be calculated
+
+      std::vector<Double_t>().swap(fWeightTable);
+      fWeightTableN = 0;
+   }
 
-      // sort weights in decreasing order
-      fWeightList->Sort();
+   void MCSampler::buildAliasTable()
+   {
+      // Build the alias table used by PickRandomChannel() to pick a channel at random
+      // according to the current weights in constant time (Vose's alias method).
+      //
+      // Each of the fPartitions bins of the table contains a channel and an 'alias' channel:
+      // a bin is chosen uniformly, then its channel is chosen with probability fAliasProb
+      // and its alias otherwise.
+
+      fAliasProb.assign(fPartitions, 0.);
+      fAlias.assign(fPartitions, 0);
+      if (fSumWeights <= 0) return;
+
+      std::vector<Double_t> scaled(fPartitions);
+      std::vector<Int_t> small, large;
+      for (Int_t i = 0; i < fPartitions; ++i) {
+         scaled[i] = GetWeight(i)->GetWeight() * fPartitions / fSumWeights;
+         if (scaled[i] < 1.) small.push_back(i);
+         else large.push_back(i);
+      }
+      Int_t l = -1;
+      while (!small.empty() && !large.empty()) {
+         Int_t s = small.back();
+         small.pop_back();
+         l = large.back();
+         fAliasProb[s] = scaled[s];
+         fAlias[s] = l;
+         scaled[l] -= (1. - scaled[s]);
+         if (scaled[l] < 1.) {
+            large.pop_back();
+            small.push_back(l);
+         }
+      }
+      // remaining bins are full, apart from rounding errors
+      for (size_t k = 0; k < large.size(); ++k) {
+         fAliasProb[large[k]] = 1.;
+         fAlias[large[k]] = large[k];
+      }
+      for (size_t k = 0; k < small.size(); ++k) {
+         Int_t s = small[k];
+         if (scaled[s] > 0 || l < 0) {
+            fAliasProb[s] = 1.;
+            fAlias[s] = s;
+         }
+         else {
+            // never pick closed channel because of rounding errors
+            fAliasProb[s] = 0.;
+            fAlias[s] = l;
+         }
+      }
    }
 
    Long64_t MCSampler::PickRandomChannel()
@@ -119,15 +374,8 @@ namespace MicroStat {
       // If no channel is open (i.e. all weights = 0, E* < Q value of first channel),
       // we return -1.
 
-      Double_t x = gRandom->Uniform(fSumWeights);
-
-      int i;
-      for (i = 0; i < fPartitions; i++) {
-         Double_t w = ((StatWeight*)(*fWeightList)[i])->GetWeight();
-         if (x < w) break;
-         x -= w;
-      }
-      if (i == fPartitions) {
+      Int_t i = pickChannel(gRandom);
+      if (i < 0) {
          fLastPicked = nullptr;
          return -1;
       }
@@ -135,6 +383,17 @@ namespace MicroStat {
       return fLastPicked->GetIndex();
    }
 
+   Int_t MCSampler::pickChannel(TRandom* rndm) const
+   {
+      // Return position in list of weights of a channel chosen at random according to the weights,
+      // using the alias table, or -1 if no channel is open
+
+      if (fSumWeights <= 0 || fAliasProb.empty()) return -1;
+      Double_t x = rndm->Rndm() * fPartitions;
+      Int_t i = TMath::Min((Int_t)x, (Int_t)fPartitions - 1);
+      return (x - i < fAliasProb[i] ? i : fAlias[i]);
+   }
+
    void MCSampler::SetBranch(TTree* theTree, const TString& bname, void* variable, const TString& vartype)
    {
       TString leaflist = bname + "/";
@@ -175,6 +434,9 @@ namespace MicroStat {
       //    - picking a channel at random
       //    - generating momenta of all nuclei in chosen channel
       //    - filling the TTree with the new event
+      //
+      // In multi-threaded mode (see SetNumberOfThreads()) the events for different partitions
+      // are generated in parallel (see class description).
 
       Info("GenerateEvents", "Generating events for E*=%f", Exx);
 
@@ -183,6 +445,15 @@ namespace MicroStat {
          return;
       }
 
+      if (fThreadPool) {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,24,0)
+         generateEventsParallel(theTree, event, npartitions, nev_part);
+         return;
+#else
+         Warning("GenerateEvents", "Parallel generation of events requires ROOT v6.24 or later: events will be generated sequentially");
+#endif
+      }
+
       // generate events
       while (npartitions--) {
 
@@ -248,6 +519,78 @@ namespace MicroStat {
 
    }
 
+   void MCSampler::generateEventsParallel(TTree* theTree, KVEvent* event, Long64_t npartitions, Long64_t nev_part)
+   {
+      // Multi-threaded generation of events, called by GenerateEvents() after SetExcitationEnergy().
+      //
+      // The batches of nev_part events for each randomly-chosen partition are generated in blocks of
+      // a few batches per thread. Each batch of the block is generated by a worker thread in its own slot
+      // with its own copy of the statistical weight and its own random generator; then the calling thread
+      // copies each event into 'event' and fills the tree, in the order of the batches.
+
+#ifdef WITH_CPP11
+      if (!fRandomSeedSet) SetRandomSeed(gRandom->Integer(kMaxUInt));
+      const ULong64_t call = fGenerateCalls++;
+
+      struct batch_slot {
+         std::unique_ptr<StatWeight> weight;
+         KVEvent partition;
+         std::vector<std::unique_ptr<KVEvent> > events;
+         Long64_t ipart;
+         Double_t edisp;
+      };
+      const Long64_t nslots = TMath::Min((Long64_t)(4 * fThreadPool->GetNumberOfThreads()), npartitions);
+      std::vector<batch_slot> slots(nslots);
+      for (auto& s : slots) {
+         s.weight.reset((StatWeight*)fWeight->New());
+         for (Long64_t iev = 0; iev < nev_part; ++iev) s.events.emplace_back((KVEvent*)event->IsA()->New());
+      }
+
+      for (Long64_t first_batch = 0; first_batch < npartitions; first_batch += nslots) {
+         const Long64_t nbatch = TMath::Min(nslots, npartitions - first_batch);
+         for (Long64_t k = 0; k < nbatch; ++k) {
+            batch_slot* s = &slots[k];
+            const ULong64_t batch = first_batch + k;
+            fThreadPool->Submit([ = ]() {
+               TRandom3 rndm(stream_seed(fRandomSeed, call, batch));
+               s->ipart = -1;
+               Int_t i = pickChannel(&rndm);
+               if (i < 0) return;
+               s->ipart = GetWeight(i)->GetIndex();
+               fPartitionArrays.GetPartition(s->ipart, &s->partition);
+               StatWeight* w = s->weight.get();
+               w->SetRandomGenerator(&rndm);
+               w->SetWeight(fPartitionArrays, s->ipart, ESTAR + fPartitionArrays.GetQValue(s->ipart));
+               w->initGenerateEvent(&s->partition);
+               s->edisp = w->GetAvailableEnergy();
+               for (auto& e : s->events) {
+                  w->GenerateEvent(&s->partition, e.get());
+                  w->resetGenerateEvent();
+               }
+               w->SetRandomGenerator(nullptr);
+            });
+         }
+         fThreadPool->Wait();
+         for (Long64_t k = 0; k < nbatch; ++k) {
+            batch_slot& s = slots[k];
+            if (s.ipart < 0) continue;
+            IPART = s.ipart;
+            EDISP = s.edisp;
+            for (auto& e : s.events) {
+               event->Clear();
+               e->Copy(*event);
+               theTree->Fill();
+            }
+         }
+      }
+#else
+      (void)theTree;
+      (void)event;
+      (void)npartitions;
+      (void)nev_part;
+#endif
+   }
+
    void MCSampler::PlotProbabilities(double emin, double emax, double estep, Option_t* opt)
    {
       // Plot probability of each channel as a function of E* (default)
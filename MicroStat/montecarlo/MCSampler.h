@@ -9,6 +9,10 @@
 #include "TTree.h"
 #include "TLegend.h"
 #include "StatWeight.h"
+#include "PartitionList.h"
+#include <vector>
+
+class KVThreadPool;
 
 namespace MicroStat {
 
@@ -16,6 +20,33 @@ namespace MicroStat {
       \class MCSampler
       \brief Monte-Carlo sampling of events with statistical weights
       \ingroup MicroStat \ingroup Simulation
+
+      ### Picking channels
+      After the weights of all partitions have been calculated for a given E* by CalculateWeights(),
+      an alias table (Vose's method) is built so that PickRandomChannel() picks each channel
+      with a probability proportional to its weight in constant time, whatever the number of partitions.
+
+      ### Table of weights
+      For scans over E* (PlotProbabilities(), PlotMultiplicities(), GenerateEvents() for many E*),
+      SetWeightTable() can be used to calculate the weights of all partitions once for a grid of E*
+      values: CalculateWeights() then interpolates the weights from the table for any E* inside
+      its range. The available energy of each channel is still exact; only its weight is interpolated.
+
+      ### Multi-threaded mode
+      After calling SetNumberOfThreads(), the following steps are performed by several threads:
+
+        - CalculateWeights() calculates the weights of all channels from an in-memory copy of the list of
+          partitions (see PartitionList), which is read from the TTree only once;
+        - GenerateEvents() generates the events for each randomly chosen channel (a batch of nev_part events)
+          in parallel: each batch uses its own copy of the statistical weight object and its own TRandom3
+          generator, whose seed is calculated from the seed given to SetRandomSeed(), the number of previous calls
+          to GenerateEvents() and the number of the batch. The events are then written to the tree
+          by the calling thread in the order of the batches.
+
+      The events generated in multi-threaded mode therefore depend only on the random seed, and not on the
+      number of threads or on how the batches were scheduled. They are not the same as those generated
+      in the default (sequential) mode, which uses gRandom. Parallel generation of events requires
+      ROOT v6.24 or later (otherwise only the weights are calculated in parallel).
    */
 
    class MCSampler : public KVBase {
@@ -27,6 +58,27 @@ namespace MicroStat {
 
       void SetBranch(TTree* theTree, const TString& name, void* variable, const TString& vartype);
 
+      PartitionList            fPartitionArrays;//! in-memory copy of partitions used in multi-threaded mode
+      KVThreadPool*            fThreadPool;//! worker threads for multi-threaded mode
+      ULong64_t                fRandomSeed;//! seed for random generators used in multi-threaded mode
+      Bool_t                   fRandomSeedSet;//! kTRUE if SetRandomSeed() was called
+      ULong64_t                fGenerateCalls;//! number of calls to GenerateEvents() in multi-threaded mode
+
+      void fillPartitionArrays();
+      std::vector<Double_t>    fAliasProb;//! probability of each bin of alias table
+      std::vector<Int_t>       fAlias;//! alias of each bin of alias table
+      std::vector<Double_t>    fWeightTable;//! weights of all partitions for each E* of table
+      Double_t                 fWeightTableEmin;//! first E* of table of weights
+      Double_t                 fWeightTableStep;//! E* step of table of weights
+      Int_t                    fWeightTableN;//! number of E* values in table of weights
+
+      void buildAliasTable();
+      Int_t pickChannel(TRandom*) const;
+      void computeWeights(Double_t excitation_energy, Bool_t use_table);
+      Double_t computeWeights(Long64_t first, Long64_t last, Double_t excitation_energy);
+      Double_t interpolateWeights(Long64_t first, Long64_t last, Double_t excitation_energy, Int_t row, Double_t frac);
+      void generateEventsParallel(TTree*, KVEvent* event, Long64_t npartitions, Long64_t nev_part);
+
    protected:
       Long64_t                 fPartitions;//! number of partitions in TTree/TChain
       TBranch*                 fBranch;    //! branch containing events
@@ -61,16 +113,40 @@ namespace MicroStat {
       void SetModifyMasses(Bool_t yes = kTRUE)
       {
          fModifyMasses = yes;
+         fPartitionArrays.Clear();
+         ResetWeightTable();
       }
       void UpdateMasses();
 
+      void SetNumberOfThreads(UInt_t nthreads = 0);
+      Bool_t IsMultiThreaded() const
+      {
+         return fThreadPool != nullptr;
+      }
+      void SetRandomSeed(ULong64_t seed)
+      {
+         // Set seed used for the random generators in multi-threaded mode.
+         // The same seed (with the same sequence of calls to GenerateEvents())
+         // always gives the same events, whatever the number of threads.
+         fRandomSeed = seed;
+         fRandomSeedSet = kTRUE;
+         fGenerateCalls = 0;
+      }
+
       void CalculateWeights(Double_t excitation_energy);
+      void SetWeightTable(Double_t emin, Double_t emax, Int_t npoints);
+      void ResetWeightTable();
+      Bool_t HasWeightTable() const
+      {
+         return fWeightTableN > 1;
+      }
       TClonesArray* GetWeights() const
       {
          return fWeightList;
       }
       StatWeight* GetWeight(Int_t i) const
       {
+         // Weight of partition with index i, calculated by last call to CalculateWeights()
          return (StatWeight*)(*fWeightList)[i];
       }
       Double_t GetSumWeights() const
@@ -6,6 +6,7 @@
 #pragma link C++ nestedclasses;
 #pragma link C++ nestedtypedefs;
 #pragma link C++ namespace MicroStat;
+#pragma link C++ class MicroStat::PartitionList+;
 #pragma link C++ class MicroStat::StatWeight+;
 #pragma link C++ class MicroStat::mdweight+;
 #pragma link C++ class MicroStat::mcweight+;
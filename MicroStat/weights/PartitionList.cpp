@@ -0,0 +1,46 @@
+//Created by KVClassFactory on Sat Oct 17 15:52:18 2026
+
+#include "PartitionList.h"
+
+namespace MicroStat {
+
+   void PartitionList::Clear()
+   {
+      // Remove all partitions from list
+
+      fQValue.clear();
+      fFirst.assign(1, 0);
+      fZ.clear();
+      fA.clear();
+      fExcitEnergy.clear();
+      fMass.clear();
+   }
+
+   void PartitionList::Add(KVEvent* partition)
+   {
+      // Add partition to end of list
+
+      fQValue.push_back(partition->GetChannelQValue());
+      KVNucleus* n;
+      while ((n = partition->GetNextParticle())) {
+         fZ.push_back(n->GetZ());
+         fA.push_back(n->GetA());
+         fExcitEnergy.push_back(n->GetExcitEnergy());
+         fMass.push_back(n->GetMass());
+      }
+      fFirst.push_back(fZ.size());
+   }
+
+   void PartitionList::GetPartition(Long64_t i, KVEvent* partition) const
+   {
+      // Fill the event with the nuclei of partition i
+
+      partition->Clear();
+      for (Int_t j = fFirst[i]; j < fFirst[i + 1]; ++j) {
+         KVNucleus* n = partition->AddParticle();
+         n->SetZandA(fZ[j], fA[j]);
+         n->SetExcitEnergy(fExcitEnergy[j]);
+      }
+   }
+
+}/*  namespace MicroStat */
@@ -0,0 +1,92 @@
+//Created by KVClassFactory on Sat Oct 17 15:52:18 2026
+
+#ifndef __PARTITIONLIST_H
+#define __PARTITIONLIST_H
+
+#include "KVEvent.h"
+#include <vector>
+
+namespace MicroStat {
+
+   /**
+   \class PartitionList
+   \brief In-memory copy of a list of partitions, stored as arrays
+   \ingroup MicroStat \ingroup Simulation
+
+   The list of partitions (decay channels) used by MCSampler is usually stored in a TTree.
+   Reading a partition from the tree means decompressing it and creating a KVEvent with
+   all its nuclei, which is much more time-consuming than calculating its statistical weight.
+
+   This class holds the information needed to calculate weights and generate events for each
+   partition in a set of contiguous arrays (structure of arrays):
+
+     - for each partition: its Q-value and the index of its first nucleus in the arrays of nuclei;
+     - for each nucleus: Z, A, excitation energy and mass (including excitation energy).
+
+   The nuclei of partition `i` have indices GetFirst(i) to GetFirst(i)+GetMult(i)-1 in the arrays of nuclei.
+   */
+
+   class PartitionList {
+      std::vector<Double_t> fQValue;// Q-value of each partition
+      std::vector<Int_t> fFirst;// index of first nucleus of each partition (one extra element at end)
+      std::vector<Int_t> fZ;// atomic number of each nucleus
+      std::vector<Int_t> fA;// mass number of each nucleus
+      std::vector<Double_t> fExcitEnergy;// excitation energy of each nucleus
+      std::vector<Double_t> fMass;// mass of each nucleus
+
+   public:
+      PartitionList()
+      {
+         Clear();
+      }
+      virtual ~PartitionList() {}
+
+      void Clear();
+      void Add(KVEvent* partition);
+      void GetPartition(Long64_t i, KVEvent* partition) const;
+
+      Long64_t GetN() const
+      {
+         // Number of partitions in list
+         return fQValue.size();
+      }
+      Double_t GetQValue(Long64_t i) const
+      {
+         // Q-value of partition i (see KVEvent::GetChannelQValue())
+         return fQValue[i];
+      }
+      Int_t GetMult(Long64_t i) const
+      {
+         // Number of nuclei in partition i
+         return fFirst[i + 1] - fFirst[i];
+      }
+      Int_t GetFirst(Long64_t i) const
+      {
+         // Index of first nucleus of partition i
+         return fFirst[i];
+      }
+      Int_t GetZ(Int_t j) const
+      {
+         // Atomic number of nucleus j
+         return fZ[j];
+      }
+      Int_t GetA(Int_t j) const
+      {
+         // Mass number of nucleus j
+         return fA[j];
+      }
+      Double_t GetExcitEnergy(Int_t j) const
+      {
+         // Excitation energy of nucleus j
+         return fExcitEnergy[j];
+      }
+      Double_t GetMass(Int_t j) const
+      {
+         // Mass of nucleus j, including its excitation energy
+         return fMass[j];
+      }
+   };
+
+}/*  namespace MicroStat */
+
+#endif
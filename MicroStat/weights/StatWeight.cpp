@@ -12,6 +12,7 @@ namespace MicroStat {
       // Default initialisations
 
       fWeight = 0;
+      fRandom = nullptr;
    }
 
    StatWeight::StatWeight()
@@ -43,6 +44,20 @@ namespace MicroStat {
       return (w == fWeight ? 0 : 1);
    }
 
+   void StatWeight::SetWeight(const PartitionList& partitions, Long64_t i, Double_t E)
+   {
+      // Set available energy, E, and calculate statistical weight for partition i
+      // of the in-memory list of partitions.
+      //
+      // This default implementation fills a KVEvent with the partition and calls
+      // SetWeight(KVEvent*, Double_t): override it in derived classes to calculate
+      // the weight directly from the arrays of the list.
+
+      KVEvent e;
+      partitions.GetPartition(i, &e);
+      SetWeight(&e, E);
+   }
+
    void StatWeight::GenerateEvent(KVEvent* partition, KVEvent* event)
    {
       // Generate a full kinematical event using the statistical weight
@@ -5,6 +5,8 @@
 #define __STATWEIGHT_H
 
 #include "KVEvent.h"
+#include "TRandom.h"
+#include "PartitionList.h"
 
 namespace MicroStat {
 
@@ -12,6 +14,11 @@ namespace MicroStat {
    \class StatWeight
    \brief Abstract base class for calculating statistical weights for events
    \ingroup MicroStat \ingroup Simulation
+
+   All random numbers used to generate events must be drawn from the generator returned
+   by GetRandomGenerator() (gRandom unless SetRandomGenerator() was called), so that
+   several weight objects can generate events at the same time in different threads,
+   each with its own generator (see MCSampler::SetNumberOfThreads()).
    */
 
    class StatWeight : public TObject {
@@ -21,6 +28,7 @@ namespace MicroStat {
       Double_t fWeight; //calculated weight
       Long64_t fIndex;  //index of corresponding partition
       Double_t fEDisp;  //available kinetic energy - set by SetWeight(KVEvent*, Double_t)
+      TRandom* fRandom; //! random number generator used to generate events (if not gRandom)
 
    protected:
       void setWeight(Double_t w)
@@ -37,6 +45,14 @@ namespace MicroStat {
       virtual ~StatWeight();
 
       virtual void SetWeight(KVEvent* e, Double_t E) = 0;
+      virtual void SetWeight(const PartitionList& partitions, Long64_t i, Double_t E);
+      void SetInterpolatedWeight(Double_t w, Double_t E)
+      {
+         // Set weight w interpolated from previously calculated weights
+         // (see MCSampler::SetWeightTable()) for available energy E
+         setWeight(w);
+         setAvailableEnergy(E);
+      }
       Double_t GetWeight() const
       {
          return fWeight;
@@ -63,6 +79,17 @@ namespace MicroStat {
 
       Int_t Compare(const TObject* obj) const;
 
+      void SetRandomGenerator(TRandom* r)
+      {
+         // Set random number generator used to generate events.
+         // If not set (or set to nullptr), gRandom is used.
+         fRandom = r;
+      }
+      TRandom* GetRandomGenerator() const
+      {
+         return fRandom ? fRandom : gRandom;
+      }
+
       void GenerateEvent(KVEvent* partition, KVEvent* event);
       virtual void initGenerateEvent(KVEvent* partition) = 0;
       virtual void resetGenerateEvent() = 0;
@@ -3,6 +3,7 @@
 
 #include "mdweight.h"
 #include "TMath.h"
+#include "RVersion.h"
 
 ClassImp(MicroStat::mdweight)
 
@@ -89,8 +90,6 @@ namespace MicroStat {
          setWeight(0.);
          return;
       }
-      setAvailableEnergy(E);
-      Double_t N = e->GetMult();
       Double_t logmass_sum, mass_sum;
       logmass_sum = mass_sum = 0.;
       KVNucleus* n;
@@ -99,6 +98,38 @@ namespace MicroStat {
          logmass_sum += TMath::Log(m);
          mass_sum += m;
       }
+      calcWeight(e->GetMult(), logmass_sum, mass_sum, E);
+   }
+
+   void mdweight::SetWeight(const PartitionList& partitions, Long64_t i, Double_t E)
+   {
+      // Set available energy, E, and calculate statistical weight
+      // for partition i of the list, using only the masses of its nuclei
+
+      if (E <= 0) {
+         setAvailableEnergy(0.);
+         setWeight(0.);
+         return;
+      }
+      Double_t logmass_sum, mass_sum;
+      logmass_sum = mass_sum = 0.;
+      Int_t first = partitions.GetFirst(i);
+      Int_t last = first + partitions.GetMult(i);
+      for (Int_t j = first; j < last; ++j) {
+         Double_t m = partitions.GetMass(j);
+         logmass_sum += TMath::Log(m);
+         mass_sum += m;
+      }
+      calcWeight(partitions.GetMult(i), logmass_sum, mass_sum, E);
+   }
+
+   void mdweight::calcWeight(Int_t mult, Double_t logmass_sum, Double_t mass_sum, Double_t E)
+   {
+      // Calculate weight for available energy E>0 and a partition with multiplicity mult,
+      // given the sum of the masses and the sum of their logarithms
+
+      setAvailableEnergy(E);
+      Double_t N = mult;
       A = (3 * (N - 1) / 2.) * log2pi - TMath::LnGamma(3 * (N - 1) / 2.)
           + 1.5 * (logmass_sum - TMath::Log(mass_sum));
       B = (3 * N - 5) / 2.;
@@ -149,7 +180,11 @@ namespace MicroStat {
          Double_t p = 0.; //momentum to give particle
          if (N > 2) {
             // draw random KE from 1-particle distribution for given N & ratio
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,24,0)
+            ec = eDisp * getKEdist(N, ratio)->GetRandom(GetRandomGenerator());
+#else
             ec = eDisp * getKEdist(N, ratio)->GetRandom();
+#endif
             p = sqrt(2.*mPart * ec);
          }
          else {
@@ -157,9 +192,13 @@ namespace MicroStat {
             p = sqrt(2.*(massTot - mPart) * mPart * eDisp / massTot);
             ec = p * p / 2. / mPart;
          }
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,24,0)
+         Double_t ct = fCosTheta.GetRandom(-1, 1, GetRandomGenerator());
+#else
          Double_t ct = fCosTheta.GetRandom(-1, 1); //1. - 2.*gRandom->Rndm();
+#endif
          Double_t st = TMath::Sqrt(1. - ct * ct);
-         Double_t phi = gRandom->Rndm() * 2.*TMath::Pi();
+         Double_t phi = GetRandomGenerator()->Rndm() * 2.*TMath::Pi();
          ppz = ct * p;
          ppx = st * TMath::Cos(phi) * p;
          ppy = st * TMath::Sin(phi) * p;
@@ -26,6 +26,7 @@ namespace MicroStat {
       TF1 fCosTheta;//! function used to draw random CosTheta values
 
       TF1* getKEdist(Int_t, Double_t);
+      void calcWeight(Int_t N, Double_t logmass_sum, Double_t mass_sum, Double_t E);
 
    protected:
 
@@ -34,6 +35,7 @@ namespace MicroStat {
       virtual ~mdweight();
 
       virtual void SetWeight(KVEvent* e, Double_t E);
+      virtual void SetWeight(const PartitionList& partitions, Long64_t i, Double_t E);
       void SetAnisotropy(double a, double b)
       {
          // Set anisotropy of particle momentum distribution
@@ -153,6 +153,13 @@ KVVAMOS::~KVVAMOS()
 }
 //________________________________________________________________
 
+void KVVAMOS::set_global_pointers()
+{
+   // Make gVamos point to this array (after making a working copy)
+   gVamos = this;
+}
+//________________________________________________________________
+
 void KVVAMOS::BuildFocalPlaneGeometry(TEnv* infos)
 {
    // Construction of the detector geometry at the focal plane of VAMOS for the.
@@ -79,6 +79,7 @@ protected:
    virtual void   SetGroupsAndIDTelescopes();
    virtual void set_up_telescope(KVDetector* de, KVDetector* e, KVIDTelescope* idt, TCollection* l);
    virtual void set_up_single_stage_telescope(KVDetector* det, KVIDTelescope* idt, TCollection* l);
+   void set_global_pointers();
 
 
 public:
@@ -2,6 +2,10 @@
 //Author: Patrick St-Onge,,,
 
 #include "KVZGOUBIInverseMatrix.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
 
 ClassImp(KVZGOUBIInverseMatrix)
 
@@ -48,8 +52,11 @@ KVZGOUBIInverseMatrix::KVZGOUBIInverseMatrix(Int_t nbstepxft, Int_t nbstepthetaf
    }
    FindDeltaParameters();
    PrintExtremum();
-   initZGOUBIInversePositionDatabase();
-   SetZGOUBIInversePositionDatabase();
+   characteristicdistance_xf = 1.;
+   characteristicdistance_yf = 1.;
+   characteristicdistance_thetaf = 1.;
+   characteristicdistance_phif = 1.;
+   BuildIndex();
 }
 
 //____________________________________________________________________________//
@@ -80,13 +87,12 @@ KVZGOUBIInverseMatrix::~KVZGOUBIInverseMatrix()
 
 void KVZGOUBIInverseMatrix::Copy(TObject& obj) const
 {
-   // This method copies the current state of 'this' KVZGOUBIInversePosition
+   // This method copies the current state of 'this' KVZGOUBIInverseMatrix
    // object into 'obj'.
 
    KVBase::Copy(obj);
    KVZGOUBIInverseMatrix& CastedObj = (KVZGOUBIInverseMatrix&)obj;
    CastedObj.ZGOUBIDatabase = ZGOUBIDatabase;
-   CastedObj.ZGOUBIInversePositionDatabase = ZGOUBIInversePositionDatabase ;
    CastedObj.xfmin = xfmin ;
    CastedObj.xfmax = xfmax ;
    CastedObj.yfmin = yfmin ;
@@ -107,6 +113,13 @@ void KVZGOUBIInverseMatrix::Copy(TObject& obj) const
    CastedObj.characteristicdistance_yf = characteristicdistance_yf;
    CastedObj.characteristicdistance_thetaf = characteristicdistance_thetaf;
    CastedObj.characteristicdistance_phif = characteristicdistance_phif ;
+   CastedObj.fCellStart = fCellStart;
+   CastedObj.fCellLines = fCellLines;
+   CastedObj.fCellXF = fCellXF;
+   CastedObj.fCellThetaF = fCellThetaF;
+   CastedObj.fCellYF = fCellYF;
+   CastedObj.fCellPhiF = fCellPhiF;
+   CastedObj.fCombinations = fCombinations;
 
 }
 //____________________________________________________________________________//
@@ -215,69 +228,96 @@ void KVZGOUBIInverseMatrix::SetNbSteps(Int_t nbstepxft, Int_t nbstepthetaft, Int
    nbstep_phif = nbstepphift;
 }
 
-void KVZGOUBIInverseMatrix::AddZGOUBIInversePosition()
-{
-   KVZGOUBIInversePosition atemp;
-   ZGOUBIInversePositionDatabase.push_back(atemp);
-}
+namespace {
+   Int_t cell_number(Float_t x, Float_t xmin, Float_t delta, Int_t nsteps)
+   {
+      // number of cell containing x, in [0,nsteps-1]
+      Int_t i = (Int_t)((x - xmin) / delta);
+      return std::max(0, std::min(i, nsteps - 1));
+   }
 
+   std::vector<UInt_t> combinations(int N)
+   {
+      // All combinations of 1, 2, ..., N elements among N, as bitmasks (bit i set if element i is used),
+      // in order of increasing number of elements, and lexicographic order of the elements used for each number
+      std::vector<UInt_t> masks;
+      for (int K = 1; K <= N; ++K) {
+         std::string bitmask(K, 1);
+         bitmask.resize(N, 0);
+         do {
+            UInt_t m = 0;
+            for (int i = 0; i < N; ++i) if (bitmask[i]) m |= (1u << i);
+            masks.push_back(m);
+         }
+         while (std::prev_permutation(bitmask.begin(), bitmask.end()));
+      }
+      return masks;
+   }
+}
 
-void KVZGOUBIInverseMatrix::initZGOUBIInversePositionDatabase()
+void KVZGOUBIInverseMatrix::BuildIndex()
 {
-   for (int i = 0; i < nbstep_xf * nbstep_yf * nbstep_thetaf * nbstep_phif; i++) {
-      AddZGOUBIInversePosition();
+   // Build the index of trajectories used to find the nearest trajectories to a point:
+   // for each cell of the grid of focal plane coordinates, the numbers and coordinates
+   // of its trajectories are stored contiguously, and fCellStart gives the position
+   // of the first trajectory of each cell.
+
+   Int_t ncells = nbstep_xf * nbstep_yf * nbstep_thetaf * nbstep_phif;
+   Int_t ntraj = ZGOUBIDatabase.size();
+   std::vector<Int_t> cell_of_line(ntraj);
+   fCellStart.assign(ncells + 1, 0);
+   for (Int_t i = 0; i < ntraj; i++) {
+      Int_t cell[4];
+      GetCellCoordinates(ZGOUBIDatabase[i].GetXF(), ZGOUBIDatabase[i].GetThetaF(), ZGOUBIDatabase[i].GetYF(), ZGOUBIDatabase[i].GetPhiF(), cell);
+      cell_of_line[i] = GetCellIndex(cell);
+      ++fCellStart[cell_of_line[i] + 1];
+   }
+   for (Int_t c = 0; c < ncells; c++) fCellStart[c + 1] += fCellStart[c];
+   fCellLines.resize(ntraj);
+   fCellXF.resize(ntraj);
+   fCellThetaF.resize(ntraj);
+   fCellYF.resize(ntraj);
+   fCellPhiF.resize(ntraj);
+   std::vector<Int_t> next(fCellStart.begin(), fCellStart.end() - 1);
+   for (Int_t i = 0; i < ntraj; i++) {
+      Int_t j = next[cell_of_line[i]]++;
+      fCellLines[j] = i;
+      fCellXF[j] = ZGOUBIDatabase[i].GetXF();
+      fCellThetaF[j] = ZGOUBIDatabase[i].GetThetaF();
+      fCellYF[j] = ZGOUBIDatabase[i].GetYF();
+      fCellPhiF[j] = ZGOUBIDatabase[i].GetPhiF();
    }
+
+   fCombinations.resize(11);
+   for (int N = 1; N <= 10; ++N) fCombinations[N] = combinations(N);
 }
 
-void KVZGOUBIInverseMatrix::SetZGOUBIInversePositionDatabase()
+void KVZGOUBIInverseMatrix::GetCellCoordinates(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t* cell) const
 {
-   double xftemp;
-   double yftemp;
-   double phiftemp;
-   double thetaftemp;
-
-   Int_t ZGOUBIDatabase_position;
-   for (int i = 0; i < (int) ZGOUBIDatabase.size(); i++) {
-      xftemp = ZGOUBIDatabase[i].GetXF();
-      yftemp = ZGOUBIDatabase[i].GetYF();
-      thetaftemp = ZGOUBIDatabase[i].GetThetaF();
-      phiftemp = ZGOUBIDatabase[i].GetPhiF();
+   // Fill cell[4] with the coordinates (xf, yf, thetaf, phif) of the cell of the index
+   // containing the point (points outside the range of the grid are put in the nearest cell)
 
-      ZGOUBIDatabase_position = GetZGOUBIDatabase_position(xftemp, thetaftemp, yftemp, phiftemp);
-      if (ZGOUBIDatabase_position > (int) ZGOUBIInversePositionDatabase.size()) {
-         std::cout << "Problem acceptvectorposition size" << std::endl;
-      }
-      else {
-         ZGOUBIInversePositionDatabase[ZGOUBIDatabase_position].AddtoInversePositionVector(i);
-      }
-   }
+   cell[0] = cell_number(XFt, xfmin, delta_xf, nbstep_xf);
+   cell[1] = cell_number(YFt, yfmin, delta_yf, nbstep_yf);
+   cell[2] = cell_number(ThetaFt, thetafmin, delta_thetaf, nbstep_thetaf);
+   cell[3] = cell_number(PhiFt, phifmin, delta_phif, nbstep_phif);
 }
 
-
-Int_t KVZGOUBIInverseMatrix::GetZGOUBIDatabase_position(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt)
+Int_t KVZGOUBIInverseMatrix::GetZGOUBIDatabase_position(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt) const
 {
-   Int_t ZGOUBIDatabase_position = -1;
-   Int_t positionxf;
-   Int_t positionyf;
-   Int_t positionthetaf;
-   Int_t positionphif;
-
+   // Index of cell containing the point, or -1 if the point is outside the range of the grid
 
    if (XFt <= xfmax && XFt >= xfmin && YFt <= yfmax && YFt >= yfmin && ThetaFt <= thetafmax && ThetaFt >= thetafmin && PhiFt <= phifmax && PhiFt >= phifmin) {
-      positionxf = (XFt - xfmin) / delta_xf;
-      positionyf = (YFt - yfmin) / delta_yf;
-      positionthetaf = (ThetaFt - thetafmin) / delta_thetaf;
-      positionphif = (PhiFt - phifmin) / delta_phif;
-
-      ZGOUBIDatabase_position = positionxf * nbstep_yf * nbstep_thetaf * nbstep_phif + positionyf * nbstep_thetaf * nbstep_phif + positionthetaf * nbstep_phif + positionphif;
-      return ZGOUBIDatabase_position;
+      Int_t cell[4];
+      GetCellCoordinates(XFt, ThetaFt, YFt, PhiFt, cell);
+      return GetCellIndex(cell);
    }
    else {
       return -1;
    }
 }
 
-std::vector<Int_t> KVZGOUBIInverseMatrix::GetClosest4DVoxels(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nbneighbors)
+std::vector<Int_t> KVZGOUBIInverseMatrix::GetClosest4DVoxels(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nbneighbors) const
 {
    if (nbneighbors < 0) {
       nbneighbors = 0;
@@ -358,7 +398,7 @@ std::vector<Int_t> KVZGOUBIInverseMatrix::GetClosest4DVoxels(Float_t XFt, Float_
 
 
 
-Float_t KVZGOUBIInverseMatrix::GetDistance(Float_t xf, Float_t thetaf, Float_t yf, Float_t phif, Float_t xf_line, Float_t thetaf_line, Float_t yf_line, Float_t phif_line)
+Float_t KVZGOUBIInverseMatrix::GetDistance(Float_t xf, Float_t thetaf, Float_t yf, Float_t phif, Float_t xf_line, Float_t thetaf_line, Float_t yf_line, Float_t phif_line) const
 {
    Float_t distance = 0;
    Float_t distancexf = sqrt(pow(xf - xf_line, 2)) / characteristicdistance_xf;
@@ -369,7 +409,7 @@ Float_t KVZGOUBIInverseMatrix::GetDistance(Float_t xf, Float_t thetaf, Float_t y
    return distance;
 }
 
-Float_t KVZGOUBIInverseMatrix::GetDistance(Float_t xf, Float_t thetaf, Float_t yf, Float_t phif, Int_t linenb)
+Float_t KVZGOUBIInverseMatrix::GetDistance(Float_t xf, Float_t thetaf, Float_t yf, Float_t phif, Int_t linenb) const
 {
    Float_t distance = 0;
    Float_t distancexf = sqrt(pow(xf - ZGOUBIDatabase[linenb].GetXF(), 2)) / characteristicdistance_xf;
@@ -380,7 +420,7 @@ Float_t KVZGOUBIInverseMatrix::GetDistance(Float_t xf, Float_t thetaf, Float_t y
    return distance;
 }
 
-Float_t KVZGOUBIInverseMatrix::GetDistance(Int_t linenb1, Int_t linenb2)
+Float_t KVZGOUBIInverseMatrix::GetDistance(Int_t linenb1, Int_t linenb2) const
 {
    Float_t distance = 0;
    Float_t distancexf = sqrt(pow(ZGOUBIDatabase[linenb1].GetXF() - ZGOUBIDatabase[linenb2].GetXF(), 2)) / characteristicdistance_xf;
@@ -392,153 +432,133 @@ Float_t KVZGOUBIInverseMatrix::GetDistance(Int_t linenb1, Int_t linenb2)
 }
 
 
-Int_t KVZGOUBIInverseMatrix::GetNearestLinenb(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt)
+Int_t KVZGOUBIInverseMatrix::GetNearestLinenb(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt) const
 {
-   Int_t Maxnbneighbors = 100;
-   std::vector<Int_t> Closest4DVoxelsvector;
-   Int_t MultZGOUBIInversePosition;
-   Int_t ZGOUBITrajectoryposition;
-   Int_t ZGOUBIInversePositionDatabaseposition;
-   Float_t xf_line;
-   Float_t yf_line;
-   Float_t thetaf_line;
-   Float_t phif_line;
-   Float_t distance = 1;
-   Float_t distancemin = 10000000000000.;
-   Int_t  ZGOUBIDatabase_positionmin = -1;
-   Bool_t ZGOUBITrajectoryAvailable = false;
-   Int_t nbneighbors = 1;
-   while (ZGOUBITrajectoryAvailable == false && nbneighbors <= Maxnbneighbors) {
-      Closest4DVoxelsvector = GetClosest4DVoxels(XFt, ThetaFt, YFt, PhiFt, nbneighbors);
-      if (Closest4DVoxelsvector.size() <= 0) {
-         // std::cout<<"Value outside full range"<<std::endl;
-      }
-      else {
-         for (int i = 0; i < (int) Closest4DVoxelsvector.size(); i++) {
-            ZGOUBIInversePositionDatabaseposition = Closest4DVoxelsvector[i];
-            MultZGOUBIInversePosition = ZGOUBIInversePositionDatabase[ZGOUBIInversePositionDatabaseposition].GetInversePositionVectorSize();
-            if (MultZGOUBIInversePosition > 0) {
-               ZGOUBITrajectoryAvailable = true;
-               for (int j = 0; j < MultZGOUBIInversePosition; j++) {
-                  ZGOUBITrajectoryposition = ZGOUBIInversePositionDatabase[ZGOUBIInversePositionDatabaseposition].GetInversePositionVectorValue(j);
-                  xf_line = ZGOUBIDatabase[ZGOUBITrajectoryposition].GetXF();
-                  yf_line = ZGOUBIDatabase[ZGOUBITrajectoryposition].GetYF();
-                  thetaf_line = ZGOUBIDatabase[ZGOUBITrajectoryposition].GetThetaF();
-                  phif_line = ZGOUBIDatabase[ZGOUBITrajectoryposition].GetPhiF();
-                  distance = GetDistance(XFt, ThetaFt, YFt, PhiFt, xf_line, thetaf_line, yf_line, phif_line);
-                  if (distance < distancemin) {
-                     distancemin = distance;
-                     ZGOUBIDatabase_positionmin = ZGOUBITrajectoryposition;
-                  }
-               }
-            }
-         }
-      }
-      nbneighbors++;
-   }
-   return  ZGOUBIDatabase_positionmin;
+   // Number of the trajectory nearest to the point, or -1 if the point is outside
+   // the range of the grid
+
+   if (GetZGOUBIDatabase_position(XFt, ThetaFt, YFt, PhiFt) < 0) return -1;
+   std::vector<Int_t> lines;
+   std::vector<Float_t> distances;
+   FindNearestLines(XFt, ThetaFt, YFt, PhiFt, 1, lines, distances);
+   return lines.size() ? lines[0] : -1;
 }
 
-std::vector<Int_t> KVZGOUBIInverseMatrix::GetNearestLinenbs(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines)
+void KVZGOUBIInverseMatrix::FindNearestLines(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines,
+      std::vector<Int_t>& lines, std::vector<Float_t>& distances) const
 {
-   Int_t Maxnbneighbors = 100;
-   std::vector<Int_t> Closest4DVoxelsvector;
-   Int_t MultZGOUBIInversePosition;
-   Int_t ZGOUBITrajectoryposition;
-   Int_t ZGOUBIInversePositionDatabaseposition;
-   Float_t xf_line;
-   Float_t yf_line;
-   Float_t thetaf_line;
-   Float_t phif_line;
-   Float_t distance = 1;
-   Bool_t ZGOUBITrajectoryAvailable = false;
-   Int_t nbneighbors = 1;
-
-   std::vector<Int_t> ZGOUBIDatabase_positionmin;
-   std::vector<Float_t> ZGOUBIDatabase_positionmin_distance;
-   Int_t positionmax = 0;
-   Float_t distancemax = 0;
-   std::vector<Float_t>::iterator result_max_element;
-   if (XFt > xfmin && XFt < xfmax && YFt > yfmin && YFt < yfmax && ThetaFt > thetafmin && ThetaFt < thetafmax && PhiFt > phifmin && PhiFt < phifmax) {
-      while (ZGOUBITrajectoryAvailable == false && nbneighbors <= Maxnbneighbors) {
-         Closest4DVoxelsvector = GetClosest4DVoxels(XFt, ThetaFt, YFt, PhiFt, nbneighbors);
-         if (Closest4DVoxelsvector.size() <= 0) {
-            // std::cout<<"Value outside full range"<<std::endl;
+   // Find the nblines trajectories nearest to the point (or all trajectories if there are less than nblines).
+   // Their numbers are returned in lines and their distances (see GetDistance()) in distances,
+   // in order of increasing distance (trajectories at the same distance in order of increasing number).
+   //
+   // The cells of the index are searched in rings of increasing size r around the cell of the point,
+   // i.e. all cells whose coordinates differ from those of the point's cell by at most r in each dimension,
+   // and by exactly r in at least one. Trajectories in ring r+1 are at least at distance r*delta/characteristicdistance
+   // (in the dimension where this is the smallest) from the point: the search stops when this is larger than
+   // the distance of the furthest of the nblines trajectories found so far.
+
+   lines.clear();
+   distances.clear();
+   if (nblines < 1 || fCellStart.empty()) return;
+
+   const Int_t nsteps[4] = {nbstep_xf, nbstep_yf, nbstep_thetaf, nbstep_phif};
+   const Float_t cellsize[4] = {delta_xf / characteristicdistance_xf, delta_yf / characteristicdistance_yf,
+                                delta_thetaf / characteristicdistance_thetaf, delta_phif / characteristicdistance_phif
+                               };
+   Int_t centre[4];
+   GetCellCoordinates(XFt, ThetaFt, YFt, PhiFt, centre);
+   Int_t rmax = 0;
+   for (int d = 0; d < 4; ++d) rmax = std::max(rmax, std::max(centre[d], nsteps[d] - 1 - centre[d]));
+
+   // squared distances of trajectories found so far, in increasing order
+   std::vector<Float_t> dist2;
+   dist2.reserve(nblines + 1);
+   lines.reserve(nblines + 1);
+
+   Int_t lo[4], hi[4], cell[4];
+   for (Int_t r = 0; r <= rmax; ++r) {
+      if ((Int_t)lines.size() == nblines && r > 0) {
+         // lower bound of distance to any trajectory in ring r
+         Float_t bound = std::numeric_limits<Float_t>::max();
+         for (int d = 0; d < 4; ++d) {
+            if (centre[d] - r >= 0 || centre[d] + r < nsteps[d]) bound = std::min(bound, (r - 1) * cellsize[d]);
          }
-         else {
-            for (int i = 0; i < (int) Closest4DVoxelsvector.size(); i++) {
-               ZGOUBIInversePositionDatabaseposition = Closest4DVoxelsvector[i];
-               MultZGOUBIInversePosition = ZGOUBIInversePositionDatabase[ZGOUBIInversePositionDatabaseposition].GetInversePositionVectorSize();
-               if (MultZGOUBIInversePosition > 0) {
-                  ZGOUBITrajectoryAvailable = true;
-                  for (int j = 0; j < MultZGOUBIInversePosition; j++) {
-                     ZGOUBITrajectoryposition = ZGOUBIInversePositionDatabase[ZGOUBIInversePositionDatabaseposition].GetInversePositionVectorValue(j);
-                     xf_line = ZGOUBIDatabase[ZGOUBITrajectoryposition].GetXF();
-                     yf_line = ZGOUBIDatabase[ZGOUBITrajectoryposition].GetYF();
-                     thetaf_line = ZGOUBIDatabase[ZGOUBITrajectoryposition].GetThetaF();
-                     phif_line = ZGOUBIDatabase[ZGOUBITrajectoryposition].GetPhiF();
-                     distance = GetDistance(XFt, ThetaFt, YFt, PhiFt, xf_line, thetaf_line, yf_line, phif_line);
-                     if ((int) ZGOUBIDatabase_positionmin.size() < nblines) {
-                        ZGOUBIDatabase_positionmin.push_back(ZGOUBITrajectoryposition);
-                        ZGOUBIDatabase_positionmin_distance.push_back(distance);
-                        result_max_element = std::max_element(ZGOUBIDatabase_positionmin_distance.begin(), ZGOUBIDatabase_positionmin_distance.end());
-                        positionmax = std::distance(ZGOUBIDatabase_positionmin_distance.begin(), result_max_element);
-                        distancemax = ZGOUBIDatabase_positionmin_distance[positionmax];
-                     }
-                     else if (distance < distancemax) {
-                        ZGOUBIDatabase_positionmin[positionmax] = ZGOUBITrajectoryposition;
-                        ZGOUBIDatabase_positionmin_distance[positionmax] = distance;
-                        result_max_element = std::max_element(ZGOUBIDatabase_positionmin_distance.begin(), ZGOUBIDatabase_positionmin_distance.end());
-                        positionmax = std::distance(ZGOUBIDatabase_positionmin_distance.begin(), result_max_element);
-                        distancemax = ZGOUBIDatabase_positionmin_distance[positionmax];
+         if (bound * bound > dist2.back()) break;
+      }
+      for (int d = 0; d < 4; ++d) {
+         lo[d] = std::max(0, centre[d] - r);
+         hi[d] = std::min(nsteps[d] - 1, centre[d] + r);
+      }
+      for (cell[0] = lo[0]; cell[0] <= hi[0]; ++cell[0]) {
+         for (cell[1] = lo[1]; cell[1] <= hi[1]; ++cell[1]) {
+            for (cell[2] = lo[2]; cell[2] <= hi[2]; ++cell[2]) {
+               // if the first 3 coordinates are inside the ring, only the 2 cells at distance r in the last are on it
+               Bool_t inside = (std::abs(cell[0] - centre[0]) < r && std::abs(cell[1] - centre[1]) < r && std::abs(cell[2] - centre[2]) < r);
+               Int_t step = (inside ? 2 * r : 1);
+               for (cell[3] = (inside ? centre[3] - r : lo[3]); cell[3] <= hi[3]; cell[3] += step) {
+                  if (cell[3] < lo[3]) continue;
+                  Int_t c = GetCellIndex(cell);
+                  for (Int_t j = fCellStart[c]; j < fCellStart[c + 1]; ++j) {
+                     Float_t dxf = (XFt - fCellXF[j]) / characteristicdistance_xf;
+                     Float_t dyf = (YFt - fCellYF[j]) / characteristicdistance_yf;
+                     Float_t dthetaf = (ThetaFt - fCellThetaF[j]) / characteristicdistance_thetaf;
+                     Float_t dphif = (PhiFt - fCellPhiF[j]) / characteristicdistance_phif;
+                     Float_t d2 = dxf * dxf + dyf * dyf + dthetaf * dthetaf + dphif * dphif;
+                     if ((Int_t)lines.size() == nblines && d2 >= dist2.back()) continue;
+                     // insert in sorted list
+                     Int_t k = lines.size();
+                     while (k > 0 && (dist2[k - 1] > d2 || (dist2[k - 1] == d2 && lines[k - 1] > fCellLines[j]))) --k;
+                     dist2.insert(dist2.begin() + k, d2);
+                     lines.insert(lines.begin() + k, fCellLines[j]);
+                     if ((Int_t)lines.size() > nblines) {
+                        dist2.pop_back();
+                        lines.pop_back();
                      }
                   }
                }
             }
          }
-         nbneighbors++;
       }
    }
-   return  ZGOUBIDatabase_positionmin;
+   distances.resize(lines.size());
+   for (size_t k = 0; k < lines.size(); ++k) distances[k] = sqrt(dist2[k]);
 }
 
-
-
-std::vector<Int_t> KVZGOUBIInverseMatrix::GetLinesinRadius(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Float_t radius)
+std::vector<Int_t> KVZGOUBIInverseMatrix::GetNearestLinenbs(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines) const
 {
-   std::vector<Int_t> vectorLinesinRadius;
-   Int_t nbxf = (Int_t) ceil(radius / delta_xf);
-   Int_t nbyf = (Int_t) ceil(radius / delta_yf);
-   Int_t nbthetaf = (Int_t) ceil(radius / delta_thetaf);
-   Int_t nbphif = (Int_t) ceil(radius / delta_phif);
+   // Numbers of the nblines trajectories nearest to the point, in order of increasing distance
+   // (see FindNearestLines()). The vector is empty if the point is outside the range of the grid.
 
-   Int_t nbmax = 0;
-   if (nbxf > nbmax) nbmax = nbxf;
-   if (nbyf > nbmax) nbmax = nbyf;
-   if (nbthetaf > nbmax) nbmax = nbthetaf;
-   if (nbphif > nbmax) nbmax = nbphif;
+   std::vector<Int_t> lines;
+   std::vector<Float_t> distances;
+   if (XFt > xfmin && XFt < xfmax && YFt > yfmin && YFt < yfmax && ThetaFt > thetafmin && ThetaFt < thetafmax && PhiFt > phifmin && PhiFt < phifmax) {
+      FindNearestLines(XFt, ThetaFt, YFt, PhiFt, nblines, lines, distances);
+   }
+   return lines;
+}
 
-   //nbmax++;
+std::vector<Int_t> KVZGOUBIInverseMatrix::GetLinesinRadius(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Float_t radius) const
+{
+   // Numbers of all trajectories at a distance less than radius from the point
 
-   std::vector<Int_t> Closest4DVoxelsvector;
-   Int_t MultZGOUBIInversePosition;
-   Int_t ZGOUBITrajectoryposition;
-   Int_t ZGOUBIInversePositionDatabaseposition;
-   Float_t distance = 1;
-   Closest4DVoxelsvector = GetClosest4DVoxels(XFt, ThetaFt, YFt, PhiFt, nbmax);
-   if (Closest4DVoxelsvector.size() <= 0) {
-      // std::cout<<"Value outside full range"<<std::endl;
-   }
-   else {
-      for (int i = 0; i < (int) Closest4DVoxelsvector.size(); i++) {
-         ZGOUBIInversePositionDatabaseposition = Closest4DVoxelsvector[i];
-         MultZGOUBIInversePosition = ZGOUBIInversePositionDatabase[ZGOUBIInversePositionDatabaseposition].GetInversePositionVectorSize();
-         if (MultZGOUBIInversePosition > 0) {
-            for (int j = 0; j < MultZGOUBIInversePosition; j++) {
-               ZGOUBITrajectoryposition = ZGOUBIInversePositionDatabase[ZGOUBIInversePositionDatabaseposition].GetInversePositionVectorValue(j);
-               distance = GetDistance(XFt, ThetaFt, YFt, PhiFt, ZGOUBITrajectoryposition);
-               if (distance < radius) {
-                  vectorLinesinRadius.push_back(ZGOUBITrajectoryposition);
+   std::vector<Int_t> vectorLinesinRadius;
+   if (GetZGOUBIDatabase_position(XFt, ThetaFt, YFt, PhiFt) < 0) return vectorLinesinRadius;
+
+   // range of cells which may contain trajectories inside radius
+   Int_t lo[4], hi[4], cell[4];
+   GetCellCoordinates(XFt - radius * characteristicdistance_xf, ThetaFt - radius * characteristicdistance_thetaf,
+                      YFt - radius * characteristicdistance_yf, PhiFt - radius * characteristicdistance_phif, lo);
+   GetCellCoordinates(XFt + radius * characteristicdistance_xf, ThetaFt + radius * characteristicdistance_thetaf,
+                      YFt + radius * characteristicdistance_yf, PhiFt + radius * characteristicdistance_phif, hi);
+   for (cell[0] = lo[0]; cell[0] <= hi[0]; ++cell[0]) {
+      for (cell[1] = lo[1]; cell[1] <= hi[1]; ++cell[1]) {
+         for (cell[2] = lo[2]; cell[2] <= hi[2]; ++cell[2]) {
+            for (cell[3] = lo[3]; cell[3] <= hi[3]; ++cell[3]) {
+               Int_t c = GetCellIndex(cell);
+               for (Int_t j = fCellStart[c]; j < fCellStart[c + 1]; ++j) {
+                  if (GetDistance(XFt, ThetaFt, YFt, PhiFt, fCellXF[j], fCellThetaF[j], fCellYF[j], fCellPhiF[j]) < radius) {
+                     vectorLinesinRadius.push_back(fCellLines[j]);
+                  }
                }
             }
          }
@@ -695,7 +715,23 @@ std::vector<Float_t> KVZGOUBIInverseMatrix::testGetLinesinRadius_weight(Float_t
 }
 */
 
-std::vector<Float_t> KVZGOUBIInverseMatrix::testGetResults_weight(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines)
+void KVZGOUBIInverseMatrix::FillResults(std::vector<Float_t>& results, Int_t linenb, Int_t nblines) const
+{
+   // Fill results with the parameters of trajectory linenb (see testGetResults_weight_comb())
+
+   results[0] = ZGOUBIDatabase[linenb].GetXF();
+   results[1] = ZGOUBIDatabase[linenb].GetYF();
+   results[2] = ZGOUBIDatabase[linenb].GetThetaF();
+   results[3] = ZGOUBIDatabase[linenb].GetPhiF();
+   results[4] = ZGOUBIDatabase[linenb].GetThetaV();
+   results[5] = ZGOUBIDatabase[linenb].GetPhiV();
+   results[6] = ZGOUBIDatabase[linenb].GetDelta();
+   results[7] = ZGOUBIDatabase[linenb].GetPath();
+   results[8] = 0;
+   results[9] = nblines;
+}
+
+std::vector<Float_t> KVZGOUBIInverseMatrix::testGetResults_weight(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines) const
 {
    std::vector<Int_t> linenbs = GetNearestLinenbs(XFt, ThetaFt, YFt, PhiFt, nblines);
    std::vector<Float_t> results(10, -1);
@@ -705,16 +741,7 @@ std::vector<Float_t> KVZGOUBIInverseMatrix::testGetResults_weight(Float_t XFt, F
       for (int i = 0; i < (int) linenbs.size(); i++) {
          Distance.push_back(GetDistance(XFt, ThetaFt, YFt, PhiFt, linenbs[i]));
          if (Distance[i] == 0) {
-            results[0] = ZGOUBIDatabase[linenbs[i]].GetXF();
-            results[1] = ZGOUBIDatabase[linenbs[i]].GetYF();
-            results[2] = ZGOUBIDatabase[linenbs[i]].GetThetaF();
-            results[3] = ZGOUBIDatabase[linenbs[i]].GetPhiF();
-            results[4] = ZGOUBIDatabase[linenbs[i]].GetThetaV();
-            results[5] = ZGOUBIDatabase[linenbs[i]].GetPhiV();
-            results[6] = ZGOUBIDatabase[linenbs[i]].GetDelta();
-            results[7] = ZGOUBIDatabase[linenbs[i]].GetPath();
-            results[8] = 0;
-            results[9] = linenbs.size();
+            FillResults(results, linenbs[i], linenbs.size());
             return results;
          }
          inversedistancetotal += 1. / Distance[i];
@@ -760,118 +787,188 @@ std::vector<Float_t> KVZGOUBIInverseMatrix::testGetResults_weight(Float_t XFt, F
    return results;
 }
 
-std::vector<Float_t> KVZGOUBIInverseMatrix::testGetResults_weight_comb(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines)
+std::vector<Float_t> KVZGOUBIInverseMatrix::testGetResults_weight_comb(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines) const
 {
+   // Parameters of the trajectory at the point, interpolated from the nblines nearest trajectories.
+   //
+   // For each combination of the nearest trajectories, the average of their focal plane coordinates weighted
+   // by the inverse of their distance to the point is calculated: the result is the weighted average of the
+   // parameters of the combination whose average is closest to the point.
+   //
+   // The sums of weights for all combinations are calculated recursively, the sums for each combination
+   // being those of the same combination without its last trajectory plus the last trajectory,
+   // which gives the same sums (and results) as adding the trajectories of each combination in order.
+   //
+   // results[0-3]: xf, yf, thetaf, phif
+   // results[4-7]: ThetaV, PhiV, Delta, Path
+   // results[9]: number of trajectories used (-1 if point is outside range of grid)
+
    std::vector<Int_t> linenbs = GetNearestLinenbs(XFt, ThetaFt, YFt, PhiFt, nblines);
-   std::vector<std::vector<int> > listofcomb = comb.GetComb((int) linenbs.size());
    std::vector<Float_t> results(10, -1);
-   std::vector<Float_t> Distance;
+   Int_t N = linenbs.size();
+   if (!N) return results;
 
-   if (linenbs.size() > 0) {
-      for (int i = 0; i < (int) linenbs.size(); i++) {
-         Distance.push_back(GetDistance(XFt, ThetaFt, YFt, PhiFt, linenbs[i]));
-         if (Distance[i] == 0) {
-            results[0] = ZGOUBIDatabase[linenbs[i]].GetXF();
-            results[1] = ZGOUBIDatabase[linenbs[i]].GetYF();
-            results[2] = ZGOUBIDatabase[linenbs[i]].GetThetaF();
-            results[3] = ZGOUBIDatabase[linenbs[i]].GetPhiF();
-            results[4] = ZGOUBIDatabase[linenbs[i]].GetThetaV();
-            results[5] = ZGOUBIDatabase[linenbs[i]].GetPhiV();
-            results[6] = ZGOUBIDatabase[linenbs[i]].GetDelta();
-            results[7] = ZGOUBIDatabase[linenbs[i]].GetPath();
-            results[8] = 0;
-            results[9] = linenbs.size();
-            return results;
-         }
+   std::vector<Float_t> Distance(N);
+   for (int i = 0; i < N; i++) {
+      Distance[i] = GetDistance(XFt, ThetaFt, YFt, PhiFt, linenbs[i]);
+      if (Distance[i] == 0) {
+         FillResults(results, linenbs[i], N);
+         return results;
       }
+   }
 
+   std::vector<UInt_t> other_combinations;
+   if (N >= (int)fCombinations.size()) other_combinations = combinations(N);
+   const std::vector<UInt_t>& listofcomb = (N < (int)fCombinations.size() ? fCombinations[N] : other_combinations);
+
+   // sums of inverse distances and of weighted coordinates for each combination (bitmask)
+   const UInt_t nmasks = (1u << N);
+   std::vector<Float_t> inversedistancetotal(nmasks, 0), XFsum(nmasks, 0), YFsum(nmasks, 0), ThetaFsum(nmasks, 0), PhiFsum(nmasks, 0);
+   Int_t last = 0; // highest bit of m
+   for (UInt_t m = 1; m < nmasks; ++m) {
+      if (m >> (last + 1)) ++last;
+      UInt_t prev = m & ~(1u << last);
+      const KVZGOUBITrajectory& line = ZGOUBIDatabase[linenbs[last]];
+      inversedistancetotal[m] = inversedistancetotal[prev] + 1. / Distance[last];
+      XFsum[m] = XFsum[prev] + 1. / Distance[last] * line.GetXF();
+      YFsum[m] = YFsum[prev] + 1. / Distance[last] * line.GetYF();
+      ThetaFsum[m] = ThetaFsum[prev] + 1. / Distance[last] * line.GetThetaF();
+      PhiFsum[m] = PhiFsum[prev] + 1. / Distance[last] * line.GetPhiF();
+   }
 
-
-      Float_t XFtemp = 0;
-      Float_t YFtemp = 0;
-      Float_t ThetaFtemp = 0;
-      Float_t PhiFtemp = 0;
-      Float_t inversedistancetotal = 0;
-      Float_t distancemin = 1000000;
-      Float_t configurationmin = 0;
-      Float_t distancecomb;
-
-      for (int comb_test = 0; comb_test < (int) listofcomb.size(); comb_test++) {
-         XFtemp = 0;
-         YFtemp = 0;
-         ThetaFtemp = 0;
-         PhiFtemp = 0;
-         inversedistancetotal = 0;
-         for (int i = 0; i < (int) listofcomb[comb_test].size(); i++) {
-            inversedistancetotal += 1. / Distance[listofcomb[comb_test][i]];
-         }
-         for (int i = 0; i < (int) listofcomb[comb_test].size(); i++) {
-            XFtemp += 1. / Distance[listofcomb[comb_test][i]] * ZGOUBIDatabase[linenbs[listofcomb[comb_test][i]]].GetXF();
-            YFtemp += 1. / Distance[listofcomb[comb_test][i]] * ZGOUBIDatabase[linenbs[listofcomb[comb_test][i]]].GetYF();
-            ThetaFtemp += 1. / Distance[listofcomb[comb_test][i]] * ZGOUBIDatabase[linenbs[listofcomb[comb_test][i]]].GetThetaF();
-            PhiFtemp += 1. / Distance[listofcomb[comb_test][i]] * ZGOUBIDatabase[linenbs[listofcomb[comb_test][i]]].GetPhiF();
-         }
-         XFtemp = XFtemp / inversedistancetotal;
-         YFtemp = YFtemp / inversedistancetotal;
-         ThetaFtemp = ThetaFtemp / inversedistancetotal;
-         PhiFtemp = PhiFtemp / inversedistancetotal;
-         distancecomb = GetDistance(XFtemp, ThetaFtemp, YFtemp, PhiFtemp, XFt, ThetaFt, YFt, PhiFt);
-         if (distancecomb < distancemin) {
-            distancemin = distancecomb;
-            configurationmin = comb_test;
-         }
+   Float_t distancemin = 1000000;
+   UInt_t configurationmin = listofcomb[0];
+   for (size_t comb_test = 0; comb_test < listofcomb.size(); comb_test++) {
+      UInt_t m = listofcomb[comb_test];
+      Float_t XFtemp = XFsum[m] / inversedistancetotal[m];
+      Float_t YFtemp = YFsum[m] / inversedistancetotal[m];
+      Float_t ThetaFtemp = ThetaFsum[m] / inversedistancetotal[m];
+      Float_t PhiFtemp = PhiFsum[m] / inversedistancetotal[m];
+      Float_t distancecomb = GetDistance(XFtemp, ThetaFtemp, YFtemp, PhiFtemp, XFt, ThetaFt, YFt, PhiFt);
+      if (distancecomb < distancemin) {
+         distancemin = distancecomb;
+         configurationmin = m;
       }
+   }
 
-      //  std::cout<<listofcomb[configurationmin].size()<<" "<< configurationmin<<" "<<distancemin<<std::endl;
-      XFtemp = 0;
-      YFtemp = 0;
-      ThetaFtemp = 0;
-      PhiFtemp = 0;
-      Float_t ThetaVtemp = 0;
-      Float_t PhiVtemp = 0;
-      Float_t Deltatemp = 0;
-      Float_t Pathtemp = 0;
-      inversedistancetotal = 0;
-      for (int i = 0; i < (int) listofcomb[configurationmin].size(); i++) {
-         inversedistancetotal += 1. / Distance[listofcomb[configurationmin][i]];
-      }
-      for (int i = 0; i < (int) listofcomb[configurationmin].size(); i++) {
-         XFtemp += 1. / Distance[listofcomb[configurationmin][i]] * ZGOUBIDatabase[linenbs[listofcomb[configurationmin][i]]].GetXF();
-         YFtemp += 1. / Distance[listofcomb[configurationmin][i]] * ZGOUBIDatabase[linenbs[listofcomb[configurationmin][i]]].GetYF();
-         ThetaFtemp += 1. / Distance[listofcomb[configurationmin][i]] * ZGOUBIDatabase[linenbs[listofcomb[configurationmin][i]]].GetThetaF();
-         PhiFtemp += 1. / Distance[listofcomb[configurationmin][i]] * ZGOUBIDatabase[linenbs[listofcomb[configurationmin][i]]].GetPhiF();
-         ThetaVtemp += 1. / Distance[listofcomb[configurationmin][i]] * ZGOUBIDatabase[linenbs[listofcomb[configurationmin][i]]].GetThetaV();
-         PhiVtemp += 1. / Distance[listofcomb[configurationmin][i]] * ZGOUBIDatabase[linenbs[listofcomb[configurationmin][i]]].GetPhiV();
-         Deltatemp += 1. / Distance[listofcomb[configurationmin][i]] * ZGOUBIDatabase[linenbs[listofcomb[configurationmin][i]]].GetDelta();
-         Pathtemp += 1. / Distance[listofcomb[configurationmin][i]] * ZGOUBIDatabase[linenbs[listofcomb[configurationmin][i]]].GetPath();
-      }
-      XFtemp = XFtemp / inversedistancetotal;
-      YFtemp = YFtemp / inversedistancetotal;
-      ThetaFtemp = ThetaFtemp / inversedistancetotal;
-      PhiFtemp = PhiFtemp / inversedistancetotal;
-      ThetaVtemp = ThetaVtemp / inversedistancetotal;
-      PhiVtemp = PhiVtemp / inversedistancetotal;
-      Deltatemp = Deltatemp / inversedistancetotal;
-      Pathtemp = Pathtemp / inversedistancetotal;
+   Float_t ThetaVtemp = 0;
+   Float_t PhiVtemp = 0;
+   Float_t Deltatemp = 0;
+   Float_t Pathtemp = 0;
+   for (int i = 0; i < N; i++) {
+      if (!(configurationmin & (1u << i))) continue;
+      const KVZGOUBITrajectory& line = ZGOUBIDatabase[linenbs[i]];
+      ThetaVtemp += 1. / Distance[i] * line.GetThetaV();
+      PhiVtemp += 1. / Distance[i] * line.GetPhiV();
+      Deltatemp += 1. / Distance[i] * line.GetDelta();
+      Pathtemp += 1. / Distance[i] * line.GetPath();
+   }
+   Float_t inversedistance = inversedistancetotal[configurationmin];
+
+   results[0] = XFsum[configurationmin] / inversedistance;
+   results[1] = YFsum[configurationmin] / inversedistance;
+   results[2] = ThetaFsum[configurationmin] / inversedistance;
+   results[3] = PhiFsum[configurationmin] / inversedistance;
+   results[4] = ThetaVtemp / inversedistance;
+   results[5] = PhiVtemp / inversedistance;
+   results[6] = Deltatemp / inversedistance;
+   results[7] = Pathtemp / inversedistance;
+   results[8] = 0;
+   results[9] = N;
+   return results;
+}
 
-      results[0] = XFtemp;
-      results[1] = YFtemp;
-      results[2] = ThetaFtemp;
-      results[3] = PhiFtemp;
-      results[4] = ThetaVtemp;
-      results[5] = PhiVtemp;
-      results[6] = Deltatemp;
-      results[7] = Pathtemp;
-      results[8] = 0;
-      results[9] = linenbs.size();
+std::vector<Float_t> KVZGOUBIInverseMatrix::GetResults_linear(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines) const
+{
+   // Parameters of the trajectory at the point, interpolated from the nblines nearest trajectories
+   // by a local linear fit: each of ThetaV, PhiV, Delta and Path is fitted as a linear function of the focal
+   // plane coordinates by least squares, weighting each trajectory by the inverse of its distance to the point,
+   // and evaluated at the point.
+   //
+   // Only the coordinates which vary significantly between the trajectories (on the scale given by
+   // Setcharacteristicdistance()) are used in the fit. If there are not enough trajectories for the fit
+   // or the fit fails, the result of testGetResults_weight_comb() is returned.
+   //
+   // The meaning of the elements of the vector is the same as for testGetResults_weight_comb(),
+   // results[0-3] being the coordinates of the point.
+
+   std::vector<Int_t> linenbs = GetNearestLinenbs(XFt, ThetaFt, YFt, PhiFt, nblines);
+   std::vector<Float_t> results(10, -1);
+   Int_t N = linenbs.size();
+   if (!N) return results;
+
+   const Float_t point[4] = {XFt, ThetaFt, YFt, PhiFt};
+   const Float_t scale[4] = {characteristicdistance_xf, characteristicdistance_thetaf, characteristicdistance_yf, characteristicdistance_phif};
+   std::vector<Double_t> weight(N);
+   std::vector<Double_t> coords(4 * N);
+   Double_t spread[4] = {0, 0, 0, 0};
+   for (int i = 0; i < N; i++) {
+      Float_t distance = GetDistance(XFt, ThetaFt, YFt, PhiFt, linenbs[i]);
+      if (distance == 0) {
+         FillResults(results, linenbs[i], N);
+         return results;
+      }
+      weight[i] = 1. / distance;
+      const KVZGOUBITrajectory& line = ZGOUBIDatabase[linenbs[i]];
+      const Float_t c[4] = {line.GetXF(), line.GetThetaF(), line.GetYF(), line.GetPhiF()};
+      for (int d = 0; d < 4; ++d) {
+         coords[4 * i + d] = (c[d] - point[d]) / scale[d];
+         spread[d] = std::max(spread[d], std::abs(coords[4 * i + d]));
+      }
    }
+   Double_t maxspread = *std::max_element(spread, spread + 4);
+   Int_t dims[4], ndims = 0;
+   for (int d = 0; d < 4; ++d) if (spread[d] > 1.e-3 * maxspread) dims[ndims++] = d;
+   const Int_t npar = ndims + 1;
+   if (N < npar + 1) return testGetResults_weight_comb(XFt, ThetaFt, YFt, PhiFt, nblines);
+
+   // normal equations: A.p = b for each fitted parameter
+   Double_t A[5][5], b[5][4];
+   for (int j = 0; j < npar; ++j) {
+      for (int k = 0; k < npar; ++k) A[j][k] = 0;
+      for (int q = 0; q < 4; ++q) b[j][q] = 0;
+   }
+   for (int i = 0; i < N; i++) {
+      const KVZGOUBITrajectory& line = ZGOUBIDatabase[linenbs[i]];
+      const Double_t y[4] = {line.GetThetaV(), line.GetPhiV(), line.GetDelta(), line.GetPath()};
+      Double_t x[5];
+      x[0] = 1;
+      for (int j = 0; j < ndims; ++j) x[j + 1] = coords[4 * i + dims[j]];
+      for (int j = 0; j < npar; ++j) {
+         for (int k = 0; k < npar; ++k) A[j][k] += weight[i] * x[j] * x[k];
+         for (int q = 0; q < 4; ++q) b[j][q] += weight[i] * x[j] * y[q];
+      }
+   }
+   // Gauss-Jordan elimination with partial pivoting
+   const Double_t tiny = 1.e-12 * A[0][0];
+   for (int j = 0; j < npar; ++j) {
+      int piv = j;
+      for (int k = j + 1; k < npar; ++k) if (std::abs(A[k][j]) > std::abs(A[piv][j])) piv = k;
+      if (std::abs(A[piv][j]) < tiny) return testGetResults_weight_comb(XFt, ThetaFt, YFt, PhiFt, nblines);
+      if (piv != j) {
+         for (int k = 0; k < npar; ++k) std::swap(A[j][k], A[piv][k]);
+         for (int q = 0; q < 4; ++q) std::swap(b[j][q], b[piv][q]);
+      }
+      for (int k = 0; k < npar; ++k) {
+         if (k == j) continue;
+         Double_t f = A[k][j] / A[j][j];
+         for (int l = j; l < npar; ++l) A[k][l] -= f * A[j][l];
+         for (int q = 0; q < 4; ++q) b[k][q] -= f * b[j][q];
+      }
+   }
+   // the coordinates are relative to the point, so the interpolated values are the constant terms
+   results[0] = XFt;
+   results[1] = YFt;
+   results[2] = ThetaFt;
+   results[3] = PhiFt;
+   for (int q = 0; q < 4; ++q) results[4 + q] = b[0][q] / A[0][0];
+   results[8] = 0;
+   results[9] = N;
    return results;
 }
 
 
-KVZGOUBITrajectory KVZGOUBIInverseMatrix::GetZGOUBITrajectory(Int_t Trajectorynb)
+KVZGOUBITrajectory KVZGOUBIInverseMatrix::GetZGOUBITrajectory(Int_t Trajectorynb) const
 {
    return ZGOUBIDatabase[Trajectorynb];
 }
-
-
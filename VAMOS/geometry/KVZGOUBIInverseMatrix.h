@@ -6,8 +6,6 @@
 
 #include "KVBase.h"
 #include "KVZGOUBITrajectory.h"
-#include "KVZGOUBIInversePosition.h"
-#include "KVZGOUBIComb.h"
 #include <vector>
 #include <math.h>
 #include "TFile.h"
@@ -17,10 +15,27 @@
 #include "KVVAMOS.h"
 #include "TChain.h"
 
+/**
+\class KVZGOUBIInverseMatrix
+\brief Class used to reconstruct trajectories in VAMOS
+\ingroup VAMOS
+
+Trajectories of a ZGOUBI database are found from their coordinates (xf, thetaf, yf, phif) at the focal plane
+using an index built by the constructor: the 4D space of focal plane coordinates is divided into a grid of
+cells (whose numbers are given to the constructor or SetNbSteps()), and the numbers and focal plane coordinates
+of the trajectories of each cell are stored contiguously in flat arrays, in the order of the cells.
+
+The nearest trajectories to a point, according to the distance GetDistance() (whose scale in each dimension
+is set with Setcharacteristicdistance()), are found by GetNearestLinenbs() by looking through the cells
+in rings of increasing size around the cell of the point, until the next ring cannot contain any trajectory
+closer than those already found.
+
+All methods used to reconstruct trajectories are `const` and do not modify the object, so that
+the same matrix can be used to reconstruct different events at the same time in different threads.
+*/
 class KVZGOUBIInverseMatrix : public KVBase {
 protected:
    std::vector<KVZGOUBITrajectory> ZGOUBIDatabase;
-   std::vector<KVZGOUBIInversePosition> ZGOUBIInversePositionDatabase;
    Float_t xfmin;
    Float_t xfmax;
    Float_t yfmin;
@@ -41,7 +56,22 @@ protected:
    Float_t characteristicdistance_yf;
    Float_t characteristicdistance_thetaf;
    Float_t characteristicdistance_phif;
-   KVZGOUBIComb comb;
+
+   std::vector<Int_t> fCellStart;//! index in fCellLines of first trajectory of each cell (with one extra element at end)
+   std::vector<Int_t> fCellLines;//! trajectory numbers, sorted by cell
+   std::vector<Float_t> fCellXF;//! xf of trajectories, in same order as fCellLines
+   std::vector<Float_t> fCellThetaF;//! thetaf of trajectories, in same order as fCellLines
+   std::vector<Float_t> fCellYF;//! yf of trajectories, in same order as fCellLines
+   std::vector<Float_t> fCellPhiF;//! phif of trajectories, in same order as fCellLines
+   std::vector<std::vector<UInt_t> > fCombinations;//! all combinations of N=1,...,10 neighbours (bitmasks)
+
+   void GetCellCoordinates(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t* cell) const;
+   Int_t GetCellIndex(const Int_t* cell) const
+   {
+      // cell coordinates are in the order (xf, yf, thetaf, phif)
+      return ((cell[0] * nbstep_yf + cell[1]) * nbstep_thetaf + cell[2]) * nbstep_phif + cell[3];
+   }
+   void FillResults(std::vector<Float_t>& results, Int_t linenb, Int_t nblines) const;
 
 public:
    KVZGOUBIInverseMatrix();
@@ -57,22 +87,23 @@ public:
    void PrintExtremum();
    void FindDeltaParameters();
    void SetNbSteps(Int_t nbstepxft, Int_t nbstepthetaft, Int_t nbstepyft, Int_t nbstepphift);
-   void AddZGOUBIInversePosition();
-   void initZGOUBIInversePositionDatabase();
-   void SetZGOUBIInversePositionDatabase();
-   Int_t GetZGOUBIDatabase_position(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt);
-   std::vector<Int_t> GetClosest4DVoxels(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nbneighbors);
-   Float_t GetDistance(Float_t xf, Float_t thetaf, Float_t yf, Float_t phif, Float_t xf_line, Float_t thetaf_line, Float_t yf_line, Float_t phif_line);
-   Int_t GetNearestLinenb(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt);
-   KVZGOUBITrajectory GetZGOUBITrajectory(Int_t Trajectorynb);
-   std::vector<Int_t> GetNearestLinenbs(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines);
-   Float_t GetDistance(Float_t xf, Float_t thetaf, Float_t yf, Float_t phif, Int_t linenb);
-   Float_t GetDistance(Int_t linenb1, Int_t linenb2);
-   std::vector<Int_t> GetLinesinRadius(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Float_t radius);
+   void BuildIndex();
+   Int_t GetZGOUBIDatabase_position(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt) const;
+   std::vector<Int_t> GetClosest4DVoxels(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nbneighbors) const;
+   Float_t GetDistance(Float_t xf, Float_t thetaf, Float_t yf, Float_t phif, Float_t xf_line, Float_t thetaf_line, Float_t yf_line, Float_t phif_line) const;
+   Int_t GetNearestLinenb(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt) const;
+   KVZGOUBITrajectory GetZGOUBITrajectory(Int_t Trajectorynb) const;
+   void FindNearestLines(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines,
+                         std::vector<Int_t>& lines, std::vector<Float_t>& distances) const;
+   std::vector<Int_t> GetNearestLinenbs(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines) const;
+   Float_t GetDistance(Float_t xf, Float_t thetaf, Float_t yf, Float_t phif, Int_t linenb) const;
+   Float_t GetDistance(Int_t linenb1, Int_t linenb2) const;
+   std::vector<Int_t> GetLinesinRadius(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Float_t radius) const;
    // std::vector<Float_t> testGetLinesinRadius_bari(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Float_t radiusmultiplier);
    //std::vector<Float_t> testGetLinesinRadius_weight(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Float_t radiusmultiplier);
-   std::vector<Float_t> testGetResults_weight(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines);
-   std::vector<Float_t> testGetResults_weight_comb(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines);
+   std::vector<Float_t> testGetResults_weight(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines) const;
+   std::vector<Float_t> testGetResults_weight_comb(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines) const;
+   std::vector<Float_t> GetResults_linear(Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Int_t nblines) const;
    void Setcharacteristicdistance(Float_t d_XF, Float_t d_ThetaF, Float_t d_YF, Float_t d_PhiF)
    {
       characteristicdistance_xf = d_XF;
@@ -80,7 +111,7 @@ public:
       characteristicdistance_yf = d_YF;
       characteristicdistance_phif = d_PhiF;
    }
-   ClassDef(KVZGOUBIInverseMatrix, 1) //Class used to reconstruct trajectories in VAMOS
+   ClassDef(KVZGOUBIInverseMatrix, 2) //Class used to reconstruct trajectories in VAMOS
 };
 
 #endif
@@ -2,6 +2,13 @@
 //Author: Patrick St-Onge,,,
 
 #include "KVZGOUBIReconstruction.h"
+#include <algorithm>
+#ifdef WITH_CPP11
+#include "KVThreadPool.h"
+#endif
+#ifdef USING_ROOT6
+#include "TROOT.h"
+#endif
 
 ClassImp(KVZGOUBIReconstruction)
 
@@ -15,7 +22,7 @@ ClassImp(KVZGOUBIReconstruction)
 ////////////////////////////////////////////////////////////////////////////////
 
 KVZGOUBIReconstruction::KVZGOUBIReconstruction()
-   : KVBase()
+   : KVBase(), fLinearInterpolation(kFALSE), fThreadPool(nullptr)
 {
    // Default constructor
    Matrix_2D = NULL;
@@ -25,7 +32,7 @@ KVZGOUBIReconstruction::KVZGOUBIReconstruction()
 //____________________________________________________________________________//
 
 KVZGOUBIReconstruction::KVZGOUBIReconstruction(Bool_t init)
-   : KVBase()
+   : KVBase(), fLinearInterpolation(kFALSE), fThreadPool(nullptr)
 {
    Matrix_2D = NULL;
    Matrix_4D = NULL;
@@ -35,7 +42,8 @@ KVZGOUBIReconstruction::KVZGOUBIReconstruction(Bool_t init)
 //____________________________________________________________________________//
 
 
-KVZGOUBIReconstruction::KVZGOUBIReconstruction(const KVZGOUBIReconstruction& obj) : KVBase()
+KVZGOUBIReconstruction::KVZGOUBIReconstruction(const KVZGOUBIReconstruction& obj)
+   : KVBase(), fLinearInterpolation(kFALSE), fThreadPool(nullptr)
 {
    // Copy constructor
    // Use this constructor to copy an existing object
@@ -45,7 +53,7 @@ KVZGOUBIReconstruction::KVZGOUBIReconstruction(const KVZGOUBIReconstruction& obj
 //____________________________________________________________________________//
 
 KVZGOUBIReconstruction::KVZGOUBIReconstruction(const Char_t* name, const Char_t* title)
-   : KVBase(name, title)
+   : KVBase(name, title), Matrix_2D(NULL), Matrix_4D(NULL), fLinearInterpolation(kFALSE), fThreadPool(nullptr)
 {
    // Constructor inherited from KVBase
 }
@@ -55,6 +63,9 @@ KVZGOUBIReconstruction::KVZGOUBIReconstruction(const Char_t* name, const Char_t*
 KVZGOUBIReconstruction::~KVZGOUBIReconstruction()
 {
    // Destructor
+#ifdef WITH_CPP11
+   delete fThreadPool;
+#endif
 }
 
 //____________________________________________________________________________//
@@ -68,6 +79,7 @@ void KVZGOUBIReconstruction::Copy(TObject& obj) const
    KVZGOUBIReconstruction& CastedObj = (KVZGOUBIReconstruction&)obj;
    CastedObj.Matrix_2D = Matrix_2D ;
    CastedObj.Matrix_4D = Matrix_4D ;
+   CastedObj.fLinearInterpolation = fLinearInterpolation;
 
 }
 //____________________________________________________________________________//
@@ -76,6 +88,8 @@ void KVZGOUBIReconstruction::Init()
 {
    TString hardcoded_datasetsubdir = "INDRA_e494s";
 
+   fLinearInterpolation = !strcmp(gDataSet->GetDataSetEnv("KVZGOUBIReconstruction.Interpolation", "Combination"), "Linear");
+
 
    TString filename4D = gDataSet->GetDataSetEnv("KVZGOUBIReconstruction.ZGOUBIDatabase4D");
    TString filename_localdatabase4D = gDataSet->GetDataSetEnv("KVZGOUBIReconstruction.ZGOUBIDatabase_local4D");
@@ -108,6 +122,7 @@ void KVZGOUBIReconstruction::Init()
          }
       }
       Matrix_4D = new KVZGOUBIInverseMatrix(250, 250, 1, 1, t);
+      Matrix_4D->Setcharacteristicdistance(1, 1, 1, 1);
       delete t;
    }
 
@@ -143,12 +158,22 @@ void KVZGOUBIReconstruction::Init()
          }
       }
       Matrix_2D = new KVZGOUBIInverseMatrix(250, 250, 1, 1, t);
+      // yf and phif are not used to find the nearest trajectories in the 2D database
+      Matrix_2D->Setcharacteristicdistance(1, 1, 1000000, 1000000);
       delete t;
    }
 }
 //____________________________________________________________________________//
 
-Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(KVVAMOSReconTrajectory* traj)
+std::vector<Float_t> KVZGOUBIReconstruction::GetResults(const KVZGOUBIInverseMatrix* mat, Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt) const
+{
+   // Interpolate parameters of trajectory from the 10 nearest trajectories of the database
+
+   if (fLinearInterpolation) return mat->GetResults_linear(XFt, ThetaFt, YFt, PhiFt, 10);
+   return mat->testGetResults_weight_comb(XFt, ThetaFt, YFt, PhiFt, 10);
+}
+
+Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(KVVAMOSReconTrajectory* traj) const
 {
    // Reconstruction of the trajectory at the target point, in the reference
    // frame of the laboratory, from the trajectory at the focal plane.
@@ -157,6 +182,8 @@ Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(KVVAMOSReconTrajectory* traj)
    //
    // The result is stored in the 'traj' object and the method returns true
    // if the attempt is a success.
+   //
+   // This method may be called for different trajectories at the same time in different threads.
 
    Bool_t ok = kFALSE;
 
@@ -164,6 +191,10 @@ Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(KVVAMOSReconTrajectory* traj)
       Error("ReconstructFPtoLab", "Focal plane position parameters are not ready to reconstruct the trajectory");
       return ok;
    }
+   if (!Matrix_2D || !Matrix_4D) {
+      Error("ReconstructFPtoLab", "ZGOUBI databases are not initialised");
+      return ok;
+   }
 
 
    Float_t XFt = (Float_t) - 1.*traj->pointFP[0];
@@ -218,11 +249,9 @@ Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(KVVAMOSReconTrajectory* traj)
    */
 
 
-   Matrix_2D->Setcharacteristicdistance(1, 1, 1000000, 1000000);
-   std::vector<Float_t> results_identification2D = Matrix_2D->testGetResults_weight_comb(XFt, ThetaFt, YFt, PhiFt, 10);
+   std::vector<Float_t> results_identification2D = GetResults(Matrix_2D, XFt, ThetaFt, YFt, PhiFt);
    if (results_identification2D[9] > 0) {
-      Matrix_4D->Setcharacteristicdistance(1, 1, 1, 1);
-      std::vector<Float_t> results_identification4D = Matrix_4D->testGetResults_weight_comb(XFt, ThetaFt, YFt, PhiFt, 10);
+      std::vector<Float_t> results_identification4D = GetResults(Matrix_4D, XFt, ThetaFt, YFt, PhiFt);
       if (results_identification4D[9] > 0) {
          traj->path = (Double_t) results_identification2D[7];
          traj->Brho = (Double_t) results_identification2D[6] * gVamos->GetBrhoRef();
@@ -244,12 +273,12 @@ Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(KVVAMOSReconTrajectory* traj)
 
 //________________________________________________________________
 
-Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(Double_t x_f, Double_t y_f, Double_t theta_f, Double_t phi_f, Double_t& brho, Double_t& path, Double_t& theta_v, Double_t& phi_v)
+Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(Double_t x_f, Double_t y_f, Double_t theta_f, Double_t phi_f, Double_t& brho, Double_t& path, Double_t& theta_v, Double_t& phi_v) const
 {
    // x_f and y_f in cm.
    // phi_f, theta_f, phi_l and theta_l in degree.
 
-   static KVVAMOSReconTrajectory traj;
+   KVVAMOSReconTrajectory traj;
 
    traj.pointFP[0] = x_f;
    traj.pointFP[1] = y_f;
@@ -269,3 +298,57 @@ Bool_t KVZGOUBIReconstruction::ReconstructFPtoLab(Double_t x_f, Double_t y_f, Do
    return status;
 }
 //________________________________________________________________
+
+Int_t KVZGOUBIReconstruction::ReconstructFPtoLab(std::vector<KVVAMOSReconTrajectory*>& trajs)
+{
+   // Reconstruct a batch of trajectories from the focal plane to the target
+   // (see ReconstructFPtoLab(KVVAMOSReconTrajectory*)).
+   // If SetNumberOfThreads() was called, the trajectories are shared between the threads.
+   //
+   // Returns the number of trajectories successfully reconstructed.
+
+   Int_t ntraj = trajs.size();
+#ifdef WITH_CPP11
+   if (fThreadPool && ntraj > 1) {
+      const Int_t nchunks = std::min(ntraj, (Int_t)(4 * fThreadPool->GetNumberOfThreads()));
+      const Int_t chunk_size = (ntraj + nchunks - 1) / nchunks;
+      std::vector<Int_t> nok(nchunks, 0);
+      for (Int_t c = 0; c < nchunks; ++c) {
+         fThreadPool->Submit([ =, &trajs, &nok]() {
+            for (Int_t i = c * chunk_size; i < std::min(ntraj, (c + 1) * chunk_size); ++i) {
+               if (ReconstructFPtoLab(trajs[i])) ++nok[c];
+            }
+         });
+      }
+      fThreadPool->Wait();
+      Int_t ok = 0;
+      for (auto n : nok) ok += n;
+      return ok;
+   }
+#endif
+   Int_t ok = 0;
+   for (Int_t i = 0; i < ntraj; ++i) {
+      if (ReconstructFPtoLab(trajs[i])) ++ok;
+   }
+   return ok;
+}
+
+//________________________________________________________________
+
+void KVZGOUBIReconstruction::SetNumberOfThreads(UInt_t nthreads)
+{
+   // Use the given number of threads (if nthreads=0, the number of hardware threads of the machine)
+   // to reconstruct batches of trajectories with ReconstructFPtoLab(std::vector<KVVAMOSReconTrajectory*>&)
+
+#ifdef WITH_CPP11
+#ifdef USING_ROOT6
+   ROOT::EnableThreadSafety();
+#endif
+   delete fThreadPool;
+   fThreadPool = new KVThreadPool(nthreads);
+#else
+   Warning("SetNumberOfThreads", "Multi-threaded reconstruction requires C++11: %u threads requested, using 1", nthreads);
+#endif
+}
+
+//________________________________________________________________
@@ -7,13 +7,39 @@
 #include "KVBase.h"
 #include "KVZGOUBIInverseMatrix.h"
 #include "KVZGOUBITrajectory.h"
+#include <vector>
 
 class KVZGOUBIInverseMatrix;
+class KVThreadPool;
 
+/**
+\class KVZGOUBIReconstruction
+\brief Reconstruction of trajectories in VAMOS from the focal plane to the target using a ZGOUBI database
+\ingroup VAMOS
+
+The trajectory at the target is interpolated from the nearest trajectories of the ZGOUBI databases
+(see KVZGOUBIInverseMatrix). The interpolation method is given by the (dataset-dependent) variable
+
+~~~~
+KVZGOUBIReconstruction.Interpolation:  Combination
+~~~~
+
+which can be `Combination` (default, see KVZGOUBIInverseMatrix::testGetResults_weight_comb()) or
+`Linear` (see KVZGOUBIInverseMatrix::GetResults_linear()).
+
+ReconstructFPtoLab() does not modify the object, so it can be called for different trajectories at the same time
+in different threads. A batch of trajectories can be reconstructed with ReconstructFPtoLab(std::vector<KVVAMOSReconTrajectory*>&),
+which uses several threads after a call to SetNumberOfThreads().
+*/
 class KVZGOUBIReconstruction : public KVBase {
 protected:
    KVZGOUBIInverseMatrix* Matrix_2D;
    KVZGOUBIInverseMatrix* Matrix_4D;
+   Bool_t fLinearInterpolation;//! kTRUE for local linear interpolation
+   KVThreadPool* fThreadPool;//! threads used to reconstruct batches of trajectories
+
+   std::vector<Float_t> GetResults(const KVZGOUBIInverseMatrix*, Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt) const;
+
 public:
    KVZGOUBIReconstruction();
    KVZGOUBIReconstruction(Bool_t init);
@@ -22,8 +48,15 @@ public:
    virtual ~KVZGOUBIReconstruction();
    virtual void Copy(TObject&) const;
    void Init();
-   Bool_t ReconstructFPtoLab(KVVAMOSReconTrajectory* traj);
-   Bool_t ReconstructFPtoLab(Double_t x_f, Double_t y_f, Double_t theta_f, Double_t phi_f, Double_t& brho, Double_t& path, Double_t& theta_v, Double_t& phi_v);
+   Bool_t ReconstructFPtoLab(KVVAMOSReconTrajectory* traj) const;
+   Bool_t ReconstructFPtoLab(Double_t x_f, Double_t y_f, Double_t theta_f, Double_t phi_f, Double_t& brho, Double_t& path, Double_t& theta_v, Double_t& phi_v) const;
+   Int_t ReconstructFPtoLab(std::vector<KVVAMOSReconTrajectory*>& trajs);
+   void SetNumberOfThreads(UInt_t nthreads = 0);
+   void SetLinearInterpolation(Bool_t yes = kTRUE)
+   {
+      // Use local linear interpolation between the nearest trajectories (see class description)
+      fLinearInterpolation = yes;
+   }
    ClassDef(KVZGOUBIReconstruction, 1) //Class used to access one ZGOUBI Trajectory
 };
 
@@ -93,56 +93,56 @@ void KVZGOUBITrajectory::SetTrajectoryParameters(Float_t ThetaV_t, Float_t PhiV_
 
 //____________________________________________________________________________//
 
-Float_t KVZGOUBITrajectory::GetThetaV()
+Float_t KVZGOUBITrajectory::GetThetaV() const
 {
    return ThetaV;
 }
 
 //____________________________________________________________________________//
 
-Float_t KVZGOUBITrajectory::GetPhiV()
+Float_t KVZGOUBITrajectory::GetPhiV() const
 {
    return PhiV;
 }
 
 //____________________________________________________________________________//
 
-Float_t KVZGOUBITrajectory::GetDelta()
+Float_t KVZGOUBITrajectory::GetDelta() const
 {
    return Delta;
 }
 
 //____________________________________________________________________________//
 
-Float_t KVZGOUBITrajectory::GetXF()
+Float_t KVZGOUBITrajectory::GetXF() const
 {
    return XF;
 }
 
 //____________________________________________________________________________//
 
-Float_t KVZGOUBITrajectory::GetYF()
+Float_t KVZGOUBITrajectory::GetYF() const
 {
    return YF;
 }
 
 //____________________________________________________________________________//
 
-Float_t KVZGOUBITrajectory::GetThetaF()
+Float_t KVZGOUBITrajectory::GetThetaF() const
 {
    return ThetaF;
 }
 
 //____________________________________________________________________________//
 
-Float_t KVZGOUBITrajectory::GetPhiF()
+Float_t KVZGOUBITrajectory::GetPhiF() const
 {
    return PhiF;
 }
 
 //____________________________________________________________________________//
 
-Float_t KVZGOUBITrajectory::GetPath()
+Float_t KVZGOUBITrajectory::GetPath() const
 {
    return Path;
 }
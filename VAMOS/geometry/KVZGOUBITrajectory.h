@@ -27,14 +27,14 @@ public:
 
    void SetTrajectoryParameters(Float_t ThetaVt, Float_t PhiVt, Float_t Deltat, Float_t XFt, Float_t ThetaFt, Float_t YFt, Float_t PhiFt, Float_t Patht);
 
-   Float_t GetThetaV();
-   Float_t GetPhiV();
-   Float_t GetDelta();
-   Float_t GetXF();
-   Float_t GetYF();
-   Float_t GetThetaF();
-   Float_t GetPhiF();
-   Float_t GetPath();
+   Float_t GetThetaV() const;
+   Float_t GetPhiV() const;
+   Float_t GetDelta() const;
+   Float_t GetXF() const;
+   Float_t GetYF() const;
+   Float_t GetThetaF() const;
+   Float_t GetPhiF() const;
+   Float_t GetPath() const;
 
    ClassDef(KVZGOUBITrajectory, 1) //Class used to access one ZGOUBI Trajectory
 };